@@ -17,6 +17,7 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <cstddef>
 #include <exception>
 #include <functional>
 #include <memory>
@@ -192,25 +193,65 @@ namespace Pistache::Async
             }
         };
 
+        // Blocks up to this size are recycled by a per-thread pool
+        static constexpr size_t PoolMaxSize = 2048;
+
+        void* poolAllocate(size_t size);
+        void poolDeallocate(void* ptr, size_t size) noexcept;
+
+        template <typename T>
+        struct PoolAllocator
+        {
+            typedef T value_type;
+
+            PoolAllocator() = default;
+
+            template <typename U>
+            PoolAllocator(const PoolAllocator<U>&) noexcept
+            { }
+
+            T* allocate(size_t n) { return static_cast<T*>(poolAllocate(n * sizeof(T))); }
+            void deallocate(T* ptr, size_t n) noexcept { poolDeallocate(ptr, n * sizeof(T)); }
+
+            template <typename U>
+            bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+
+            template <typename U>
+            bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+        };
+
         struct Core;
 
         class Request
         {
         public:
-            virtual void resolve(const std::shared_ptr<Core>& core) = 0;
-            virtual void reject(const std::shared_ptr<Core>& core)  = 0;
-            virtual ~Request()                                      = default;
+            virtual void resolve(Core& core) = 0;
+            virtual void reject(Core& core)  = 0;
+            virtual ~Request()               = default;
+
+            static void* operator new(size_t size) { return poolAllocate(size); }
+            static void* operator new(size_t, void* ptr) noexcept { return ptr; }
+            static void operator delete(void* ptr, size_t size) noexcept { poolDeallocate(ptr, size); }
+            static void operator delete(void*, void*) noexcept { }
+
+        private:
+            friend struct Core;
+            Request* next_ = nullptr;
         };
 
         struct Core
         {
+            // The first continuation attached to a promise, usually the only
+            // one, is built inside the core when it fits
+            static constexpr size_t InlineRequestSize = 96;
+
             Core(State _state, TypeId _id)
                 : allocated(false)
                 , state(_state)
                 , exc()
-                , mtx()
-                , requests()
+                , requests(nullptr)
                 , id(_id)
+                , inlineUsed_(false)
             { }
 
             bool allocated;
@@ -218,18 +259,14 @@ namespace Pistache::Async
             std::exception_ptr exc;
 
             /*
-             * We need this lock because a Promise might be resolved or rejected from a
-             * thread A while a continuation to the same Promise (Core) might be attached
-             * at the same from a thread B. If that's the case, then we need to serialize
-             * operations so that we avoid a race-condition.
-             *
-             * Since we have a lock, we have a blocking progress guarantee but I don't
-             * expect this to be a major bottleneck as I don't expect major contention on
-             * the lock If it ends up being a bottlenick, try @improving it by
-             * experimenting with a lock-free scheme
+             * The continuations waiting for the promise, most recent first.
+             * A Promise might be resolved or rejected from a thread A while a
+             * continuation to the same Promise (Core) is attached from a thread
+             * B. Attaching pushes onto this list and settling swaps it for a
+             * mark, so that each continuation runs exactly once without a lock:
+             * those attached after the mark run right away
              */
-            std::mutex mtx;
-            std::vector<std::shared_ptr<Request>> requests;
+            std::atomic<Request*> requests;
             TypeId id;
 
             virtual void* memory() = 0;
@@ -260,7 +297,116 @@ namespace Pistache::Async
                 state     = State::Fulfilled;
             }
 
-            virtual ~Core() = default;
+            template <typename Req, typename... Args>
+            Request* makeRequest(Args&&... args)
+            {
+                static_assert(alignof(Req) <= alignof(std::max_align_t),
+                              "Over-aligned continuations are not supported");
+
+                if constexpr (sizeof(Req) <= InlineRequestSize)
+                {
+                    if (!inlineUsed_.exchange(true, std::memory_order_relaxed))
+                        return new (inlineRequest_) Req(std::forward<Args>(args)...);
+                }
+                return new Req(std::forward<Args>(args)...);
+            }
+
+            // Takes ownership of a request made by makeRequest
+            void attach(Request* request)
+            {
+                Request* head = requests.load(std::memory_order_acquire);
+                do
+                {
+                    if (head == settledMark())
+                    {
+                        request->next_ = nullptr;
+                        RequestList list(this, request);
+                        dispatch(request);
+                        return;
+                    }
+                    request->next_ = head;
+                } while (!requests.compare_exchange_weak(head, request,
+                                                         std::memory_order_acq_rel,
+                                                         std::memory_order_acquire));
+            }
+
+            // Runs the continuations attached so far, once the state is set
+            void settle()
+            {
+                Request* head = requests.exchange(settledMark(), std::memory_order_acq_rel);
+                if (head == settledMark())
+                    return;
+
+                RequestList list(this, nullptr);
+                while (head)
+                {
+                    Request* next = head->next_;
+                    head->next_   = list.head;
+                    list.head     = head;
+                    head          = next;
+                }
+
+                for (; list.head; list.pop())
+                    dispatch(list.head);
+            }
+
+            // For a core settled before it is shared, which has nothing to run
+            void markSettled() { requests.store(settledMark(), std::memory_order_relaxed); }
+
+            virtual ~Core()
+            {
+                Request* head = requests.load(std::memory_order_relaxed);
+                if (head != settledMark())
+                    RequestList pending(this, head);
+            }
+
+        private:
+            // Destroys the requests it holds, even when one throws
+            struct RequestList
+            {
+                RequestList(Core* _owner, Request* _head)
+                    : owner(_owner)
+                    , head(_head)
+                { }
+
+                ~RequestList()
+                {
+                    while (head)
+                        pop();
+                }
+
+                void pop()
+                {
+                    Request* next = head->next_;
+                    owner->destroy(head);
+                    head = next;
+                }
+
+                Core* owner;
+                Request* head;
+            };
+
+            Request* settledMark() { return reinterpret_cast<Request*>(this); }
+
+            void dispatch(Request* request)
+            {
+                if (state == State::Fulfilled)
+                    request->resolve(*this);
+                else
+                    request->reject(*this);
+            }
+
+            void destroy(Request* request)
+            {
+                auto* bytes = reinterpret_cast<std::byte*>(request);
+                if (bytes >= inlineRequest_ && bytes < inlineRequest_ + InlineRequestSize)
+                    request->~Request();
+                else
+                    delete request;
+            }
+
+            std::atomic<bool> inlineUsed_;
+            alignas(std::max_align_t) std::byte inlineRequest_[InlineRequestSize];
         };
 
         template <typename T>
@@ -316,26 +462,32 @@ namespace Pistache::Async
             void* memory() override { return nullptr; }
         };
 
+        template <typename T>
+        std::shared_ptr<CoreT<T>> makeCore()
+        {
+            return std::allocate_shared<CoreT<T>>(PoolAllocator<CoreT<T>>());
+        }
+
         template <typename T>
         struct Continuable : public Request
         {
-            explicit Continuable(const std::shared_ptr<Core>& chain)
+            explicit Continuable(std::shared_ptr<Core> chain)
                 : resolveCount_(0)
                 , rejectCount_(0)
-                , chain_(chain)
+                , chain_(std::move(chain))
             { }
 
-            void resolve(const std::shared_ptr<Core>& core) override
+            void resolve(Core& core) override
             {
                 if (resolveCount_ >= 1)
                     return; // TODO is this the right thing?
                             // throw Error("Resolve must not be called more than once");
 
                 ++resolveCount_;
-                doResolve(coreCast(core));
+                doResolve(static_cast<CoreT<T>&>(core));
             }
 
-            void reject(const std::shared_ptr<Core>& core) override
+            void reject(Core& core) override
             {
                 if (rejectCount_ >= 1)
                     return; // TODO is this the right thing?
@@ -344,27 +496,18 @@ namespace Pistache::Async
                 ++rejectCount_;
                 try
                 {
-                    doReject(coreCast(core));
+                    doReject(static_cast<CoreT<T>&>(core));
                 }
                 catch (const InternalRethrow& e)
                 {
                     chain_->exc   = e.exc;
                     chain_->state = State::Rejected;
-                    for (const auto& req : chain_->requests)
-                    {
-                        if (req)
-                            req->reject(chain_);
-                    }
+                    chain_->settle();
                 }
             }
 
-            std::shared_ptr<CoreT<T>> coreCast(const std::shared_ptr<Core>& core) const
-            {
-                return std::static_pointer_cast<CoreT<T>>(core);
-            }
-
-            virtual void doResolve(const std::shared_ptr<CoreT<T>>& core) = 0;
-            virtual void doReject(const std::shared_ptr<CoreT<T>>& core)  = 0;
+            virtual void doResolve(CoreT<T>& core) = 0;
+            virtual void doReject(CoreT<T>& core)  = 0;
 
             ~Continuable() override = default;
 
@@ -386,9 +529,9 @@ namespace Pistache::Async
             {
                 typedef Continuation<T, Resolve, Reject, Res(Args...)> Base;
 
-                Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
+                Continuation(std::shared_ptr<Core> chain, Resolve resolve,
                              Reject reject)
-                    : Base(chain, std::move(resolve), std::move(reject))
+                    : Base(std::move(chain), std::move(resolve), std::move(reject))
                 { }
             };
 
@@ -399,9 +542,9 @@ namespace Pistache::Async
             {
                 typedef Continuation<T, Resolve, Reject, Res(Args...)> Base;
 
-                Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
+                Continuation(std::shared_ptr<Core> chain, Resolve resolve,
                              Reject reject)
-                    : Base(chain, std::move(resolve), std::move(reject))
+                    : Base(std::move(chain), std::move(resolve), std::move(reject))
                 { }
             };
 
@@ -419,31 +562,23 @@ namespace Pistache::Async
                 static_assert(std::is_same<T, Arg>::value || std::is_convertible<T, Arg>::value,
                               "Incompatible types detected");
 
-                Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
+                Continuation(std::shared_ptr<Core> chain, Resolve resolve,
                              Reject reject)
-                    : Continuable<T>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    : Continuable<T>(std::move(chain))
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
-                void doResolve(const std::shared_ptr<CoreT<T>>& core) override
+                void doResolve(CoreT<T>& core) override
                 {
-                    finishResolve(resolve_(detail::tryMove<Resolve>(core->value())));
+                    finishResolve(resolve_(detail::tryMove<Resolve>(core.value())));
                 }
 
-                void doReject(const std::shared_ptr<CoreT<T>>& core) override
+                void doReject(CoreT<T>& core) override
                 {
-                    reject_(core->exc);
-                    /*
-                     * reject_ is guaranteed to throw ("[[noreturn]]") so
-                     * doing this "for" loop is pointless
-                     *
-                    for (const auto& req : this->chain_->requests)
-                    {
-                        if (req)
-                            req->reject(this->chain_);
-                    }
-                    */
+                    reject_(core.exc);
+                    // reject_ is guaranteed to throw ("[[noreturn]]") so
+                    // settling the chain here is pointless
                 }
 
                 template <typename Ret>
@@ -451,11 +586,7 @@ namespace Pistache::Async
                 {
                     typedef typename std::decay<Ret>::type CleanRet;
                     this->chain_->template construct<CleanRet>(std::forward<Ret>(ret));
-                    for (const auto& req : this->chain_->requests)
-                    {
-                        if (req)
-                            req->resolve(this->chain_);
-                    }
+                    this->chain_->settle();
                 }
 
                 Resolve resolve_;
@@ -468,29 +599,27 @@ namespace Pistache::Async
                 : public Continuable<void>
             {
 
-                Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
+                Continuation(std::shared_ptr<Core> chain, Resolve resolve,
                              Reject reject)
-                    : Continuable<void>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    : Continuable<void>(std::move(chain))
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
                 static_assert(sizeof...(Args) == 0,
                               "Can not attach a non-void continuation to a void-Promise");
 
-                void doResolve(const std::shared_ptr<CoreT<void>>& /*core*/) override
+                void doResolve(CoreT<void>& /*core*/) override
                 {
                     finishResolve(resolve_());
                 }
 
-                void doReject(const std::shared_ptr<CoreT<void>>& core) override
+                void doReject(CoreT<void>& core) override
                 {
-                    reject_(core->exc);
-                    for (const auto& req : this->chain_->requests)
-                    {
-                        if (req)
-                            req->reject(this->chain_);
-                    }
+                    reject_(core.exc);
+                    this->chain_->exc   = core.exc;
+                    this->chain_->state = State::Rejected;
+                    this->chain_->settle();
                 }
 
                 template <typename Ret>
@@ -498,11 +627,7 @@ namespace Pistache::Async
                 {
                     typedef typename std::remove_reference<Ret>::type CleanRet;
                     this->chain_->template construct<CleanRet>(std::forward<Ret>(ret));
-                    for (const auto& req : this->chain_->requests)
-                    {
-                        if (req)
-                            req->resolve(this->chain_);
-                    }
+                    this->chain_->settle();
                 }
 
                 Resolve resolve_;
@@ -514,11 +639,11 @@ namespace Pistache::Async
             struct Continuation<T, Resolve, Reject, void(Args...)> : public Continuable<T>
             {
 
-                Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
+                Continuation(std::shared_ptr<Core> chain, Resolve resolve,
                              Reject reject)
-                    : Continuable<T>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    : Continuable<T>(std::move(chain))
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
                 static_assert(sizeof...(Args) == 1,
@@ -529,14 +654,14 @@ namespace Pistache::Async
                 static_assert(std::is_same<T, Arg>::value || std::is_convertible<T, Arg>::value,
                               "Incompatible types detected");
 
-                void doResolve(const std::shared_ptr<CoreT<T>>& core) override
+                void doResolve(CoreT<T>& core) override
                 {
-                    resolve_(core->value());
+                    resolve_(core.value());
                 }
 
-                void doReject(const std::shared_ptr<CoreT<T>>& core) override
+                void doReject(CoreT<T>& core) override
                 {
-                    reject_(core->exc);
+                    reject_(core.exc);
                 }
 
                 Resolve resolve_;
@@ -549,24 +674,24 @@ namespace Pistache::Async
                 : public Continuable<void>
             {
 
-                Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
+                Continuation(std::shared_ptr<Core> chain, Resolve resolve,
                              Reject reject)
-                    : Continuable<void>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    : Continuable<void>(std::move(chain))
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
                 static_assert(sizeof...(Args) == 0,
                               "Can not attach a non-void continuation to a void-Promise");
 
-                void doResolve(const std::shared_ptr<CoreT<void>>& /*core*/) override
+                void doResolve(CoreT<void>& /*core*/) override
                 {
                     resolve_();
                 }
 
-                void doReject(const std::shared_ptr<CoreT<void>>& core) override
+                void doReject(CoreT<void>& core) override
                 {
-                    reject_(core->exc);
+                    reject_(core.exc);
                 }
 
                 Resolve resolve_;
@@ -588,32 +713,24 @@ namespace Pistache::Async
                 static_assert(std::is_same<T, Arg>::value || std::is_convertible<T, Arg>::value,
                               "Incompatible types detected");
 
-                Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
+                Continuation(std::shared_ptr<Core> chain, Resolve resolve,
                              Reject reject)
-                    : Continuable<T>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    : Continuable<T>(std::move(chain))
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
-                void doResolve(const std::shared_ptr<CoreT<T>>& core) override
+                void doResolve(CoreT<T>& core) override
                 {
-                    auto promise = resolve_(detail::tryMove<Resolve>(core->value()));
+                    auto promise = resolve_(detail::tryMove<Resolve>(core.value()));
                     finishResolve(promise);
                 }
 
-                void doReject(const std::shared_ptr<CoreT<T>>& core) override
+                void doReject(CoreT<T>& core) override
                 {
-                    reject_(core->exc);
-                    /*
-                     * reject_ is guaranteed to throw ("[[noreturn]]") so
-                     * doing this "for" loop is pointless
-                     *
-                    for (const auto& req : core->requests)
-                    {
-                        if (req)
-                            req->reject(core);
-                    }
-                    */
+                    reject_(core.exc);
+                    // reject_ is guaranteed to throw ("[[noreturn]]") so
+                    // settling the chain here is pointless
                 }
 
                 template <typename PromiseType>
@@ -626,11 +743,7 @@ namespace Pistache::Async
                     void operator()(const PromiseType& val)
                     {
                         chainCore->construct<PromiseType>(val);
-                        for (const auto& req : chainCore->requests)
-                        {
-                            if (req)
-                                req->resolve(chainCore);
-                        }
+                        chainCore->settle();
                     }
 
                     std::shared_ptr<Core> chainCore;
@@ -654,11 +767,7 @@ namespace Pistache::Async
                             core->exc   = std::move(exc);
                             core->state = State::Rejected;
 
-                            for (const auto& req : core->requests)
-                            {
-                                if (req)
-                                    req->reject(core);
-                            }
+                            core->settle();
                         }
                     });
                 }
@@ -676,27 +785,22 @@ namespace Pistache::Async
                 static_assert(sizeof...(Args) == 0,
                               "Can not attach a non-void continuation to a void-Promise");
 
-                Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
+                Continuation(std::shared_ptr<Core> chain, Resolve resolve,
                              Reject reject)
-                    : Continuable<void>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    : Continuable<void>(std::move(chain))
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
-                void doResolve(const std::shared_ptr<CoreT<void>>& /*core*/) override
+                void doResolve(CoreT<void>& /*core*/) override
                 {
                     auto promise = resolve_();
                     finishResolve(promise);
                 }
 
-                void doReject(const std::shared_ptr<CoreT<void>>& core) override
+                void doReject(CoreT<void>& core) override
                 {
-                    reject_(core->exc);
-                    for (const auto& req : core->requests)
-                    {
-                        if (req)
-                            req->reject(core);
-                    }
+                    reject_(core.exc);
                 }
 
                 template <typename PromiseType, typename Dummy = void>
@@ -709,11 +813,7 @@ namespace Pistache::Async
                     void operator()(const PromiseType& val)
                     {
                         chainCore->construct<PromiseType>(val);
-                        for (const auto& req : chainCore->requests)
-                        {
-                            if (req)
-                                req->resolve(chainCore);
-                        }
+                        chainCore->settle();
                     }
 
                     std::shared_ptr<Core> chainCore;
@@ -730,11 +830,7 @@ namespace Pistache::Async
                     {
                         chainCore->state = State::Fulfilled;
 
-                        for (const auto& req : chainCore->requests)
-                        {
-                            if (req)
-                                req->resolve(chainCore);
-                        }
+                        chainCore->settle();
                     }
 
                     std::shared_ptr<Core> chainCore;
@@ -750,16 +846,15 @@ namespace Pistache::Async
                 template <typename P>
                 void finishResolve(P& promise)
                 {
-                    auto chainer = makeChainer(promise);
-                    promise.then(std::move(chainer), [this](std::exception_ptr exc) {
-                        auto core   = this->chain_;
-                        core->exc   = std::move(exc);
-                        core->state = State::Rejected;
-
-                        for (const auto& req : core->requests)
+                    auto chainer                = makeChainer(promise);
+                    std::weak_ptr<Core> weakPtr = this->chain_;
+                    promise.then(std::move(chainer), [weakPtr](std::exception_ptr exc) {
+                        if (auto core = weakPtr.lock())
                         {
-                            if (req)
-                                req->reject(core);
+                            core->exc   = std::move(exc);
+                            core->state = State::Rejected;
+
+                            core->settle();
                         }
                     });
                 }
@@ -778,9 +873,9 @@ namespace Pistache::Async
             typedef impl::Continuation<T, Resolve, Reject, decltype(&Sig::operator())>
                 Base;
 
-            Continuation(const std::shared_ptr<Core>& core, Resolve resolve,
+            Continuation(std::shared_ptr<Core> core, Resolve resolve,
                          Reject reject)
-                : Base(core, std::move(resolve), std::move(reject))
+                : Base(std::move(core), std::move(resolve), std::move(reject))
             { }
         };
 
@@ -791,9 +886,9 @@ namespace Pistache::Async
         {
             typedef impl::Continuation<T, Resolve, Reject, Res(Args...)> Base;
 
-            Continuation(const std::shared_ptr<Core>& core, Resolve resolve,
+            Continuation(std::shared_ptr<Core> core, Resolve resolve,
                          Reject reject)
-                : Base(core, std::move(resolve), std::move(reject))
+                : Base(std::move(core), std::move(resolve), std::move(reject))
             { }
         };
 
@@ -804,9 +899,9 @@ namespace Pistache::Async
         {
             typedef impl::Continuation<T, Resolve, Reject, Res(Args...)> Base;
 
-            Continuation(const std::shared_ptr<Core>& core, Resolve resolve,
+            Continuation(std::shared_ptr<Core> core, Resolve resolve,
                          Reject reject)
-                : Base(core, std::move(resolve), std::move(reject))
+                : Base(std::move(core), std::move(resolve), std::move(reject))
             { }
         };
 
@@ -817,9 +912,9 @@ namespace Pistache::Async
         {
             typedef impl::Continuation<T, Resolve, Reject, Res(Args...)> Base;
 
-            Continuation(const std::shared_ptr<Core>& core, Resolve resolve,
+            Continuation(std::shared_ptr<Core> core, Resolve resolve,
                          Reject reject)
-                : Base(core, std::move(resolve), std::move(reject))
+                : Base(std::move(core), std::move(resolve), std::move(reject))
             { }
         };
 
@@ -830,9 +925,9 @@ namespace Pistache::Async
         {
             typedef impl::Continuation<T, Resolve, Reject, Res(Args...)> Base;
 
-            Continuation(const std::shared_ptr<Core>& core, Resolve resolve,
+            Continuation(std::shared_ptr<Core> core, Resolve resolve,
                          Reject reject)
-                : Base(core, std::move(resolve), std::move(reject))
+                : Base(std::move(core), std::move(resolve), std::move(reject))
             { }
         };
     } // namespace Private
@@ -870,14 +965,8 @@ namespace Pistache::Async
                 throw Error("Attempt to resolve a void promise with arguments");
             }
 
-            std::unique_lock<std::mutex> guard(core_->mtx);
             core_->construct<Type>(std::forward<Arg>(arg));
-
-            for (const auto& req : core_->requests)
-            {
-                if (req)
-                    req->resolve(core_);
-            }
+            core_->settle();
 
             return true;
         }
@@ -893,13 +982,8 @@ namespace Pistache::Async
             if (!core_->isVoid())
                 throw Error("Attempt ro resolve a non-void promise with no argument");
 
-            std::unique_lock<std::mutex> guard(core_->mtx);
             core_->state = State::Fulfilled;
-            for (const auto& req : core_->requests)
-            {
-                if (req)
-                    req->resolve(core_);
-            }
+            core_->settle();
 
             return true;
         }
@@ -934,14 +1018,9 @@ namespace Pistache::Async
             if (core_->state != State::Pending)
                 throw Error("Attempt to reject a fulfilled promise");
 
-            std::unique_lock<std::mutex> guard(core_->mtx);
             core_->exc   = std::make_exception_ptr(exc);
             core_->state = State::Rejected;
-            for (const auto& req : core_->requests)
-            {
-                if (req)
-                    req->reject(core_);
-            }
+            core_->settle();
 
             return true;
         }
@@ -1076,7 +1155,7 @@ namespace Pistache::Async
 
         template <typename Func>
         explicit Promise(Func func)
-            : core_(std::make_shared<Core>())
+            : core_(Private::makeCore<T>())
             , resolver_(core_)
             , rejection_(core_)
         {
@@ -1099,8 +1178,9 @@ namespace Pistache::Async
             static_assert(std::is_same<T, U>::value || std::is_convertible<U, T>::value,
                           "Incompatible value type");
 
-            auto core = std::make_shared<Core>();
+            auto core = Private::makeCore<T>();
             core->template construct<T>(std::forward<U>(value));
+            core->markSettled();
             return Promise<T>(std::move(core));
         }
 
@@ -1109,17 +1189,19 @@ namespace Pistache::Async
             static_assert(std::is_void<T>::value,
                           "Resolving a non-void promise requires parameters");
 
-            auto core   = std::make_shared<Core>();
+            auto core   = Private::makeCore<T>();
             core->state = State::Fulfilled;
+            core->markSettled();
             return Promise<T>(std::move(core));
         }
 
         template <typename Exc>
         static Promise<T> rejected(Exc exc)
         {
-            auto core   = std::make_shared<Core>();
+            auto core   = Private::makeCore<T>();
             core->exc   = std::make_exception_ptr(exc);
             core->state = State::Rejected;
+            core->markSettled();
             return Promise<T>(std::move(core));
         }
 
@@ -1140,28 +1222,15 @@ namespace Pistache::Async
 
             typedef Private::Continuation<T, ResolveFunc, RejectFunc, ResolveFunc>
                 Continuation;
-            std::shared_ptr<Private::Request> req = std::make_shared<Continuation>(promise.core_, resolveFunc, rejectFunc);
-
-            std::unique_lock<std::mutex> guard(core_->mtx);
-            if (isFulfilled())
-            {
-                if (req)
-                    req->resolve(core_);
-            }
-            else if (isRejected())
-            {
-                if (req)
-                    req->reject(core_);
-            }
-
-            core_->requests.push_back(req);
+            core_->attach(core_->template makeRequest<Continuation>(
+                promise.core_, std::move(resolveFunc), std::move(rejectFunc)));
 
             return promise;
         }
 
     private:
         Promise()
-            : core_(std::make_shared<Core>())
+            : core_(Private::makeCore<T>())
             , resolver_(core_)
             , rejection_(core_)
         { }
@@ -1283,16 +1352,14 @@ namespace Pistache::Async
                 Data(const size_t _total, Resolver _resolver, Rejection _rejection)
                     : total(_total)
                     , resolved(0)
-                    , rejected(false)
-                    , mtx()
+                    , done(false)
                     , resolve(std::move(_resolver))
                     , reject(std::move(_rejection))
                 { }
 
                 const size_t total;
-                size_t resolved;
-                bool rejected;
-                std::mutex mtx;
+                std::atomic<size_t> resolved;
+                std::atomic<bool> done;
 
                 Resolver resolve;
                 Rejection reject;
@@ -1301,44 +1368,40 @@ namespace Pistache::Async
             template <size_t Index, typename T, typename Data>
             static void resolveT(const T& val, Data& data)
             {
-                std::lock_guard<std::mutex> guard(data->mtx);
-
-                if (data->rejected)
+                if (data->done.load(std::memory_order_acquire))
                     return;
 
-                // @Check thread-safety of std::get ?
+                // Each promise writes its own element, the last one to
+                // resolve sees all of them
                 std::get<Index>(data->results) = val;
-                data->resolved++;
-
-                if (data->resolved == data->total)
-                {
-                    data->resolve(data->results);
-                }
+                resolveOne(data);
             }
 
             template <typename Data>
             static void resolveVoid(Data& data)
             {
-                std::lock_guard<std::mutex> guard(data->mtx);
-
-                if (data->rejected)
+                if (data->done.load(std::memory_order_acquire))
                     return;
 
-                data->resolved++;
-
-                if (data->resolved == data->total)
-                {
-                    data->resolve(data->results);
-                }
+                resolveOne(data);
             }
 
             template <typename Data>
             static void reject(std::exception_ptr exc, Data& data)
             {
-                std::lock_guard<std::mutex> guard(data->mtx);
+                if (!data->done.exchange(true, std::memory_order_acq_rel))
+                    data->reject(exc);
+            }
 
-                data->rejected = true;
-                data->reject(exc);
+        private:
+            template <typename Data>
+            static void resolveOne(Data& data)
+            {
+                if (data->resolved.fetch_add(1, std::memory_order_acq_rel) + 1 == data->total
+                    && !data->done.exchange(true, std::memory_order_acq_rel))
+                {
+                    data->resolve(data->results);
+                }
             }
         };
 
@@ -1349,13 +1412,11 @@ namespace Pistache::Async
             {
                 Data(size_t, Resolver resolver, Rejection rejection)
                     : done(false)
-                    , mtx()
                     , resolve(std::move(resolver))
                     , reject(std::move(rejection))
                 { }
 
-                bool done;
-                std::mutex mtx;
+                std::atomic<bool> done;
 
                 Resolver resolve;
                 Rejection reject;
@@ -1364,42 +1425,32 @@ namespace Pistache::Async
             template <size_t Index, typename T, typename Data>
             static void resolveT(const T& val, Data& data)
             {
-                std::lock_guard<std::mutex> guard(data->mtx);
-
-                if (data->done)
+                if (data->done.exchange(true, std::memory_order_acq_rel))
                     return;
 
                 // Instead of allocating a new core, ideally we could share the same core as
                 // the relevant promise but we do not have access to the promise here is so
                 // meh
-                auto core = std::make_shared<Private::CoreT<T>>();
+                auto core = Private::makeCore<T>();
                 core->template construct<T>(val);
                 data->resolve(Async::Any(core));
-
-                data->done = true;
             }
 
             template <typename Data>
             static void resolveVoid(Data& data)
             {
-                std::lock_guard<std::mutex> guard(data->mtx);
-
-                if (data->done)
+                if (data->done.exchange(true, std::memory_order_acq_rel))
                     return;
 
-                auto core = std::make_shared<Private::CoreT<void>>();
+                auto core = Private::makeCore<void>();
                 data->resolve(Async::Any(core));
-
-                data->done = true;
             }
 
             template <typename Data>
             static void reject(std::exception_ptr exc, Data& data)
             {
-                std::lock_guard<std::mutex> guard(data->mtx);
-
-                data->done = true;
-                data->reject(exc);
+                if (!data->done.exchange(true, std::memory_order_acq_rel))
+                    data->reject(exc);
             }
         };
 
@@ -1539,13 +1590,8 @@ namespace Pistache::Async
                     WhenContinuation<T> cont(data, index);
 
                     it->then(std::move(cont), [=](std::exception_ptr ptr) {
-                        std::lock_guard<std::mutex> guard(data->mtx);
-
-                        if (data->rejected)
-                            return;
-
-                        data->rejected = true;
-                        data->reject(std::move(ptr));
+                        if (!data->done.exchange(true, std::memory_order_acq_rel))
+                            data->reject(std::move(ptr));
                     });
 
                     ++index;
@@ -1558,16 +1604,14 @@ namespace Pistache::Async
                 Data(size_t _total, Resolver _resolver, Rejection _rejection)
                     : total(_total)
                     , resolved(0)
-                    , rejected(false)
-                    , mtx()
+                    , done(false)
                     , resolve(std::move(_resolver))
                     , reject(std::move(_rejection))
                 { }
 
                 const size_t total;
-                size_t resolved;
-                bool rejected;
-                std::mutex mtx;
+                std::atomic<size_t> resolved;
+                std::atomic<bool> done;
 
                 Resolver resolve;
                 Rejection reject;
@@ -1612,14 +1656,12 @@ namespace Pistache::Async
 
                 void operator()(const ValueType& val) const
                 {
-                    std::lock_guard<std::mutex> guard(data->mtx);
-
-                    if (data->rejected)
+                    if (data->done.load(std::memory_order_acquire))
                         return;
 
                     data->results[index] = val;
-                    data->resolved++;
-                    if (data->resolved == data->total)
+                    if (data->resolved.fetch_add(1, std::memory_order_acq_rel) + 1 == data->total
+                        && !data->done.exchange(true, std::memory_order_acq_rel))
                     {
                         data->resolve(data->results);
                     }
@@ -1640,13 +1682,11 @@ namespace Pistache::Async
 
                 void operator()() const
                 {
-                    std::lock_guard<std::mutex> guard(data->mtx);
-
-                    if (data->rejected)
+                    if (data->done.load(std::memory_order_acquire))
                         return;
 
-                    data->resolved++;
-                    if (data->resolved == data->total)
+                    if (data->resolved.fetch_add(1, std::memory_order_acq_rel) + 1 == data->total
+                        && !data->done.exchange(true, std::memory_order_acq_rel))
                     {
                         data->resolve();
                     }
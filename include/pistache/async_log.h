@@ -0,0 +1,113 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* async_log.h
+
+   Asynchronous logging. Once AsyncLog::start has been called, PS_LOG_* and
+   AsyncStringLogger messages are written by the thread logging them into a
+   ring buffer of its own, without locking, and a background thread drains
+   the rings into syslog, a file or stdout.
+
+   The caller formats the message itself; the timestamp, source location and
+   thread prefix are formatted by the background thread. A message logged
+   while the ring of its thread is full is dropped, and counted, rather than
+   blocking the thread.
+
+   Until started, or once stopped, PS_LOG_* log synchronously.
+*/
+
+#pragma once
+
+#include <pistache/string_logger.h>
+#include <pistache/winornix.h>
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace Pistache::Log
+{
+
+    class AsyncLog
+    {
+    public:
+        enum class Sink {
+            Syslog,
+            File,
+            Stdout
+        };
+
+        struct Options
+        {
+            Sink sink = Sink::Syslog;
+
+            // The file appended to by Sink::File
+            std::string path;
+
+            // Messages each thread can have waiting, rounded up to a power
+            // of two
+            size_t records = 256;
+
+            // How long the background thread sleeps once all rings are empty
+            std::chrono::milliseconds interval { 2 };
+        };
+
+        struct Stats
+        {
+            uint64_t written = 0;
+            uint64_t dropped = 0;
+        };
+
+        // Throws std::runtime_error if already started or if the file of
+        // Sink::File cannot be opened
+        static void start();
+        static void start(const Options& options);
+
+        // Writes what is left in the rings, then stops the background thread
+        static void stop();
+
+        static bool isRunning();
+
+        // False if the message was dropped, or if not started
+        static bool log(int priority, bool andPrintf,
+                        const char* file, int line, const char* function,
+                        const char* format, va_list ap);
+        static bool log(int priority, bool andPrintf, const char* message);
+
+        // Waits until what was logged before the call has been written
+        static void flush();
+
+        static Stats stats();
+    };
+
+    // Logs through AsyncLog, or synchronously through PS_LOG_* while it is
+    // not started
+    class AsyncStringLogger : public StringLogger
+    {
+    public:
+        explicit AsyncStringLogger(Level level)
+            : level_(level)
+        { }
+        ~AsyncStringLogger() override = default;
+
+        void log(Level level, const std::string& message) override;
+        bool isEnabledFor(Level level) const override;
+
+    private:
+        Level level_;
+    };
+
+    namespace Private
+    {
+        // Writes a message logged by thread at time: to out if not null, to
+        // syslog otherwise. Defined in pist_syslog.cc
+        void emitLog(FILE* out, int priority, bool andPrintf, PST_THREAD_ID thread,
+                     std::chrono::system_clock::time_point time, const char* str);
+    } // namespace Private
+
+} // namespace Pistache::Log
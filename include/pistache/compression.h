@@ -0,0 +1,169 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* compression.h
+
+   Streaming encoders for the compressed content encodings (Brotli, zstd,
+   deflate, whichever are built in), shared by ResponseWriter::send and by
+   compressed ResponseStreams.
+
+   An encoder's context is costly to set up, so they are pooled: every
+   thread keeps a few idle encoders of each kind, which acquire() resets
+   and hands out again rather than creating new ones.
+
+   Bodies sent over and over (static files, API descriptions) need not be
+   compressed more than once either: CompressedCache keeps their compressed
+   representations, by content, encoding and level, within a memory cap.
+*/
+
+#pragma once
+
+#include <pistache/http_header.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Pistache::Http
+{
+
+    class Compressor
+    {
+    public:
+        enum class Flush {
+            None, // the encoder may hold on to some of its input
+            Sync, // everything given so far can be decoded from the output
+            Finish // also ends the stream, reset() before using it again
+        };
+
+        virtual ~Compressor() = default;
+
+        virtual Header::Encoding encoding() const = 0;
+
+        // Appends to out whatever the encoder outputs for data. Throws
+        // std::runtime_error if the encoder fails
+        virtual void compress(const char* data, size_t size, Flush flush,
+                              std::string& out)
+            = 0;
+
+        // Starts a new stream, compressed at level (as passed to the
+        // setCompression*Level functions of ResponseWriter)
+        virtual void reset(int level) = 0;
+    };
+
+    class CompressorPool
+    {
+    public:
+        // Idle encoders kept per encoding, per thread
+        static constexpr size_t MaxIdle = 8;
+
+        // Hands the compressor back to the pool of the releasing thread
+        struct Release
+        {
+            void operator()(Compressor* compressor) const;
+        };
+
+        using Handle = std::unique_ptr<Compressor, Release>;
+
+        // A compressor ready to start a new stream at level. Throws
+        // std::runtime_error for an encoding that is not built in
+        static Handle acquire(Header::Encoding encoding, int level);
+
+        // Number of idle compressors pooled by the calling thread
+        static size_t idle(Header::Encoding encoding);
+    };
+
+    class CompressedCache
+    {
+    public:
+        static constexpr size_t DefaultMaxBytes = 32 * 1024 * 1024;
+
+        struct Key
+        {
+            std::string id; // identifies the uncompressed body
+            Header::Encoding encoding;
+            int level;
+
+            bool operator==(const Key& other) const
+            {
+                return encoding == other.encoding && level == other.level && id == other.id;
+            }
+        };
+
+        struct Stats
+        {
+            uint64_t hits      = 0;
+            uint64_t misses    = 0;
+            uint64_t evictions = 0;
+        };
+
+        // Bodies compressing to more than maxBytes are never cached
+        explicit CompressedCache(size_t maxBytes = DefaultMaxBytes);
+
+        CompressedCache(const CompressedCache&)            = delete;
+        CompressedCache& operator=(const CompressedCache&) = delete;
+
+        // An id for a body, from its contents: its 128-bit SipHash, keyed
+        // at random per process so that colliding bodies cannot be
+        // crafted, and its size
+        static std::string bodyId(const char* data, size_t size);
+
+        // Null if not cached
+        std::shared_ptr<const std::string> get(const Key& key);
+
+        // The cached representation, or data compressed (and then cached)
+        // with an encoder from CompressorPool. Throws as the encoder does
+        std::shared_ptr<const std::string> getOrCompress(const Key& key, const char* data,
+                                                         size_t size);
+
+        // Compresses data for key and caches the result, even if something
+        // is cached for it already
+        std::shared_ptr<const std::string> compress(const Key& key, const char* data,
+                                                    size_t size);
+
+        void put(const Key& key, std::shared_ptr<const std::string> compressed);
+        void clear();
+
+        void setMaxBytes(size_t maxBytes);
+        size_t maxBytes() const;
+
+        size_t bytes() const; // of all the representations cached
+        size_t size() const;
+        Stats stats() const;
+
+        // The cache ResponseWriter::send and serveFile go through
+        static CompressedCache& instance();
+
+    private:
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct Slot
+        {
+            std::shared_ptr<const std::string> compressed;
+            std::list<Key>::iterator lru;
+        };
+
+        void evictLocked();
+
+        mutable std::mutex lock_;
+
+        size_t maxBytes_;
+        size_t bytes_ = 0;
+
+        std::unordered_map<Key, Slot, KeyHash> slots_;
+        std::list<Key> lru_; // most recently used first
+
+        Stats stats_;
+    };
+
+} // namespace Pistache::Http
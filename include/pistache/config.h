@@ -25,6 +25,7 @@ namespace Pistache::Const
     // Defined from CMakeLists.txt in project root
     static constexpr size_t DefaultMaxRequestSize    = 4096;
     static constexpr size_t DefaultMaxResponseSize   = std::numeric_limits<uint32_t>::max();
+    static constexpr size_t DefaultReadBufferSize    = MaxBuffer;
     static constexpr auto DefaultHeaderTimeout       = std::chrono::seconds(60);
     static constexpr auto DefaultBodyTimeout         = std::chrono::seconds(60);
     static constexpr auto DefaultKeepaliveTimeout    = std::chrono::seconds(300);
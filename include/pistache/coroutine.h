@@ -0,0 +1,349 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* coroutine.h
+
+   C++20 coroutines: an Async::Promise can be co_await'ed from an
+   Async::Task<T>, the return type of coroutines, route handlers among them:
+
+       Async::Task<> fetch(Rest::Request request, Http::ResponseWriter response)
+       {
+           auto reply = co_await client.get(url).send();
+           co_await response.send(Http::Code::Ok, reply.body());
+       }
+
+   A task starts running when it is called, and carries on by itself once
+   its Task is dropped, as a route handler's is. A task started from a
+   transport's reactor thread resumes in that thread after each co_await,
+   whichever thread the promise it awaited settled in. Frames are allocated
+   from the same per-thread pool as promise cores, so that each worker
+   recycles its own.
+
+   What a task takes by reference has to outlive its first suspension: a
+   route handler takes the request by value (see Routes::bind).
+
+   Empty unless compiled as C++20 or later.
+*/
+
+#pragma once
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <pistache/async.h>
+#include <pistache/pist_syslog.h>
+#include <pistache/transport.h>
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace Pistache::Async
+{
+
+    template <typename T = void>
+    class Task;
+
+    namespace Private
+    {
+
+        // Resumes handle in home's reactor thread, right away if there is no
+        // home or if this is its thread
+        inline void resumeOn(Tcp::Transport* home, std::coroutine_handle<> handle)
+        {
+            if (home && Tcp::Transport::current() != home)
+                home->post([handle] { handle.resume(); });
+            else
+                handle.resume();
+        }
+
+        template <typename T>
+        struct AwaitedValue
+        {
+            std::optional<T> value;
+        };
+
+        template <>
+        struct AwaitedValue<void>
+        { };
+
+        template <typename T>
+        class PromiseAwaiter : private AwaitedValue<T>
+        {
+        public:
+            PromiseAwaiter(Promise<T>& promise, Tcp::Transport* home)
+                : promise_(promise)
+                , home_(home)
+            { }
+
+            bool await_ready() const noexcept { return false; }
+
+            // Does not suspend when the promise has already settled
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                handle_     = handle;
+                auto reject = [this](std::exception_ptr exc) {
+                    exc_ = std::move(exc);
+                    settled();
+                };
+
+                if constexpr (std::is_void_v<T>)
+                {
+                    promise_.then([this]() { settled(); }, std::move(reject));
+                }
+                else
+                {
+                    promise_.then(
+                        [this](const T& value) {
+                            this->value.emplace(value);
+                            settled();
+                        },
+                        std::move(reject));
+                }
+
+                return !done_.exchange(true, std::memory_order_acq_rel);
+            }
+
+            T await_resume()
+            {
+                if (exc_)
+                    std::rethrow_exception(exc_);
+
+                if constexpr (!std::is_void_v<T>)
+                    return std::move(*this->value);
+            }
+
+        private:
+            // Whichever of settling and suspending comes second resumes
+            void settled()
+            {
+                if (done_.exchange(true, std::memory_order_acq_rel))
+                    resumeOn(home_, handle_);
+            }
+
+            Promise<T>& promise_;
+            Tcp::Transport* home_;
+            std::coroutine_handle<> handle_;
+            std::atomic<bool> done_ { false };
+            std::exception_ptr exc_;
+        };
+
+        class TaskPromiseBase
+        {
+        public:
+            struct FinalAwaiter
+            {
+                bool await_ready() const noexcept { return false; }
+
+                template <typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+                {
+                    return handle.promise().finish(handle);
+                }
+
+                void await_resume() const noexcept { }
+            };
+
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+
+            void unhandled_exception() { exc_ = std::current_exception(); }
+
+            template <typename U>
+            PromiseAwaiter<U> await_transform(Promise<U>& promise)
+            {
+                return PromiseAwaiter<U>(promise, home_);
+            }
+
+            // A temporary lives until the end of the co_await expression
+            template <typename U>
+            PromiseAwaiter<U> await_transform(Promise<U>&& promise)
+            {
+                return PromiseAwaiter<U>(promise, home_);
+            }
+
+            template <typename Awaitable>
+            Awaitable&& await_transform(Awaitable&& awaitable) const noexcept
+            {
+                return std::forward<Awaitable>(awaitable);
+            }
+
+            static void* operator new(size_t size) { return poolAllocate(size); }
+            static void operator delete(void* ptr, size_t size) noexcept { poolDeallocate(ptr, size); }
+
+            bool finished() const
+            {
+                return waiter_.load(std::memory_order_acquire) == finishedMark();
+            }
+
+            // Lets the coroutine waiting be resumed once this one finishes.
+            // False, with nothing done, if it already has
+            bool awaitedBy(std::coroutine_handle<> waiter)
+            {
+                void* expected = nullptr;
+                return waiter_.compare_exchange_strong(expected, waiter.address(),
+                                                       std::memory_order_acq_rel,
+                                                       std::memory_order_acquire);
+            }
+
+            // Called by the Task when dropped. True if the frame is for it
+            // to destroy, the coroutine being done
+            bool release() { return released_.exchange(true, std::memory_order_acq_rel); }
+
+        protected:
+            void rethrow() const
+            {
+                if (exc_)
+                    std::rethrow_exception(exc_);
+            }
+
+        private:
+            template <typename Promise>
+            std::coroutine_handle<> finish(std::coroutine_handle<Promise> handle) noexcept
+            {
+                void* waiter   = waiter_.exchange(finishedMark(), std::memory_order_acq_rel);
+                const bool own = released_.exchange(true, std::memory_order_acq_rel);
+                if (waiter)
+                    return std::coroutine_handle<>::from_address(waiter);
+
+                // Nobody is left to see how it ended
+                if (own)
+                {
+                    if (exc_)
+                        PS_LOG_WARNING("Exception escaped a detached coroutine");
+                    handle.destroy();
+                }
+                return std::noop_coroutine();
+            }
+
+            void* finishedMark() const { return const_cast<TaskPromiseBase*>(this); }
+
+            Tcp::Transport* home_ = Tcp::Transport::current();
+            std::exception_ptr exc_;
+
+            // The coroutine awaiting this one, finishedMark() once it is done
+            std::atomic<void*> waiter_ { nullptr };
+
+            // Set by the first of the Task being dropped and the coroutine
+            // finishing, the second destroys the frame
+            std::atomic<bool> released_ { false };
+        };
+
+        template <typename T>
+        class TaskPromise : public TaskPromiseBase
+        {
+        public:
+            Task<T> get_return_object();
+
+            template <typename U>
+            void return_value(U&& value)
+            {
+                value_.emplace(std::forward<U>(value));
+            }
+
+            T result()
+            {
+                rethrow();
+                return std::move(*value_);
+            }
+
+        private:
+            std::optional<T> value_;
+        };
+
+        template <>
+        class TaskPromise<void> : public TaskPromiseBase
+        {
+        public:
+            Task<void> get_return_object();
+
+            void return_void() const { }
+
+            void result() const { rethrow(); }
+        };
+
+    } // namespace Private
+
+    template <typename T>
+    class Task
+    {
+    public:
+        typedef Private::TaskPromise<T> promise_type;
+
+        explicit Task(std::coroutine_handle<promise_type> handle)
+            : handle_(handle)
+        { }
+
+        Task(const Task&)            = delete;
+        Task& operator=(const Task&) = delete;
+
+        Task(Task&& other) noexcept
+            : handle_(std::exchange(other.handle_, nullptr))
+        { }
+
+        Task& operator=(Task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                release();
+                handle_ = std::exchange(other.handle_, nullptr);
+            }
+            return *this;
+        }
+
+        ~Task() { release(); }
+
+        bool isDone() const { return handle_ && handle_.promise().finished(); }
+
+        auto operator co_await() const noexcept
+        {
+            struct Awaiter
+            {
+                bool await_ready() const { return handle.promise().finished(); }
+                bool await_suspend(std::coroutine_handle<> waiter) const
+                {
+                    return handle.promise().awaitedBy(waiter);
+                }
+                T await_resume() const { return handle.promise().result(); }
+
+                std::coroutine_handle<promise_type> handle;
+            };
+
+            return Awaiter { handle_ };
+        }
+
+    private:
+        void release()
+        {
+            if (handle_ && handle_.promise().release())
+                handle_.destroy();
+            handle_ = nullptr;
+        }
+
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    namespace Private
+    {
+
+        template <typename T>
+        Task<T> TaskPromise<T>::get_return_object()
+        {
+            return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object()
+        {
+            return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+        }
+
+    } // namespace Private
+
+} // namespace Pistache::Async
+
+#endif // __cpp_impl_coroutine
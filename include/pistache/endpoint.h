@@ -44,6 +44,31 @@ namespace Pistache::Http
             Options& maxRequestSize(size_t val);
             Options& maxResponseSize(size_t val);
 
+            // Size of each worker's receive buffer. Incoming data is read
+            // until this buffer is full (or the socket is drained) before
+            // being parsed, so large uploads benefit from a larger value
+            Options& readBufferSize(size_t val);
+
+            // Responses (or parts of them) of at least this many bytes are
+            // sent with MSG_ZEROCOPY where available, see
+            // Tcp::Transport::setZeroCopyThreshold. 0, the default, is for
+            // never: it only pays off for bulk transfers of several MB
+            Options& zeroCopyThreshold(size_t val);
+
+            // What the worker threads poll connections with. With
+            // Polling::Backend::IoUring, changes of interest in a socket
+            // are batched into the wait for the next events instead of
+            // costing a system call each; it falls back to epoll where
+            // io_uring is missing or disabled
+            Options& pollBackend(Polling::Backend backend);
+
+            // Each worker thread accepts connections from a listening
+            // socket of its own, the kernel spreading them over the
+            // sockets with SO_REUSEPORT; optionally as the eBPF program
+            // given decides. See Tcp::Listener::setPerWorkerListeners
+            Options& perWorkerListeners(bool enable);
+            Options& reusePortProgram(int bpfProgramFd);
+
             template <typename Duration>
             Options& headerTimeout(Duration timeout)
             {
@@ -99,6 +124,12 @@ namespace Pistache::Http
             PISTACHE_STRING_LOGGER_T logger_;
             // This should be moved after "keepaliveTimeout_" in the next ABI change
             std::chrono::milliseconds sslHandshakeTimeout_;
+            // This should be moved after "maxResponseSize_" in the next ABI change
+            size_t readBufferSize_;
+            size_t zeroCopyThreshold_;
+            Polling::Backend pollBackend_;
+            bool perWorkerListeners_;
+            int reusePortProgram_;
             Options();
         };
         Endpoint();
@@ -0,0 +1,134 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* file_cache.h
+
+   A cache of open files for serveFile: the file stays open, and its size,
+   modification time, MIME type and ETag are kept alongside, so that
+   serving a file again takes none of open, fstat and close.
+
+   Entries are evicted least recently used first once the capacity is
+   reached, and dropped once older than the TTL. On Linux, entries are also
+   dropped as soon as inotify reports their file modified, replaced or
+   deleted. Evicted files stay open for as long as a pending write still
+   needs them.
+
+   Hits only share the lock, and inotify is read at most once per
+   millisecond: a change may go unnoticed for that long.
+*/
+
+#pragma once
+
+#include <pistache/mime.h>
+#include <pistache/stream.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Pistache::Http
+{
+
+    class FileCache
+    {
+    public:
+        // Every entry holds an fd, keep well below the usual fd limit
+        static constexpr size_t DefaultCapacity = 256;
+        static constexpr std::chrono::milliseconds DefaultTtl { 5000 };
+
+        struct Entry
+        {
+            std::string path;
+            std::shared_ptr<const OpenFile> file; // null if the file is missing
+            size_t size        = 0;
+            std::time_t mtime  = 0;
+            Mime::MediaType mime; // from the file's extension
+            std::string etag; // opaque tag, without quotes
+            std::chrono::steady_clock::time_point loaded;
+        };
+
+        struct Stats
+        {
+            uint64_t hits          = 0;
+            uint64_t misses        = 0;
+            uint64_t evictions     = 0; // capacity or TTL
+            uint64_t invalidations = 0; // file changed, or invalidate()
+        };
+
+        // A capacity of 0 disables caching: every get() opens the file
+        explicit FileCache(size_t capacity           = DefaultCapacity,
+                           std::chrono::milliseconds ttl = DefaultTtl);
+        ~FileCache();
+
+        FileCache(const FileCache&)            = delete;
+        FileCache& operator=(const FileCache&) = delete;
+
+        // Throws HttpError (Not_Found, or Internal_Server_Error) when the
+        // file cannot be opened
+        std::shared_ptr<const Entry> get(const std::string& path);
+
+        // Same, but null for a file that does not exist, which is then
+        // remembered (until the TTL) like any other entry. For files that
+        // are looked for on every request but seldom there
+        std::shared_ptr<const Entry> find(const std::string& path);
+
+        void invalidate(const std::string& path);
+        void clear();
+
+        void setCapacity(size_t capacity);
+        void setTtl(std::chrono::milliseconds ttl);
+
+        size_t capacity() const;
+        size_t size() const;
+        Stats stats() const;
+
+        // The cache serveFile goes through
+        static FileCache& instance();
+
+    private:
+        struct Slot
+        {
+            std::shared_ptr<const Entry> entry;
+            std::atomic<uint64_t> used { 0 }; // tick of the last lookup
+            int watch = -1;
+        };
+
+        std::shared_ptr<const Entry> lookup(const std::string& path, bool allowMissing);
+        static std::shared_ptr<const Entry> load(const std::string& path, bool allowMissing);
+
+        void drainEvents();
+        void processEvents();
+        void eraseLocked(std::unordered_map<std::string, Slot>::iterator it);
+        void evictLocked();
+
+        mutable std::shared_mutex lock_;
+
+        size_t capacity_;
+        std::chrono::milliseconds ttl_;
+
+        // Hits bump their slot's tick rather than reorder a list, which
+        // they could not under a shared lock: eviction looks for the
+        // lowest tick instead
+        std::unordered_map<std::string, Slot> slots_;
+        std::atomic<uint64_t> ticks_ { 0 };
+
+        // inotify watch descriptor to the paths watched through it: paths
+        // naming the same file share one watch
+        int inotifyFd_ = -1;
+        std::unordered_map<int, std::vector<std::string>> watches_;
+        std::atomic<int64_t> nextDrain_ { 0 }; // steady clock, in ns
+
+        Stats stats_; // but for hits, under the exclusive lock
+        std::atomic<uint64_t> hits_ { 0 };
+    };
+
+} // namespace Pistache::Http
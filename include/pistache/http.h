@@ -14,8 +14,13 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -30,9 +35,11 @@
 #endif
 
 #include <pistache/async.h>
+#include <pistache/compression.h>
 #include <pistache/cookie.h>
 #include <pistache/http_defs.h>
 #include <pistache/http_headers.h>
+#include <pistache/trace.h>
 #include <pistache/meta.h>
 #include <pistache/mime.h>
 #include <pistache/net.h>
@@ -82,12 +89,98 @@ namespace Pistache
     PROTOTYPE_OF(Pistache::Tcp::Handler, Class) \
     typedef Pistache::Http::details::prototype_tag tag;
 
+        class Request;
+        class ResponseWriter;
+
         namespace Private
         {
             class RequestLineStep;
             class ResponseLineStep;
             class HeadersStep;
             class BodyStep;
+
+            template <typename Message>
+            class ParserImpl;
+
+            // Both serveFile overloads, request is null for the one without
+            Async::Promise<PST_SSIZE_T>
+            serveFile(ResponseWriter& writer, const Request* request,
+                      const std::string& fileName, const Mime::MediaType& contentType);
+
+            class ResponseSlot;
+
+            // Responses to the requests pipelined on a connection go out in
+            // the order of the requests. Each request takes a slot, shared by
+            // whatever may still write its response (its writer, stream, or
+            // file being served): the writes of a slot are held back until
+            // the slots before it are all released. A slot is released once
+            // its response's last write is queued, or else when it is
+            // destroyed
+            class ResponseQueue : public std::enable_shared_from_this<ResponseQueue>
+            {
+            public:
+                using Write = std::function<Async::Promise<PST_SSIZE_T>()>;
+
+                // For the next request, in the order they are read
+                std::shared_ptr<ResponseSlot> next();
+
+            private:
+                friend class ResponseSlot;
+
+                struct Held
+                {
+                    Write write;
+                    std::shared_ptr<Async::Deferred<PST_SSIZE_T>> deferred;
+                };
+
+                Async::Promise<PST_SSIZE_T> hold(uint64_t id, Write write);
+                void release(uint64_t id);
+
+                std::mutex lock;
+                uint64_t nextId  = 0; // of the next slot
+                uint64_t current = 0; // whose writes go out as they come
+                std::map<uint64_t, std::vector<Held>> held;
+                std::set<uint64_t> released; // after current
+            };
+
+            class ResponseSlot
+            {
+            public:
+                ResponseSlot(std::shared_ptr<ResponseQueue> queue, uint64_t id)
+                    : queue_(std::move(queue))
+                    , id_(id)
+                { }
+
+                ResponseSlot(const ResponseSlot&)            = delete;
+                ResponseSlot& operator=(const ResponseSlot&) = delete;
+
+                ~ResponseSlot() { release(); }
+
+                // Lets the responses after this one go out
+                void release()
+                {
+                    if (!released_.exchange(true))
+                        queue_->release(id_);
+                }
+
+                // Calls write, a Transport::asyncWrite, now if it is this
+                // slot's turn (or past it, for a write after the release),
+                // or else once it is
+                template <typename Write>
+                Async::Promise<PST_SSIZE_T> write(Write&& write)
+                {
+                    std::lock_guard<std::mutex> guard(queue_->lock);
+                    if (id_ <= queue_->current)
+                        return write();
+
+                    return queue_->hold(id_, ResponseQueue::Write(std::forward<Write>(write)));
+                }
+
+            private:
+                std::shared_ptr<ResponseQueue> queue_;
+                uint64_t id_;
+                std::atomic<bool> released_ { false };
+            };
         } // namespace Private
 
         template <class CharT, class Traits>
@@ -128,6 +221,10 @@ namespace Pistache
             Header::Collection& headers();
 
         protected:
+            // As if newly constructed, but keeping the memory already
+            // allocated, for the next message of a connection
+            void clear();
+
             Version version_ = Version::Http11;
             Code code_;
 
@@ -196,6 +293,8 @@ namespace Pistache
         {
         public:
             friend class Private::RequestLineStep;
+            friend class Private::ParserImpl<Request>;
+            friend class Handler;
 
             friend class Experimental::RequestBuilder;
 
@@ -230,6 +329,9 @@ namespace Pistache
 
             std::chrono::milliseconds timeout() const;
 
+            // Null unless the request is traced, see trace.h
+            const std::shared_ptr<Trace::Span>& span() const { return span_; }
+
             /*
              * Returns the "best" encoding to use to encode (typically compress)
              * a response to the current request. The "best" encoding is the one
@@ -241,6 +343,8 @@ namespace Pistache
             Header::Encoding getBestAcceptEncoding() const;
 
         private:
+            void clear();
+
 #ifdef LIBSTDCPP_SMARTPTR_LOCK_FIXME
             void associatePeer(const std::shared_ptr<Tcp::Peer>& peer)
             {
@@ -260,6 +364,7 @@ namespace Pistache
 #endif
             Address address_;
             std::chrono::milliseconds timeout_ = std::chrono::milliseconds(0);
+            std::shared_ptr<Trace::Span> span_;
         };
 
         class Handler;
@@ -274,12 +379,12 @@ namespace Pistache
                 : handler(other.handler)
                 , transport(other.transport)
                 , armed(other.armed)
-                , timerFd(other.timerFd)
+                , timerId(other.timerId)
                 , peer(std::move(other.peer))
+                , slot(std::move(other.slot))
             {
                 // cppcheck-suppress useInitializationList
-                other.timerFd = PS_FD_EMPTY;
-                // For libevent, don't need to free, passed to this->timerFd
+                other.timerId = Tcp::Transport::TimerId();
             }
 
             Timeout& operator=(Timeout&& other)
@@ -288,12 +393,12 @@ namespace Pistache
                 transport = other.transport;
                 version   = other.version;
                 armed     = other.armed;
-                timerFd   = other.timerFd;
+                timerId   = other.timerId;
 
-                other.timerFd = PS_FD_EMPTY;
-                // For libevent, don't need to free, passed to this->timerFd
+                other.timerId = Tcp::Transport::TimerId();
 
                 peer = std::move(other.peer);
+                slot = std::move(other.slot);
                 return *this;
             }
 
@@ -302,31 +407,16 @@ namespace Pistache
             template <typename Duration>
             void arm(Duration duration)
             {
+                // Served by the transport's timer wheel, no fd of its own
                 Async::Promise<uint64_t> p([duration, this](Async::Deferred<uint64_t> deferred) {
-#ifdef _USE_LIBEVENT
-                    std::shared_ptr<EventMethEpollEquiv>
-                        event_meth_epoll_equiv(
-                            transport->getEventMethEpollEquiv());
-                    if (!event_meth_epoll_equiv)
-                        throw std::runtime_error(
-                            "event_meth_epoll_equiv null");
-
-                    timerFd = TRY_NULL_RET(EventMethFns::em_timer_new(
-                        PST_CLOCK_MONOTONIC,
-                        F_SETFDL_NOTHING, PST_O_NONBLOCK,
-                        event_meth_epoll_equiv.get()));
-#else
-                    timerFd = TRY_RET(timerfd_create(PST_CLOCK_MONOTONIC, TFD_NONBLOCK));
-#endif
-                    transport->armTimer(timerFd, duration, std::move(deferred));
+                    timerId = transport->armTimer(duration, std::move(deferred));
                 });
 
                 p.then(
                     [this](uint64_t numWakeup) {
                         this->armed = false;
+                        this->timerId = Tcp::Transport::TimerId();
                         this->onTimeout(numWakeup);
-                        CLOSE_FD(timerFd);
-                        timerFd = PS_FD_EMPTY;
                     },
                     [](std::exception_ptr exc) { std::rethrow_exception(exc); });
 
@@ -349,8 +439,10 @@ namespace Pistache
             Http::Version version;
             Tcp::Transport* transport;
             bool armed;
-            Fd timerFd;
+            Tcp::Transport::TimerId timerId;
             std::weak_ptr<Tcp::Peer> peer;
+            // Of the response timed out, whose turn the timeout response takes
+            std::weak_ptr<Private::ResponseSlot> slot;
         };
 
         class ResponseStream final
@@ -367,21 +459,37 @@ namespace Pistache
 
             std::streamsize write(const char* data, std::streamsize sz);
 
+            // With compression, write() only feeds the encoder, and every
+            // flush() sends what it output so far as one chunk
             void flush();
             void ends();
 
+            bool compressed() const { return static_cast<bool>(compressor_); }
+
         private:
             ResponseStream(Message&& other, std::weak_ptr<Tcp::Peer> peer,
                            Tcp::Transport* transport, Timeout timeout, size_t streamSize,
-                           size_t maxResponseSize);
+                           size_t maxResponseSize,
+                           CompressorPool::Handle compressor = nullptr);
 
             std::shared_ptr<Tcp::Peer> peer() const;
 
+            void writeChunk(const char* data, size_t size);
+
+            // Queues what is buffered
+            Async::Promise<PST_SSIZE_T> send();
+
             Message response_;
             std::weak_ptr<Tcp::Peer> peer_;
             DynamicStreamBuf buf_;
             Tcp::Transport* transport_;
             Timeout timeout_;
+
+            CompressorPool::Handle compressor_;
+            std::string compressed_; // not sent yet
+
+            std::shared_ptr<Private::ResponseSlot> slot_;
+            std::shared_ptr<Trace::Span> span_;
         };
 
         inline ResponseStream& ends(ResponseStream& stream)
@@ -399,6 +507,15 @@ namespace Pistache
         template <typename T>
         ResponseStream& operator<<(ResponseStream& stream, const T& val)
         {
+            if (stream.compressed())
+            {
+                std::ostringstream oss;
+                oss << val;
+                const auto str = oss.str();
+                stream.write(str.data(), static_cast<std::streamsize>(str.size()));
+                return stream;
+            }
+
             Size<T> size;
 
             std::ostream os(&stream.buf_);
@@ -436,7 +553,8 @@ namespace Pistache
             static constexpr size_t DefaultStreamSize = 512;
 
             friend Async::Promise<PST_SSIZE_T>
-            serveFile(ResponseWriter&, const std::string&, const Mime::MediaType&);
+            Private::serveFile(ResponseWriter&, const Request*, const std::string&,
+                               const Mime::MediaType&);
 
             friend class Handler;
             friend class Timeout;
@@ -481,6 +599,15 @@ namespace Pistache
             Async::Promise<PST_SSIZE_T> send(Code code, const char* data, const size_t size,
                                              const Mime::MediaType& mime = Mime::MediaType());
 
+            // The body is not copied behind the headers: it is moved in, or
+            // shared with whoever else holds it (e.g. a cache), and sent
+            // along with them with a single writev
+            Async::Promise<PST_SSIZE_T> send(Code code, std::string&& body,
+                                             const Mime::MediaType& mime = Mime::MediaType());
+
+            Async::Promise<PST_SSIZE_T> send(Code code, std::shared_ptr<const std::string> body,
+                                             const Mime::MediaType& mime = Mime::MediaType());
+
             ResponseStream stream(Code code, size_t streamSize = DefaultStreamSize);
 
             template <typename Duration>
@@ -526,6 +653,23 @@ namespace Pistache
             //  automatically set to the requested encoding, if supported...
             void setCompression(const Pistache::Http::Header::Encoding _contentEncoding);
 
+            // Bodies passed to send() smaller than this are sent
+            //  uncompressed. Defaults to 0, i.e. compress everything.
+            //  Streams are always compressed, their size is not known...
+            void setCompressionMinSize(const size_t minSize)
+            {
+                compressionMinSize_ = minSize;
+            }
+
+            // Look bodies passed to send() up in CompressedCache::instance()
+            //  by their contents, and only compress them when not found.
+            //  Worth it for bodies sent over and over, e.g. at the highest
+            //  compression levels...
+            void setCompressionCache(const bool cached)
+            {
+                compressionCached_ = cached;
+            }
+
 #ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
             // Set the compression level for Brotli algorithm. Defaults to
             //  BROTLI_DEFAULT_QUALITY...
@@ -560,7 +704,21 @@ namespace Pistache
                                                  const size_t size,
                                                  const Mime::MediaType& mime);
 
-            Async::Promise<PST_SSIZE_T> putOnWire(const char* data, size_t len);
+            // Sets the code and content type, true if a body of size is to
+            // be compressed
+            bool prepareSend(Code code, size_t size, const Mime::MediaType& mime);
+
+            Async::Promise<PST_SSIZE_T> sendCompressed(const char* data, size_t size);
+
+            // The status line and headers, then data, copied behind them
+            // when small enough, then the pieces of body
+            Async::Promise<PST_SSIZE_T> putOnWire(const char* data, size_t len,
+                                                  GatherBuffer body = GatherBuffer());
+
+            void setSlot(std::shared_ptr<Private::ResponseSlot> slot);
+
+            // Into Metrics::local(), as the response is handed over
+            void countResponse(Code code) const;
 
             Response response_;
             std::weak_ptr<Tcp::Peer> peer_;
@@ -569,7 +727,20 @@ namespace Pistache
             Timeout timeout_;
             PST_SSIZE_T sent_bytes_ = 0;
 
+            // Null unless the response is to a request read by a Handler
+            std::shared_ptr<Private::ResponseSlot> slot_;
+
+            // When the request was parsed, or the writer made otherwise
+            std::chrono::steady_clock::time_point created_ = std::chrono::steady_clock::now();
+
+            // The request's, null unless it is traced
+            std::shared_ptr<Trace::Span> span_;
+
+            int compressionLevel() const;
+
             Http::Header::Encoding contentEncoding_ = Http::Header::Encoding::Identity;
+            size_t compressionMinSize_              = 0;
+            bool compressionCached_                 = false;
 
 #ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
             int contentEncodingBrotliLevel_ = BROTLI_DEFAULT_QUALITY;
@@ -586,16 +757,30 @@ namespace Pistache
 #endif
         };
 
+        // Sends the whole file, with a 200. The file is opened and stat'ed
+        // through FileCache::instance(), see file_cache.h
         Async::Promise<PST_SSIZE_T>
         serveFile(ResponseWriter& writer, const std::string& fileName,
                   const Mime::MediaType& contentType = Mime::MediaType());
 
+        // Same, but honouring the request's conditional and Range headers
+        // (RFC 9110 13 and 14): answers 304 when If-None-Match or
+        // If-Modified-Since matches the file's ETag or Last-Modified, and
+        // 206 with the requested ranges (as multipart/byteranges when there
+        // are several of them), or 416 when none can be satisfied, for a
+        // GET with a Range whose If-Range, if any, still holds
+        Async::Promise<PST_SSIZE_T>
+        serveFile(ResponseWriter& writer, const Request& request,
+                  const std::string& fileName,
+                  const Mime::MediaType& contentType = Mime::MediaType());
+
         namespace Private
         {
 
             enum class State { Again,
                                Next,
-                               Done };
+                               Done,
+                               Paused }; // by a BodyConsumer, until parse() is called again
             using StepId = uint64_t;
 
             struct Step
@@ -607,6 +792,9 @@ namespace Pistache
                 virtual StepId id() const                 = 0;
                 virtual State apply(StreamCursor& cursor) = 0;
 
+                // Forgets what was kept of a partial input, for a new message
+                virtual void reset() { }
+
                 [[noreturn]] static void raise(const char* msg, Code code = Code::Bad_Request);
 
             protected:
@@ -624,6 +812,11 @@ namespace Pistache
 
                 StepId id() const override { return Id; }
                 State apply(StreamCursor& cursor) override;
+                void reset() override;
+
+            private:
+                // How much of the line is known not to end yet
+                size_t scanned = 0;
             };
 
             class ResponseLineStep : public Step
@@ -637,6 +830,11 @@ namespace Pistache
 
                 StepId id() const override { return Id; }
                 State apply(StreamCursor& cursor) override;
+                void reset() override;
+
+            private:
+                // How much of the line is known not to end yet
+                size_t scanned = 0;
             };
 
             class HeadersStep : public Step
@@ -650,6 +848,30 @@ namespace Pistache
 
                 StepId id() const override { return Id; }
                 State apply(StreamCursor& cursor) override;
+                void reset() override;
+
+            private:
+                static constexpr size_t NoColon = static_cast<size_t>(-1);
+
+                // How much of the current header line was searched, and where
+                // its colon is once found
+                size_t scanned     = 0;
+                size_t colonOffset = NoColon;
+            };
+
+            // Takes the bodies a parser is to stream as they arrive, rather
+            // than keep them in their message
+            class BodyConsumer
+            {
+            public:
+                virtual ~BodyConsumer() = default;
+
+                // Once the headers of a message with a body are parsed
+                virtual bool streams(const Message& message) = 0;
+
+                // Each part of a streamed body, in order. False to have the
+                // parser pause after this part
+                virtual bool onBody(const char* data, size_t size) = 0;
             };
 
             class BodyStep : public Step
@@ -657,14 +879,23 @@ namespace Pistache
             public:
                 static constexpr auto Id = Meta::Hash::fnv1a("Body");
 
-                explicit BodyStep(Message* message_)
+                // A body that is not streamed must fit in maxSize
+                BodyStep(Message* message_, size_t maxSize)
                     : Step(message_)
-                    , chunk(message_)
+                    , chunk(this)
                     , bytesRead(0)
+                    , maxSize_(maxSize)
                 { }
 
                 StepId id() const override { return Id; }
                 State apply(StreamCursor& cursor) override;
+                void reset() override;
+
+                void setConsumer(BodyConsumer* consumer_) { consumer = consumer_; }
+
+                // Whether the body of the message being parsed goes to the
+                // consumer
+                bool streaming() const { return streaming_; }
 
             private:
                 struct Chunk
@@ -673,8 +904,8 @@ namespace Pistache
                                   Incomplete,
                                   Final };
 
-                    explicit Chunk(Message* message_)
-                        : message(message_)
+                    explicit Chunk(BodyStep* step_)
+                        : step(step_)
                         , bytesRead(0)
                         , size(-1)
                     { }
@@ -685,13 +916,16 @@ namespace Pistache
                     {
                         bytesRead = 0;
                         size      = -1;
+                        scanned   = 0;
                     }
 
                 private:
-                    Message* message;
+                    BodyStep* step;
                     size_t bytesRead;
                     PST_SSIZE_T size;
                     PST_SSIZE_T alreadyAppendedChunkBytes;
+                    // How much of the size line is known not to end yet
+                    size_t scanned = 0;
                 };
 
                 State parseContentLength(StreamCursor& cursor,
@@ -700,8 +934,17 @@ namespace Pistache
                 parseTransferEncoding(StreamCursor& cursor,
                                       const std::shared_ptr<Header::TransferEncoding>& te);
 
+                // To the message's body, or the consumer's
+                void append(const char* data, size_t size);
+
                 Chunk chunk;
                 size_t bytesRead;
+                size_t maxSize_;
+
+                BodyConsumer* consumer = nullptr;
+                bool started           = false; // whether the body is known to stream or not
+                bool streaming_        = false;
+                bool paused            = false; // by the consumer, after the last part
             };
 
             class ParserBase
@@ -719,18 +962,36 @@ namespace Pistache
                 virtual ~ParserBase() = default;
 
                 bool feed(const char* data, size_t len);
+                // Like feed(), but parses data where it is when no earlier
+                // input is left, copying in only what parse() leaves of it.
+                // data must outlive the parse() calls until one returns
+                // other than Done
+                bool borrow(const char* data, size_t len);
                 virtual void reset();
                 State parse();
 
                 Step* step();
 
+                // Bodies of the messages to come may be streamed to consumer,
+                // if it so decides, rather than kept whole. Only what is not
+                // yet parsed of them is then buffered, so only that counts
+                // towards the maximum size
+                void setBodyConsumer(std::unique_ptr<BodyConsumer> consumer);
+
             protected:
+                // Gets ready for the next message, keeping the bytes already
+                // received after this one
+                void resetKeepingInput();
+
                 std::array<std::unique_ptr<Step>, StepsCount> allSteps;
                 size_t currentStep = 0;
 
             private:
+                BodyStep* bodyStep() const;
+
                 ArrayStreamBuf<char> buffer;
                 StreamCursor cursor;
+                std::unique_ptr<BodyConsumer> bodyConsumer;
             };
 
             template <typename Message>
@@ -744,11 +1005,19 @@ namespace Pistache
 
                 void reset() override;
 
+                // For the request pipelined after this one, if any: unlike
+                // reset(), keeps what was received of it
+                void next();
+
                 std::chrono::steady_clock::time_point time() const
                 {
                     return time_;
                 }
 
+                // The body timeout being counted from time(), for a body
+                // streamed as it comes, since the last part of it
+                void touch() { time_ = std::chrono::steady_clock::now(); }
+
                 Request request;
 
             private:
@@ -773,12 +1042,31 @@ namespace Pistache
         class Handler : public Tcp::Handler
         {
         public:
-            static constexpr const char* ParserData = "__Parser";
+            static constexpr const char* ParserData    = "__Parser";
+            static constexpr const char* ResponsesData = "__Responses";
 
             virtual void onRequest(const Request& request, ResponseWriter response) = 0;
 
+            // What the transport calls, with a request it has no more use
+            // for: a handler that keeps the request can take it rather than
+            // copy it. Calls onRequest by default
+            virtual void takeRequest(Request&& request, ResponseWriter response);
+
             virtual void onTimeout(const Request& request, ResponseWriter response);
 
+            // For uploads too large to be held in memory: asked once the
+            // headers of a request with a body are parsed, whether the body
+            // is to be passed to onBody part by part as it arrives rather than
+            // read into request.body(). onRequest then follows the last part,
+            // and only each part, not the whole body, is limited by the
+            // maximum request size. No, by default
+            virtual bool streamBody(const Request& request);
+
+            // A part of a streamed body. Nothing more is read from the peer
+            // until the promise returned is settled
+            virtual Async::Promise<void> onBody(const Request& request,
+                                                const char* data, size_t size);
+
             void setMaxRequestSize(size_t value);
             size_t getMaxRequestSize() const;
             void setMaxResponseSize(size_t value);
@@ -814,6 +1102,7 @@ namespace Pistache
             void onConnection(const std::shared_ptr<Tcp::Peer>& peer) override;
             void onInput(const char* buffer, size_t len,
                          const std::shared_ptr<Tcp::Peer>& peer) override;
+            void onReadResumed(const std::shared_ptr<Tcp::Peer>& peer) override;
 
         private:
             size_t maxRequestSize_  = Const::DefaultMaxRequestSize;
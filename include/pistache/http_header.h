@@ -777,6 +777,9 @@ namespace Pistache::Http::Header
 
 #define CUSTOM_HEADER(header_name) PISTACHE_CUSTOM_HEADER(header_name, #header_name)
 
+    // Only ever sent, so not registered
+    PISTACHE_CUSTOM_HEADER(Vary, "Vary")
+
     class Raw
     {
     public:
@@ -13,12 +13,17 @@
 #pragma once
 
 #include <algorithm>
+#include <cctype>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 #include <pistache/http_header.h>
+#include <pistache/small_vector.h>
 #include <pistache/type_checkers.h>
 
 namespace Pistache::Http::Header
@@ -44,14 +49,20 @@ namespace Pistache::Http::Header
 
     struct LowercaseHash
     {
+        // FNV-1a over the lowercased bytes, not to copy the key
         size_t operator()(const std::string& key) const
         {
-            return std::hash<std::string> {}(toLowercase(key));
+            uint64_t hash = 14695981039346656037ull;
+            for (char c : key)
+            {
+                hash ^= static_cast<unsigned char>(std::tolower(static_cast<unsigned char>(c)));
+                hash *= 1099511628211ull;
+            }
+            return static_cast<size_t>(hash);
         }
     };
 
-    bool LowercaseEqualStatic(const std::string& dynamic,
-                              const std::string& statik);
+    bool LowercaseEqualStatic(std::string_view dynamic, std::string_view statik);
 
     struct LowercaseEqual
     {
@@ -64,42 +75,58 @@ namespace Pistache::Http::Header
         };
     };
 
+    /*
+     * Headers received by a parser are kept as they came, in a single copy of
+     * their text, until asked for: a typed header is only parsed on its first
+     * get() or tryGet(), and memoized. That is done under the collection's
+     * lock, so that it can still be read from several threads at once.
+     */
     class Collection
     {
     public:
         Collection()
             : headers()
             , rawHeaders()
+            , received()
+            , fields()
         { }
 
+        Collection(const Collection& other);
+        Collection& operator=(const Collection& other);
+        Collection(Collection&& other) noexcept;
+        Collection& operator=(Collection&& other) noexcept;
+
         template <typename H>
         typename std::enable_if<IsHeader<H>::value, std::shared_ptr<const H>>::type
         get() const
         {
-            return std::static_pointer_cast<const H>(get(H::Name));
+            return std::static_pointer_cast<const H>(get(nameOf<H>()));
         }
         template <typename H>
         typename std::enable_if<IsHeader<H>::value, std::shared_ptr<H>>::type get()
         {
-            return std::static_pointer_cast<H>(get(H::Name));
+            return std::static_pointer_cast<H>(get(nameOf<H>()));
         }
 
         template <typename H>
         typename std::enable_if<IsHeader<H>::value, std::shared_ptr<const H>>::type
         tryGet() const
         {
-            return std::static_pointer_cast<const H>(tryGet(H::Name));
+            return std::static_pointer_cast<const H>(tryGet(nameOf<H>()));
         }
         template <typename H>
         typename std::enable_if<IsHeader<H>::value, std::shared_ptr<H>>::type
         tryGet()
         {
-            return std::static_pointer_cast<H>(tryGet(H::Name));
+            return std::static_pointer_cast<H>(tryGet(nameOf<H>()));
         }
 
         Collection& add(const std::shared_ptr<Header>& header);
         Collection& addRaw(const Raw& raw);
 
+        // Adds a header as received from a peer, to be parsed on demand
+        Collection& addReceived(std::string_view name, std::string_view value);
+
         template <typename H, typename... Args>
         typename std::enable_if<IsHeader<H>::value, Collection&>::type
         add(Args&&... args)
@@ -110,7 +137,7 @@ namespace Pistache::Http::Header
         template <typename H>
         typename std::enable_if<IsHeader<H>::value, bool>::type remove()
         {
-            return remove(H::Name);
+            return remove(nameOf<H>());
         }
 
         std::shared_ptr<const Header> get(const std::string& name) const;
@@ -124,7 +151,7 @@ namespace Pistache::Http::Header
         template <typename H>
         typename std::enable_if<IsHeader<H>::value, bool>::type has() const
         {
-            return has(H::Name);
+            return has(nameOf<H>());
         }
         bool has(const std::string& name) const;
 
@@ -133,6 +160,8 @@ namespace Pistache::Http::Header
         const std::unordered_map<std::string, Raw, LowercaseHash, LowercaseEqual>&
         rawList() const
         {
+            std::lock_guard<std::mutex> guard(lock);
+            foldRaw();
             return rawHeaders;
         }
 
@@ -141,14 +170,54 @@ namespace Pistache::Http::Header
         void clear();
 
     private:
+        // A received header, as offsets into received so that copies of the
+        // collection stay valid
+        struct Field
+        {
+            uint32_t nameOffset;
+            uint32_t nameSize;
+            uint32_t valueOffset;
+            uint32_t valueSize;
+        };
+
         std::pair<bool, std::shared_ptr<Header>>
         getImpl(const std::string& name) const;
+        std::pair<bool, std::shared_ptr<Header>>
+        findOrParse(const std::string& name) const;
 
-        std::unordered_map<std::string, std::shared_ptr<Header>, LowercaseHash,
-                           LowercaseEqual>
+        // Made once: most names are too long for the small string buffer,
+        // and looked up for every request
+        template <typename H>
+        static const std::string& nameOf()
+        {
+            static const std::string name(H::Name);
+            return name;
+        }
+
+        std::string_view fieldName(const Field& field) const;
+        std::string_view fieldValue(const Field& field) const;
+        const Field* findField(const std::string& name) const;
+        static bool isTyped(std::string_view name);
+
+        // Move received headers to the maps, raw ones or typed ones. Under
+        // lock, unless the collection is being changed
+        void foldRaw() const;
+        void foldTyped() const;
+        // Before any change, for the received headers to keep their priority
+        void materialize();
+
+        mutable std::unordered_map<std::string, std::shared_ptr<Header>, LowercaseHash,
+                                   LowercaseEqual>
             headers;
-        std::unordered_map<std::string, Raw, LowercaseHash, LowercaseEqual>
+        mutable std::unordered_map<std::string, Raw, LowercaseHash, LowercaseEqual>
             rawHeaders;
+
+        std::string received;
+        SmallVector<Field, 16> fields;
+        mutable bool rawFolded = false;
+
+        // Over what const methods change: the maps, and rawFolded
+        mutable std::mutex lock;
     };
 
     class Registry
@@ -70,6 +70,25 @@ namespace Pistache::Tcp
         void setTransportFactory(TransportFactory factory);
         void setHandler(const std::shared_ptr<Handler>& handler);
 
+        // What the workers poll their connections with; the listening
+        // socket itself is always polled with epoll
+        void setPollBackend(Polling::Backend backend);
+
+        // Rather than one listening socket, whose connections the
+        // listener's thread accepts and hands over to the workers, each
+        // worker gets a socket of its own on the same address, with
+        // SO_REUSEPORT, and accepts from it in its own reactor loop. The
+        // kernel spreads the connections over the sockets. Only for TCP on
+        // platforms with SO_REUSEPORT, ignored otherwise. To take effect,
+        // call before bind()
+        void setPerWorkerListeners(bool enable);
+
+        // An eBPF program (BPF_PROG_TYPE_SK_REUSEPORT, loaded by the
+        // caller) to pick the socket of each new connection instead of the
+        // kernel's hash, in per-worker mode on Linux. The sockets are in
+        // the order of the workers. -1, the default, is for none
+        void setReusePortProgram(int bpfProgramFd);
+
         void bind();
         void bind(const Address& address);
 
@@ -107,6 +126,15 @@ namespace Pistache::Tcp
 
         size_t workers_ = Const::DefaultWorkers;
         std::string workersName_;
+        Polling::Backend pollBackend_ = Polling::Backend::Epoll;
+
+        bool perWorkerListeners_ = false;
+        int reusePortProgram_    = -1;
+
+        // Of the workers other than the first, which accepts on listen_fd;
+        // set when they do accept
+        bool workersAccept_ = false;
+        std::vector<Fd> workerListenFds_;
         std::shared_ptr<Handler> handler_;
 
         std::shared_ptr<Aio::Reactor> reactor_;
@@ -119,7 +147,15 @@ namespace Pistache::Tcp
         bool bindListener(const struct addrinfo* addr);
 
         void handleNewConnection();
-        em_socket_t acceptConnection(struct sockaddr_storage& peer_addr) const;
+
+        // nullptr if there was no connection to accept after all
+        std::shared_ptr<Peer> acceptPeer(Fd listenFd);
+        em_socket_t acceptConnection(Fd listenFd,
+                                     struct sockaddr_storage& peer_addr) const;
+
+        bool acceptsPerWorker(int family) const;
+        void acceptInWorkers(const struct addrinfo* addr, int socktype,
+                             em_socket_t first);
         void dispatchPeer(const std::shared_ptr<Peer>& peer);
 
 #ifdef _IS_WINDOWS
@@ -0,0 +1,166 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* metrics.h
+
+   Runtime counters and histograms, kept by each thread in a block of its
+   own that only it writes, so that counting costs no locked instruction.
+   They are collected by the transports (connections, bytes, writes), by
+   Http::Handler (requests, responses, parse errors, timeouts) and by
+   Rest::Router (requests no route matched).
+
+   Metrics::workers() reads the blocks of the threads alive, total() adds
+   up every thread's, those gone included, and prometheus() formats the
+   totals in the Prometheus text format, see also Rest::Routes::Prometheus.
+*/
+
+#pragma once
+
+#include <pistache/http_defs.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Pistache::Metrics
+{
+
+    constexpr size_t MethodCount = 0
+#define METHOD(m, _) +1
+        HTTP_METHODS
+#undef METHOD
+        ;
+
+    // 1xx to 5xx
+    constexpr size_t CodeClassCount = 5;
+
+    // Written by one thread only, read by any
+    class Counter
+    {
+    public:
+        Counter() = default;
+        Counter(const Counter& other) { *this = other; }
+        Counter& operator=(const Counter& other)
+        {
+            value_.store(other.value(), std::memory_order_relaxed);
+            return *this;
+        }
+
+        void add(uint64_t n = 1)
+        {
+            value_.store(value_.load(std::memory_order_relaxed) + n,
+                         std::memory_order_relaxed);
+        }
+
+        uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> value_ { 0 };
+    };
+
+    // Log-linear, as HDR histograms are: each power of two is split in
+    // 2^SubBucketBits buckets, values being known within about 12%
+    class Histogram
+    {
+    public:
+        static constexpr unsigned SubBucketBits = 3;
+        static constexpr size_t SubBuckets      = size_t(1) << SubBucketBits;
+        static constexpr size_t BucketCount     = (64 - SubBucketBits + 1) * SubBuckets;
+
+        Histogram() = default;
+        Histogram(const Histogram& other) { *this = other; }
+        Histogram& operator=(const Histogram& other);
+
+        void record(uint64_t value);
+
+        // Adds other's values to this one, which only the calling thread
+        // may be writing
+        void merge(const Histogram& other);
+
+        uint64_t count() const { return count_.value(); }
+        uint64_t sum() const { return sum_.value(); }
+        uint64_t max() const { return max_.value(); }
+
+        // How many of the values recorded are below bound, a power of two
+        uint64_t countBelow(uint64_t bound) const;
+
+        // The upper bound of the bucket the q-th quantile (0 to 1) falls in
+        uint64_t quantile(double q) const;
+
+        static size_t bucketOf(uint64_t value);
+        static uint64_t lowerBound(size_t bucket);
+
+    private:
+        std::array<Counter, BucketCount> buckets_;
+        Counter count_;
+        Counter sum_;
+        Counter max_;
+    };
+
+    struct alignas(64) Values
+    {
+        Counter connectionsAccepted;
+        Counter connectionsClosed;
+        Counter bytesIn;
+        Counter bytesOut;
+        Counter parseErrors;
+        Counter timeouts;
+
+        // Writes the socket could not take at once
+        Counter writesWouldBlock;
+
+        Counter routesNotFound;
+        Counter routesNotAllowed;
+
+        std::array<Counter, MethodCount> requests;
+        std::array<Counter, CodeClassCount> responses;
+
+        // From the request being parsed to its response being handed to
+        // the transport, in microseconds
+        Histogram requestLatency;
+
+        // Writes queued for a peer, counting the one just queued
+        Histogram writeQueueDepth;
+
+        uint64_t activePeers() const;
+
+        Counter& requestsFor(Http::Method method) { return requests[static_cast<size_t>(method)]; }
+        Counter& responsesFor(Http::Code code);
+
+        void merge(const Values& other);
+    };
+
+    struct Worker
+    {
+        std::thread::id thread;
+        Values values;
+    };
+
+    // The calling thread's values, for it to count into
+    Values& local();
+
+    // A copy of the values of each thread alive that counted anything
+    std::vector<Worker> workers();
+
+    // Every thread's values added up, those of the threads gone included
+    Values total();
+
+    // total() in the Prometheus text exposition format
+    std::string prometheus();
+
+    inline uint64_t microsecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                         std::chrono::steady_clock::now() - start)
+                                         .count());
+    }
+
+} // namespace Pistache::Metrics
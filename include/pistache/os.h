@@ -73,7 +73,11 @@ namespace Pistache
             Read     = 1,
             Write    = Read << 1,
             Hangup   = Read << 2,
-            Shutdown = Read << 3
+            Shutdown = Read << 3,
+
+            // Pending on the socket's error queue, e.g. the completions
+            // of MSG_ZEROCOPY sends. Always reported, asked for or not
+            Error = Read << 4
         };
 
         DECLARE_FLAGS_OPERATORS(NotifyOn)
@@ -125,6 +129,17 @@ namespace Pistache
             return lhs.value_ == rhs.value_;
         }
 
+        // What an Epoll polls with. IoUring arms io_uring poll requests
+        // instead of registering with epoll, on Linux 5.13 and later: the
+        // changes of interest made while handling events are then queued,
+        // and submitted along with the next wait rather than costing an
+        // epoll_ctl each. Where io_uring is missing or disabled, it falls
+        // back to epoll
+        enum class Backend { Epoll,
+                             IoUring };
+
+        class Uring;
+
         struct Event
         {
             explicit Event(Tag _tag);
@@ -136,9 +151,12 @@ namespace Pistache
         class Epoll
         {
         public:
-            Epoll();
+            explicit Epoll(Backend backend = Backend::Epoll);
             ~Epoll();
 
+            // What this poller ended up polling with
+            Backend backend() const;
+
             void addFd(Fd fd, Flags<NotifyOn> interest, Tag tag,
                        [[maybe_unused]] Mode mode = Mode::Level);
             void addFdOneShot(Fd fd, Flags<NotifyOn> interest, Tag tag,
@@ -201,6 +219,8 @@ namespace Pistache
 
         private:
 #ifndef _USE_LIBEVENT
+            friend class Uring;
+
             static int toEpollEvents(const Flags<NotifyOn>& interest);
             static Flags<NotifyOn> toNotifyOn(int events);
 #endif
@@ -210,6 +230,9 @@ namespace Pistache
 #else
             Fd epoll_fd;
 #endif
+
+            // Set when polling with io_uring, epoll_fd being closed then
+            std::unique_ptr<Uring> uring_;
         };
 
     } // namespace Polling
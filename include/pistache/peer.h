@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -33,11 +34,13 @@ namespace Pistache::Tcp
 {
 
     class Transport;
+    class Listener;
 
     class Peer
     {
     public:
         friend class Transport;
+        friend class Listener;
         friend class Http::Handler;
         friend class Http::Timeout;
 
@@ -94,6 +97,21 @@ namespace Pistache::Tcp
         void* ssl_ = nullptr;
         const size_t id_;
         bool isIdle_ = false;
+
+        // While the handler has reading paused (Transport::pauseReading).
+        // Only ever accessed from the transport's thread
+        bool readPaused_ = false;
+
+        // Set by the Listener when the TLS handshake has yet to be done; the
+        // Transport drives it to completion (or drops the peer once
+        // sslHandshakeDeadline_ has passed) before the peer is handed to
+        // the Tcp::Handler
+        bool sslHandshakePending_ = false;
+        std::chrono::steady_clock::time_point sslHandshakeDeadline_ = std::chrono::steady_clock::time_point::max();
+
+        // When the peer was accepted (Trace::now()), while tracing is on and
+        // until its first request is read
+        uint64_t acceptedAt_ = 0;
     };
 
     std::ostream& operator<<(std::ostream& os, Peer& peer);
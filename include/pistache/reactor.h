@@ -36,14 +36,6 @@ namespace Pistache::Aio
     public:
         FdSet() = delete;
 
-        explicit FdSet(std::vector<Polling::Event>&& events)
-            : events_()
-        {
-            events_.reserve(events.size());
-            events_.insert(events_.end(), std::make_move_iterator(events.begin()),
-                           std::make_move_iterator(events.end()));
-        }
-
         struct Entry : private Polling::Event
         {
             Entry(Polling::Event&& event)
@@ -53,10 +45,28 @@ namespace Pistache::Aio
             bool isReadable() const { return flags.hasFlag(Polling::NotifyOn::Read); }
             bool isWritable() const { return flags.hasFlag(Polling::NotifyOn::Write); }
             bool isHangup() const { return flags.hasFlag(Polling::NotifyOn::Hangup); }
+            bool isError() const { return flags.hasFlag(Polling::NotifyOn::Error); }
 
             Polling::Tag getTag() const { return this->tag; }
         };
 
+        explicit FdSet(std::vector<Polling::Event>&& events)
+            : FdSet(std::move(events), std::vector<Entry>())
+        { }
+
+        // In storage, a previous set's given back by release(), so that
+        // polling over and over does not allocate every time
+        FdSet(std::vector<Polling::Event>&& events, std::vector<Entry>&& storage)
+            : events_(std::move(storage))
+        {
+            events_.clear();
+            events_.reserve(events.size());
+            events_.insert(events_.end(), std::make_move_iterator(events.begin()),
+                           std::make_move_iterator(events.end()));
+        }
+
+        std::vector<Entry> release() && { return std::move(events_); }
+
         using iterator       = std::vector<Entry>::iterator;
         using const_iterator = std::vector<Entry>::const_iterator;
 
@@ -155,19 +165,31 @@ namespace Pistache::Aio
         virtual Reactor::Impl* makeImpl(Reactor* reactor) const = 0;
     };
 
+    // The backend of a context is what its pollers poll with, see
+    // Polling::Backend
+
     class SyncContext : public ExecutionContext
     {
     public:
+        explicit SyncContext(Polling::Backend backend = Polling::Backend::Epoll)
+            : backend_(backend)
+        { }
+
         ~SyncContext() override = default;
         Reactor::Impl* makeImpl(Reactor* reactor) const override;
+
+    private:
+        Polling::Backend backend_;
     };
 
     class AsyncContext : public ExecutionContext
     {
     public:
-        explicit AsyncContext(size_t threads, const std::string& threadsName = "")
+        explicit AsyncContext(size_t threads, const std::string& threadsName = "",
+                              Polling::Backend backend = Polling::Backend::Epoll)
             : threads_(threads)
             , threadsName_(threadsName)
+            , backend_(backend)
         { }
 
         ~AsyncContext() override = default;
@@ -179,6 +201,7 @@ namespace Pistache::Aio
     private:
         size_t threads_;
         std::string threadsName_;
+        Polling::Backend backend_;
     };
 
     class Handler : public Prototype<Handler>
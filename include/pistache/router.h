@@ -12,9 +12,10 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
-#include <regex>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
@@ -22,6 +23,7 @@
 #include <pistache/flags.h>
 #include <pistache/http.h>
 #include <pistache/http_defs.h>
+#include <pistache/small_vector.h>
 
 namespace Pistache::Rest
 {
@@ -53,9 +55,9 @@ namespace Pistache::Rest
     class TypedParam
     {
     public:
-        TypedParam(std::string name, std::string value)
-            : name_(std::move(name))
-            , value_(std::move(value))
+        TypedParam(std::string_view name, std::string_view value)
+            : name_(name)
+            , value_(value)
         { }
 
         template <typename T>
@@ -119,9 +121,13 @@ namespace Pistache::Rest
      * optional parametric and splats).
      * Each child is in turn a SegmentTreeNode.
      */
+    class RouteTable;
+
     class SegmentTreeNode
     {
     private:
+        friend class RouteTable;
+
         enum class SegmentType { Fixed,
                                  Param,
                                  Optional,
@@ -144,35 +150,21 @@ namespace Pistache::Rest
         std::shared_ptr<SegmentTreeNode> splat_;
         std::shared_ptr<Route> route_;
 
-        /**
-         * Common web servers (nginx, httpd, IIS) collapse multiple
-         * forward slashes to a single one. This regex is used to
-         * obtain the same result.
-         */
-        static std::regex multiple_slash;
-
         static SegmentType getSegmentType(const std::string_view& fragment);
 
+    public:
         /**
-         * Fetches the route associated to a given path.
-         * \param[in] path Requested resource path. Must have no leading slash
-         * and no multiple slashes:
-         * eg:
-         * - auth/login is valid
-         * - /auth/login is invalid
-         * - auth//login is invalid
-         * \param[in,out] params Contains all the parameters parsed so far.
-         * \param[in,out] splats Contains all the splats parsed so far.
-         * \returns Tuple containing the route, the list of all parsed parameters
-         * and the list of all parsed splats.
-         * \throws std::runtime_error An empty path was given
+         * A parameter or splat matched by a lookup: its name, a view into
+         * the tree, and its value, a view into the path looked up.
          */
-        std::tuple<std::shared_ptr<Route>, std::vector<TypedParam>,
-                   std::vector<TypedParam>>
-        findRoute(const std::string_view& path, std::vector<TypedParam>& params,
-                  std::vector<TypedParam>& splats) const;
+        struct Match
+        {
+            std::string_view name;
+            std::string_view value;
+        };
+
+        using Matches = SmallVector<Match, 8>;
 
-    public:
         SegmentTreeNode();
         explicit SegmentTreeNode(const std::shared_ptr<char>& resourceReference);
 
@@ -184,6 +176,17 @@ namespace Pistache::Rest
          */
         static std::string sanitizeResource(const std::string& path);
 
+        /**
+         * Same as above, without allocating unless the URL has duplicate
+         * slashes (common web servers, nginx, httpd, IIS, collapse them).
+         * @param path URL to sanitize.
+         * @param scratch Holds the sanitized URL when it is not a substring
+         * of path.
+         * @return Sanitized URL, a view into path or scratch.
+         */
+        static std::string_view sanitizeResource(std::string_view path,
+                                                 std::string& scratch);
+
         /**
          * Associates a route handler to a given path.
          * \param[in] path Requested resource path. Must have no leading and trailing
@@ -227,6 +230,87 @@ namespace Pistache::Rest
         std::tuple<std::shared_ptr<Route>, std::vector<TypedParam>,
                    std::vector<TypedParam>>
         findRoute(const std::string_view& path) const;
+
+        /**
+         * Same as above, without allocating: the parameters and splats
+         * matched are appended to params and splats, as views that are
+         * valid as long as the tree and path are.
+         * \param[in] path Requested resource path, as above.
+         * \param[in,out] params Contains all the parameters parsed so far.
+         * \param[in,out] splats Contains all the splats parsed so far.
+         * \return Found route, or null if no route is found (then params and
+         * splats are left as they were).
+         */
+        const std::shared_ptr<Route>* findRoute(std::string_view path, Matches& params,
+                                                Matches& splats) const;
+    };
+
+    /**
+     * A SegmentTreeNode compiled, or frozen, into flat arrays: the nodes
+     * laid out breadth first, so that the children of a node are next to
+     * each other, and the edges of every node in one contiguous range,
+     * fixed segments first, then parameters, then optional parameters.
+     * Fixed segments are compared one by one when a node has few of them,
+     * otherwise looked up in an open addressing hash table of the node,
+     * all of these tables in one array too.
+     * Routes are matched exactly as the tree they were compiled from
+     * matches them; later changes to the tree are not seen.
+     */
+    class RouteTable
+    {
+    public:
+        explicit RouteTable(const SegmentTreeNode& root);
+
+        /**
+         * Same as SegmentTreeNode::findRoute. Parameter names are views into
+         * the table, valid as long as it is.
+         */
+        const std::shared_ptr<Route>* findRoute(std::string_view path,
+                                                SegmentTreeNode::Matches& params,
+                                                SegmentTreeNode::Matches& splats) const;
+
+        size_t nodeCount() const { return nodes_.size(); }
+
+    private:
+        static constexpr uint32_t None = UINT32_MAX;
+
+        // Nodes with more fixed segments than this get a hash table
+        static constexpr uint32_t MaxScanned = 8;
+
+        struct Node
+        {
+            uint32_t edges    = 0; // first edge of the node
+            uint32_t fixedEnd = 0; // fixed segments are [edges, fixedEnd)
+            uint32_t paramEnd = 0; // parameters are [fixedEnd, paramEnd)
+            uint32_t edgesEnd = 0; // optional ones are [paramEnd, edgesEnd)
+            uint32_t splat    = None;
+            uint32_t route    = None; // into routes_
+            uint32_t slots    = 0; // first slot of the fixed segments' table
+            uint32_t slotMask = 0; // its size, a power of two, minus one
+        };
+
+        struct Edge
+        {
+            size_t hash; // of the name, for fixed segments only
+            uint32_t name; // into names_
+            uint32_t nameLength;
+            uint32_t child;
+        };
+
+        std::string_view name(const Edge& edge) const
+        {
+            return { names_.data() + edge.name, edge.nameLength };
+        }
+
+        const std::shared_ptr<Route>* findRoute(uint32_t node, std::string_view path,
+                                                SegmentTreeNode::Matches& params,
+                                                SegmentTreeNode::Matches& splats) const;
+
+        std::vector<Node> nodes_;
+        std::vector<Edge> edges_;
+        std::vector<uint32_t> slots_; // edges, or None for an empty slot
+        std::string names_;
+        std::vector<std::shared_ptr<Route>> routes_;
     };
 
     class Router
@@ -254,6 +338,16 @@ namespace Pistache::Rest
         void addCustomHandler(Route::Handler handler);
         void addMiddleware(Route::Middleware middleware);
 
+        /**
+         * Compiles the routes into RouteTables, which route() then goes
+         * through instead of the route trees. Routes added or removed
+         * afterwards are compiled into new tables, swapped in atomically:
+         * requests being routed keep the tables they started with.
+         * Adding and removing routes must still not be done concurrently.
+         */
+        void freeze();
+        bool frozen() const;
+
         void addNotFoundHandler(Route::Handler handler);
         void addDisconnectHandler(Route::DisconnectHandler handler);
         inline bool hasNotFoundHandler() const { return notFoundHandler != nullptr; }
@@ -265,6 +359,11 @@ namespace Pistache::Rest
         Route::Status route(const Http::Request& request,
                             Http::ResponseWriter response) const;
 
+        // The Rest::Request handed to the route is made from request,
+        // which the one above has to copy first
+        Route::Status route(Http::Request&& request,
+                            Http::ResponseWriter response) const;
+
         Router()
             : routes()
             , customHandlers()
@@ -273,8 +372,16 @@ namespace Pistache::Rest
         { }
 
     private:
+        using FrozenRoutes = std::unordered_map<Http::Method, RouteTable>;
+
+        // Recompiles the routes if frozen
+        void refreeze();
+
         std::unordered_map<Http::Method, SegmentTreeNode> routes;
 
+        // Only accessed with std::atomic_load and std::atomic_store
+        std::shared_ptr<const FrozenRoutes> frozenRoutes;
+
         std::vector<Route::Handler> customHandlers;
 
         std::vector<Route::Middleware> middlewares;
@@ -308,6 +415,8 @@ namespace Pistache::Rest
 
             void onRequest(const Http::Request& req,
                            Http::ResponseWriter response) override;
+            void takeRequest(Http::Request&& req,
+                             Http::ResponseWriter response) override;
 
             void onDisconnection(const std::shared_ptr<Tcp::Peer>& peer) override;
 
@@ -321,6 +430,9 @@ namespace Pistache::Rest
     public:
         friend class Router;
 
+        // Parameters and splats of a request, most routes have few of them
+        using Params = SmallVector<TypedParam, 4>;
+
         bool hasParam(const std::string& name) const;
         TypedParam param(const std::string& name) const;
 
@@ -328,12 +440,16 @@ namespace Pistache::Rest
         std::vector<TypedParam> splat() const;
 
     private:
-        explicit Request(Http::Request request,
-                         std::vector<TypedParam>&& params,
-                         std::vector<TypedParam>&& splats);
+        explicit Request(Http::Request request);
+        explicit Request(Http::Request request, Params params, Params splats);
 
-        std::vector<TypedParam> params_;
-        std::vector<TypedParam> splats_;
+        // Matches point into the resource they were found in, they have
+        // to be made params before the request goes
+        static Params paramsOf(const SegmentTreeNode::Matches& params);
+        static Params splatsOf(const SegmentTreeNode::Matches& splats);
+
+        Params params_;
+        Params splats_;
     };
 
     namespace Routes
@@ -352,6 +468,9 @@ namespace Pistache::Rest
 
         void NotFound(Router& router, Route::Handler handler);
 
+        // Serves Metrics::prometheus() on GET resource
+        void Prometheus(Router& router, const std::string& resource = "/metrics");
+
         namespace details
         {
             template <typename... Args>
@@ -369,13 +488,14 @@ namespace Pistache::Rest
             template <typename Request, typename Response>
             struct BindChecks
             {
-                constexpr static bool request_check = std::is_const<typename std::remove_reference<Request>::type>::value && std::is_lvalue_reference<typename std::remove_cv<Request>::type>::value && std::is_same<typename std::decay<Request>::type, Rest::Request>::value;
+                // By value too, for handlers outliving the call, as coroutines do
+                constexpr static bool request_check = (std::is_const<typename std::remove_reference<Request>::type>::value && std::is_lvalue_reference<typename std::remove_cv<Request>::type>::value && std::is_same<typename std::decay<Request>::type, Rest::Request>::value) || std::is_same<Request, Rest::Request>::value;
 
                 constexpr static bool response_check = !std::is_const<typename std::remove_reference<Response>::type>::value && std::is_same<typename std::remove_reference<Response>::type, Response>::value && std::is_same<typename std::decay<Response>::type, Http::ResponseWriter>::value;
 
                 static_assert(
                     request_check && response_check,
-                    "Function should accept (const Rest::Request&, HttpResponseWriter)");
+                    "Function should accept (const Rest::Request&, HttpResponseWriter) or (Rest::Request, HttpResponseWriter)");
             };
 
             template <typename Request, typename Response>
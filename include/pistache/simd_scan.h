@@ -0,0 +1,48 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* simd_scan.h
+
+   Delimiter search for the HTTP parsers: finds the first of a few bytes
+   (':', ' ', CR...) in a buffer 16 bytes at a time with SSE4.2, or 32 with
+   AVX2, whichever the CPU supports, checked once at runtime. Elsewhere, or
+   on CPUs with neither, a plain loop does the same.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace Pistache::Scan
+{
+
+    enum class Isa {
+        Scalar,
+        Sse42,
+        Avx2
+    };
+
+    const char* isaString(Isa isa);
+
+    // Whether this build and CPU can run isa
+    bool supported(Isa isa);
+
+    // The implementation in use, the best supported one unless set
+    Isa isa();
+
+    // For tests and benchmarks: not to be called while parsing. Throws
+    // std::invalid_argument if isa is not supported
+    void setIsa(Isa isa);
+
+    // The first byte of [begin, end) that is one of the bytes of set (at
+    // most 16 of them), or end
+    const char* findFirstOf(const char* begin, const char* end, std::string_view set);
+
+    // The first CRLF of [begin, end), or end
+    const char* findCrLf(const char* begin, const char* end);
+
+} // namespace Pistache::Scan
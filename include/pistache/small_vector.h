@@ -0,0 +1,213 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* small_vector.h
+
+   A vector keeping its first N elements inline, in the object itself, and
+   only going to the heap past that. For the short lists built per request
+   (route parameters, splats) where std::vector would allocate every time.
+
+   Elements only need to be move constructible: they are never assigned.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace Pistache
+{
+
+    template <typename T, size_t N>
+    class SmallVector
+    {
+    public:
+        static_assert(N > 0, "SmallVector needs some inline storage");
+
+        typedef T value_type;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef T* iterator;
+        typedef const T* const_iterator;
+        typedef size_t size_type;
+
+        SmallVector() = default;
+
+        SmallVector(std::initializer_list<T> values)
+        {
+            reserve(values.size());
+            for (const auto& value : values)
+                emplace_back(value);
+        }
+
+        SmallVector(const SmallVector& other)
+        {
+            reserve(other.size_);
+            for (const auto& value : other)
+                emplace_back(value);
+        }
+
+        SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            steal(other);
+        }
+
+        SmallVector& operator=(const SmallVector& other)
+        {
+            if (this != &other)
+            {
+                clear();
+                reserve(other.size_);
+                for (const auto& value : other)
+                    emplace_back(value);
+            }
+            return *this;
+        }
+
+        SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            if (this != &other)
+            {
+                clear();
+                release();
+                steal(other);
+            }
+            return *this;
+        }
+
+        ~SmallVector()
+        {
+            clear();
+            release();
+        }
+
+        template <typename... Args>
+        T& emplace_back(Args&&... args)
+        {
+            if (size_ == capacity_)
+                grow(capacity_ * 2);
+
+            T* value = ::new (static_cast<void*>(data_ + size_)) T(std::forward<Args>(args)...);
+            ++size_;
+            return *value;
+        }
+
+        void push_back(const T& value) { emplace_back(value); }
+        void push_back(T&& value) { emplace_back(std::move(value)); }
+
+        void pop_back()
+        {
+            --size_;
+            data_[size_].~T();
+        }
+
+        void clear()
+        {
+            std::destroy(data_, data_ + size_);
+            size_ = 0;
+        }
+
+        void reserve(size_t capacity)
+        {
+            if (capacity > capacity_)
+                grow(capacity);
+        }
+
+        T& operator[](size_t index) { return data_[index]; }
+        const T& operator[](size_t index) const { return data_[index]; }
+
+        T& at(size_t index)
+        {
+            if (index >= size_)
+                throw std::out_of_range("SmallVector index out of range");
+            return data_[index];
+        }
+
+        const T& at(size_t index) const
+        {
+            if (index >= size_)
+                throw std::out_of_range("SmallVector index out of range");
+            return data_[index];
+        }
+
+        T& back() { return data_[size_ - 1]; }
+        const T& back() const { return data_[size_ - 1]; }
+
+        iterator begin() { return data_; }
+        iterator end() { return data_ + size_; }
+        const_iterator begin() const { return data_; }
+        const_iterator end() const { return data_ + size_; }
+
+        T* data() { return data_; }
+        const T* data() const { return data_; }
+
+        size_t size() const { return size_; }
+        size_t capacity() const { return capacity_; }
+        bool empty() const { return size_ == 0; }
+
+        // Whether the elements are still in the inline storage
+        bool isInline() const { return data_ == inlineData(); }
+
+    private:
+        T* inlineData() { return std::launder(reinterpret_cast<T*>(inline_)); }
+        const T* inlineData() const { return std::launder(reinterpret_cast<const T*>(inline_)); }
+
+        void grow(size_t capacity)
+        {
+            T* data = static_cast<T*>(::operator new(capacity * sizeof(T), std::align_val_t(alignof(T))));
+
+            std::uninitialized_move(data_, data_ + size_, data);
+            std::destroy(data_, data_ + size_);
+            release();
+
+            data_     = data;
+            capacity_ = capacity;
+        }
+
+        // Frees the heap storage, if any, once the elements are destroyed
+        void release()
+        {
+            if (!isInline())
+                ::operator delete(data_, std::align_val_t(alignof(T)));
+
+            data_     = inlineData();
+            capacity_ = N;
+        }
+
+        void steal(SmallVector& other)
+        {
+            if (other.isInline())
+            {
+                std::uninitialized_move(other.data_, other.data_ + other.size_, data_);
+                size_ = other.size_;
+                other.clear();
+            }
+            else
+            {
+                data_     = other.data_;
+                size_     = other.size_;
+                capacity_ = other.capacity_;
+
+                other.data_     = other.inlineData();
+                other.size_     = 0;
+                other.capacity_ = N;
+            }
+        }
+
+        alignas(T) unsigned char inline_[N * sizeof(T)];
+
+        T* data_         = inlineData();
+        size_t size_     = 0;
+        size_t capacity_ = N;
+    };
+
+} // namespace Pistache
@@ -13,14 +13,17 @@
 #pragma once
 
 #include <pistache/os.h>
+#include <pistache/small_vector.h>
 
 #include <cstddef>
 #include <cstring>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <stdexcept>
 #include <streambuf>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace Pistache
@@ -117,30 +120,87 @@ namespace Pistache
             Base::setg(bytes.data(), bytes.data(), bytes.data() + bytes.size());
         }
 
-        bool feed(const char* data, size_t len)
+        bool feed(const char* data, size_t len) { return feed(data, len, maxSize_); }
+
+        // Up to limit rather than the maximum size
+        bool feed(const char* data, size_t len, size_t limit)
         {
-            if (bytes.size() + len > maxSize_)
+            if (read_ + bytes.size() + len > limit)
             {
                 return false;
             }
             // persist current offset
             size_t readOffset = static_cast<size_t>(this->gptr() - this->eback());
-            std::copy(data, data + len, std::back_inserter(bytes));
+            bytes.insert(bytes.end(), data, data + len);
             Base::setg(bytes.data(), bytes.data() + readOffset,
                        bytes.data() + bytes.size());
             return true;
         }
 
+        // Reads data where it is, unless bytes are already buffered, in
+        // which case it is fed. It stays the caller's: keepBorrowed() must
+        // copy in what is left of it unread before it goes
+        bool borrow(const char* data, size_t len, size_t limit)
+        {
+            keepBorrowed();
+            if (!bytes.empty())
+                return feed(data, len, limit);
+
+            if (read_ + len > limit)
+            {
+                return false;
+            }
+            // Only ever read from
+            auto* begin = const_cast<CharT*>(data);
+            Base::setg(begin, begin, begin + len);
+            borrowed_ = true;
+            return true;
+        }
+
+        void keepBorrowed()
+        {
+            if (!borrowed_)
+                return;
+
+            // What was read still counts towards the limit, as if fed
+            read_ += static_cast<size_t>(this->gptr() - this->eback());
+            bytes.assign(this->gptr(), this->egptr());
+            Base::setg(bytes.data(), bytes.data(), bytes.data() + bytes.size());
+            borrowed_ = false;
+        }
+
         void reset()
         {
             std::vector<CharT> nbytes;
             bytes.swap(nbytes);
             Base::setg(bytes.data(), bytes.data(), bytes.data() + bytes.size());
+            borrowed_ = false;
+            read_     = 0;
+        }
+
+        size_t maxSize() const { return maxSize_; }
+
+        // Drops the bytes already read, keeping the others
+        void discardRead()
+        {
+            read_ = 0;
+            if (borrowed_)
+            {
+                Base::setg(this->gptr(), this->gptr(), this->egptr());
+                return;
+            }
+
+            const auto readOffset = this->gptr() - this->eback();
+            bytes.erase(bytes.begin(), bytes.begin() + readOffset);
+            Base::setg(bytes.data(), bytes.data(), bytes.data() + bytes.size());
         }
 
     private:
         std::vector<CharT> bytes;
         size_t maxSize_ = Const::MaxBuffer;
+        // Read and then dropped by keepBorrowed(), since the last discard
+        size_t read_    = 0;
+        bool borrowed_  = false;
     };
 
     struct RawBuffer final
@@ -165,19 +225,85 @@ namespace Pistache
         size_t length_ = 0;
     };
 
+    // An open file, closed on destruction
+    class OpenFile
+    {
+    public:
+        explicit OpenFile(int fd)
+            : fd_(fd)
+        { }
+
+        OpenFile(const OpenFile&)            = delete;
+        OpenFile& operator=(const OpenFile&) = delete;
+
+        ~OpenFile();
+
+        int fd() const { return fd_; }
+
+    private:
+        int fd_; // regular old file descriptor ("int") even in libevent case
+    };
+
     struct FileBuffer
     {
         explicit FileBuffer(const std::string& fileName);
 
+        // Only the length bytes of the file starting at offset
+        FileBuffer(const std::string& fileName, size_t offset, size_t length);
+
+        // Same, from a file already open. It is shared, and stays open for
+        // as long as any holder of it (e.g. a pending write) needs it
+        FileBuffer(std::shared_ptr<const OpenFile> file, size_t offset, size_t length);
+
         int fd() const;
-        size_t size() const;
+        const std::shared_ptr<const OpenFile>& file() const { return file_; }
+        size_t offset() const;
+        size_t size() const; // of the part to send, i.e. from offset()
 
     private:
         std::string fileName_;
-        int fd_; // regular old file descriptor ("int") even in libevent case
+        std::shared_ptr<const OpenFile> file_;
+        size_t offset_ = 0;
         size_t size_;
     };
 
+    // Buffers sent one after the other, as a whole, with a single writev
+    // where the platform has one. Each piece is either owned, moved in, or
+    // a part of a string shared with others (e.g. a cached body): pieces
+    // are never copied into one
+    class GatherBuffer final
+    {
+    public:
+        GatherBuffer() = default;
+
+        void add(RawBuffer buffer);
+        void add(std::string data);
+        void add(std::shared_ptr<const std::string> data);
+        void add(std::shared_ptr<const std::string> data, size_t offset, size_t length);
+
+        // The pieces of other, after these
+        void add(GatherBuffer&& other);
+
+        size_t count() const { return pieces_.size(); }
+        std::string_view piece(size_t index) const;
+
+        size_t size() const { return size_; } // of all the pieces
+        bool empty() const { return size_ == 0; }
+
+    private:
+        struct Piece
+        {
+            RawBuffer owned;
+            std::shared_ptr<const std::string> shared;
+            size_t offset = 0;
+            size_t length = 0;
+        };
+
+        // Typically the headers and a body
+        SmallVector<Piece, 2> pieces_;
+        size_t size_ = 0;
+    };
+
     class DynamicStreamBuf : public StreamBuf<char>
     {
     public:
@@ -193,6 +319,10 @@ namespace Pistache
         DynamicStreamBuf(DynamicStreamBuf&& other);
         DynamicStreamBuf& operator=(DynamicStreamBuf&& other);
 
+        // Hands the backing storage over to the next buffer created on
+        // this thread
+        ~DynamicStreamBuf() override;
+
         RawBuffer buffer() const;
 
         void clear();
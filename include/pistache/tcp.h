@@ -53,6 +53,11 @@ namespace Pistache::Tcp
         virtual void onConnection(const std::shared_ptr<Tcp::Peer>& peer);
         virtual void onDisconnection(const std::shared_ptr<Tcp::Peer>& peer);
 
+        // Once reading from peer, paused with Transport::pauseReading, is
+        // resumed: before anything more is read, for the handler to go on
+        // with the input it had been given already
+        virtual void onReadResumed(const std::shared_ptr<Tcp::Peer>& peer);
+
     private:
         void associateTransport(Transport* transport);
         Transport* transport_;
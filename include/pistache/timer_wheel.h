@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* timer_wheel.h
+
+   A hashed timer wheel. Timers are kept in one of a fixed number of slots,
+   picked from their expiry tick, so that arming and disarming a timer are
+   both O(1) whatever the number of timers. A timer due further away than
+   one turn of the wheel simply stays in its slot until the wheel has come
+   round enough times.
+
+   The wheel does not own any clock or fd: its owner drives it by calling
+   advance() when nextExpiry() has been reached, typically from a single
+   timerfd. It is not thread-safe, all calls must be made from the thread
+   that owns it.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace Pistache
+{
+
+    class TimerWheel
+    {
+    public:
+        using Clock    = std::chrono::steady_clock;
+        using Callback = std::function<void()>;
+
+        // Identifies an armed timer. Ids are not reused once the timer has
+        // fired or been disarmed, so disarming a stale id is harmless
+        using Id                    = uint64_t;
+        static constexpr Id InvalidId = 0;
+
+        static constexpr std::chrono::milliseconds DefaultTick { 1 };
+        static constexpr size_t DefaultSlots = 4096;
+
+        // slots is rounded up to a power of two, and to at least 64
+        explicit TimerWheel(std::chrono::milliseconds tick = DefaultTick,
+                            size_t slots                   = DefaultSlots,
+                            Clock::time_point origin       = Clock::now());
+
+        TimerWheel(const TimerWheel&)            = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+        template <typename Duration>
+        Id arm(Duration delay, Callback callback)
+        {
+            return armAt(Clock::now() + std::chrono::duration_cast<Clock::duration>(delay),
+                         std::move(callback));
+        }
+
+        // Timers never fire before their deadline, but may fire up to one
+        // tick after it
+        Id armAt(Clock::time_point deadline, Callback callback);
+
+        // Returns false if the timer already fired or was disarmed
+        bool disarm(Id id);
+
+        // Fires every timer due at now, in no particular order. Returns the
+        // number of timers fired. Must not be called from a callback
+        size_t advance(Clock::time_point now = Clock::now());
+
+        // When advance() should next be called, if any timer is armed. This
+        // may be earlier than the first actual deadline (but never later),
+        // in which case advance() just fires nothing
+        std::optional<Clock::time_point> nextExpiry() const;
+
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        std::chrono::milliseconds tick() const { return tick_; }
+
+    private:
+        static constexpr uint32_t Nil = UINT32_MAX;
+
+        struct Node
+        {
+            uint64_t expiry     = 0;
+            uint32_t prev       = Nil;
+            uint32_t next       = Nil;
+            uint32_t generation = 1;
+            bool armed          = false;
+            Callback callback;
+        };
+
+        uint64_t tickOf(Clock::time_point time) const;
+
+        uint32_t allocNode();
+        void freeNode(uint32_t index);
+        void link(uint32_t index);
+        void unlink(uint32_t index);
+
+        std::chrono::milliseconds tick_;
+        Clock::time_point origin_;
+        uint64_t currentTick_ = 0;
+        size_t mask_;
+        size_t size_ = 0;
+
+        std::vector<uint32_t> slots_; // head node of every slot
+        std::vector<uint64_t> occupied_; // one bit per non-empty slot
+        std::vector<Node> nodes_;
+        uint32_t freeList_ = Nil;
+
+        std::vector<Callback> due_;
+    };
+
+} // namespace Pistache
@@ -0,0 +1,164 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* trace.h
+
+   Per-request latency tracing. One request in every n (see sampleEvery)
+   gets a Span, shared by its Http::Request and its ResponseWriter, which is
+   stamped as the request goes through each Phase. Once the handler has
+   returned and the response's last byte has been written, the span is
+   handed to the sink set with setSink.
+
+   Sampling is off by default. Requests that are not sampled cost a relaxed
+   atomic load, plus a null check at each phase.
+
+   Only the first request read by each call to Http::Handler::onInput can
+   be sampled, so pipelined requests that arrive together are traced as
+   one. Accepted is set for the first request on a connection only. Spans
+   whose response is never sent are dropped.
+*/
+
+#pragma once
+
+#include <pistache/http_defs.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Pistache::Trace
+{
+
+    enum class Phase {
+        Accepted,
+        FirstByte,
+        Parsed,
+        RouteMatched,
+        HandlerReturned,
+        FirstWrite,
+        LastByteFlushed
+    };
+
+    constexpr size_t PhaseCount = 7;
+
+    const char* phaseString(Phase phase);
+
+    // Nanoseconds on the monotonic clock
+    uint64_t now();
+
+    struct Span
+    {
+        uint64_t id         = 0;
+        Http::Method method = Http::Method::Get;
+        std::string resource;
+        Http::Code code = Http::Code::Ok;
+
+        // When each phase was reached, see now(), 0 for phases that were not
+        std::array<uint64_t, PhaseCount> at {};
+
+        // Stamps phase, unless it was already
+        void mark(Phase phase)
+        {
+            auto& when = at[static_cast<size_t>(phase)];
+            if (!when)
+                when = now();
+        }
+
+        bool reached(Phase phase) const { return at[static_cast<size_t>(phase)] != 0; }
+
+        // Nanoseconds from one phase to the other, 0 unless both were reached
+        uint64_t between(Phase from, Phase to) const;
+    };
+
+    class Sink
+    {
+    public:
+        virtual ~Sink() = default;
+
+        // Called by the transport thread of the request's peer
+        virtual void onSpan(const Span& span) = 0;
+    };
+
+    // Keeps the last spans
+    class RingSink : public Sink
+    {
+    public:
+        explicit RingSink(size_t capacity);
+
+        void onSpan(const Span& span) override;
+
+        // Oldest first
+        std::vector<Span> spans() const;
+
+    private:
+        mutable std::mutex mtx_;
+        std::vector<Span> spans_;
+        size_t capacity_;
+        size_t next_ = 0;
+    };
+
+    // Appends a line per span, the offset of each phase reached in
+    // microseconds
+    class FileSink : public Sink
+    {
+    public:
+        // Throws std::runtime_error if path cannot be opened
+        explicit FileSink(const std::string& path);
+        ~FileSink() override;
+
+        FileSink(const FileSink&)            = delete;
+        FileSink& operator=(const FileSink&) = delete;
+
+        void onSpan(const Span& span) override;
+
+    private:
+        std::mutex mtx_;
+        FILE* file_;
+    };
+
+    class CallbackSink : public Sink
+    {
+    public:
+        explicit CallbackSink(std::function<void(const Span&)> callback)
+            : callback_(std::move(callback))
+        { }
+
+        void onSpan(const Span& span) override { callback_(span); }
+
+    private:
+        std::function<void(const Span&)> callback_;
+    };
+
+    // One request in every n is traced, none when 0
+    void sampleEvery(uint32_t n);
+
+    void setSink(std::shared_ptr<Sink> sink);
+    std::shared_ptr<Sink> sink();
+
+    namespace Private
+    {
+        extern std::atomic<uint32_t> sampling;
+    } // namespace Private
+
+    inline bool enabled()
+    {
+        return Private::sampling.load(std::memory_order_relaxed) != 0;
+    }
+
+    // A span, stamped FirstByte, if the request about to be read is to be
+    // traced. Null otherwise
+    std::shared_ptr<Span> sample();
+
+    // Hands span over to the sink
+    void finish(const Span& span);
+
+} // namespace Pistache::Trace
@@ -22,13 +22,18 @@
 #include <pistache/pist_timelog.h>
 #include <pistache/reactor.h>
 #include <pistache/stream.h>
+#include <pistache/timer_wheel.h>
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <unordered_map>
+#include <vector>
 
 namespace Pistache::Tcp
 {
@@ -54,8 +59,16 @@ namespace Pistache::Tcp
         void handleNewPeer(const std::shared_ptr<Peer>& peer);
         void onReady(const Aio::FdSet& fds) override;
 
+        // Accepts the connections of listenFd itself, from its own reactor
+        // thread, instead of being handed them by the listener's thread
+        // (see Listener::setPerWorkerListeners). accept returns the next
+        // peer, or nullptr when there is none for now. To be called once
+        // the transport is attached to its reactor, before it runs
+        using Acceptor = std::function<std::shared_ptr<Peer>(Fd listenFd)>;
+        void acceptOn(Fd listenFd, Acceptor accept);
+
         template <typename Buf>
-        Async::Promise<PST_SSIZE_T> asyncWrite(Fd fd, const Buf& buffer,
+        Async::Promise<PST_SSIZE_T> asyncWrite(Fd fd, Buf&& buffer,
                                            int flags = 0
 #ifdef _USE_LIBEVENT_LIKE_APPLE
                                            ,
@@ -67,10 +80,11 @@ namespace Pistache::Tcp
             // consumer context means chunked responses could be sent out of
             // order.
             //
-            // Note: fd could be PS_FD_EMPTY
+            // Note: fd could be PS_FD_EMPTY. A RawBuffer passed as an rvalue
+            // is moved to the queue rather than copied
             return Async::Promise<PST_SSIZE_T>(
                 [&, this](Async::Deferred<PST_SSIZE_T> deferred) mutable {
-                    BufferHolder holder { buffer };
+                    BufferHolder holder { std::forward<Buf>(buffer) };
                     WriteEntry write(std::move(deferred), std::move(holder),
                                      fd, flags
 #ifdef _USE_LIBEVENT_LIKE_APPLE
@@ -92,6 +106,34 @@ namespace Pistache::Tcp
             });
         }
 
+        // Runs task on the transport's reactor thread, whichever thread it
+        // is posted from. Always through the queue, even from that thread,
+        // so that it runs once the reactor is done with the current events
+        void post(std::function<void()> task);
+
+        // The transport whose events the calling thread is handling, or
+        // nullptr outside of a transport's reactor thread
+        static Transport* current();
+
+        // Timers are all served by the transport's timer wheel, behind a
+        // single timerfd, rather than by a timerfd of their own. The
+        // deferred is resolved (with 1) from the reactor thread once the
+        // timeout expires, unless the timer is disarmed first. Both arming
+        // and disarming may be done from any thread
+        using TimerId = TimerWheel::Id;
+
+        template <typename Duration>
+        TimerId armTimer(Duration timeout, Async::Deferred<uint64_t> deferred)
+        {
+            return armTimerMs(PS_FD_EMPTY,
+                              std::chrono::duration_cast<std::chrono::milliseconds>(timeout),
+                              std::move(deferred));
+        }
+
+        void disarmTimer(TimerId id);
+
+        // Same, with the timer identified by an fd of the caller's. The fd
+        // is only used as a key, it is neither armed nor polled
         template <typename Duration>
         void armTimer(Fd fd, Duration timeout, Async::Deferred<uint64_t> deferred)
         {
@@ -104,6 +146,21 @@ namespace Pistache::Tcp
 
         void disarmTimer(Fd fd);
 
+        // Size of the buffer incoming bytes are read into. A peer's input is
+        // read until the buffer is full (or the socket has nothing more)
+        // before being handed to the handler, so a larger buffer means
+        // fewer handler invocations for large requests
+        void setReadBufferSize(size_t size);
+        size_t readBufferSize() const { return readBufferSize_; }
+
+        // Writes of at least this many bytes are sent with MSG_ZEROCOPY,
+        // where there is one (Linux, not over TLS): the kernel sends from
+        // the buffer itself rather than from a copy of it. The buffer is
+        // held on to until the kernel reports it is done with it. Only
+        // worth it for large writes, 0 (the default) is for never
+        void setZeroCopyThreshold(size_t bytes) { zeroCopyThreshold_ = bytes; }
+        size_t zeroCopyThreshold() const { return zeroCopyThreshold_; }
+
         std::shared_ptr<Aio::Handler> clone() const override;
 
         void flush();
@@ -119,6 +176,15 @@ namespace Pistache::Tcp
 
         void closeFd(Fd fd);
 
+        // Backpressure: stops reading from peer until resumeReading, its
+        // input being left in the socket, where TCP flow control eventually
+        // holds the client back. To be called from the handler, i.e. in
+        // the transport's thread
+        void pauseReading(const std::shared_ptr<Peer>& peer);
+
+        // May be called from any thread
+        void resumeReading(const std::shared_ptr<Peer>& peer);
+
         // !!!! Make protected like removePeer
         void removeAllPeers(); // cleans up toWrite and does CLOSE_FD on each
 
@@ -129,7 +195,8 @@ namespace Pistache::Tcp
         struct BufferHolder
         {
             enum Type { Raw,
-                        File };
+                        File,
+                        Gather };
 
             explicit BufferHolder(const RawBuffer& buffer, off_t offset = 0)
                 : _raw(buffer)
@@ -138,15 +205,40 @@ namespace Pistache::Tcp
                 , type(Raw)
             { }
 
-            explicit BufferHolder(const FileBuffer& buffer, off_t offset = 0)
-                : _fd(buffer.fd())
+            explicit BufferHolder(RawBuffer&& buffer, off_t offset = 0)
+                : _raw(std::move(buffer))
+                , size_(_raw.size())
+                , offset_(offset)
+                , type(Raw)
+            { }
+
+            // For gathers, offset_ is how much of all the pieces is sent
+            explicit BufferHolder(const GatherBuffer& buffer, off_t offset = 0)
+                : gather_(buffer)
                 , size_(buffer.size())
                 , offset_(offset)
+                , type(Gather)
+            { }
+
+            explicit BufferHolder(GatherBuffer&& buffer, off_t offset = 0)
+                : gather_(std::move(buffer))
+                , size_(gather_.size())
+                , offset_(offset)
+                , type(Gather)
+            { }
+
+            // For files, offset_ and size_ are positions in the file
+            explicit BufferHolder(const FileBuffer& buffer, off_t offset = 0)
+                : _fd(buffer.fd())
+                , file_(buffer.file())
+                , size_(buffer.offset() + buffer.size())
+                , offset_(static_cast<off_t>(buffer.offset()) + offset)
                 , type(File)
             { }
 
             bool isFile() const { return type == File; }
             bool isRaw() const { return type == Raw; }
+            bool isGather() const { return type == Gather; }
             size_t size() const { return size_; }
             size_t offset() const { return static_cast<size_t>(offset_); }
 
@@ -157,17 +249,27 @@ namespace Pistache::Tcp
                 return _fd;
             }
 
-            RawBuffer raw() const
+            const RawBuffer& raw() const
             {
                 if (!isRaw())
                     throw std::runtime_error("Tried to retrieve raw data of a non-buffer");
                 return _raw;
             }
 
+            const GatherBuffer& gather() const
+            {
+                if (!isGather())
+                    throw std::runtime_error("Tried to retrieve pieces of a non-gather buffer");
+                return gather_;
+            }
+
+            // Pieces are not copied, the holder is done with once detached
             BufferHolder detach(off_t offset = 0)
             {
+                if (isGather())
+                    return BufferHolder(std::move(gather_), offset);
                 if (!isRaw())
-                    return BufferHolder(_fd, size_, offset);
+                    return BufferHolder(_fd, file_, size_, offset);
 
                 auto detached = _raw.copy(static_cast<size_t>(offset));
                 return BufferHolder(detached);
@@ -175,15 +277,19 @@ namespace Pistache::Tcp
 
         private:
             BufferHolder(int fd, // regular file desc ("int") even for libevent
+                         std::shared_ptr<const OpenFile> file,
                          size_t size, off_t offset = 0)
                 : _fd(fd)
+                , file_(std::move(file))
                 , size_(size)
                 , offset_(offset)
                 , type(File)
             { }
 
             RawBuffer _raw;
+            GatherBuffer gather_;
             int _fd; // regular old file desc ("int") even in libevent case
+            std::shared_ptr<const OpenFile> file_; // keeps _fd open
 
             size_t size_  = 0;
             off_t offset_ = 0;
@@ -215,35 +321,51 @@ namespace Pistache::Tcp
             bool msg_more_style = false;
 #endif
             Fd peerFd = PS_FD_EMPTY;
+
+            // Once sent with MSG_ZEROCOPY, the buffer, moved where it stays
+            // put for as long as the kernel may read from it, and how much
+            // of it is sent
+            std::shared_ptr<const BufferHolder> pinned;
+            size_t pinnedSent = 0;
+        };
+
+        // MSG_ZEROCOPY sends to a peer whose buffers the kernel may still
+        // read from. Each send is numbered, as the kernel numbers them in
+        // the completions it reports
+        struct ZeroCopy
+        {
+            bool enabled     = false; // SO_ZEROCOPY set on the socket
+            bool unsupported = false; // setting it failed, never again
+            uint32_t nextSend = 0;
+            std::deque<std::pair<uint32_t, std::shared_ptr<const BufferHolder>>> sent;
         };
 
         struct TimerEntry
         {
-            TimerEntry(Fd fd_, std::chrono::milliseconds value_,
+            TimerEntry(TimerId id_, Fd fd_, std::chrono::milliseconds value_,
                        Async::Deferred<uint64_t> deferred_)
-                : fd(fd_)
+                : id(id_)
+                , fd(fd_)
                 , value(value_)
                 , deferred(std::move(deferred_))
-                , active()
-            {
-                active.store(true, std::memory_order_relaxed);
-            }
-
-            TimerEntry(TimerEntry&& other)
-                : fd(other.fd)
-                , value(other.value)
-                , deferred(std::move(other.deferred))
-                , active(other.active.load())
             { }
 
-            void disable() { active.store(false, std::memory_order_relaxed); }
-
-            bool isActive() const { return active.load(std::memory_order_relaxed); }
+            // Asks for timer id_ (or, if id_ is InvalidId, the timer keyed
+            // by fd_) to be disarmed rather than armed
+            static TimerEntry disarming(TimerId id_, Fd fd_)
+            {
+                TimerEntry entry(id_, fd_, std::chrono::milliseconds(0),
+                                 Async::Deferred<uint64_t>());
+                entry.disarm = true;
+                return entry;
+            }
 
+            TimerId id;
             Fd fd;
             std::chrono::milliseconds value;
             Async::Deferred<uint64_t> deferred;
-            std::atomic<bool> active;
+            bool disarm = false;
+            TimerWheel::Id wheelId = TimerWheel::InvalidId;
         };
 
         struct PeerEntry
@@ -261,20 +383,87 @@ namespace Pistache::Tcp
         std::shared_ptr<EventMethEpollEquiv> epoll_fd;
 #endif
 
+        // Pending writes of one peer, behind a lock of its own that is held
+        // while sending: writing to one peer never holds up another
+        struct PeerWrites
+        {
+            Lock lock;
+            std::deque<WriteEntry> queue;
+            bool queued = false; // the peer has a write queue, maybe empty
+            ZeroCopy zeroCopy;
+        };
+
+        // The PeerWrites of each peer fd. Rather than one map behind one
+        // lock, the fds are spread over WriteShardCount shards, each with
+        // its own lock, only held to look a peer up
+        struct alignas(CachelineSize) WriteShard
+        {
+            Lock lock;
+            std::unordered_map<Fd, std::shared_ptr<PeerWrites>> peers;
+        };
+        static constexpr size_t WriteShardCount = 16;
+
         PollableQueue<WriteEntry> writesQueue;
-        std::unordered_map<Fd, std::deque<WriteEntry>> toWrite;
-        Lock toWriteLock;
+        std::array<WriteShard, WriteShardCount> toWrite;
 
+        // Arm and disarm requests made from other threads
         PollableQueue<TimerEntry> timersQueue;
-        std::unordered_map<FdConst, TimerEntry> timers;
+
+        // Armed timers, only ever accessed from the reactor thread. Ids are
+        // handed out by armTimer, in whatever thread it is called from
+        std::atomic<TimerId> nextTimerId_ { 1 };
+        std::unordered_map<TimerId, TimerEntry> timers;
+        std::unordered_map<FdConst, TimerId> fdTimers_;
+
+        TimerWheel timerWheel_;
+        Fd timerWheelFd_ = PS_FD_EMPTY;
+        std::optional<TimerWheel::Clock::time_point> timerWheelArmedFor_;
 
         PollableQueue<PeerEntry> peersQueue;
+        PollableQueue<PeerEntry> resumesQueue; // whose reading is to resume
+        PollableQueue<std::function<void()>> postsQueue;
 
         Async::Deferred<PST_RUSAGE> loadRequest_;
         NotifyFd notifier;
 
         std::shared_ptr<Tcp::Handler> handler_;
 
+        // One per transport, i.e. per worker thread: input is passed on to
+        // handler_ synchronously, so no peer needs a buffer of its own
+        size_t readBufferSize_ = Const::DefaultReadBufferSize;
+        std::vector<char> readBuffer_;
+
+        size_t zeroCopyThreshold_ = 0;
+
+        // Sockets closed while the kernel may still read from buffers they
+        // sent with MSG_ZEROCOPY. Their fds are shut down but left open, for
+        // the completions of those sends to be read: the buffers are only
+        // released, and the fds closed, once they are all reported, or when
+        // the transport goes
+        struct Lingering
+        {
+            Fd fd;
+            ZeroCopy zeroCopy;
+        };
+        Lock lingeringLock_;
+        std::vector<Lingering> lingering_;
+        TimerWheel::Id lingeringTimer_ = TimerWheel::InvalidId; // reactor thread only
+
+        Fd acceptFd_ = PS_FD_EMPTY;
+        Acceptor acceptor_;
+
+#ifdef PISTACHE_USE_SSL
+        // Peers whose TLS handshake is still in progress. They only move to
+        // peers_ (and are announced to handler_) once SSL_accept completes.
+        // Only ever accessed from the reactor thread
+        struct SslHandshake
+        {
+            std::shared_ptr<Peer> peer;
+            TimerWheel::Id timer = TimerWheel::InvalidId; // handshake deadline
+        };
+        std::unordered_map<Fd, SslHandshake> handshakes_;
+#endif /* PISTACHE_USE_SSL */
+
 #ifdef _USE_LIBEVENT_LIKE_APPLE
         int tcp_prot_num_; // TCP protocol num on this host per getprotobyname
 #endif
@@ -295,21 +484,47 @@ namespace Pistache::Tcp
     private:
         bool isPeerFd(FdConst fd) const;
         bool isPeerFdNoPeersMutexLock(FdConst fd) const;
-        bool isTimerFd(FdConst fd) const;
         bool isPeerFd(Polling::Tag tag) const;
-        bool isTimerFd(Polling::Tag tag) const;
 
         std::shared_ptr<Peer> getPeer(FdConst fd);
         std::shared_ptr<Peer> getPeer(Polling::Tag tag);
 
-        void armTimerMs(Fd fd, std::chrono::milliseconds value,
-                        Async::Deferred<uint64_t> deferred);
+        WriteShard& writeShard(Fd fd);
+        // Null if the fd has none and create is false
+        std::shared_ptr<PeerWrites> peerWrites(Fd fd, bool create);
+        bool hasPendingWrites(Fd fd);
+
+        TimerId armTimerMs(Fd fd, std::chrono::milliseconds value,
+                           Async::Deferred<uint64_t> deferred);
+        void disarmTimer(TimerId id, Fd fd);
 
         void armTimerMsImpl(TimerEntry entry);
+        bool disarmTimerImpl(TimerId id, Fd fd);
+        void rearmTimerWheel();
 
         // This will attempt to drain the write queue for the fd
         void asyncWriteImpl(Fd fd);
 
+        // Sends the raw buffers at the front of the fd's queue, when there
+        // are several of them, with a single sendmsg. Returns false, with
+        // nothing done, when that does not apply
+        bool writeGathered(Fd fd, PeerWrites& writes,
+                           std::unique_lock<Lock>& lock, bool& stop);
+
+        // Sends the buffer at the front of the queue with MSG_ZEROCOPY, if
+        // it is large enough for it. Returns false, with nothing done,
+        // otherwise
+        bool writeZeroCopy(Fd fd, PeerWrites& writes,
+                           std::unique_lock<Lock>& lock, bool& stop);
+
+        // Releases the buffers of the sends the kernel reports complete
+        void handleZeroCopyCompletions(Fd fd);
+        static void readZeroCopyCompletions(Fd fd, ZeroCopy& zeroCopy);
+
+        // Closes the lingering sockets the kernel is done with, and polls
+        // the others again a little later. In the reactor thread
+        void reapLingering();
+
 #ifdef _USE_LIBEVENT_LIKE_APPLE
         void configureMsgMoreStyle(Fd fd, bool msg_more_style);
 #endif
@@ -327,9 +542,22 @@ namespace Pistache::Tcp
         void handleWriteQueue(bool flush = false);
         void handleTimerQueue();
         void handlePeerQueue();
+        void handleAccept();
+        void handleResumeQueue();
+        void handlePostQueue();
         void handleNotify();
-        void handleTimer(TimerEntry entry);
+        void handleTimer(TimerId id);
+        void handleTimerWheel();
         void handlePeer(const std::shared_ptr<Peer>& peer);
+        void activatePeer(const std::shared_ptr<Peer>& peer);
+
+#ifdef PISTACHE_USE_SSL
+        bool isSslHandshakeFd(Polling::Tag tag) const;
+        void startSslHandshake(const std::shared_ptr<Peer>& peer);
+        void continueSslHandshake(const std::shared_ptr<Peer>& peer);
+        void abortSslHandshake(const std::shared_ptr<Peer>& peer);
+        void eraseSslHandshake(Fd fd);
+#endif /* PISTACHE_USE_SSL */
     };
 
 } // namespace Pistache::Tcp
@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* async.cc
+
+   Pool the promise cores, continuations and coroutine frames are
+   allocated from
+*/
+
+#include <pistache/async.h>
+
+#include <new>
+
+namespace Pistache::Async::Private
+{
+
+    namespace
+    {
+        constexpr size_t Granularity = 64;
+        constexpr size_t Classes     = PoolMaxSize / Granularity;
+
+        // Bounds what a thread keeps when it frees more than it allocates,
+        // as when promises made on one thread are resolved on another
+        constexpr size_t MaxFreeBytesPerClass = 256 * 1024;
+
+        struct Block
+        {
+            Block* next;
+        };
+
+        // Trivially destructible, so that it can still be used while the
+        // thread's other thread_local objects are destroyed
+        struct FreeLists
+        {
+            Block* heads[Classes];
+            size_t counts[Classes];
+            bool closed;
+        };
+
+        thread_local FreeLists freeLists {};
+
+        struct Drain
+        {
+            ~Drain()
+            {
+                for (size_t i = 0; i < Classes; ++i)
+                {
+                    while (Block* block = freeLists.heads[i])
+                    {
+                        freeLists.heads[i] = block->next;
+                        ::operator delete(block);
+                    }
+                    freeLists.counts[i] = 0;
+                }
+                freeLists.closed = true;
+            }
+        };
+
+        thread_local Drain drain;
+
+        size_t sizeClass(size_t size) { return (size - 1) / Granularity; }
+    }
+
+    void* poolAllocate(size_t size)
+    {
+        if (size == 0 || size > PoolMaxSize)
+            return ::operator new(size);
+
+        const size_t index = sizeClass(size);
+        if (Block* block = freeLists.heads[index])
+        {
+            freeLists.heads[index] = block->next;
+            --freeLists.counts[index];
+            return block;
+        }
+
+        return ::operator new((index + 1) * Granularity);
+    }
+
+    void poolDeallocate(void* ptr, size_t size) noexcept
+    {
+        if (size == 0 || size > PoolMaxSize)
+        {
+            ::operator delete(ptr);
+            return;
+        }
+
+        const size_t index = sizeClass(size);
+        if (freeLists.closed
+            || freeLists.counts[index] * (index + 1) * Granularity >= MaxFreeBytesPerClass)
+        {
+            ::operator delete(ptr);
+            return;
+        }
+
+        // Registers the thread's drain before the first block is kept
+        static_cast<void>(&drain);
+
+        auto* block            = static_cast<Block*>(ptr);
+        block->next            = freeLists.heads[index];
+        freeLists.heads[index] = block;
+        ++freeLists.counts[index];
+    }
+
+} // namespace Pistache::Async::Private
@@ -0,0 +1,443 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* async_log.cc
+
+   Per-thread log rings and the background thread draining them
+*/
+
+#include <pistache/async_log.h>
+#include <pistache/pist_syslog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Pistache::Log
+{
+
+    namespace
+    {
+        constexpr size_t MessageSize = 448;
+
+        // The message formatted by the caller, the rest left for the
+        // background thread to format
+        struct Record
+        {
+            std::chrono::system_clock::time_point time;
+            PST_THREAD_ID thread;
+            const char* file;
+            const char* function;
+            int line;
+            int priority;
+            bool andPrintf;
+            char message[MessageSize];
+        };
+
+        // Written by one thread, read by the background one
+        class Ring
+        {
+        public:
+            explicit Ring(size_t records)
+            {
+                size_t size = 1;
+                while (size < std::max<size_t>(records, 2))
+                    size <<= 1;
+
+                records_.resize(size);
+                mask_ = size - 1;
+            }
+
+            // Null, the message being counted as dropped, when full
+            Record* reserve()
+            {
+                const uint64_t tail = tail_.load(std::memory_order_relaxed);
+                if (tail - head_ > mask_)
+                {
+                    head_ = consumed_.load(std::memory_order_acquire);
+                    if (tail - head_ > mask_)
+                    {
+                        dropped_.fetch_add(1, std::memory_order_relaxed);
+                        return nullptr;
+                    }
+                }
+                return &records_[tail & mask_];
+            }
+
+            void commit() { tail_.fetch_add(1, std::memory_order_release); }
+
+            // Passes each record written to write, returns how many
+            template <typename Write>
+            size_t drain(Write&& write)
+            {
+                uint64_t head       = consumed_.load(std::memory_order_relaxed);
+                const uint64_t tail = tail_.load(std::memory_order_acquire);
+                for (; head != tail; ++head)
+                    write(records_[head & mask_]);
+
+                const size_t count = tail - consumed_.load(std::memory_order_relaxed);
+                consumed_.store(tail, std::memory_order_release);
+                return count;
+            }
+
+            uint64_t written() const { return tail_.load(std::memory_order_acquire); }
+            uint64_t consumed() const { return consumed_.load(std::memory_order_acquire); }
+            uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+        private:
+            std::vector<Record> records_;
+            uint64_t mask_ = 0;
+
+            // The producer's cached copy of consumed_
+            uint64_t head_ = 0;
+
+            alignas(64) std::atomic<uint64_t> tail_ { 0 };
+            alignas(64) std::atomic<uint64_t> consumed_ { 0 };
+            alignas(64) std::atomic<uint64_t> dropped_ { 0 };
+        };
+
+        class Backend
+        {
+        public:
+            void start(const AsyncLog::Options& options)
+            {
+                std::lock_guard<std::mutex> lifecycle(lifecycleMtx_);
+                std::lock_guard<std::mutex> guard(mtx_);
+                if (thread_.joinable())
+                    throw std::runtime_error("Asynchronous logging already started");
+
+                FILE* out = nullptr;
+                if (options.sink == AsyncLog::Sink::File)
+                {
+                    out = fopen(options.path.c_str(), "a");
+                    if (!out)
+                        throw std::runtime_error("Cannot open log file " + options.path);
+                }
+                else if (options.sink == AsyncLog::Sink::Stdout)
+                {
+                    out = stdout;
+                }
+
+                out_     = out;
+                options_ = options;
+                records_.store(options.records, std::memory_order_relaxed);
+                running_.store(true, std::memory_order_release);
+                thread_ = std::thread([this] { run(); });
+            }
+
+            void stop()
+            {
+                std::lock_guard<std::mutex> lifecycle(lifecycleMtx_);
+
+                std::thread thread;
+                {
+                    std::lock_guard<std::mutex> lock(mtx_);
+                    if (!thread_.joinable())
+                        return;
+                    running_.store(false, std::memory_order_release);
+                    thread = std::move(thread_);
+                }
+                thread.join();
+
+                std::lock_guard<std::mutex> lock(mtx_);
+                if (out_ && out_ != stdout)
+                    fclose(out_);
+                out_ = nullptr;
+            }
+
+            bool isRunning() const { return running_.load(std::memory_order_acquire); }
+
+            // The calling thread's, kept until drained once the thread is gone
+            Ring& ring()
+            {
+                thread_local std::shared_ptr<Ring> ring;
+                if (!ring)
+                {
+                    ring = std::make_shared<Ring>(records_.load(std::memory_order_relaxed));
+
+                    std::lock_guard<std::mutex> guard(mtx_);
+                    rings_.push_back(ring);
+                }
+                return *ring;
+            }
+
+            void flush()
+            {
+                std::lock_guard<std::mutex> lifecycle(lifecycleMtx_);
+
+                std::vector<std::pair<std::shared_ptr<Ring>, uint64_t>> pending;
+                FILE* out = nullptr;
+                {
+                    std::lock_guard<std::mutex> guard(mtx_);
+                    if (!thread_.joinable())
+                        return;
+                    for (const auto& ring : rings_)
+                        pending.emplace_back(ring, ring->written());
+                    out = out_;
+                }
+
+                for (const auto& [ring, written] : pending)
+                {
+                    while (ring->consumed() < written && isRunning())
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+
+                if (out)
+                    fflush(out);
+            }
+
+            AsyncLog::Stats stats()
+            {
+                std::lock_guard<std::mutex> guard(mtx_);
+
+                AsyncLog::Stats stats;
+                stats.written = written_;
+                stats.dropped = retiredDrops_;
+                for (const auto& ring : rings_)
+                    stats.dropped += ring->dropped();
+                return stats;
+            }
+
+        private:
+            void run()
+            {
+                for (;;)
+                {
+                    const bool stopping = !isRunning();
+                    const size_t count  = drainAll();
+                    if (stopping)
+                        break;
+                    if (count == 0)
+                        std::this_thread::sleep_for(options_.interval);
+                }
+            }
+
+            // Writes what every ring holds, forgets the rings of the threads
+            // that are gone once empty
+            size_t drainAll()
+            {
+                std::vector<std::shared_ptr<Ring>> rings;
+                {
+                    std::lock_guard<std::mutex> guard(mtx_);
+                    rings = rings_;
+                }
+
+                size_t count   = 0;
+                uint64_t drops = 0;
+                for (const auto& ring : rings)
+                {
+                    count += ring->drain([this](const Record& record) { write(record); });
+                    drops += ring->dropped();
+                }
+
+                std::lock_guard<std::mutex> guard(mtx_);
+                written_ += count;
+
+                drops += retiredDrops_;
+                if (drops > reportedDrops_)
+                {
+                    char notice[96];
+                    snprintf(notice, sizeof(notice), "%llu log messages dropped, log rings full",
+                             static_cast<unsigned long long>(drops - reportedDrops_));
+                    Private::emitLog(out_, LOG_WARNING, false, PST_THREAD_ID_SELF(),
+                                     std::chrono::system_clock::now(), notice);
+                    reportedDrops_ = drops;
+                }
+
+                // The ring's own reference and the copy above
+                rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                            [this](const std::shared_ptr<Ring>& ring) {
+                                                if (ring.use_count() > 2 || ring->consumed() != ring->written())
+                                                    return false;
+                                                retiredDrops_ += ring->dropped();
+                                                return true;
+                                            }),
+                             rings_.end());
+
+                if (count && out_)
+                    fflush(out_);
+                return count;
+            }
+
+            void write(const Record& record) const
+            {
+                const char* file = record.file;
+                if (file)
+                {
+                    for (const char* c = file; *c; ++c)
+                    {
+                        if (*c == '/' || *c == '\\')
+                            file = c + 1;
+                    }
+                }
+
+                char buf[MessageSize + 256];
+                if (file && record.function)
+                    snprintf(buf, sizeof(buf), "%s:%d in %s(): %s", file, record.line,
+                             record.function, record.message);
+                else if (file)
+                    snprintf(buf, sizeof(buf), "%s:%d: %s", file, record.line, record.message);
+                else
+                    snprintf(buf, sizeof(buf), "%s", record.message);
+
+                Private::emitLog(out_, record.priority, record.andPrintf, record.thread,
+                                 record.time, buf);
+            }
+
+            // Taken by the producers only when a thread logs for the first
+            // time
+            std::mutex mtx_;
+
+            // Serializes start and stop
+            std::mutex lifecycleMtx_;
+
+            std::vector<std::shared_ptr<Ring>> rings_;
+            std::thread thread_;
+            std::atomic<bool> running_ { false };
+            std::atomic<size_t> records_ { 256 };
+
+            AsyncLog::Options options_;
+            FILE* out_ = nullptr;
+
+            uint64_t written_       = 0;
+            uint64_t retiredDrops_  = 0;
+            uint64_t reportedDrops_ = 0;
+        };
+
+        // Never destroyed, for static objects to be able to log while
+        // destroyed, synchronously once it is stopped at exit
+        Backend& backend()
+        {
+            static Backend* instance = new Backend;
+            return *instance;
+        }
+
+        struct StopAtExit
+        {
+            ~StopAtExit() { backend().stop(); }
+        } stopAtExit;
+
+        Record* reserve(Ring& ring, int priority, bool andPrintf, const char* file,
+                        int line, const char* function)
+        {
+            Record* record = ring.reserve();
+            if (!record)
+                return nullptr;
+
+            record->time      = std::chrono::system_clock::now();
+            record->thread    = PST_THREAD_ID_SELF();
+            record->file      = file;
+            record->function  = function;
+            record->line      = line;
+            record->priority  = priority;
+            record->andPrintf = andPrintf;
+            return record;
+        }
+
+        void markTruncated(Record* record, int length)
+        {
+            if (length >= static_cast<int>(MessageSize))
+                memcpy(record->message + MessageSize - 4, "...", 4);
+            else if (length < 0)
+                record->message[0] = 0;
+        }
+
+        int syslogPriority(Level level)
+        {
+            switch (level)
+            {
+            case Level::LL_TRACE:
+            case Level::LL_DEBUG:
+                return LOG_DEBUG;
+            case Level::LL_INFO:
+                return LOG_INFO;
+            case Level::LL_WARN:
+                return LOG_WARNING;
+            case Level::LL_ERROR:
+                return LOG_ERR;
+            case Level::LL_FATAL:
+                return LOG_ALERT;
+            }
+            return LOG_ERR;
+        }
+    }
+
+    void AsyncLog::start() { start(Options()); }
+
+    void AsyncLog::start(const Options& options) { backend().start(options); }
+
+    void AsyncLog::stop() { backend().stop(); }
+
+    bool AsyncLog::isRunning() { return backend().isRunning(); }
+
+    bool AsyncLog::log(int priority, bool andPrintf,
+                       const char* file, int line, const char* function,
+                       const char* format, va_list ap)
+    {
+        if (!isRunning() || !format)
+            return false;
+
+        Ring& ring     = backend().ring();
+        Record* record = reserve(ring, priority, andPrintf, file, line, function);
+        if (!record)
+            return false;
+
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wformat-nonliteral"
+#endif
+        markTruncated(record, vsnprintf(record->message, MessageSize, format, ap));
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
+
+        ring.commit();
+        return true;
+    }
+
+    bool AsyncLog::log(int priority, bool andPrintf, const char* message)
+    {
+        if (!isRunning() || !message)
+            return false;
+
+        Ring& ring     = backend().ring();
+        Record* record = reserve(ring, priority, andPrintf, nullptr, 0, nullptr);
+        if (!record)
+            return false;
+
+        markTruncated(record, snprintf(record->message, MessageSize, "%s", message));
+
+        ring.commit();
+        return true;
+    }
+
+    void AsyncLog::flush() { backend().flush(); }
+
+    AsyncLog::Stats AsyncLog::stats() { return backend().stats(); }
+
+    void AsyncStringLogger::log(Level level, const std::string& message)
+    {
+        if (!isEnabledFor(level))
+            return;
+
+        if (!AsyncLog::isRunning())
+            PSLogNoLocFn(syslogPriority(level), false, "%s", message.c_str());
+        else
+            AsyncLog::log(syslogPriority(level), false, message.c_str());
+    }
+
+    bool AsyncStringLogger::isEnabledFor(Level level) const
+    {
+        return static_cast<int>(level) >= static_cast<int>(level_);
+    }
+
+} // namespace Pistache::Log
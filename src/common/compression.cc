@@ -0,0 +1,554 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* compression.cc
+
+   Implementation of the streaming encoders, of their per-thread pool, and
+   of the cache of compressed representations
+*/
+
+#include <pistache/compression.h>
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+#include <brotli/encode.h>
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+#include <zlib.h>
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+#include <zstd.h>
+#endif
+
+namespace Pistache::Http
+{
+
+    namespace
+    {
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+        class BrotliCompressor : public Compressor
+        {
+        public:
+            explicit BrotliCompressor(int level) { reset(level); }
+
+            ~BrotliCompressor() override
+            {
+                if (state_)
+                    ::BrotliEncoderDestroyInstance(state_);
+            }
+
+            Header::Encoding encoding() const override { return Header::Encoding::Br; }
+
+            void compress(const char* data, size_t size, Flush flush,
+                          std::string& out) override
+            {
+                const auto op = flush == Flush::None ? BROTLI_OPERATION_PROCESS
+                    : flush == Flush::Sync           ? BROTLI_OPERATION_FLUSH
+                                                     : BROTLI_OPERATION_FINISH;
+
+                auto nextIn    = reinterpret_cast<const uint8_t*>(data);
+                size_t availIn = size;
+                size_t availOut = 0;
+
+                for (;;)
+                {
+                    // The encoder's own output buffer is taken as is,
+                    // rather than copied through one of ours
+                    if (!::BrotliEncoderCompressStream(state_, op, &availIn, &nextIn,
+                                                       &availOut, nullptr, nullptr))
+                        throw std::runtime_error("BrotliEncoderCompressStream() failed");
+
+                    size_t length      = 0;
+                    const uint8_t* ptr = ::BrotliEncoderTakeOutput(state_, &length);
+                    out.append(reinterpret_cast<const char*>(ptr), length);
+
+                    if (availIn == 0 && !::BrotliEncoderHasMoreOutput(state_)
+                        && (op != BROTLI_OPERATION_FINISH || ::BrotliEncoderIsFinished(state_)))
+                        break;
+                }
+            }
+
+            // Brotli has no way to reset an encoder, only its instance is
+            // recreated
+            void reset(int level) override
+            {
+                if (state_)
+                    ::BrotliEncoderDestroyInstance(state_);
+
+                state_ = ::BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
+                if (!state_)
+                    throw std::runtime_error("BrotliEncoderCreateInstance() failed");
+
+                ::BrotliEncoderSetParameter(state_, BROTLI_PARAM_QUALITY,
+                                            static_cast<uint32_t>(level));
+            }
+
+        private:
+            BrotliEncoderState* state_ = nullptr;
+        };
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+        class ZstdCompressor : public Compressor
+        {
+        public:
+            explicit ZstdCompressor(int level)
+                : ctx_(::ZSTD_createCCtx())
+            {
+                if (!ctx_)
+                    throw std::runtime_error("ZSTD_createCCtx() failed");
+                reset(level);
+            }
+
+            ~ZstdCompressor() override { ::ZSTD_freeCCtx(ctx_); }
+
+            Header::Encoding encoding() const override { return Header::Encoding::Zstd; }
+
+            void compress(const char* data, size_t size, Flush flush,
+                          std::string& out) override
+            {
+                const auto mode = flush == Flush::None ? ZSTD_e_continue
+                    : flush == Flush::Sync             ? ZSTD_e_flush
+                                                       : ZSTD_e_end;
+
+                ZSTD_inBuffer input { data, size, 0 };
+                for (;;)
+                {
+                    const size_t offset = out.size();
+                    out.resize(offset + ::ZSTD_CStreamOutSize());
+
+                    ZSTD_outBuffer output { out.data() + offset, out.size() - offset, 0 };
+                    const size_t remaining = ::ZSTD_compressStream2(ctx_, &output, &input, mode);
+                    out.resize(offset + output.pos);
+
+                    if (::ZSTD_isError(remaining))
+                        throw std::runtime_error(
+                            std::string("ZSTD_compressStream2() failed: ")
+                            + ::ZSTD_getErrorName(remaining));
+
+                    // Without a flush, the encoder is done once it has taken
+                    // all of the input; otherwise once it has output all
+                    if (mode == ZSTD_e_continue ? input.pos == input.size : remaining == 0)
+                        break;
+                }
+            }
+
+            void reset(int level) override
+            {
+                ::ZSTD_CCtx_reset(ctx_, ZSTD_reset_session_only);
+                ::ZSTD_CCtx_setParameter(ctx_, ZSTD_c_compressionLevel, level);
+            }
+
+        private:
+            ZSTD_CCtx* ctx_;
+        };
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+        class DeflateCompressor : public Compressor
+        {
+        public:
+            explicit DeflateCompressor(int level)
+                : level_(level)
+            {
+                // The zlib format, as compress2() used to produce
+                if (::deflateInit(&stream_, level) != Z_OK)
+                    throw std::runtime_error("deflateInit() failed");
+            }
+
+            ~DeflateCompressor() override { ::deflateEnd(&stream_); }
+
+            Header::Encoding encoding() const override { return Header::Encoding::Deflate; }
+
+            void compress(const char* data, size_t size, Flush flush,
+                          std::string& out) override
+            {
+                const int mode = flush == Flush::None ? Z_NO_FLUSH
+                    : flush == Flush::Sync            ? Z_SYNC_FLUSH
+                                                      : Z_FINISH;
+
+                static constexpr size_t OutChunk = 16 * 1024;
+
+                // zlib counts in uInt, feed it big inputs piecewise
+                do
+                {
+                    const size_t piece = std::min<size_t>(size, UINT_MAX);
+                    const bool last    = piece == size;
+
+                    stream_.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+                    stream_.avail_in = static_cast<uInt>(piece);
+
+                    const int pieceMode = last ? mode : Z_NO_FLUSH;
+                    int res;
+                    do
+                    {
+                        const size_t offset = out.size();
+                        out.resize(offset + OutChunk);
+
+                        stream_.next_out  = reinterpret_cast<Bytef*>(out.data() + offset);
+                        stream_.avail_out = static_cast<uInt>(OutChunk);
+
+                        res = ::deflate(&stream_, pieceMode);
+                        out.resize(offset + OutChunk - stream_.avail_out);
+
+                        if (res == Z_STREAM_ERROR)
+                            throw std::runtime_error("deflate() failed");
+                    } while (stream_.avail_out == 0
+                             || (pieceMode == Z_FINISH && res != Z_STREAM_END));
+
+                    data += piece;
+                    size -= piece;
+                } while (size > 0);
+            }
+
+            void reset(int level) override
+            {
+                if (::deflateReset(&stream_) != Z_OK)
+                    throw std::runtime_error("deflateReset() failed");
+
+                if (level != level_)
+                {
+                    // Nothing has been compressed since the reset, so this
+                    // outputs nothing
+                    if (::deflateParams(&stream_, level, Z_DEFAULT_STRATEGY) != Z_OK)
+                        throw std::runtime_error("deflateParams() failed");
+                    level_ = level;
+                }
+            }
+
+        private:
+            z_stream stream_ {};
+            int level_;
+        };
+#endif
+
+        std::unique_ptr<Compressor> makeCompressor(Header::Encoding encoding,
+                                                   [[maybe_unused]] int level)
+        {
+            switch (encoding)
+            {
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+            case Header::Encoding::Br:
+                return std::make_unique<BrotliCompressor>(level);
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+            case Header::Encoding::Zstd:
+                return std::make_unique<ZstdCompressor>(level);
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+            case Header::Encoding::Deflate:
+                return std::make_unique<DeflateCompressor>(level);
+#endif
+
+            default:
+                throw std::runtime_error("Unsupported content encoding compression requested.");
+            }
+        }
+
+        // Idle compressors of the calling thread, by encoding
+        struct Pool
+        {
+            Pool() { alive = true; }
+            ~Pool() { alive = false; }
+
+            std::vector<std::unique_ptr<Compressor>>& idle(Header::Encoding encoding)
+            {
+                return compressors[static_cast<size_t>(encoding)];
+            }
+
+            std::vector<std::unique_ptr<Compressor>>
+                compressors[static_cast<size_t>(Header::Encoding::Unknown) + 1];
+
+            // A handle released during thread exit must not reach a pool
+            // already destroyed
+            static thread_local bool alive;
+        };
+
+        thread_local bool Pool::alive = false;
+
+        Pool& pool()
+        {
+            static thread_local Pool threadPool;
+            return threadPool;
+        }
+
+    } // namespace
+
+    void CompressorPool::Release::operator()(Compressor* compressor) const
+    {
+        std::unique_ptr<Compressor> owned(compressor);
+        if (!Pool::alive)
+            return;
+
+        auto& idle = pool().idle(compressor->encoding());
+        if (idle.size() < MaxIdle)
+            idle.push_back(std::move(owned));
+    }
+
+    CompressorPool::Handle CompressorPool::acquire(Header::Encoding encoding, int level)
+    {
+        auto& idle = pool().idle(encoding);
+        if (!idle.empty())
+        {
+            auto compressor = std::move(idle.back());
+            idle.pop_back();
+
+            compressor->reset(level);
+            return Handle(compressor.release());
+        }
+
+        return Handle(makeCompressor(encoding, level).release());
+    }
+
+    size_t CompressorPool::idle(Header::Encoding encoding)
+    {
+        return pool().idle(encoding).size();
+    }
+
+    namespace
+    {
+        uint64_t rotl(uint64_t x, int b) { return (x << b) | (x >> (64 - b)); }
+
+        void sipRound(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3)
+        {
+            v0 += v1;
+            v1 = rotl(v1, 13);
+            v1 ^= v0;
+            v0 = rotl(v0, 32);
+            v2 += v3;
+            v3 = rotl(v3, 16);
+            v3 ^= v2;
+            v0 += v3;
+            v3 = rotl(v3, 21);
+            v3 ^= v0;
+            v2 += v1;
+            v1 = rotl(v1, 17);
+            v1 ^= v2;
+            v2 = rotl(v2, 32);
+        }
+
+        uint64_t readLe64(const unsigned char* p, size_t len)
+        {
+            uint64_t value = 0;
+            for (size_t i = 0; i < len; ++i)
+                value |= static_cast<uint64_t>(p[i]) << (8 * i);
+            return value;
+        }
+
+        // SipHash-2-4 with its 128-bit output
+        std::array<uint64_t, 2> sipHash128(const std::array<uint64_t, 2>& key,
+                                           const char* data, size_t size)
+        {
+            std::array<uint64_t, 2> out {};
+            uint64_t v0 = 0x736f6d6570736575ULL ^ key[0];
+            uint64_t v1 = 0x646f72616e646f6dULL ^ key[1] ^ 0xee;
+            uint64_t v2 = 0x6c7967656e657261ULL ^ key[0];
+            uint64_t v3 = 0x7465646279746573ULL ^ key[1];
+
+            const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+            const size_t tail = size & 7;
+            for (const auto* end = bytes + (size - tail); bytes != end; bytes += 8)
+            {
+                const uint64_t m = readLe64(bytes, 8);
+                v3 ^= m;
+                sipRound(v0, v1, v2, v3);
+                sipRound(v0, v1, v2, v3);
+                v0 ^= m;
+            }
+
+            const uint64_t last = (static_cast<uint64_t>(size) << 56) | readLe64(bytes, tail);
+            v3 ^= last;
+            sipRound(v0, v1, v2, v3);
+            sipRound(v0, v1, v2, v3);
+            v0 ^= last;
+
+            v2 ^= 0xee;
+            for (int i = 0; i < 4; ++i)
+                sipRound(v0, v1, v2, v3);
+            out[0] = v0 ^ v1 ^ v2 ^ v3;
+
+            v1 ^= 0xdd;
+            for (int i = 0; i < 4; ++i)
+                sipRound(v0, v1, v2, v3);
+            out[1] = v0 ^ v1 ^ v2 ^ v3;
+            return out;
+        }
+
+        // Drawn once per process, so that which bodies collide cannot be
+        // worked out from outside
+        const std::array<uint64_t, 2>& bodyIdKey()
+        {
+            static const auto key = [] {
+                std::random_device device;
+                std::array<uint64_t, 2> words {};
+                for (auto& word : words)
+                    word = (static_cast<uint64_t>(device()) << 32) | device();
+                return words;
+            }();
+            return key;
+        }
+
+    } // namespace
+
+    CompressedCache::CompressedCache(size_t maxBytes)
+        : maxBytes_(maxBytes)
+    { }
+
+    std::string CompressedCache::bodyId(const char* data, size_t size)
+    {
+        const auto hash = sipHash128(bodyIdKey(), data, size);
+
+        char id[64];
+        std::snprintf(id, sizeof(id), "%016llx%016llx-%zx",
+                      static_cast<unsigned long long>(hash[0]),
+                      static_cast<unsigned long long>(hash[1]), size);
+        return id;
+    }
+
+    std::shared_ptr<const std::string> CompressedCache::get(const Key& key)
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+
+        auto it = slots_.find(key);
+        if (it == slots_.end())
+        {
+            ++stats_.misses;
+            return nullptr;
+        }
+
+        ++stats_.hits;
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        return it->second.compressed;
+    }
+
+    std::shared_ptr<const std::string>
+    CompressedCache::getOrCompress(const Key& key, const char* data, size_t size)
+    {
+        if (auto cached = get(key))
+            return cached;
+
+        return compress(key, data, size);
+    }
+
+    std::shared_ptr<const std::string>
+    CompressedCache::compress(const Key& key, const char* data, size_t size)
+    {
+        // Not under the lock, this is the costly part. Two threads missing
+        // the same key both compress it, the last one's is kept
+        auto compressor = CompressorPool::acquire(key.encoding, key.level);
+
+        std::string compressed;
+        compressor->compress(data, size, Compressor::Flush::Finish, compressed);
+        compressed.shrink_to_fit();
+
+        auto shared = std::make_shared<const std::string>(std::move(compressed));
+        put(key, shared);
+        return shared;
+    }
+
+    void CompressedCache::put(const Key& key, std::shared_ptr<const std::string> compressed)
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+
+        if (!compressed || compressed->size() > maxBytes_)
+            return;
+
+        auto it = slots_.find(key);
+        if (it != slots_.end())
+        {
+            bytes_ -= it->second.compressed->size();
+            lru_.erase(it->second.lru);
+            slots_.erase(it);
+        }
+
+        lru_.push_front(key);
+        bytes_ += compressed->size();
+        slots_.emplace(key, Slot { std::move(compressed), lru_.begin() });
+
+        evictLocked();
+    }
+
+    void CompressedCache::clear()
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+
+        slots_.clear();
+        lru_.clear();
+        bytes_ = 0;
+    }
+
+    void CompressedCache::setMaxBytes(size_t maxBytes)
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+
+        maxBytes_ = maxBytes;
+        evictLocked();
+    }
+
+    size_t CompressedCache::maxBytes() const
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        return maxBytes_;
+    }
+
+    size_t CompressedCache::bytes() const
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        return bytes_;
+    }
+
+    size_t CompressedCache::size() const
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        return slots_.size();
+    }
+
+    CompressedCache::Stats CompressedCache::stats() const
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        return stats_;
+    }
+
+    CompressedCache& CompressedCache::instance()
+    {
+        static CompressedCache cache;
+        return cache;
+    }
+
+    size_t CompressedCache::KeyHash::operator()(const Key& key) const
+    {
+        const size_t variant = static_cast<size_t>(key.encoding) << 8
+            | static_cast<size_t>(key.level & 0xff);
+        return std::hash<std::string> {}(key.id) ^ (variant * 0x9e3779b97f4a7c15ULL);
+    }
+
+    void CompressedCache::evictLocked()
+    {
+        while (bytes_ > maxBytes_ && !lru_.empty())
+        {
+            auto it = slots_.find(lru_.back());
+            bytes_ -= it->second.compressed->size();
+            slots_.erase(it);
+            lru_.pop_back();
+            ++stats_.evictions;
+        }
+    }
+
+} // namespace Pistache::Http
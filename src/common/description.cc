@@ -495,7 +495,7 @@ namespace Pistache::Rest
                 else
                 {
                     auto index = uiDir.join("index.html");
-                    Http::serveFile(response, index);
+                    Http::serveFile(response, req, index);
                 }
                 return Route::Result::Ok;
             }
@@ -509,7 +509,7 @@ namespace Pistache::Rest
                 // In C++20, use std::string::starts_with()
                 if (path.rfind(uiDirectory_, 0) == 0)
                 {
-                    Http::serveFile(response, path);
+                    Http::serveFile(response, req, path);
                     return Route::Result::Ok;
                 }
                 else
@@ -521,6 +521,16 @@ namespace Pistache::Rest
 
             else if (res == apiPath_)
             {
+                // The description only changes when the API does, so its
+                // compressed form is cached rather than redone every time
+                const auto encoding = req.getBestAcceptEncoding();
+                if (encoding != Http::Header::Encoding::Identity)
+                {
+                    response.setCompression(encoding);
+                    response.setCompressionCache(true);
+                }
+                response.headers().add<Http::Header::Vary>("Accept-Encoding");
+
                 response.send(Http::Code::Ok, serializer_(description_),
                               MIME(Application, Json));
                 return Route::Result::Ok;
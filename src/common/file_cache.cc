@@ -0,0 +1,380 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* file_cache.cc
+
+   Implementation of the open file cache
+*/
+
+#include <pistache/winornix.h>
+
+#include <pistache/file_cache.h>
+#include <pistache/http.h>
+#include <pistache/pist_syslog.h>
+
+#include PST_STRERROR_R_HDR
+
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+
+#include <fcntl.h> // for file-constants (_O_RDONLY etc.) in Windows
+#include PST_FCNTL_HDR
+
+#include PST_MISC_IO_HDR // for _close (io.h / unistd.h)
+#include PIST_FILEFNS_HDR // for "open"
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace Pistache::Http
+{
+
+#ifdef __linux__
+    namespace
+    {
+        constexpr uint32_t WatchMask = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE
+            | IN_MOVE_SELF | IN_DELETE_SELF;
+
+        // Hits do not each pay a read() on the inotify fd
+        constexpr std::chrono::nanoseconds DrainInterval = std::chrono::milliseconds(1);
+    }
+#endif
+
+    FileCache::FileCache(size_t capacity, std::chrono::milliseconds ttl)
+        : capacity_(capacity)
+        , ttl_(ttl)
+    {
+#ifdef __linux__
+        inotifyFd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd_ == -1)
+            PS_LOG_WARNING("inotify unavailable, cached files expire on TTL only");
+#endif
+    }
+
+    FileCache::~FileCache()
+    {
+        if (inotifyFd_ != -1)
+            PST_FILE_CLOSE(inotifyFd_);
+    }
+
+    std::shared_ptr<const FileCache::Entry> FileCache::get(const std::string& path)
+    {
+        return lookup(path, false);
+    }
+
+    std::shared_ptr<const FileCache::Entry> FileCache::find(const std::string& path)
+    {
+        auto entry = lookup(path, true);
+        return entry->file ? entry : nullptr;
+    }
+
+    std::shared_ptr<const FileCache::Entry> FileCache::lookup(const std::string& path,
+                                                              bool allowMissing)
+    {
+        drainEvents();
+
+        // A file known to be missing may have appeared since, get() has to
+        // make sure
+        auto fresh = [&](const Slot& slot) {
+            const auto& entry = slot.entry;
+            return (entry->file || allowMissing)
+                && std::chrono::steady_clock::now() - entry->loaded < ttl_;
+        };
+
+        {
+            std::shared_lock<std::shared_mutex> guard(lock_);
+
+            auto it = slots_.find(path);
+            if (it != slots_.end() && fresh(it->second))
+            {
+                ++hits_;
+                it->second.used.store(++ticks_, std::memory_order_relaxed);
+                return it->second.entry;
+            }
+        }
+
+        {
+            std::unique_lock<std::shared_mutex> guard(lock_);
+
+            auto it = slots_.find(path);
+            if (it != slots_.end())
+            {
+                // Another thread may have loaded it meanwhile
+                if (fresh(it->second))
+                {
+                    ++hits_;
+                    it->second.used.store(++ticks_, std::memory_order_relaxed);
+                    return it->second.entry;
+                }
+
+                if (it->second.entry->file || allowMissing)
+                    ++stats_.evictions;
+                eraseLocked(it);
+            }
+
+            ++stats_.misses;
+        }
+
+        // Not under the lock, so that opening one file does not hold up
+        // hits on others
+        auto entry = load(path, allowMissing);
+
+        std::unique_lock<std::shared_mutex> guard(lock_);
+        if (capacity_ == 0)
+            return entry;
+
+        // Another thread may have loaded the same file meanwhile, ours is
+        // at least as recent
+        auto it = slots_.find(path);
+        if (it != slots_.end())
+            eraseLocked(it);
+
+        // A missing file cannot be watched, it waits for the TTL
+        int watch = -1;
+#ifdef __linux__
+        if (inotifyFd_ != -1 && entry->file)
+        {
+            watch = ::inotify_add_watch(inotifyFd_, path.c_str(), WatchMask);
+            if (watch != -1)
+                watches_[watch].push_back(path);
+        }
+#endif
+
+        auto& slot = slots_.try_emplace(path).first->second;
+        slot.entry = entry;
+        slot.used.store(++ticks_, std::memory_order_relaxed);
+        slot.watch = watch;
+        evictLocked();
+
+        return entry;
+    }
+
+    void FileCache::invalidate(const std::string& path)
+    {
+        std::unique_lock<std::shared_mutex> guard(lock_);
+
+        auto it = slots_.find(path);
+        if (it != slots_.end())
+        {
+            ++stats_.invalidations;
+            eraseLocked(it);
+        }
+    }
+
+    void FileCache::clear()
+    {
+        std::unique_lock<std::shared_mutex> guard(lock_);
+
+        while (!slots_.empty())
+            eraseLocked(slots_.begin());
+    }
+
+    void FileCache::setCapacity(size_t capacity)
+    {
+        std::unique_lock<std::shared_mutex> guard(lock_);
+
+        capacity_ = capacity;
+        evictLocked();
+    }
+
+    void FileCache::setTtl(std::chrono::milliseconds ttl)
+    {
+        std::unique_lock<std::shared_mutex> guard(lock_);
+        ttl_ = ttl;
+    }
+
+    size_t FileCache::capacity() const
+    {
+        std::shared_lock<std::shared_mutex> guard(lock_);
+        return capacity_;
+    }
+
+    size_t FileCache::size() const
+    {
+        std::shared_lock<std::shared_mutex> guard(lock_);
+        return slots_.size();
+    }
+
+    FileCache::Stats FileCache::stats() const
+    {
+        std::shared_lock<std::shared_mutex> guard(lock_);
+
+        auto stats = stats_;
+        stats.hits = hits_.load();
+        return stats;
+    }
+
+    FileCache& FileCache::instance()
+    {
+        static FileCache cache;
+        return cache;
+    }
+
+    std::shared_ptr<const FileCache::Entry> FileCache::load(const std::string& path,
+                                                            bool allowMissing)
+    {
+        int fd = PST_FILE_OPEN(path.c_str(), PST_O_RDONLY);
+        if (fd == -1 && allowMissing && (errno == ENOENT || errno == ENOTDIR))
+        {
+            auto missing    = std::make_shared<Entry>();
+            missing->path   = path;
+            missing->loaded = std::chrono::steady_clock::now();
+            return missing;
+        }
+
+        if (fd == -1)
+        {
+            PST_DECL_SE_ERR_P_EXTRA;
+            std::string str_error(PST_STRERROR_R_ERRNO);
+            if (errno == ENOENT)
+            {
+                throw HttpError(Http::Code::Not_Found, std::move(str_error));
+            }
+            throw HttpError(Http::Code::Internal_Server_Error, std::move(str_error));
+        }
+
+        auto entry  = std::make_shared<Entry>();
+        entry->path = path;
+        entry->file = std::make_shared<const OpenFile>(fd);
+
+        struct stat sb;
+        if (::fstat(fd, &sb) == -1)
+        {
+            throw HttpError(Code::Internal_Server_Error, "");
+        }
+
+        entry->size   = static_cast<size_t>(sb.st_size);
+        entry->mtime  = sb.st_mtime;
+        entry->mime   = Mime::MediaType::fromFile(path.c_str());
+        entry->loaded = std::chrono::steady_clock::now();
+
+        std::ostringstream oss;
+        oss << std::hex << static_cast<uint64_t>(sb.st_mtime) << '-' << entry->size;
+        entry->etag = oss.str();
+
+        return entry;
+    }
+
+    void FileCache::drainEvents()
+    {
+#ifdef __linux__
+        if (inotifyFd_ == -1)
+            return;
+
+        // One thread drains, the others go on as if it was done already
+        const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now().time_since_epoch())
+                                .count();
+        auto due = nextDrain_.load(std::memory_order_relaxed);
+        if (now < due
+            || !nextDrain_.compare_exchange_strong(due, now + DrainInterval.count()))
+            return;
+
+        std::unique_lock<std::shared_mutex> guard(lock_);
+        processEvents();
+#endif
+    }
+
+    void FileCache::processEvents()
+    {
+#ifdef __linux__
+        if (inotifyFd_ == -1)
+            return;
+
+        alignas(struct inotify_event) char buffer[4096];
+        for (;;)
+        {
+            const auto bytes = ::read(inotifyFd_, buffer, sizeof(buffer));
+            if (bytes <= 0)
+                break;
+
+            for (char* ptr = buffer; ptr < buffer + bytes;)
+            {
+                const auto* event = reinterpret_cast<const struct inotify_event*>(ptr);
+                ptr += sizeof(struct inotify_event) + event->len;
+
+                // Events were lost, any entry may be stale
+                if (event->mask & IN_Q_OVERFLOW)
+                {
+                    stats_.invalidations += slots_.size();
+                    while (!slots_.empty())
+                        eraseLocked(slots_.begin());
+                    continue;
+                }
+
+                auto watch = watches_.find(event->wd);
+                if (watch == watches_.end())
+                    continue;
+
+                const auto paths = watch->second;
+                if (event->mask & IN_IGNORED)
+                {
+                    // The kernel dropped the watch already
+                    for (const auto& path : paths)
+                    {
+                        auto it = slots_.find(path);
+                        if (it != slots_.end())
+                            it->second.watch = -1;
+                    }
+                    watches_.erase(watch);
+                }
+
+                for (const auto& path : paths)
+                {
+                    auto it = slots_.find(path);
+                    if (it != slots_.end())
+                    {
+                        ++stats_.invalidations;
+                        eraseLocked(it);
+                    }
+                }
+            }
+        }
+#endif
+    }
+
+    void FileCache::eraseLocked(std::unordered_map<std::string, Slot>::iterator it)
+    {
+#ifdef __linux__
+        if (it->second.watch != -1)
+        {
+            auto watch = watches_.find(it->second.watch);
+            if (watch != watches_.end())
+            {
+                auto& paths = watch->second;
+                paths.erase(std::remove(paths.begin(), paths.end(), it->first), paths.end());
+                if (paths.empty())
+                {
+                    ::inotify_rm_watch(inotifyFd_, watch->first);
+                    watches_.erase(watch);
+                }
+            }
+        }
+#endif
+
+        slots_.erase(it);
+    }
+
+    void FileCache::evictLocked()
+    {
+        while (slots_.size() > capacity_)
+        {
+            auto oldest = std::min_element(slots_.begin(), slots_.end(), [](const auto& a, const auto& b) {
+                return a.second.used.load(std::memory_order_relaxed)
+                    < b.second.used.load(std::memory_order_relaxed);
+            });
+
+            ++stats_.evictions;
+            eraseLocked(oldest);
+        }
+    }
+
+} // namespace Pistache::Http
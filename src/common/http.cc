@@ -12,22 +12,31 @@
 
 #include <pistache/winornix.h>
 
+#include <pistache/compression.h>
 #include <pistache/config.h>
 #include <pistache/eventmeth.h>
+#include <pistache/file_cache.h>
 #include <pistache/http.h>
 #include <pistache/http_header.h>
+#include <pistache/metrics.h>
 #include <pistache/net.h>
 #include <pistache/peer.h>
+#include <pistache/simd_scan.h>
+#include <pistache/small_vector.h>
 #include <pistache/transport.h>
 
 #include PST_STRERROR_R_HDR
 
+#include <algorithm>
 #include <charconv>
 #include <cstring>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -60,6 +69,10 @@ namespace Pistache::Http
 
     namespace
     {
+        // Bodies larger than this are sent as a buffer of their own after
+        // the headers, rather than copied behind them
+        constexpr size_t MaxInlineBody = 16 * 1024;
+
         bool writeStatusLine(Version version, Code code, DynamicStreamBuf& buf)
         {
 #define PST_OUT(...)      \
@@ -138,6 +151,93 @@ namespace Pistache::Http
 #undef METHOD
         };
 
+        // Through the response's slot if it has one, to go out in turn
+        template <typename Write>
+        Async::Promise<PST_SSIZE_T> writeInTurn(const std::shared_ptr<Private::ResponseSlot>& slot,
+                                                Write&& write)
+        {
+            if (!slot)
+                return write();
+            return slot->write(std::forward<Write>(write));
+        }
+
+        // Once the response's last write is queued, those after it need not
+        // wait for its writer to be gone
+        void releaseSlot(const std::shared_ptr<Private::ResponseSlot>& slot)
+        {
+            if (slot)
+                slot->release();
+        }
+
+        // Passes the bodies the handler streams on to it, pausing reads from
+        // the peer while it is busy with a part
+        class BodyStreamer : public Private::BodyConsumer
+        {
+        public:
+            BodyStreamer(Handler* handler, Tcp::Transport* transport,
+                         std::weak_ptr<Tcp::Peer> peer, RequestParser* parser)
+                : handler_(handler)
+                , transport_(transport)
+                , peer_(std::move(peer))
+                , parser_(parser)
+            { }
+
+            bool streams(const Message& /*message*/) override
+            {
+                return handler_->streamBody(parser_->request);
+            }
+
+            bool onBody(const char* data, size_t size) override
+            {
+                parser_->touch();
+
+                auto ready = handler_->onBody(parser_->request, data, size);
+                if (!ready.isPending())
+                    return true;
+
+                auto peer = peer_.lock();
+                if (!peer)
+                    return true;
+
+                transport_->pauseReading(peer);
+
+                auto resume = [transport = transport_, peer = peer_]() {
+                    if (auto sp = peer.lock())
+                        transport->resumeReading(sp);
+                };
+                ready.then(resume, [resume](std::exception_ptr) { resume(); });
+                return false;
+            }
+
+        private:
+            Handler* handler_;
+            Tcp::Transport* transport_;
+            std::weak_ptr<Tcp::Peer> peer_;
+            RequestParser* parser_; // which owns this
+        };
+
+        // A span is complete once its handler has returned and its
+        // response's last byte has been written, in whichever order. Both
+        // happen on the peer's transport thread
+        void finishIfComplete(const Trace::Span& span)
+        {
+            if (span.reached(Trace::Phase::HandlerReturned)
+                && span.reached(Trace::Phase::LastByteFlushed))
+                Trace::finish(span);
+        }
+
+        Async::Promise<PST_SSIZE_T> traceFlush(Async::Promise<PST_SSIZE_T> written,
+                                               std::shared_ptr<Trace::Span> span)
+        {
+            return written.then(
+                [span = std::move(span)](PST_SSIZE_T bytes) {
+                    span->mark(Trace::Phase::LastByteFlushed);
+                    finishIfComplete(*span);
+                    return bytes;
+                },
+                Async::Throw);
+        }
+
     } // namespace
 
     namespace Private
@@ -154,101 +254,90 @@ namespace Pistache::Http
 
         State RequestLineStep::apply(StreamCursor& cursor)
         {
-            StreamCursor::Revert revert(cursor);
-
             auto* request = static_cast<Request*>(message);
 
-            StreamCursor::Token methodToken(cursor);
-            if (!match_until(' ', cursor))
-                return State::Again;
-
-            auto it = httpMethods.find(methodToken.text());
-            if (it != httpMethods.end())
-            {
-                request->method_ = it->second;
-            }
-            else
+            // The line is only parsed once it is whole. Until then, the
+            // cursor stays at its start and the search for its end resumes
+            // where it stopped
+            const char* begin   = nullptr;
+            const char* end     = nullptr;
+            const char* lineEnd = nullptr;
+            for (;;)
             {
-                raise("Unknown HTTP request method");
-            }
+                begin = cursor.offset();
+                end   = begin + cursor.remaining();
 
-            int n;
+                lineEnd = Scan::findCrLf(begin + (scanned > 0 ? scanned - 1 : 0), end);
+                if (lineEnd == end)
+                {
+                    scanned = static_cast<size_t>(end - begin);
+                    return State::Again;
+                }
+                if (lineEnd != begin)
+                    break;
 
-            if (cursor.eof())
-                return State::Again;
-            else if ((n = cursor.current()) != ' ')
-                raise("Malformed HTTP request after Method, expected SP");
+                // Empty lines before a request line are ignored, as RFC 9112
+                // section 2.2 allows
+                cursor.advance(2);
+                scanned = 0;
+            }
 
-            if (!cursor.advance(1))
-                return State::Again;
+            const char* methodEnd = Scan::findFirstOf(begin, lineEnd, " ");
+            if (methodEnd == lineEnd)
+                raise("Malformed HTTP request line");
 
-            StreamCursor::Token resToken(cursor);
-            while ((n = cursor.current()) != '?' && n != ' ')
-                if (!cursor.advance(1))
-                    return State::Again;
+            auto it = httpMethods.find(std::string(begin, methodEnd));
+            if (it == httpMethods.end())
+                raise("Unknown HTTP request method");
 
-            request->resource_ = resToken.text();
+            const char* resource    = methodEnd + 1;
+            const char* resourceEnd = Scan::findFirstOf(resource, lineEnd, " ?");
+            if (resourceEnd == lineEnd)
+                raise("Malformed HTTP request line");
 
             // Query parameters of the Uri
-            if (n == '?')
+            SmallVector<std::pair<std::string_view, std::string_view>, 8> query;
+            const char* p = resourceEnd;
+            if (*p == '?')
             {
-                if (!cursor.advance(1))
-                    return State::Again;
-
-                while ((n = cursor.current()) != ' ')
+                ++p;
+                while (p == lineEnd || *p != ' ')
                 {
-                    StreamCursor::Token keyToken(cursor);
-                    if (!match_until({ '=', ' ', '&' }, cursor))
-                        return State::Again;
-
-                    std::string key = keyToken.text();
+                    const char* keyEnd = Scan::findFirstOf(p, lineEnd, "= &");
+                    if (keyEnd == lineEnd)
+                        raise("Malformed HTTP request line");
 
-                    auto c = cursor.current();
-                    if (c == ' ')
+                    const std::string_view key(p, static_cast<size_t>(keyEnd - p));
+                    p = keyEnd;
+                    if (*p == ' ')
                     {
-                        request->query_.add(std::move(key), "");
+                        query.push_back({ key, {} });
                     }
-                    else if (c == '&')
+                    else if (*p == '&')
                     {
-                        request->query_.add(std::move(key), "");
-                        if (!cursor.advance(1))
-                            return State::Again;
+                        query.push_back({ key, {} });
+                        ++p;
                     }
-                    else if (c == '=')
+                    else // '='
                     {
-                        if (!cursor.advance(1))
-                            return State::Again;
-
-                        StreamCursor::Token valueToken(cursor);
-                        if (!match_until({ ' ', '&' }, cursor))
-                            return State::Again;
-
-                        std::string value = valueToken.text();
-                        request->query_.add(std::move(key), std::move(value));
-                        if (cursor.current() == '&')
-                        {
-                            if (!cursor.advance(1))
-                                return State::Again;
-                        }
+                        const char* value    = p + 1;
+                        const char* valueEnd = Scan::findFirstOf(value, lineEnd, " &");
+                        if (valueEnd == lineEnd)
+                            raise("Malformed HTTP request line");
+
+                        query.push_back({ key, std::string_view(value, static_cast<size_t>(valueEnd - value)) });
+                        p = valueEnd;
+                        if (*p == '&')
+                            ++p;
                     }
                 }
             }
 
             // @Todo: Fragment
 
-            // SP
-            if (!cursor.advance(1))
-                return State::Again;
-
-            // HTTP-Version
-            StreamCursor::Token versionToken(cursor);
-
-            while (!cursor.eol())
-                if (!cursor.advance(1))
-                    return State::Again;
-
-            const char* ver   = versionToken.rawText();
-            const size_t size = versionToken.size();
+            // SP, then HTTP-Version
+            const char* ver   = p + 1;
+            const size_t size = static_cast<size_t>(lineEnd - ver);
             if (strncmp(ver, "HTTP/1.0", size) == 0)
             {
                 request->version_ = Version::Http10;
@@ -262,140 +351,146 @@ namespace Pistache::Http
                 raise("Encountered invalid HTTP version");
             }
 
-            if (!cursor.advance(2))
-                return State::Again;
+            request->method_   = it->second;
+            request->resource_ = std::string(resource, resourceEnd);
+            for (const auto& [key, value] : query)
+                request->query_.add(std::string(key), std::string(value));
 
-            revert.ignore();
+            cursor.advance(static_cast<size_t>(lineEnd + 2 - begin));
+            scanned = 0;
             return State::Next;
         }
 
+        void RequestLineStep::reset() { scanned = 0; }
+
         State ResponseLineStep::apply(StreamCursor& cursor)
         {
-            StreamCursor::Revert revert(cursor);
-
             auto* response = static_cast<Response*>(message);
 
-            if (match_raw("HTTP/1.1", strlen("HTTP/1.1"), cursor))
-            {
-                // response->version = Version::Http11;
-            }
-            else if (match_raw("HTTP/1.0", strlen("HTTP/1.0"), cursor))
+            // As for the request line, parsed only once it is whole
+            const char* const begin = cursor.offset();
+            const char* const end   = begin + cursor.remaining();
+
+            const char* lineEnd = Scan::findCrLf(begin + (scanned > 0 ? scanned - 1 : 0), end);
+            if (lineEnd == end)
             {
+                scanned = static_cast<size_t>(end - begin);
+                return State::Again;
             }
-            else
-            {
+
+            const size_t versionSize = strlen("HTTP/1.1");
+            if (lineEnd - begin < static_cast<PST_SSIZE_T>(versionSize)
+                || (strncmp(begin, "HTTP/1.1", versionSize) != 0
+                    && strncmp(begin, "HTTP/1.0", versionSize) != 0))
                 raise("Encountered invalid HTTP version");
-            }
 
-            int n;
             // SP
-            if ((n = cursor.current()) != StreamCursor::Eof && n != ' ')
+            const char* codeBegin = begin + versionSize;
+            if (codeBegin == lineEnd || *codeBegin != ' ')
                 raise("Expected SPACE after http version");
-            if (!cursor.advance(1))
-                return State::Again;
+            ++codeBegin;
 
-            StreamCursor::Token codeToken(cursor);
-            if (!match_until(' ', cursor))
-                return State::Again;
+            const char* codeEnd = Scan::findFirstOf(codeBegin, lineEnd, " ");
 
             int code               = 0;
-            const char* beg        = codeToken.rawText();
-            const char* end        = codeToken.rawText() + codeToken.size();
-            const auto parseResult = std::from_chars(beg, end, code);
+            const auto parseResult = std::from_chars(codeBegin, codeEnd, code);
 
-            if (parseResult.ec != std::errc {} || *parseResult.ptr != ' ')
+            if (parseResult.ec != std::errc {} || parseResult.ptr != codeEnd || codeEnd == lineEnd)
                 raise("Failed to parse return code");
             response->code_ = static_cast<Http::Code>(code);
 
-            if (!cursor.advance(1))
-                return State::Again;
-
-            while (!cursor.eol() && !cursor.eof())
-            {
-                cursor.advance(1);
-            }
-
-            if (!cursor.advance(2))
-                return State::Again;
-
-            revert.ignore();
+            // The reason phrase is ignored
+            cursor.advance(static_cast<size_t>(lineEnd + 2 - begin));
+            scanned = 0;
             return State::Next;
         }
 
+        void ResponseLineStep::reset() { scanned = 0; }
+
         State HeadersStep::apply(StreamCursor& cursor)
         {
-            StreamCursor::Revert revert(cursor);
-
-            while (!cursor.eol())
+            // Each header is added and consumed as soon as its line is
+            // complete, so that none is added twice when more data is needed.
+            // Until then, the searches for its colon and its end resume where
+            // they stopped
+            for (;;)
             {
-                StreamCursor::Revert headerRevert(cursor);
+                const char* const begin = cursor.offset();
+                const char* const end   = begin + cursor.remaining();
 
-                // Read the header name
-                size_t start = cursor;
+                if (colonOffset == NoColon)
+                {
+                    if (scanned == 0)
+                    {
+                        if (end - begin < 2)
+                            return State::Again;
+                        if (begin[0] == '\r' && begin[1] == '\n')
+                            break;
+                    }
 
-                while (cursor.current() != ':')
-                    if (!cursor.advance(1))
+                    // Read the header name
+                    const char* colon = Scan::findFirstOf(begin + scanned, end, ":");
+                    if (colon == end)
+                    {
+                        scanned = static_cast<size_t>(end - begin);
                         return State::Again;
+                    }
+                    colonOffset = static_cast<size_t>(colon - begin);
+                    scanned     = colonOffset + 1;
+                }
+                const char* colon = begin + colonOffset;
 
-                // Skip the ':'
-                if (!cursor.advance(1))
+                // Find the end of the header value
+                const char* valueEnd = Scan::findCrLf(begin + std::max(scanned - 1, colonOffset + 1), end);
+                if (valueEnd == end)
+                {
+                    scanned = static_cast<size_t>(end - begin);
                     return State::Again;
-
-                std::string name = std::string(cursor.offset(start), cursor.diff(start) - 1);
+                }
 
                 // Ignore spaces
-                while (cursor.current() == ' ')
-                    if (!cursor.advance(1))
-                        return State::Again;
+                const char* valueBegin = colon + 1;
+                while (valueBegin != valueEnd && *valueBegin == ' ')
+                    ++valueBegin;
 
-                // Read the header value
-                start = cursor;
-                while (!cursor.eol())
-                {
-                    if (!cursor.advance(1))
-                        return State::Again;
-                }
+                const std::string_view name(begin, static_cast<size_t>(colon - begin));
+                const std::string_view value(valueBegin, static_cast<size_t>(valueEnd - valueBegin));
 
                 if (Header::LowercaseEqualStatic(name, "cookie"))
                 {
                     message->cookies_.removeAllCookies(); // removing existing cookies before
                                                           // re-adding them.
-                    message->cookies_.addFromRaw(cursor.offset(start), cursor.diff(start));
+                    message->cookies_.addFromRaw(value.data(), value.size());
                 }
                 else if (Header::LowercaseEqualStatic(name, "set-cookie"))
                 {
-                    message->cookies_.add(
-                        Cookie::fromRaw(cursor.offset(start), cursor.diff(start)));
-                }
-
-                // If the header is registered with the Registry, add its strongly
-                //  typed form to the headers list...
-                else if (Header::Registry::instance().isRegistered(name))
-                {
-                    std::shared_ptr<Header::Header> header = Header::Registry::instance().makeHeader(name);
-                    header->parseRaw(cursor.offset(start), cursor.diff(start));
-                    message->headers_.add(header);
+                    message->cookies_.add(Cookie::fromRaw(value.data(), value.size()));
                 }
 
-                // But also preserve a raw header version too, regardless of whether
-                //  its type was known to the Registry...
-                std::string value(cursor.offset(start), cursor.diff(start));
-                message->headers_.addRaw(Header::Raw(std::move(name), std::move(value)));
+                // Kept as received, a registered header is only parsed into
+                //  its strongly typed form when first asked for...
+                message->headers_.addReceived(name, value);
 
                 // CRLF
-                if (!cursor.advance(2))
-                    return State::Again;
-
-                headerRevert.ignore();
+                cursor.advance(static_cast<size_t>(valueEnd + 2 - begin));
+                scanned     = 0;
+                colonOffset = NoColon;
             }
 
-            if (!cursor.advance(2))
-                return State::Again;
+            // An unsupported media type is still refused before any handler
+            // is called
+            message->headers_.tryGet<Header::ContentType>();
 
-            revert.ignore();
+            cursor.advance(2);
             return State::Next;
         }
 
+        void HeadersStep::reset()
+        {
+            scanned     = 0;
+            colonOffset = NoColon;
+        }
+
         State BodyStep::apply(StreamCursor& cursor)
         {
             auto cl = message->headers_.tryGet<Header::ContentLength>();
@@ -404,57 +499,49 @@ namespace Pistache::Http
             if (cl && te)
                 raise("Got mutually exclusive ContentLength and TransferEncoding header");
 
+            if (!cl && !te)
+                return State::Done;
+
+            if (!started)
+            {
+                streaming_ = consumer && consumer->streams(*message);
+                started    = true;
+            }
+            paused = false;
+
             if (cl)
                 return parseContentLength(cursor, cl);
 
-            if (te)
-                return parseTransferEncoding(cursor, te);
-
-            return State::Done;
+            return parseTransferEncoding(cursor, te);
         }
 
         State BodyStep::parseContentLength(
             StreamCursor& cursor, const std::shared_ptr<Header::ContentLength>& cl)
         {
-            auto contentLength = cl->value();
+            const auto contentLength = static_cast<size_t>(cl->value());
 
-            auto readBody = [&](size_t size) {
-                StreamCursor::Token token(cursor);
-                const size_t available = cursor.remaining();
-
-                // We have an incomplete body, read what we can
-                if (available < size)
-                {
-                    cursor.advance(available);
-                    message->body_.append(token.rawText(), token.size());
+            // This is the first time we are reading the payload. It could
+            // never fit, whatever the client claims is not to be allocated
+            if (bytesRead == 0 && !streaming_)
+            {
+                if (contentLength > maxSize_)
+                    raise("Request exceeded maximum buffer size", Code::Request_Entity_Too_Large);
 
-                    bytesRead += available;
+                message->body_.reserve(contentLength);
+            }
 
-                    return false;
-                }
+            // Whatever we have of what we still need
+            const size_t size = std::min(cursor.remaining(), contentLength - bytesRead);
 
-                cursor.advance(size);
-                message->body_.append(token.rawText(), token.size());
-                return true;
-            };
+            StreamCursor::Token token(cursor);
+            cursor.advance(size);
+            bytesRead += size;
+            append(token.rawText(), size);
 
-            // We already started to read some bytes but we got an incomplete payload
-            if (bytesRead > 0)
-            {
-                // How many bytes do we still need to read ?
-                const size_t remaining = static_cast<size_t>(
-                    contentLength - bytesRead);
-                if (!readBody(remaining))
-                    return State::Again;
-            }
-            // This is the first time we are reading the payload
-            else
-            {
-                message->body_.reserve(
-                    static_cast<unsigned int>(contentLength));
-                if (!readBody(static_cast<size_t>(contentLength)))
-                    return State::Again;
-            }
+            if (paused)
+                return State::Paused;
+            if (bytesRead < contentLength)
+                return State::Again;
 
             bytesRead = 0;
             return State::Done;
@@ -464,53 +551,64 @@ namespace Pistache::Http
         {
             if (size == -1)
             {
-                StreamCursor::Revert revert(cursor);
-                StreamCursor::Token chunkSize(cursor);
-
-                while (!cursor.eol())
-                    if (!cursor.advance(1))
-                        return Incomplete;
+                // The search for the end of the size line resumes where it
+                // stopped
+                const char* const begin = cursor.offset();
+                const char* const end   = begin + cursor.remaining();
 
-                const char* raw { chunkSize.rawText() };
-                const auto* end { chunkSize.rawText() + chunkSize.size() };
+                const char* lineEnd = Scan::findCrLf(begin + (scanned > 0 ? scanned - 1 : 0), end);
+                if (lineEnd == end)
+                {
+                    scanned = static_cast<size_t>(end - begin);
+                    return Incomplete;
+                }
 
                 size_t sz              = 0;
-                const auto parseResult = std::from_chars(raw, end, sz, 16);
+                const auto parseResult = std::from_chars(begin, lineEnd, sz, 16);
 
-                if (parseResult.ec != std::errc {} || *parseResult.ptr != '\r')
+                if (parseResult.ec != std::errc {} || parseResult.ptr != lineEnd)
                     throw std::runtime_error("Invalid chunk size");
 
                 // CRLF
-                if (!cursor.advance(2))
-                    return Incomplete;
-
-                revert.ignore();
+                cursor.advance(static_cast<size_t>(lineEnd + 2 - begin));
+                scanned = 0;
 
                 size                      = sz;
                 alreadyAppendedChunkBytes = 0;
+
+                if (!step->streaming_)
+                    step->message->body_.reserve(step->message->body_.size() + sz);
             }
 
             if (size == 0)
+            {
+                // The blank line ending the body (no trailers are supported),
+                // not to be taken for the start of a pipelined message. The
+                // last chunk stays pending, size 0, until both of its bytes
+                // are in
+                const size_t remaining = cursor.remaining();
+                if (remaining == 0 || (remaining == 1 && cursor.offset()[0] == '\r'))
+                    return Incomplete;
+                if (cursor.offset()[0] == '\r' && cursor.offset()[1] == '\n')
+                    cursor.advance(2);
                 return Final;
+            }
+
+            // What we have of the chunk's data, and then of its trailing EOL
+            const size_t wanted = static_cast<size_t>(size - alreadyAppendedChunkBytes);
+            const size_t taken  = std::min(cursor.remaining(), wanted);
 
-            message->body_.reserve(size);
             StreamCursor::Token chunkData(cursor);
-            const PST_SSIZE_T available = cursor.remaining();
+            cursor.advance(taken);
+            alreadyAppendedChunkBytes += static_cast<PST_SSIZE_T>(taken);
+            step->append(chunkData.rawText(), taken);
 
-            if (available + alreadyAppendedChunkBytes < size + 2)
-            {
-                cursor.advance(available);
-                message->body_.append(chunkData.rawText(), available);
-                alreadyAppendedChunkBytes += available;
+            if (taken < wanted || cursor.remaining() < 2)
                 return Incomplete;
-            }
-            cursor.advance(size - alreadyAppendedChunkBytes);
 
             // trailing EOL
             cursor.advance(2);
 
-            message->body_.append(chunkData.rawText(), size - alreadyAppendedChunkBytes);
-
             return Complete;
         }
 
@@ -526,9 +624,11 @@ namespace Pistache::Http
                     while ((result = chunk.parse(cursor)) != Chunk::Final)
                     {
                         if (result == Chunk::Incomplete)
-                            return State::Again;
+                            return paused ? State::Paused : State::Again;
 
                         chunk.reset();
+                        if (paused)
+                            return State::Paused;
                         if (cursor.eof())
                             return State::Again;
                     }
@@ -551,6 +651,28 @@ namespace Pistache::Http
             // reach here
         }
 
+        void BodyStep::append(const char* data, size_t size)
+        {
+            if (!streaming_)
+            {
+                message->body_.append(data, size);
+                return;
+            }
+
+            // Nothing new for the consumer when resuming after a pause
+            if (size > 0 && !consumer->onBody(data, size))
+                paused = true;
+        }
+
+        void BodyStep::reset()
+        {
+            chunk.reset();
+            bytesRead  = 0;
+            started    = false;
+            streaming_ = false;
+            paused     = false;
+        }
+
         ParserBase::ParserBase(size_t maxDataSize)
             : buffer(maxDataSize)
             , cursor(&buffer)
@@ -569,23 +691,128 @@ namespace Pistache::Http
                 }
             } while (state == State::Next);
 
-            // Should be either Again or Done
+            // What was passed on of a streamed body is not kept
+            if (bodyStep()->streaming())
+                buffer.discardRead();
+
+            // Input parsed in place is about to go, but for a message done
+            // the next is parsed from it straight away
+            if (state != State::Done)
+                buffer.keepBorrowed();
+
+            // Should be either Again, Done or Paused
             return state;
         }
 
+        void ParserBase::setBodyConsumer(std::unique_ptr<BodyConsumer> consumer)
+        {
+            bodyConsumer = std::move(consumer);
+            bodyStep()->setConsumer(bodyConsumer.get());
+        }
+
+        BodyStep* ParserBase::bodyStep() const
+        {
+            // The last step of requests and responses alike
+            return static_cast<BodyStep*>(allSteps[StepsCount - 1].get());
+        }
+
         bool ParserBase::feed(const char* data, size_t len)
         {
+            // While a body streams, what was passed on of it is gone from the
+            // buffer, and what is left unparsed of the last input (a partial
+            // chunk size line, say) can be on top of a full one
+            if (bodyStep()->streaming())
+                return len <= buffer.maxSize() && buffer.feed(data, len, 2 * buffer.maxSize());
+
             return buffer.feed(data, len);
         }
 
+        bool ParserBase::borrow(const char* data, size_t len)
+        {
+            if (bodyStep()->streaming())
+                return len <= buffer.maxSize() && buffer.borrow(data, len, 2 * buffer.maxSize());
+
+            return buffer.borrow(data, len, buffer.maxSize());
+        }
+
         void ParserBase::reset()
         {
             buffer.reset();
             cursor.reset();
 
+            for (auto& step : allSteps)
+                step->reset();
+            currentStep = 0;
+        }
+
+        void ParserBase::resetKeepingInput()
+        {
+            buffer.discardRead();
+
+            for (auto& step : allSteps)
+                step->reset();
             currentStep = 0;
         }
 
+        std::shared_ptr<ResponseSlot> ResponseQueue::next()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            return std::make_shared<ResponseSlot>(shared_from_this(), nextId++);
+        }
+
+        Async::Promise<PST_SSIZE_T> ResponseQueue::hold(uint64_t id, Write write)
+        {
+            return Async::Promise<PST_SSIZE_T>([&](Async::Deferred<PST_SSIZE_T> deferred) {
+                held[id].push_back(
+                    { std::move(write), std::make_shared<Async::Deferred<PST_SSIZE_T>>(std::move(deferred)) });
+            });
+        }
+
+        void ResponseQueue::release(uint64_t id)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+
+            if (id != current)
+            {
+                released.insert(id);
+                return;
+            }
+
+            // Until a slot that is still in use: its writes held so far go
+            // out, the next ones as they come
+            for (;;)
+            {
+                ++current;
+
+                auto it = held.find(current);
+                if (it != std::end(held))
+                {
+                    for (auto& write : it->second)
+                    {
+                        auto deferred = write.deferred;
+                        write.write().then(
+                            [deferred](PST_SSIZE_T bytes) { deferred->resolve(bytes); },
+                            [deferred](std::exception_ptr& eptr) {
+                                try
+                                {
+                                    std::rethrow_exception(eptr);
+                                }
+                                catch (const std::exception& e)
+                                {
+                                    deferred->reject(Error(e.what()));
+                                }
+                            });
+                    }
+                    held.erase(it);
+                }
+
+                auto done = released.find(current);
+                if (done == std::end(released))
+                    break;
+                released.erase(done);
+            }
+        }
+
         Step* ParserBase::step()
         {
             return allSteps[currentStep].get();
@@ -660,6 +887,36 @@ namespace Pistache::Http
 
     CookieJar& Message::cookies() { return cookies_; }
 
+    void Message::clear()
+    {
+        version_ = Version::Http11;
+        code_    = Code();
+
+        // Not to hold on to a large upload for as long as the connection
+        if (body_.capacity() > Const::MaxBuffer)
+            std::string().swap(body_);
+        else
+            body_.clear();
+
+        cookies_.removeAllCookies();
+        headers_.clear();
+    }
+
+    void Request::clear()
+    {
+        Message::clear();
+
+        method_ = Method();
+        resource_.clear();
+        query_.clear();
+#ifdef LIBSTDCPP_SMARTPTR_LOCK_FIXME
+        peer_.reset();
+#endif
+        address_ = Address();
+        timeout_ = std::chrono::milliseconds(0);
+        span_.reset();
+    }
+
     Method Request::method() const { return method_; }
 
     const std::string& Request::resource() const { return resource_; }
@@ -714,16 +971,22 @@ namespace Pistache::Http
         , buf_(std::move(other.buf_))
         , transport_(other.transport_)
         , timeout_(std::move(other.timeout_))
+        , compressor_(std::move(other.compressor_))
+        , compressed_(std::move(other.compressed_))
+        , slot_(std::move(other.slot_))
+        , span_(std::move(other.span_))
     { }
 
     ResponseStream::ResponseStream(Message&& other, std::weak_ptr<Tcp::Peer> peer,
                                    Tcp::Transport* transport, Timeout timeout,
-                                   size_t streamSize, size_t maxResponseSize)
+                                   size_t streamSize, size_t maxResponseSize,
+                                   CompressorPool::Handle compressor)
         : response_(std::move(other))
         , peer_(std::move(peer))
         , buf_(streamSize, maxResponseSize)
         , transport_(transport)
         , timeout_(std::move(timeout))
+        , compressor_(std::move(compressor))
     {
         if (!writeStatusLine(response_.version(), response_.code(), buf_))
             throw Error("Response exceeded buffer size");
@@ -752,22 +1015,36 @@ namespace Pistache::Http
 
     ResponseStream& ResponseStream::operator=(ResponseStream&& other)
     {
-        response_  = std::move(other.response_);
-        peer_      = std::move(other.peer_);
-        buf_       = std::move(other.buf_);
-        transport_ = other.transport_;
-        timeout_   = std::move(other.timeout_);
+        response_   = std::move(other.response_);
+        peer_       = std::move(other.peer_);
+        buf_        = std::move(other.buf_);
+        transport_  = other.transport_;
+        timeout_    = std::move(other.timeout_);
+        compressor_ = std::move(other.compressor_);
+        compressed_ = std::move(other.compressed_);
+        slot_       = std::move(other.slot_);
+        span_       = std::move(other.span_);
 
         return *this;
     }
 
     std::streamsize ResponseStream::write(const char* data, std::streamsize sz)
+    {
+        if (compressor_)
+            compressor_->compress(data, static_cast<size_t>(sz), Compressor::Flush::None,
+                                  compressed_);
+        else
+            writeChunk(data, static_cast<size_t>(sz));
+
+        return sz;
+    }
+
+    void ResponseStream::writeChunk(const char* data, size_t size)
     {
         std::ostream os(&buf_);
-        os << std::hex << sz << crlf;
-        os.write(data, sz);
+        os << std::hex << size << crlf;
+        os.write(data, static_cast<std::streamsize>(size));
         os << crlf;
-        return sz;
     }
 
     std::shared_ptr<Tcp::Peer> ResponseStream::peer() const
@@ -782,11 +1059,17 @@ namespace Pistache::Http
 
     void ResponseStream::flush()
     {
-        timeout_.disarm();
-        auto buf = buf_.buffer();
+        if (compressor_)
+        {
+            compressor_->compress(nullptr, 0, Compressor::Flush::Sync, compressed_);
 
-        auto fd = peer()->fd();
-        transport_->asyncWrite(fd, buf);
+            // An empty chunk would end the response
+            if (!compressed_.empty())
+                writeChunk(compressed_.data(), compressed_.size());
+            compressed_.clear();
+        }
+
+        send();
 
         // Calling transport_->flush from here is unnecessary - we already
         // placed the write on the transport's writesQueue with the call to
@@ -807,6 +1090,17 @@ namespace Pistache::Http
 
     void ResponseStream::ends()
     {
+        if (compressor_)
+        {
+            compressor_->compress(nullptr, 0, Compressor::Flush::Finish, compressed_);
+            if (!compressed_.empty())
+                writeChunk(compressed_.data(), compressed_.size());
+            compressed_.clear();
+
+            // Back to the pool, there is nothing more to compress
+            compressor_.reset();
+        }
+
         std::ostream os(&buf_);
         os << "0" << crlf;
         os << crlf;
@@ -816,7 +1110,24 @@ namespace Pistache::Http
             throw Error("Response exceeded buffer size");
         }
 
-        flush();
+        // As flush(), the compressor being done with
+        auto written = send();
+        buf_.clear();
+        releaseSlot(slot_);
+
+        if (span_)
+            traceFlush(std::move(written), span_);
+    }
+
+    Async::Promise<PST_SSIZE_T> ResponseStream::send()
+    {
+        timeout_.disarm();
+        auto buf = buf_.buffer();
+
+        auto fd = peer()->fd();
+        return writeInTurn(slot_, [transport = transport_, fd, buf = std::move(buf)]() mutable {
+            return transport->asyncWrite(fd, std::move(buf));
+        });
     }
 
     ResponseWriter::ResponseWriter(ResponseWriter&& other)
@@ -825,6 +1136,9 @@ namespace Pistache::Http
         , buf_(std::move(other.buf_))
         , transport_(other.transport_)
         , timeout_(std::move(other.timeout_))
+        , slot_(std::move(other.slot_))
+        , created_(other.created_)
+        , span_(std::move(other.span_))
     { }
 
     ResponseWriter::ResponseWriter(Http::Version version, Tcp::Transport* transport,
@@ -842,8 +1156,17 @@ namespace Pistache::Http
         , buf_(DefaultStreamSize, other.buf_.maxSize())
         , transport_(other.transport_)
         , timeout_(other.timeout_)
+        , slot_(other.slot_)
+        , created_(other.created_)
+        , span_(other.span_)
     { }
 
+    void ResponseWriter::setSlot(std::shared_ptr<Private::ResponseSlot> slot)
+    {
+        timeout_.slot = slot;
+        slot_         = std::move(slot);
+    }
+
     void ResponseWriter::setMime(const Mime::MediaType& mime)
     {
         auto ct = response_.headers().tryGet<Header::ContentType>();
@@ -880,9 +1203,41 @@ namespace Pistache::Http
         return sendImpl(code, data, size, mime);
     }
 
+    Async::Promise<PST_SSIZE_T> ResponseWriter::send(Code code, std::string&& body,
+                                                     const Mime::MediaType& mime)
+    {
+        if (prepareSend(code, body.size(), mime))
+            return sendCompressed(body.data(), body.size());
+
+        GatherBuffer gather;
+        gather.add(std::move(body));
+        return putOnWire(nullptr, 0, std::move(gather));
+    }
+
+    Async::Promise<PST_SSIZE_T> ResponseWriter::send(Code code,
+                                                     std::shared_ptr<const std::string> body,
+                                                     const Mime::MediaType& mime)
+    {
+        const size_t size = body ? body->size() : 0;
+        if (prepareSend(code, size, mime) && body)
+            return sendCompressed(body->data(), size);
+
+        GatherBuffer gather;
+        gather.add(std::move(body));
+        return putOnWire(nullptr, 0, std::move(gather));
+    }
+
     Async::Promise<PST_SSIZE_T> ResponseWriter::sendImpl(Code code, const char* data,
                                                          const size_t size,
                                                          const Mime::MediaType& mime)
+    {
+        if (prepareSend(code, size, mime))
+            return sendCompressed(data, size);
+
+        return putOnWire(data, size);
+    }
+
+    bool ResponseWriter::prepareSend(Code code, size_t size, const Mime::MediaType& mime)
     {
         if (!peer_.expired())
         {
@@ -909,126 +1264,88 @@ namespace Pistache::Http
         }
 
         // Compress data, if necessary, before sending over wire to user...
-        switch (contentEncoding_)
+        return contentEncoding_ != Http::Header::Encoding::Identity && size >= compressionMinSize_;
+    }
+
+    Async::Promise<PST_SSIZE_T> ResponseWriter::sendCompressed(const char* data, size_t size)
+    {
+        if (compressionCached_)
         {
+            const CompressedCache::Key key { CompressedCache::bodyId(data, size),
+                                             contentEncoding_, compressionLevel() };
 
-#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
-        // User requested Brotli compression...
-        case Http::Header::Encoding::Br: {
-
-            // Location for size of compressed buffer, initially set to upper
-            //  bound on the data after its been compressed...
-            size_t compressedSize = ::BrotliEncoderMaxCompressedSize(size);
-
-            // Failed...
-            if (compressedSize == 0)
-                throw std::runtime_error("BrotliEncoderMaxCompressedSize() failed");
-
-            // Allocate a smart buffer to contain compressed data...
-            std::unique_ptr compressedData = std::make_unique<std::byte[]>(compressedSize);
-
-            // Compress data. The encoder expects compressedSize to initially be
-            //  the size of the output buffer. After it completes writing it
-            //  will update its value to reflect actual size used...
-            const auto compressionStatus = ::BrotliEncoderCompress(
-                contentEncodingBrotliLevel_,
-                BROTLI_DEFAULT_WINDOW,
-                BROTLI_DEFAULT_MODE,
-                size,
-                reinterpret_cast<const uint8_t*>(data),
-                &compressedSize,
-                reinterpret_cast<uint8_t*>(compressedData.get()));
-
-            // Failed...
-            if (compressionStatus != BROTLI_TRUE)
-                throw std::runtime_error("BrotliEncoderCompress() failed");
-
-            // Notify client to expect Brotli compressed response...
-            headers().add<Http::Header::ContentEncoding>(
-                Http::Header::Encoding::Br);
-
-            // Send compressed data back to client...
-            return putOnWire(
-                reinterpret_cast<const char*>(compressedData.get()),
-                compressedSize);
+            // Shared with the cache, not copied
+            GatherBuffer cached;
+            cached.add(CompressedCache::instance().getOrCompress(key, data, size));
+
+            headers().add<Http::Header::ContentEncoding>(contentEncoding_);
+            return putOnWire(nullptr, 0, std::move(cached));
         }
-#endif
 
-#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+        // Small bodies are copied behind the headers, so one buffer per
+        //  thread does for every response, instead of a worst case sized
+        //  one per response...
+        thread_local std::string compressed;
+        compressed.clear();
 
-        case Http::Header::Encoding::Zstd: {
-            size_t estimated_size = ZSTD_compressBound(size);
-            // Allocate a smart buffer to contain compressed data...
-            std::unique_ptr compressedData = std::make_unique<std::byte[]>(estimated_size);
+        auto compressor = CompressorPool::acquire(contentEncoding_, compressionLevel());
+        compressor->compress(data, size, Compressor::Flush::Finish, compressed);
 
-            auto compress_size = ZSTD_compress(reinterpret_cast<void*>(compressedData.get()), estimated_size,
-                                               data, size, contentEncodingZstdLevel_);
-            if (ZSTD_isError(compress_size))
-            {
-                throw std::runtime_error(
-                    std::string("failed to compress data to ZSTD on ZSTD_compress(), returning: ") + std::to_string(compress_size));
-            }
-            headers().add<Http::Header::ContentEncoding>(
-                Http::Header::Encoding::Zstd);
+        // Notify client to expect compressed response...
+        headers().add<Http::Header::ContentEncoding>(contentEncoding_);
 
-            // Send compressed data back to client...
-            return putOnWire(
-                reinterpret_cast<const char*>(compressedData.get()),
-                compress_size);
-        }
+        if (compressed.size() <= MaxInlineBody)
+            return putOnWire(compressed.data(), compressed.size());
 
+        // ...large ones are moved out, not to be copied nor kept around
+        GatherBuffer body;
+        body.add(std::move(compressed));
+        compressed = std::string();
+        return putOnWire(nullptr, 0, std::move(body));
+    }
+
+    int ResponseWriter::compressionLevel() const
+    {
+        switch (contentEncoding_)
+        {
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+        case Http::Header::Encoding::Br:
+            return contentEncodingBrotliLevel_;
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+        case Http::Header::Encoding::Zstd:
+            return contentEncodingZstdLevel_;
 #endif
 
 #ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
-        // User requested deflate compression...
-        case Http::Header::Encoding::Deflate: {
-
-            // Compute upper bound on size of expected compressed data. This
-            //  will be updated by compress2()...
-            uLongf compressedSize = static_cast<uLongf>(::compressBound(static_cast<uLong>(size)));
-
-            // Allocate a smart buffer to contain compressed data...
-            std::unique_ptr compressedData = std::make_unique<std::byte[]>(compressedSize);
-
-            // Compress user data at requested level...
-            const auto compressionStatus = ::compress2(
-                reinterpret_cast<unsigned char*>(compressedData.get()),
-                &compressedSize,
-                reinterpret_cast<const unsigned char*>(data),
-                static_cast<uLong>(size),
-                contentEncodingDeflateLevel_);
-
-            // Failed...
-            if (compressionStatus != Z_OK)
-                throw std::runtime_error(
-                    std::string("compress2() failed, returning: ") + std::to_string(compressionStatus));
-
-            // Notify client to expect deflate compressed response...
-            headers().add<Http::Header::ContentEncoding>(
-                Http::Header::Encoding::Deflate);
-
-            // Send compressed data back to client...
-            return putOnWire(
-                reinterpret_cast<const char*>(compressedData.get()),
-                compressedSize);
-        }
+        case Http::Header::Encoding::Deflate:
+            return contentEncodingDeflateLevel_;
 #endif
-        // No compression requested. Send uncompressed data to client...
-        case Http::Header::Encoding::Identity:
-            return putOnWire(data, size);
 
-        // Unknown...
         default:
-            throw std::runtime_error("User requested unknown content encoding.");
+            return 0;
         }
     }
 
     ResponseStream ResponseWriter::stream(Code code, size_t streamSize)
     {
         response_.code_ = code;
+        countResponse(code);
+
+        CompressorPool::Handle compressor;
+        if (contentEncoding_ != Http::Header::Encoding::Identity)
+        {
+            compressor = CompressorPool::acquire(contentEncoding_, compressionLevel());
+            headers().add<Http::Header::ContentEncoding>(contentEncoding_);
+        }
 
-        return ResponseStream(std::move(response_), peer_, transport_,
-                              std::move(timeout_), streamSize, buf_.maxSize());
+        ResponseStream stream(std::move(response_), peer_, transport_,
+                              std::move(timeout_), streamSize, buf_.maxSize(),
+                              std::move(compressor));
+        stream.slot_ = std::move(slot_);
+        stream.span_ = std::move(span_);
+        return stream;
     }
 
     const CookieJar& ResponseWriter::cookies() const { return response_.cookies(); }
@@ -1063,11 +1380,36 @@ namespace Pistache::Http
 
     ResponseWriter ResponseWriter::clone() const { return ResponseWriter(*this); }
 
-    Async::Promise<PST_SSIZE_T> ResponseWriter::putOnWire(const char* data,
-                                                          size_t len)
+    void ResponseWriter::countResponse(Code code) const
+    {
+        auto& metrics = Metrics::local();
+        metrics.responsesFor(code).add();
+        metrics.requestLatency.record(Metrics::microsecondsSince(created_));
+
+        if (span_)
+        {
+            span_->code = code;
+            span_->mark(Trace::Phase::FirstWrite);
+        }
+    }
+
+    Async::Promise<PST_SSIZE_T> ResponseWriter::putOnWire(const char* data, size_t len,
+                                                          GatherBuffer body)
     {
         try
         {
+            // Large bodies get a buffer of their own rather than growing
+            // the headers' one over and over
+            if (len > MaxInlineBody)
+            {
+                GatherBuffer copied;
+                copied.add(std::string(data, len));
+                copied.add(std::move(body));
+                return putOnWire(nullptr, 0, std::move(copied));
+            }
+
+            countResponse(response_.code());
+
             std::ostream os(&buf_);
 
 #define PST_OUT(...)                                      \
@@ -1091,7 +1433,7 @@ namespace Pistache::Http
              * true
              */
             // PST_OUT(writeHeader<Header::Connection>(os, ConnectionControl::KeepAlive));
-            PST_OUT(writeHeader<Header::ContentLength>(os, len));
+            PST_OUT(writeHeader<Header::ContentLength>(os, len + body.size()));
 
             PST_OUT(os << crlf);
 
@@ -1101,7 +1443,10 @@ namespace Pistache::Http
             }
 
             auto buffer = buf_.buffer();
-            sent_bytes_ += buffer.size();
+            if (buffer.size() + body.size() > buf_.maxSize())
+                return Async::Promise<PST_SSIZE_T>::rejected(Error("Response exceeded buffer size"));
+
+            sent_bytes_ += buffer.size() + body.size();
 
             timeout_.disarm();
 
@@ -1109,16 +1454,31 @@ namespace Pistache::Http
 
             auto fd = peer()->fd();
 
-            return transport_->asyncWrite(fd, buffer)
-                .then<std::function<Async::Promise<PST_SSIZE_T>(PST_SSIZE_T)>,
-                      std::function<void(std::exception_ptr&)>>(
-                    [](PST_SSIZE_T data) {
-                        return Async::Promise<PST_SSIZE_T>::resolved(data);
-                    },
+            auto written = writeInTurn(slot_, [transport = transport_, fd, buffer = std::move(buffer),
+                                               body = std::move(body)]() mutable {
+                if (body.empty())
+                    return transport->asyncWrite(fd, std::move(buffer));
+
+                // The headers and the body go out together
+                GatherBuffer gather;
+                gather.add(std::move(buffer));
+                gather.add(std::move(body));
+                return transport->asyncWrite(fd, std::move(gather));
+            });
+            releaseSlot(slot_);
+
+            if (span_)
+                written = traceFlush(std::move(written), span_);
+
+            return written.then<std::function<Async::Promise<PST_SSIZE_T>(PST_SSIZE_T)>,
+                                std::function<void(std::exception_ptr&)>>(
+                [](PST_SSIZE_T data) {
+                    return Async::Promise<PST_SSIZE_T>::resolved(data);
+                },
 
-                    [](std::exception_ptr& eptr) {
-                        return Async::Promise<PST_SSIZE_T>::rejected(eptr);
-                    });
+                [](std::exception_ptr& eptr) {
+                    return Async::Promise<PST_SSIZE_T>::rejected(eptr);
+                });
         }
         catch (const std::runtime_error& e)
         {
@@ -1165,39 +1525,394 @@ namespace Pistache::Http
         }
     }
 
-    Async::Promise<PST_SSIZE_T> serveFile(ResponseWriter& writer,
-                                          const std::string& fileName,
-                                          const Mime::MediaType& contentType)
+    namespace
     {
-        struct stat sb;
+        // A Range header asking for more ranges than this is ignored, the
+        // whole file being served instead (RFC 9110 14.2 allows it)
+        constexpr size_t MaxByteRanges = 32;
+
+        struct ByteRange
+        {
+            size_t first;
+            size_t last; // inclusive
+        };
 
-        int fd = PST_FILE_OPEN(fileName.c_str(), PST_O_RDONLY);
-        if (fd == -1)
+        std::string_view trimmed(std::string_view str)
         {
-            PST_DECL_SE_ERR_P_EXTRA;
-            std::string str_error(PST_STRERROR_R_ERRNO);
-            if (errno == ENOENT)
+            while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+                str.remove_prefix(1);
+            while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+                str.remove_suffix(1);
+            return str;
+        }
+
+        // Calls fn on every non-empty element of a comma-separated list
+        template <typename Fn>
+        void forEachListElement(std::string_view list, Fn fn)
+        {
+            while (!list.empty())
             {
-                throw HttpError(Http::Code::Not_Found, std::move(str_error));
+                const auto comma = list.find(',');
+                const auto elem  = trimmed(list.substr(0, comma));
+                if (!elem.empty())
+                    fn(elem);
+
+                if (comma == std::string_view::npos)
+                    break;
+                list.remove_prefix(comma + 1);
             }
-            // eles if TODO
-            /* @Improvement: maybe could we check for errno here and emit a different
-       error message
-    */
-            else
+        }
+
+        bool parseDecimal(std::string_view str, size_t& value)
+        {
+            if (str.empty())
+                return false;
+
+            const auto* end = str.data() + str.size();
+            auto res        = std::from_chars(str.data(), end, value);
+            return res.ec == std::errc() && res.ptr == end;
+        }
+
+        // Parses a Range header against a file of the given size. Returns
+        // std::nullopt when the header must be ignored (not a bytes range,
+        // malformed, too many ranges), and an empty vector when none of the
+        // ranges is satisfiable. Overlapping and adjacent ranges are merged
+        std::optional<std::vector<ByteRange>> parseByteRanges(std::string_view value,
+                                                              size_t size)
+        {
+            value = trimmed(value);
+
+            constexpr std::string_view unit = "bytes=";
+            if (value.size() < unit.size()
+                || PST_STRNCASECMP(value.data(), unit.data(), unit.size()) != 0)
+                return std::nullopt;
+            value.remove_prefix(unit.size());
+
+            std::vector<ByteRange> ranges;
+            size_t count = 0;
+            bool valid   = true;
+
+            forEachListElement(value, [&](std::string_view spec) {
+                if (!valid)
+                    return;
+
+                const auto dash = spec.find('-');
+                if (dash == std::string_view::npos || ++count > MaxByteRanges)
+                {
+                    valid = false;
+                    return;
+                }
+
+                const auto firstStr = trimmed(spec.substr(0, dash));
+                const auto lastStr  = trimmed(spec.substr(dash + 1));
+
+                size_t first = 0;
+                size_t last  = 0;
+                if (firstStr.empty())
+                {
+                    // Suffix range: the last N bytes
+                    size_t suffix = 0;
+                    if (!parseDecimal(lastStr, suffix))
+                    {
+                        valid = false;
+                        return;
+                    }
+                    if (suffix == 0 || size == 0)
+                        return;
+
+                    first = suffix < size ? size - suffix : 0;
+                    last  = size - 1;
+                }
+                else
+                {
+                    if (!parseDecimal(firstStr, first))
+                    {
+                        valid = false;
+                        return;
+                    }
+
+                    last = size == 0 ? 0 : size - 1;
+                    if (!lastStr.empty())
+                    {
+                        size_t requestedLast = 0;
+                        if (!parseDecimal(lastStr, requestedLast) || requestedLast < first)
+                        {
+                            valid = false;
+                            return;
+                        }
+                        last = std::min(last, requestedLast);
+                    }
+
+                    if (first >= size)
+                        return;
+                }
+
+                ranges.push_back({ first, last });
+            });
+
+            if (!valid || count == 0)
+                return std::nullopt;
+
+            std::sort(ranges.begin(), ranges.end(),
+                      [](const ByteRange& lhs, const ByteRange& rhs) { return lhs.first < rhs.first; });
+
+            std::vector<ByteRange> merged;
+            for (const auto& range : ranges)
+            {
+                if (!merged.empty() && range.first <= merged.back().last + 1)
+                    merged.back().last = std::max(merged.back().last, range.last);
+                else
+                    merged.push_back(range);
+            }
+
+            return merged;
+        }
+
+        // Whether etag is in the If-None-Match / If-Match style list, using
+        // the weak comparison unless strong is set (RFC 9110 8.8.3.2)
+        bool etagListMatches(std::string_view list, std::string_view etag, bool strong)
+        {
+            if (trimmed(list) == "*")
+                return true;
+
+            constexpr std::string_view weakMark = "W/";
+            auto opaque                         = [&](std::string_view tag) {
+                if (tag.substr(0, weakMark.size()) == weakMark)
+                    tag.remove_prefix(weakMark.size());
+                return tag;
+            };
+            auto isWeak = [&](std::string_view tag) {
+                return tag.substr(0, weakMark.size()) == weakMark;
+            };
+
+            bool matches = false;
+            forEachListElement(list, [&](std::string_view tag) {
+                if (strong && (isWeak(tag) || isWeak(etag)))
+                    return;
+                if (opaque(tag) == opaque(etag))
+                    matches = true;
+            });
+
+            return matches;
+        }
+
+        std::optional<std::time_t> parseHttpDate(const std::string& str)
+        {
+            try
+            {
+                return std::chrono::system_clock::to_time_t(FullDate::fromString(str).date());
+            }
+            catch (const std::exception&)
+            {
+                return std::nullopt;
+            }
+        }
+
+        std::string makeBoundary()
+        {
+            static thread_local std::mt19937_64 rng { std::random_device {}() };
+
+            std::ostringstream oss;
+            oss << std::hex << std::setfill('0') << std::setw(16) << rng()
+                << std::setw(16) << rng();
+            return oss.str();
+        }
+
+        // Files larger than this are never compressed in memory, only their
+        // precompressed siblings, if any, are served compressed
+        constexpr size_t MaxCompressedFileSize = 8 * 1024 * 1024;
+
+        // Extension of the precompressed siblings of a file, for encoding
+        const char* siblingExtension(Header::Encoding encoding)
+        {
+            switch (encoding)
             {
-                throw HttpError(Http::Code::Internal_Server_Error, std::move(str_error));
+            case Header::Encoding::Br:
+                return ".br";
+            case Header::Encoding::Zstd:
+                return ".zst";
+            case Header::Encoding::Gzip:
+                return ".gz";
+            default:
+                return nullptr;
             }
         }
 
-        int res = ::fstat(fd, &sb);
+        std::string readWholeFile(const FileCache::Entry& entry)
+        {
+            std::string contents(entry.size, '\0');
+
+            size_t done = 0;
+            while (done < entry.size)
+            {
+                const auto res = PST_FILE_PREAD(entry.file->fd(), contents.data() + done,
+                                                entry.size - done, static_cast<off_t>(done));
+                if (res < 0 && errno == EINTR)
+                    continue;
+                if (res <= 0)
+                    throw HttpError(Code::Internal_Server_Error, "Could not read file");
+
+                done += static_cast<size_t>(res);
+            }
+
+            return contents;
+        }
+
+        // One piece of a response sent by serveFile: bytes sent together,
+        // or a part of the file
+        struct FilePart
+        {
+            GatherBuffer raw;
+            size_t offset = 0;
+            size_t length = 0;
+            bool isFile   = false;
+        };
+
+        // Sends parts[index] and everything after it, one after the other
+        Async::Promise<PST_SSIZE_T>
+        writeFileParts(Tcp::Transport* transport, Fd sockFd, std::shared_ptr<Private::ResponseSlot> slot,
+                       std::shared_ptr<const OpenFile> file,
+                       std::shared_ptr<std::vector<FilePart>> parts, size_t index)
+        {
+            auto promise = writeInTurn(slot, [=]() {
+                auto& part = (*parts)[index];
+                if (part.isFile)
+                    return transport->asyncWrite(sockFd, FileBuffer(file, part.offset, part.length));
+
+                // Written once, its pieces are not needed after
+                return transport->asyncWrite(sockFd, std::move(part.raw),
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+                                             0, // MSG_MORE unsupported in macos sendmsg
+                                                // Instead, we set TCP_NOPUSH via
+                                                // setsockopt (see "man tcp").
+                                             index + 1 < parts->size() // use msg_more_style
+#else
+                                             index + 1 < parts->size() ? MSG_MORE : 0
+#endif
+                );
+            });
+
+            if (index + 1 == parts->size())
+            {
+                releaseSlot(slot);
+                return promise;
+            }
+
+            // The slot is kept until the last part is written
+            return promise.then(
+                [=](PST_SSIZE_T) {
+                    return writeFileParts(transport, sockFd, slot, file, parts, index + 1);
+                },
+                Async::Throw);
+        }
+    } // namespace
+
+    Async::Promise<PST_SSIZE_T> serveFile(ResponseWriter& writer,
+                                          const std::string& fileName,
+                                          const Mime::MediaType& contentType)
+    {
+        return Private::serveFile(writer, nullptr, fileName, contentType);
+    }
+
+    Async::Promise<PST_SSIZE_T> serveFile(ResponseWriter& writer,
+                                          const Request& request,
+                                          const std::string& fileName,
+                                          const Mime::MediaType& contentType)
+    {
+        return Private::serveFile(writer, &request, fileName, contentType);
+    }
+
+    Async::Promise<PST_SSIZE_T> Private::serveFile(ResponseWriter& writer,
+                                                   const Request* request,
+                                                   const std::string& fileName,
+                                                   const Mime::MediaType& contentType)
+    {
+        // Throws if the file cannot be opened. The entry's fd is the one
+        // sent from, so what is sent is what was stat'ed
+        const auto file = FileCache::instance().get(fileName);
+
+        auto& headers = writer.headers();
+
+        // The representation sent: the file, a precompressed sibling of it
+        // the client accepts (e.g. index.html.br), or, when the writer is
+        // set to compress, the file compressed in memory once and cached
+        auto sent     = file;
+        auto encoding = Header::Encoding::Identity;
+        std::shared_ptr<const std::string> inMemory;
+        std::optional<CompressedCache::Key> toCompress; // unless cached already
+        std::string variant; // tells the representation's ETag apart
+
+        const bool negotiable = request && !headers.has<Header::ContentEncoding>();
+        if (negotiable)
+        {
+            if (auto accept = request->headers().tryGet<Header::AcceptEncoding>())
+            {
+                // In the client's order of preference
+                for (const auto& [accepted, qvalue] : accept->encodings())
+                {
+                    if (accepted == Header::Encoding::Identity)
+                        break;
+
+                    const char* extension = siblingExtension(accepted);
+                    if (qvalue == 0 || !extension)
+                        continue;
 
-        PST_FILE_CLOSE(fd); // Done with fd, close before error can be thrown
-        if (res == -1)
+                    // Siblings older than the file are stale, not served
+                    auto sibling = FileCache::instance().find(fileName + extension);
+                    if (sibling && sibling->mtime >= file->mtime)
+                    {
+                        sent     = std::move(sibling);
+                        encoding = accepted;
+                        variant  = encodingString(accepted);
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (encoding == Header::Encoding::Identity
+            && !headers.has<Header::ContentEncoding>()
+            && writer.contentEncoding_ != Header::Encoding::Identity
+            && file->size >= writer.compressionMinSize_
+            && file->size <= MaxCompressedFileSize)
         {
-            throw HttpError(Code::Internal_Server_Error, "");
+            encoding        = writer.contentEncoding_;
+            const int level = writer.compressionLevel();
+            variant         = std::string(encodingString(encoding)) + std::to_string(level);
+
+            CompressedCache::Key key { "file:" + fileName + ':' + file->etag, encoding, level };
+
+            inMemory = CompressedCache::instance().get(key);
+            if (!inMemory)
+                toCompress = std::move(key);
         }
 
+        // Only once it is known to be needed: not for a 304, nor a HEAD
+        auto compressed = [&]() {
+            if (!toCompress)
+                return;
+
+            const auto contents = readWholeFile(*file);
+            inMemory            = CompressedCache::instance().compress(*toCompress, contents.data(),
+                                                                       contents.size());
+            toCompress.reset();
+        };
+
+        // The length of the representation, which compresses it if needed
+        auto length = [&]() {
+            compressed();
+            return inMemory ? inMemory->size() : sent->size;
+        };
+
+        if (encoding != Header::Encoding::Identity)
+            headers.add<Header::ContentEncoding>(encoding);
+
+        // Whether the response is compressed depends on Accept-Encoding
+        if (negotiable
+            && (encoding != Header::Encoding::Identity
+                || writer.contentEncoding_ != Header::Encoding::Identity))
+            headers.add<Header::Vary>("Accept-Encoding");
+
         auto* buf = writer.rdbuf();
 
         std::ostream os(buf);
@@ -1213,32 +1928,193 @@ namespace Pistache::Http
         }                                                 \
     } while (0);
 
+        // Validators: the application's own if it set any, otherwise made
+        // up from the file's size and modification time
+        std::string etag;
+        if (auto userETag = headers.tryGet<Header::ETag>())
+        {
+            std::ostringstream oss;
+            userETag->write(oss);
+            etag = oss.str();
+        }
+        else
+        {
+            const auto tag = variant.empty() ? file->etag : file->etag + '-' + variant;
+            headers.add<Header::ETag>(tag);
+            etag = "\"" + tag + "\"";
+        }
+
+        std::time_t lastModified = file->mtime;
+        if (auto userLastModified = headers.tryGet<Header::LastModified>())
+            lastModified = std::chrono::system_clock::to_time_t(userLastModified->fullDate().date());
+        else
+            headers.add<Header::LastModified>(
+                FullDate(std::chrono::system_clock::from_time_t(lastModified)));
+
+        Code code = Code::Ok;
+        std::optional<std::vector<ByteRange>> ranges;
+        bool headOnly = false;
+
+        if (request)
+        {
+            const auto& reqHeaders = request->headers();
+            const auto method      = request->method();
+            headOnly               = method == Method::Head;
+            const bool isGetOrHead = method == Method::Get || method == Method::Head;
+
+            // If-Modified-Since only counts without If-None-Match
+            if (auto ifNoneMatch = reqHeaders.tryGetRaw("If-None-Match"))
+            {
+                if (isGetOrHead && etagListMatches(ifNoneMatch->value(), etag, false))
+                    code = Code::Not_Modified;
+            }
+            else if (auto ifModifiedSince = reqHeaders.tryGetRaw("If-Modified-Since"))
+            {
+                auto since = parseHttpDate(ifModifiedSince->value());
+                if (isGetOrHead && since && lastModified <= *since)
+                    code = Code::Not_Modified;
+            }
+
+            auto range = reqHeaders.tryGetRaw("Range");
+            if (code == Code::Ok && method == Method::Get && range)
+            {
+                // A Range is only honoured if the If-Range validator, if
+                // any, still matches: a strong ETag, or the exact date
+                bool rangeApplies = true;
+                if (auto ifRange = reqHeaders.tryGetRaw("If-Range"))
+                {
+                    const auto validator = std::string(trimmed(ifRange->value()));
+                    if (!validator.empty() && (validator.front() == '"' || validator.front() == 'W'))
+                    {
+                        rangeApplies = etagListMatches(validator, etag, true);
+                    }
+                    else
+                    {
+                        auto date    = parseHttpDate(validator);
+                        rangeApplies = date && *date == lastModified;
+                    }
+                }
+
+                if (rangeApplies)
+                {
+                    ranges = parseByteRanges(range->value(), length());
+                    if (ranges)
+                        code = ranges->empty() ? Code::Requested_Range_Not_Satisfiable
+                                               : Code::Partial_Content;
+                }
+            }
+        }
+
+        Mime::MediaType mime = contentType;
+        if (!mime.isValid())
+            mime = file->mime;
+
         auto setContentType = [&](const Mime::MediaType& contentType) {
-            auto& headers = writer.headers();
-            auto ct       = headers.tryGet<Header::ContentType>();
+            auto ct = headers.tryGet<Header::ContentType>();
             if (ct)
                 ct->setMime(contentType);
             else
                 headers.add<Header::ContentType>(contentType);
         };
 
-        PST_OUT(writeStatusLine(writer.response_.version(), Http::Code::Ok, *buf));
-        if (contentType.isValid())
-        {
-            setContentType(contentType);
-        }
-        else
+        const bool multipart = code == Code::Partial_Content && ranges->size() > 1;
+        if (multipart)
+            headers.remove<Header::ContentType>();
+        else if (code != Code::Not_Modified && mime.isValid())
+            setContentType(mime);
+
+        writer.countResponse(code);
+
+        PST_OUT(writeStatusLine(writer.response_.version(), code, *buf));
+        PST_OUT(writeHeaders(headers, *buf));
+        if (request)
+            PST_OUT(os << "Accept-Ranges: bytes" << crlf);
+
+        // The first part is the status line and headers, added last
+        auto parts = std::make_shared<std::vector<FilePart>>(1);
+
+        // Bytes are sent along with the bytes before them, if any
+        auto gathered = [&]() -> GatherBuffer& {
+            if (parts->back().isFile)
+                parts->emplace_back();
+            return parts->back().raw;
+        };
+
+        // In memory, a part of the cached string, not a copy of it
+        auto addBody = [&](size_t offset, size_t length) {
+            if (inMemory)
+                gathered().add(inMemory, offset, length);
+            else
+                parts->push_back(FilePart { {}, offset, length, true });
+        };
+
+        switch (code)
         {
-            auto mime = Mime::MediaType::fromFile(fileName.c_str());
-            if (mime.isValid())
-                setContentType(mime);
-        }
+        case Code::Not_Modified:
+            break;
 
-        PST_OUT(writeHeaders(writer.headers(), *buf));
+        case Code::Requested_Range_Not_Satisfiable:
+            PST_OUT(os << "Content-Range: bytes */" << length() << crlf);
+            PST_OUT(writeHeader<Header::ContentLength>(os, 0));
+            break;
 
-        const size_t len = static_cast<size_t>(sb.st_size);
+        case Code::Partial_Content:
+            if (!multipart)
+            {
+                const auto& range = ranges->front();
+                PST_OUT(os << "Content-Range: bytes " << range.first << '-' << range.last
+                           << '/' << length() << crlf);
+                PST_OUT(writeHeader<Header::ContentLength>(os, range.last - range.first + 1));
 
-        PST_OUT(writeHeader<Header::ContentLength>(os, len));
+                addBody(range.first, range.last - range.first + 1);
+            }
+            else
+            {
+                const auto boundary = makeBoundary();
+
+                size_t contentLength = 0;
+                for (const auto& range : *ranges)
+                {
+                    std::ostringstream partHeader;
+                    partHeader << crlf << "--" << boundary << crlf;
+                    if (mime.isValid())
+                        partHeader << "Content-Type: " << mime.toString() << crlf;
+                    partHeader << "Content-Range: bytes " << range.first << '-' << range.last
+                               << '/' << length() << crlf << crlf;
+
+                    auto header = partHeader.str();
+                    contentLength += header.size() + range.last - range.first + 1;
+
+                    gathered().add(std::move(header));
+                    addBody(range.first, range.last - range.first + 1);
+                }
+
+                std::ostringstream trailer;
+                trailer << crlf << "--" << boundary << "--" << crlf;
+
+                auto last = trailer.str();
+                contentLength += last.size();
+                gathered().add(std::move(last));
+
+                PST_OUT(os << "Content-Type: multipart/byteranges; boundary=" << boundary << crlf);
+                PST_OUT(writeHeader<Header::ContentLength>(os, contentLength));
+            }
+            break;
+
+        default:
+            // No body for a HEAD. Nor a Content-Length, if knowing it would
+            // take compressing the file
+            if (headOnly)
+            {
+                if (!toCompress)
+                    PST_OUT(writeHeader<Header::ContentLength>(os, length()));
+                break;
+            }
+
+            PST_OUT(writeHeader<Header::ContentLength>(os, length()));
+            addBody(0, length());
+            break;
+        }
 
         PST_OUT(os << crlf);
 
@@ -1246,22 +2122,17 @@ namespace Pistache::Http
         auto peer       = writer.peer();
         auto sockFd     = peer->fd(); // may be PS_FD_EMPTY
 
-        auto buffer = buf->buffer();
-        return transport->asyncWrite(sockFd, buffer,
-#ifdef _USE_LIBEVENT_LIKE_APPLE
-                                     0, // MSG_MORE unsupported in macos sendmsg
-                                        // Instead, we set TCP_NOPUSH via
-                                        // setsockopt (see "man tcp").
-                                     true // use msg_more_style
-#else
-                                     MSG_MORE
-#endif
-                                     )
-            .then(
-                [=](PST_SSIZE_T) {
-                    return transport->asyncWrite(sockFd, FileBuffer(fileName));
-                },
-                Async::Throw);
+        // The status line and headers go out ahead of the rest, with
+        // MSG_MORE when a part of the file follows them
+        GatherBuffer head;
+        head.add(buf->buffer());
+        head.add(std::move(parts->front().raw));
+        parts->front().raw = std::move(head);
+
+        auto written = writeFileParts(transport, sockFd, writer.slot_, sent->file, parts, 0);
+        if (writer.span_)
+            return traceFlush(std::move(written), writer.span_);
+        return written;
 
 #undef PST_OUT
     }
@@ -1273,15 +2144,23 @@ namespace Pistache::Http
     {
         allSteps[0] = std::make_unique<RequestLineStep>(&request);
         allSteps[1] = std::make_unique<HeadersStep>(&request);
-        allSteps[2] = std::make_unique<BodyStep>(&request);
+        allSteps[2] = std::make_unique<BodyStep>(&request, maxDataSize);
     }
 
     void Private::ParserImpl<Http::Request>::reset()
     {
         ParserBase::reset();
 
-        request = Request();
-        time_   = std::chrono::steady_clock::now();
+        request.clear();
+        time_ = std::chrono::steady_clock::now();
+    }
+
+    void Private::ParserImpl<Http::Request>::next()
+    {
+        ParserBase::resetKeepingInput();
+
+        request.clear();
+        time_ = std::chrono::steady_clock::now();
     }
 
     Private::ParserImpl<Http::Response>::ParserImpl(size_t maxDataSize)
@@ -1290,7 +2169,7 @@ namespace Pistache::Http
     {
         allSteps[0] = std::make_unique<ResponseLineStep>(&response);
         allSteps[1] = std::make_unique<HeadersStep>(&response);
-        allSteps[2] = std::make_unique<BodyStep>(&response);
+        allSteps[2] = std::make_unique<BodyStep>(&response, maxDataSize);
     }
 
     void Handler::onInput(const char* buffer, size_t len,
@@ -1298,11 +2177,23 @@ namespace Pistache::Http
     {
         PS_TIMEDBG_START_ARGS("input len %u", len);
 
-        auto parser   = getParser(peer);
-        auto& request = parser->request;
+        auto parser    = getParser(peer);
+        auto responses = std::static_pointer_cast<Private::ResponseQueue>(peer->getData(ResponsesData));
+        auto& request  = parser->request;
+        auto& metrics  = Metrics::local();
+
+        // The connection's first request is the one accepted with it
+        const uint64_t acceptedAt = std::exchange(peer->acceptedAt_, 0);
+        if (len && !request.span_ && Trace::enabled())
+        {
+            request.span_ = Trace::sample();
+            if (request.span_)
+                request.span_->at[static_cast<size_t>(Trace::Phase::Accepted)] = acceptedAt;
+        }
+
         try
         {
-            if (!parser->feed(buffer, len))
+            if (!parser->borrow(buffer, len))
             {
                 PS_LOG_DEBUG("parser returned false");
 
@@ -1311,13 +2202,24 @@ namespace Pistache::Http
                                 "Request exceeded maximum buffer size");
             }
 
-            auto state = parser->parse();
-
-            if (state == Private::State::Done)
+            // Every request the input completes, as a client may send
+            // several without waiting for the responses (pipelining)
+            while (parser->parse() == Private::State::Done)
             {
                 PS_LOG_DEBUG("Creating response");
+                metrics.requestsFor(request.method()).add();
 
                 ResponseWriter response(request.version(), transport(), this, peer);
+                response.setSlot(responses->next());
+
+                const auto span = request.span_;
+                if (span)
+                {
+                    span->mark(Trace::Phase::Parsed);
+                    span->method   = request.method();
+                    span->resource = request.resource();
+                    response.span_ = span;
+                }
 
 #ifdef LIBSTDCPP_SMARTPTR_LOCK_FIXME
                 request.associatePeer(peer);
@@ -1343,18 +2245,26 @@ namespace Pistache::Http
                 PS_LOG_DEBUG("Calling peer->setIdle");
                 peer->setIdle(false); // change peer state to not idle
 
-                PS_LOG_DEBUG("Calling onRequest");
-                onRequest(request, std::move(response));
+                PS_LOG_DEBUG("Calling takeRequest");
+                takeRequest(std::move(request), std::move(response));
 
-                PS_LOG_DEBUG("Calling parser->reset");
-                parser->reset();
+                if (span)
+                {
+                    span->mark(Trace::Phase::HandlerReturned);
+                    finishIfComplete(*span);
+                }
+
+                PS_LOG_DEBUG("Calling parser->next");
+                parser->next();
             }
         }
         catch (const HttpError& err)
         {
             PS_LOG_DEBUG("HTTP Error");
+            metrics.parseErrors.add();
 
             ResponseWriter response(request.version(), transport(), this, peer);
+            response.setSlot(responses->next());
             response.send(static_cast<Code>(err.code()), err.reason());
             parser->reset();
         }
@@ -1364,6 +2274,7 @@ namespace Pistache::Http
             PS_LOG_DEBUG("HTTP exception");
 
             ResponseWriter response(request.version(), transport(), this, peer);
+            response.setSlot(responses->next());
             response.send(Code::Internal_Server_Error, e.what());
             parser->reset();
         }
@@ -1371,7 +2282,16 @@ namespace Pistache::Http
 
     void Handler::onConnection(const std::shared_ptr<Tcp::Peer>& peer)
     {
-        peer->putData(ParserData, std::make_shared<RequestParser>(maxRequestSize_));
+        auto parser = std::make_shared<RequestParser>(maxRequestSize_);
+        parser->setBodyConsumer(std::make_unique<BodyStreamer>(this, transport(), peer, parser.get()));
+
+        peer->putData(ParserData, std::move(parser));
+        peer->putData(ResponsesData, std::make_shared<Private::ResponseQueue>());
+    }
+
+    void Handler::takeRequest(Request&& request, ResponseWriter response)
+    {
+        onRequest(request, std::move(response));
     }
 
     void Handler::onTimeout(const Request& /*request*/,
@@ -1380,13 +2300,31 @@ namespace Pistache::Http
         response.send(Code::Request_Timeout);
     }
 
+    bool Handler::streamBody(const Request& /*request*/) { return false; }
+
+    Async::Promise<void> Handler::onBody(const Request& /*request*/,
+                                         const char* /*data*/, size_t /*size*/)
+    {
+        return Async::Promise<void>::resolved();
+    }
+
+    void Handler::onReadResumed(const std::shared_ptr<Tcp::Peer>& peer)
+    {
+        // The handler has been busy, not the peer
+        getParser(peer)->touch();
+
+        // What is left of the input already read
+        onInput(nullptr, 0, peer);
+    }
+
     Timeout::~Timeout() { disarm(); }
 
     void Timeout::disarm()
     {
         if (transport && armed)
         {
-            transport->disarmTimer(timerFd);
+            transport->disarmTimer(timerId);
+            armed = false;
         }
     }
 
@@ -1398,7 +2336,7 @@ namespace Pistache::Http
         , version(version)
         , transport(transport_)
         , armed(false)
-        , timerFd(PS_FD_EMPTY)
+        , timerId()
         , peer(peer_)
     { }
 
@@ -1408,7 +2346,10 @@ namespace Pistache::Http
         if (!sp)
             return;
 
+        Metrics::local().timeouts.add();
+
         ResponseWriter response(version, transport, handler, peer);
+        response.setSlot(slot.lock());
         auto parser         = Handler::getParser(sp);
         const auto& request = parser->request;
         handler->onTimeout(request, std::move(response));
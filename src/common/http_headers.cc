@@ -12,6 +12,7 @@
 
 #include <pistache/http_headers.h>
 
+#include <cctype>
 #include <memory>
 #include <stdexcept>
 #include <unordered_map>
@@ -139,8 +140,7 @@ namespace Pistache::Http::Header
         return str;
     }
 
-    bool LowercaseEqualStatic(const std::string& dynamic,
-                              const std::string& statik)
+    bool LowercaseEqualStatic(std::string_view dynamic, std::string_view statik)
     {
         return std::equal(
             dynamic.begin(), dynamic.end(), statik.begin(), statik.end(),
@@ -200,8 +200,51 @@ namespace Pistache::Http::Header
         return it != std::end(registry);
     }
 
+    Collection::Collection(const Collection& other)
+    {
+        std::lock_guard<std::mutex> guard(other.lock);
+        headers    = other.headers;
+        rawHeaders = other.rawHeaders;
+        received   = other.received;
+        fields     = other.fields;
+        rawFolded  = other.rawFolded;
+    }
+
+    Collection& Collection::operator=(const Collection& other)
+    {
+        if (this == &other)
+            return *this;
+
+        std::lock_guard<std::mutex> guard(other.lock);
+        headers    = other.headers;
+        rawHeaders = other.rawHeaders;
+        received   = other.received;
+        fields     = other.fields;
+        rawFolded  = other.rawFolded;
+        return *this;
+    }
+
+    Collection::Collection(Collection&& other) noexcept
+        : headers(std::move(other.headers))
+        , rawHeaders(std::move(other.rawHeaders))
+        , received(std::move(other.received))
+        , fields(std::move(other.fields))
+        , rawFolded(other.rawFolded)
+    { }
+
+    Collection& Collection::operator=(Collection&& other) noexcept
+    {
+        headers    = std::move(other.headers);
+        rawHeaders = std::move(other.rawHeaders);
+        received   = std::move(other.received);
+        fields     = std::move(other.fields);
+        rawFolded  = other.rawFolded;
+        return *this;
+    }
+
     Collection& Collection::add(const std::shared_ptr<Header>& header)
     {
+        materialize();
         headers.insert(std::make_pair(header->name(), header));
 
         return *this;
@@ -209,10 +252,49 @@ namespace Pistache::Http::Header
 
     Collection& Collection::addRaw(const Raw& raw)
     {
+        materialize();
         rawHeaders.insert(std::make_pair(raw.name(), raw));
         return *this;
     }
 
+    Collection& Collection::addReceived(std::string_view name, std::string_view value)
+    {
+        // Headers already in the maps come first
+        if (fields.empty() && (!headers.empty() || !rawHeaders.empty()))
+        {
+            std::string nameString(name);
+            if (isTyped(name) && Registry::instance().isRegistered(nameString))
+            {
+                std::shared_ptr<Header> header = Registry::instance().makeHeader(nameString);
+                header->parseRaw(value.data(), value.size());
+                headers.insert(std::make_pair(header->name(), header));
+            }
+            rawHeaders.insert(std::make_pair(nameString, Raw(nameString, std::string(value))));
+            return *this;
+        }
+
+        // Most requests' headers fit, in a single allocation
+        if (received.capacity() < 1024)
+            received.reserve(1024);
+
+        Field field;
+        field.nameOffset = static_cast<uint32_t>(received.size());
+        field.nameSize   = static_cast<uint32_t>(name.size());
+        received.append(name);
+        field.valueOffset = static_cast<uint32_t>(received.size());
+        field.valueSize   = static_cast<uint32_t>(value.size());
+        received.append(value);
+        fields.push_back(field);
+
+        if (rawFolded)
+        {
+            std::string nameString(name);
+            rawHeaders.insert(std::make_pair(nameString, Raw(nameString, std::string(value))));
+        }
+
+        return *this;
+    }
+
     std::shared_ptr<const Header> Collection::get(const std::string& name) const
     {
         auto header = getImpl(name);
@@ -237,6 +319,13 @@ namespace Pistache::Http::Header
 
     Raw Collection::getRaw(const std::string& name) const
     {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!rawFolded)
+        {
+            if (const Field* field = findField(name))
+                return Raw(std::string(fieldName(*field)), std::string(fieldValue(*field)));
+        }
+
         auto it = rawHeaders.find(name);
         if (it == std::end(rawHeaders))
         {
@@ -267,6 +356,13 @@ namespace Pistache::Http::Header
 
     std::optional<Raw> Collection::tryGetRaw(const std::string& name) const
     {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!rawFolded)
+        {
+            if (const Field* field = findField(name))
+                return Raw(std::string(fieldName(*field)), std::string(fieldValue(*field)));
+        }
+
         auto it = rawHeaders.find(name);
         if (it == std::end(rawHeaders))
         {
@@ -278,11 +374,20 @@ namespace Pistache::Http::Header
 
     bool Collection::has(const std::string& name) const
     {
-        return getImpl(name).first;
+        std::lock_guard<std::mutex> guard(lock);
+        if (headers.find(name) != std::end(headers))
+            return true;
+
+        // Without parsing it
+        const Field* field = findField(name);
+        return field && isTyped(fieldName(*field)) && Registry::instance().isRegistered(name);
     }
 
     std::vector<std::shared_ptr<Header>> Collection::list() const
     {
+        std::lock_guard<std::mutex> guard(lock);
+        foldTyped();
+
         std::vector<std::shared_ptr<Header>> ret;
         ret.reserve(headers.size());
         for (const auto& h : headers)
@@ -295,6 +400,8 @@ namespace Pistache::Http::Header
 
     bool Collection::remove(const std::string& name)
     {
+        materialize();
+
         auto tit = headers.find(name);
         if (tit == std::end(headers))
         {
@@ -313,18 +420,108 @@ namespace Pistache::Http::Header
     {
         headers.clear();
         rawHeaders.clear();
+        received.clear();
+        fields.clear();
+        rawFolded = false;
     }
 
     std::pair<bool, std::shared_ptr<Header>>
     Collection::getImpl(const std::string& name) const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return findOrParse(name);
+    }
+
+    std::pair<bool, std::shared_ptr<Header>>
+    Collection::findOrParse(const std::string& name) const
     {
         auto it = headers.find(name);
-        if (it == std::end(headers))
+        if (it != std::end(headers))
+        {
+            return std::make_pair(true, it->second);
+        }
+
+        // Parse a received header the first time it is asked for
+        const Field* field = findField(name);
+        if (!field || !isTyped(fieldName(*field)) || !Registry::instance().isRegistered(name))
         {
             return std::make_pair(false, nullptr);
         }
 
-        return std::make_pair(true, it->second);
+        std::shared_ptr<Header> header = Registry::instance().makeHeader(name);
+        const auto value               = fieldValue(*field);
+        header->parseRaw(value.data(), value.size());
+        headers.insert(std::make_pair(header->name(), header));
+
+        return std::make_pair(true, header);
+    }
+
+    std::string_view Collection::fieldName(const Field& field) const
+    {
+        return std::string_view(received).substr(field.nameOffset, field.nameSize);
+    }
+
+    std::string_view Collection::fieldValue(const Field& field) const
+    {
+        return std::string_view(received).substr(field.valueOffset, field.valueSize);
+    }
+
+    const Collection::Field* Collection::findField(const std::string& name) const
+    {
+        for (const auto& field : fields)
+        {
+            const auto fieldName = this->fieldName(field);
+            if (std::equal(fieldName.begin(), fieldName.end(), name.begin(), name.end(),
+                           [](char a, char b) {
+                               return std::tolower(static_cast<unsigned char>(a))
+                                   == std::tolower(static_cast<unsigned char>(b));
+                           }))
+                return &field;
+        }
+
+        return nullptr;
+    }
+
+    // Cookies are kept apart by the parser, never as typed headers
+    bool Collection::isTyped(std::string_view name)
+    {
+        return !LowercaseEqualStatic(name, "cookie") && !LowercaseEqualStatic(name, "set-cookie");
+    }
+
+    void Collection::foldRaw() const
+    {
+        if (rawFolded)
+            return;
+
+        for (const auto& field : fields)
+        {
+            std::string name(fieldName(field));
+            rawHeaders.insert(std::make_pair(name, Raw(name, std::string(fieldValue(field)))));
+        }
+        rawFolded = true;
+    }
+
+    void Collection::foldTyped() const
+    {
+        for (const auto& field : fields)
+        {
+            const auto name = fieldName(field);
+            if (isTyped(name))
+                findOrParse(std::string(name));
+        }
+    }
+
+    void Collection::materialize()
+    {
+        if (fields.empty())
+            return;
+
+        foldTyped();
+        foldRaw();
+
+        received.clear();
+        fields.clear();
+        rawFolded = false;
     }
 
 } // namespace Pistache::Http::Header
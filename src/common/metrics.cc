@@ -0,0 +1,328 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* metrics.cc
+
+   Per-thread metrics blocks, and their Prometheus formatting
+*/
+
+#include <pistache/metrics.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <utility>
+
+namespace Pistache::Metrics
+{
+
+    Histogram& Histogram::operator=(const Histogram& other)
+    {
+        buckets_ = other.buckets_;
+        count_   = other.count_;
+        sum_     = other.sum_;
+        max_     = other.max_;
+        return *this;
+    }
+
+    void Histogram::record(uint64_t value)
+    {
+        buckets_[bucketOf(value)].add();
+        count_.add();
+        sum_.add(value);
+        if (value > max())
+            max_.add(value - max());
+    }
+
+    void Histogram::merge(const Histogram& other)
+    {
+        for (size_t i = 0; i < BucketCount; ++i)
+        {
+            if (const uint64_t n = other.buckets_[i].value())
+                buckets_[i].add(n);
+        }
+        count_.add(other.count());
+        sum_.add(other.sum());
+        if (other.max() > max())
+            max_.add(other.max() - max());
+    }
+
+    uint64_t Histogram::countBelow(uint64_t bound) const
+    {
+        const size_t end = bucketOf(bound);
+
+        uint64_t count = 0;
+        for (size_t i = 0; i < end; ++i)
+            count += buckets_[i].value();
+        return count;
+    }
+
+    uint64_t Histogram::quantile(double q) const
+    {
+        const uint64_t total = count();
+        if (total == 0)
+            return 0;
+
+        const auto target = static_cast<uint64_t>(
+            std::max(1.0, std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(total))));
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BucketCount; ++i)
+        {
+            seen += buckets_[i].value();
+            if (seen >= target)
+            {
+                const uint64_t upper = i + 1 < BucketCount ? lowerBound(i + 1) - 1 : max();
+                return std::min(upper, max());
+            }
+        }
+        return max();
+    }
+
+    size_t Histogram::bucketOf(uint64_t value)
+    {
+        if (value < SubBuckets)
+            return static_cast<size_t>(value);
+
+        const unsigned magnitude = 63 - static_cast<unsigned>(__builtin_clzll(value));
+        const uint64_t sub       = (value >> (magnitude - SubBucketBits)) - SubBuckets;
+        return (magnitude - SubBucketBits + 1) * SubBuckets + static_cast<size_t>(sub);
+    }
+
+    uint64_t Histogram::lowerBound(size_t bucket)
+    {
+        if (bucket < SubBuckets)
+            return bucket;
+
+        const size_t magnitude = bucket / SubBuckets + SubBucketBits - 1;
+        const uint64_t sub     = bucket % SubBuckets;
+        return (SubBuckets + sub) << (magnitude - SubBucketBits);
+    }
+
+    uint64_t Values::activePeers() const
+    {
+        const uint64_t accepted = connectionsAccepted.value();
+        const uint64_t closed   = connectionsClosed.value();
+
+        // A thread may close what another one accepted
+        return accepted > closed ? accepted - closed : 0;
+    }
+
+    Counter& Values::responsesFor(Http::Code code)
+    {
+        const int codeClass = static_cast<int>(code) / 100;
+        return responses[static_cast<size_t>(std::clamp(codeClass, 1, 5) - 1)];
+    }
+
+    void Values::merge(const Values& other)
+    {
+        connectionsAccepted.add(other.connectionsAccepted.value());
+        connectionsClosed.add(other.connectionsClosed.value());
+        bytesIn.add(other.bytesIn.value());
+        bytesOut.add(other.bytesOut.value());
+        parseErrors.add(other.parseErrors.value());
+        timeouts.add(other.timeouts.value());
+        writesWouldBlock.add(other.writesWouldBlock.value());
+        routesNotFound.add(other.routesNotFound.value());
+        routesNotAllowed.add(other.routesNotAllowed.value());
+
+        for (size_t i = 0; i < MethodCount; ++i)
+            requests[i].add(other.requests[i].value());
+        for (size_t i = 0; i < CodeClassCount; ++i)
+            responses[i].add(other.responses[i].value());
+
+        requestLatency.merge(other.requestLatency);
+        writeQueueDepth.merge(other.writeQueueDepth);
+    }
+
+    namespace
+    {
+        class Registry
+        {
+        public:
+            Values* add()
+            {
+                auto values = std::make_unique<Values>();
+                auto* ptr   = values.get();
+
+                std::lock_guard<std::mutex> guard(mtx_);
+                threads_.push_back({ std::this_thread::get_id(), std::move(values) });
+                return ptr;
+            }
+
+            // Keeps what a thread counted once it is gone
+            void retire(Values* values)
+            {
+                std::lock_guard<std::mutex> guard(mtx_);
+
+                auto it = std::find_if(threads_.begin(), threads_.end(),
+                                       [values](const Thread& thread) {
+                                           return thread.values.get() == values;
+                                       });
+                if (it == threads_.end())
+                    return;
+
+                retired_.merge(*it->values);
+                threads_.erase(it);
+            }
+
+            std::vector<Worker> workers()
+            {
+                std::lock_guard<std::mutex> guard(mtx_);
+
+                std::vector<Worker> workers;
+                workers.reserve(threads_.size());
+                for (const auto& thread : threads_)
+                    workers.push_back({ thread.id, *thread.values });
+                return workers;
+            }
+
+            Values total()
+            {
+                std::lock_guard<std::mutex> guard(mtx_);
+
+                Values total = retired_;
+                for (const auto& thread : threads_)
+                    total.merge(*thread.values);
+                return total;
+            }
+
+        private:
+            struct Thread
+            {
+                std::thread::id id;
+                std::unique_ptr<Values> values;
+            };
+
+            std::mutex mtx_;
+            std::vector<Thread> threads_;
+            Values retired_;
+        };
+
+        // Never destroyed, threads may count until the very end
+        Registry& registry()
+        {
+            static Registry* instance = new Registry;
+            return *instance;
+        }
+
+        // Trivially destructible, so that it can still be used while the
+        // thread's other thread_local objects are destroyed
+        thread_local Values* localValues = nullptr;
+
+        struct Retire
+        {
+            ~Retire()
+            {
+                if (localValues)
+                    registry().retire(localValues);
+                localValues = nullptr;
+            }
+        };
+
+        thread_local Retire retire;
+
+        void writeCounter(std::ostringstream& os, const char* name, const char* help,
+                          uint64_t value, const char* type = "counter")
+        {
+            os << "# HELP " << name << ' ' << help << '\n'
+               << "# TYPE " << name << ' ' << type << '\n'
+               << name << ' ' << value << '\n';
+        }
+
+        // Cumulative buckets bounded by powers of two, up to 2^maxShift,
+        // scaled by unit
+        void writeHistogram(std::ostringstream& os, const char* name, const char* help,
+                            const Histogram& histogram, unsigned maxShift, double unit)
+        {
+            os << "# HELP " << name << ' ' << help << '\n'
+               << "# TYPE " << name << " histogram\n";
+
+            for (unsigned shift = 0; shift <= maxShift; ++shift)
+            {
+                const uint64_t bound = uint64_t(1) << shift;
+                os << name << "_bucket{le=\"" << static_cast<double>(bound) * unit << "\"} "
+                   << histogram.countBelow(bound) << '\n';
+            }
+            os << name << "_bucket{le=\"+Inf\"} " << histogram.count() << '\n'
+               << name << "_sum " << static_cast<double>(histogram.sum()) * unit << '\n'
+               << name << "_count " << histogram.count() << '\n';
+        }
+    }
+
+    Values& local()
+    {
+        if (!localValues)
+        {
+            localValues = registry().add();
+
+            // Constructs it, for the values to be retired along with the
+            // thread
+            static_cast<void>(&retire);
+        }
+        return *localValues;
+    }
+
+    std::vector<Worker> workers() { return registry().workers(); }
+
+    Values total() { return registry().total(); }
+
+    std::string prometheus()
+    {
+        const Values values = total();
+
+        std::ostringstream os;
+        writeCounter(os, "pistache_connections_accepted_total", "Connections accepted.",
+                     values.connectionsAccepted.value());
+        writeCounter(os, "pistache_active_peers", "Connections open.", values.activePeers(),
+                     "gauge");
+
+        os << "# HELP pistache_requests_total Requests parsed, by method.\n"
+           << "# TYPE pistache_requests_total counter\n";
+        for (size_t i = 0; i < MethodCount; ++i)
+        {
+            if (const uint64_t n = values.requests[i].value())
+                os << "pistache_requests_total{method=\""
+                   << Http::methodString(static_cast<Http::Method>(i)) << "\"} " << n << '\n';
+        }
+
+        os << "# HELP pistache_responses_total Responses sent, by status class.\n"
+           << "# TYPE pistache_responses_total counter\n";
+        for (size_t i = 0; i < CodeClassCount; ++i)
+            os << "pistache_responses_total{code=\"" << i + 1 << "xx\"} "
+               << values.responses[i].value() << '\n';
+
+        writeCounter(os, "pistache_received_bytes_total", "Bytes read from peers.",
+                     values.bytesIn.value());
+        writeCounter(os, "pistache_sent_bytes_total", "Bytes written to peers.",
+                     values.bytesOut.value());
+        writeCounter(os, "pistache_parse_errors_total", "Requests that could not be parsed.",
+                     values.parseErrors.value());
+        writeCounter(os, "pistache_timeouts_total", "Response timeouts that expired.",
+                     values.timeouts.value());
+        writeCounter(os, "pistache_writes_would_block_total",
+                     "Writes the socket could not take at once (EAGAIN).",
+                     values.writesWouldBlock.value());
+
+        os << "# HELP pistache_route_misses_total Requests no route matched.\n"
+           << "# TYPE pistache_route_misses_total counter\n"
+           << "pistache_route_misses_total{reason=\"not_found\"} "
+           << values.routesNotFound.value() << '\n'
+           << "pistache_route_misses_total{reason=\"method_not_allowed\"} "
+           << values.routesNotAllowed.value() << '\n';
+
+        writeHistogram(os, "pistache_request_duration_seconds",
+                       "From the request being parsed to its response being queued.",
+                       values.requestLatency, 24, 1e-6);
+        writeHistogram(os, "pistache_write_queue_depth", "Writes queued for a peer.",
+                       values.writeQueueDepth, 10, 1.0);
+
+        return os.str();
+    }
+
+} // namespace Pistache::Metrics
@@ -27,12 +27,28 @@
 #include <sys/epoll.h>
 #endif
 
+// io_uring is used through its raw system calls, for want of liburing. The
+// multishot polls it is used for came with Linux 5.13, along with
+// IORING_FEAT_RSRC_TAGS
+#if defined(__linux__) && !defined(_USE_LIBEVENT) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#if defined(IORING_POLL_ADD_MULTI) && defined(IORING_FEAT_EXT_ARG) && defined(IORING_FEAT_RSRC_TAGS)
+#define PS_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
 #include PST_MISC_IO_HDR // unistd.h e.g. close
 
 #include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
 #include <iterator>
 #include <thread>
+#include <unordered_map>
 
 namespace Pistache
 {
@@ -172,7 +188,429 @@ namespace Pistache
             , tag(_tag)
         { }
 
-        Epoll::Epoll()
+#ifdef PS_IO_URING
+        /* One io_uring poll request is armed per registered fd. Edge
+         * triggered fds get a multishot one, which stays armed. The others
+         * get a one-shot one, armed again by the next poll(): that makes
+         * them level triggered, as it only completes if the fd is still
+         * ready by then.
+         *
+         * Registering, rearming and removing fds submit straight away from
+         * other threads. From the polling thread, in the middle of handling
+         * events, they are only queued: the next poll() submits them with
+         * the same io_uring_enter that waits.
+         */
+        class Uring
+        {
+        public:
+            // nullptr where io_uring is missing, disabled or too old
+            static std::unique_ptr<Uring> create();
+
+            ~Uring();
+
+            void add(Fd fd, Flags<NotifyOn> interest, Tag tag, Mode mode,
+                     bool oneShot);
+            void remove(Fd fd);
+
+            int poll(std::vector<Event>& events, std::chrono::milliseconds timeout);
+
+        private:
+            static constexpr unsigned Entries = 256;
+
+            struct Registration
+            {
+                Flags<NotifyOn> interest;
+                Tag tag;
+                Mode mode;
+                bool oneShot;
+
+                // Of the poll request armed last, telling its completions
+                // from those of the requests it replaced
+                uint32_t generation;
+                bool armed;
+            };
+
+            Uring() = default;
+
+            // The user data of a poll request, 0 being for removals
+            static uint64_t userData(Fd fd, uint32_t generation)
+            {
+                return (static_cast<uint64_t>(static_cast<uint32_t>(fd)) << 32) | generation;
+            }
+
+            int enter(unsigned toSubmit, unsigned minComplete, unsigned flags,
+                      const void* arg, size_t argSize);
+
+            // Submission queue entries not yet consumed by the kernel
+            unsigned pending() const;
+
+            static bool isMultishot(const Registration& registration)
+            {
+                return registration.mode == Mode::Edge && !registration.oneShot;
+            }
+
+            static uint32_t pollEvents(Flags<NotifyOn> interest);
+
+            // mutex_ must be locked for these
+            io_uring_sqe* nextSqe();
+            void arm(Fd fd, Registration& registration);
+            void update(Fd fd, const Registration& registration);
+            void disarm(Fd fd, Registration& registration);
+            void submitUnlessPolling();
+
+            int ringFd_ = -1;
+
+            void* rings_      = MAP_FAILED;
+            size_t ringsSize_ = 0;
+            void* sqes_       = MAP_FAILED;
+            size_t sqesSize_  = 0;
+
+            unsigned* sqHead_ = nullptr;
+            unsigned* sqTail_ = nullptr;
+            unsigned sqMask_  = 0;
+            unsigned sqSize_  = 0;
+
+            unsigned* cqHead_    = nullptr;
+            unsigned* cqTail_    = nullptr;
+            unsigned cqMask_     = 0;
+            io_uring_cqe* cqes_ = nullptr;
+
+            std::mutex mutex_;
+            std::unordered_map<Fd, Registration> registrations_;
+            uint32_t generation_ = 0;
+
+            // Level triggered fds that completed, to arm again next poll()
+            std::vector<std::pair<Fd, uint32_t>> rearms_;
+
+            // Where each fd's event went in the last poll(), so that the
+            // completions of one fd make a single event
+            std::unordered_map<Fd, size_t> eventIndex_;
+
+            std::atomic<std::thread::id> pollingThread_ {};
+        };
+
+        std::unique_ptr<Uring> Uring::create()
+        {
+            struct io_uring_params params;
+            std::memset(&params, 0, sizeof(params));
+            params.flags      = IORING_SETUP_CQSIZE;
+            params.cq_entries = static_cast<uint32_t>(2 * Const::MaxEvents);
+
+            const int fd = static_cast<int>(syscall(__NR_io_uring_setup, Entries, &params));
+            if (fd < 0)
+            {
+                PS_LOG_INFO_ARGS("io_uring unavailable (%s), polling with epoll",
+                                 strerror(errno));
+                return nullptr;
+            }
+
+            std::unique_ptr<Uring> ring(new Uring());
+            ring->ringFd_ = fd;
+
+            const uint32_t required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP
+                | IORING_FEAT_EXT_ARG | IORING_FEAT_RSRC_TAGS;
+            if ((params.features & required) != required)
+            {
+                PS_LOG_INFO("io_uring too old, polling with epoll");
+                return nullptr;
+            }
+
+            ring->ringsSize_ = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                                        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+            ring->rings_     = mmap(nullptr, ring->ringsSize_, PROT_READ | PROT_WRITE,
+                                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+            ring->sqesSize_  = params.sq_entries * sizeof(io_uring_sqe);
+            ring->sqes_      = mmap(nullptr, ring->sqesSize_, PROT_READ | PROT_WRITE,
+                                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+            if (ring->rings_ == MAP_FAILED || ring->sqes_ == MAP_FAILED)
+            {
+                PS_LOG_WARNING_ARGS("Failed to map io_uring (%s), polling with epoll",
+                                    strerror(errno));
+                return nullptr;
+            }
+
+            auto* base    = static_cast<char*>(ring->rings_);
+            ring->sqHead_ = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+            ring->sqTail_ = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+            ring->sqMask_ = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+            ring->sqSize_ = params.sq_entries;
+            ring->cqHead_ = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+            ring->cqTail_ = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+            ring->cqMask_ = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+            ring->cqes_   = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+
+            // Each queue slot always holds the entry of the same index
+            auto* array = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+            for (unsigned i = 0; i < params.sq_entries; ++i)
+                array[i] = i;
+
+            return ring;
+        }
+
+        Uring::~Uring()
+        {
+            // Closing the ring cancels the polls still armed
+            if (sqes_ != MAP_FAILED)
+                munmap(sqes_, sqesSize_);
+            if (rings_ != MAP_FAILED)
+                munmap(rings_, ringsSize_);
+            if (ringFd_ >= 0)
+                close(ringFd_);
+        }
+
+        void Uring::add(Fd fd, Flags<NotifyOn> interest, Tag tag, Mode mode,
+                        bool oneShot)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            // A multishot poll still armed only has its events updated, if
+            // they change at all. Unlike EPOLL_CTL_MOD, this does not report
+            // the fd again when it is ready but nothing new happened: which
+            // edge triggered fds, read or written until EAGAIN, don't need
+            auto it = registrations_.find(fd);
+            if (it != registrations_.end() && it->second.armed && isMultishot(it->second)
+                && mode == Mode::Edge && !oneShot)
+            {
+                auto& registration = it->second;
+                registration.tag   = tag;
+                if (static_cast<NotifyOn>(registration.interest) != static_cast<NotifyOn>(interest))
+                {
+                    registration.interest = interest;
+                    update(fd, registration);
+                    submitUnlessPolling();
+                }
+                return;
+            }
+
+            // Otherwise any registration left is replaced, as with
+            // EPOLL_CTL_MOD. There can be one even for an EPOLL_CTL_ADD: a
+            // poll request, unlike epoll, keeps the file it polls open
+            if (it != registrations_.end())
+                disarm(fd, it->second);
+
+            auto& registration = registrations_
+                                     .insert_or_assign(fd, Registration { interest, tag, mode, oneShot, 0, false })
+                                     .first->second;
+            arm(fd, registration);
+
+            submitUnlessPolling();
+        }
+
+        void Uring::remove(Fd fd)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            auto it = registrations_.find(fd);
+            if (it == registrations_.end())
+                return;
+
+            disarm(fd, it->second);
+            registrations_.erase(it);
+
+            submitUnlessPolling();
+        }
+
+        int Uring::poll(std::vector<Event>& events, std::chrono::milliseconds timeout)
+        {
+            pollingThread_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+            {
+                std::lock_guard<std::mutex> guard(mutex_);
+                for (const auto& [fd, generation] : rearms_)
+                {
+                    auto it = registrations_.find(fd);
+                    if (it != registrations_.end() && !it->second.armed
+                        && it->second.generation == generation)
+                        arm(fd, it->second);
+                }
+                rearms_.clear();
+            }
+
+            struct __kernel_timespec ts;
+            struct io_uring_getevents_arg arg;
+            std::memset(&arg, 0, sizeof(arg));
+            if (timeout.count() >= 0)
+            {
+                ts.tv_sec  = timeout.count() / 1000;
+                ts.tv_nsec = (timeout.count() % 1000) * 1000000;
+                arg.ts     = reinterpret_cast<uint64_t>(&ts);
+            }
+
+            int ret = -1;
+            do
+            {
+                ret = enter(pending(), 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                            &arg, sizeof(arg));
+            } while (ret < 0 && errno == EINTR);
+
+            // ETIME is for the timeout, EBUSY for completions overflowing
+            // into the kernel: those left are reaped next time
+            if (ret < 0 && errno != ETIME && errno != EBUSY)
+                return -1;
+
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            const size_t first = events.size();
+            eventIndex_.clear();
+
+            unsigned head       = *cqHead_;
+            const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head)
+            {
+                const io_uring_cqe& cqe = cqes_[head & cqMask_];
+                if (cqe.user_data == 0)
+                    continue;
+
+                const Fd fd               = static_cast<Fd>(cqe.user_data >> 32);
+                const uint32_t generation = static_cast<uint32_t>(cqe.user_data);
+                auto it                   = registrations_.find(fd);
+                if (it == registrations_.end() || it->second.generation != generation)
+                    continue; // removed or rearmed since
+
+                auto& registration = it->second;
+                if (!(cqe.flags & IORING_CQE_F_MORE))
+                    registration.armed = false;
+
+                if (cqe.res < 0)
+                {
+                    if (cqe.res != -ECANCELED)
+                        PS_LOG_WARNING_ARGS("io_uring poll failed for fd %" PIST_QUOTE(PS_FD_PRNTFCD) ": %s",
+                                            fd, strerror(-cqe.res));
+                    continue;
+                }
+
+                // A multishot poll can end, e.g. when the kernel is short
+                // of memory: it is armed again as for level triggered fds
+                if (!registration.armed && !registration.oneShot)
+                    rearms_.emplace_back(fd, generation);
+
+                const auto flags = Epoll::toNotifyOn(cqe.res);
+                auto [index, added] = eventIndex_.try_emplace(fd, events.size());
+                if (added)
+                {
+                    Event event(registration.tag);
+                    event.flags = flags;
+                    events.push_back(event);
+                }
+                else
+                {
+                    events[index->second].flags = events[index->second].flags | flags;
+                }
+            }
+            __atomic_store_n(cqHead_, tail, __ATOMIC_RELEASE);
+
+            return static_cast<int>(events.size() - first);
+        }
+
+        int Uring::enter(unsigned toSubmit, unsigned minComplete, unsigned flags,
+                         const void* arg, size_t argSize)
+        {
+            return static_cast<int>(syscall(__NR_io_uring_enter, ringFd_, toSubmit,
+                                            minComplete, flags, arg, argSize));
+        }
+
+        unsigned Uring::pending() const
+        {
+            return __atomic_load_n(sqTail_, __ATOMIC_ACQUIRE)
+                - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+        }
+
+        io_uring_sqe* Uring::nextSqe()
+        {
+            if (pending() >= sqSize_)
+            {
+                // Full of what the polling thread queued: submit it now
+                int ret = -1;
+                do
+                {
+                    ret = enter(pending(), 0, 0, nullptr, 0);
+                } while (ret < 0 && errno == EINTR);
+
+                if (pending() >= sqSize_)
+                    throw std::runtime_error("io_uring submission queue full");
+            }
+
+            const unsigned tail = *sqTail_;
+            auto* sqe           = static_cast<io_uring_sqe*>(sqes_) + (tail & sqMask_);
+            std::memset(sqe, 0, sizeof(*sqe));
+            return sqe;
+        }
+
+        uint32_t Uring::pollEvents(Flags<NotifyOn> interest)
+        {
+            auto events = static_cast<uint32_t>(Epoll::toEpollEvents(interest));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            events = (events << 16) | (events >> 16);
+#endif
+            return events;
+        }
+
+        void Uring::arm(Fd fd, Registration& registration)
+        {
+            if (++generation_ == 0)
+                ++generation_;
+            registration.generation = generation_;
+            registration.armed      = true;
+
+            io_uring_sqe* sqe  = nextSqe();
+            sqe->opcode        = IORING_OP_POLL_ADD;
+            sqe->fd            = fd;
+            sqe->poll32_events = pollEvents(registration.interest);
+            sqe->user_data     = userData(fd, registration.generation);
+            if (isMultishot(registration))
+                sqe->len = IORING_POLL_ADD_MULTI;
+
+            __atomic_store_n(sqTail_, *sqTail_ + 1, __ATOMIC_RELEASE);
+        }
+
+        void Uring::update(Fd fd, const Registration& registration)
+        {
+            // Should the poll have ended meanwhile, the update fails; its
+            // last completion, still to be reaped, then has it armed again
+            io_uring_sqe* sqe  = nextSqe();
+            sqe->opcode        = IORING_OP_POLL_REMOVE;
+            sqe->fd            = -1;
+            sqe->addr          = userData(fd, registration.generation);
+            sqe->len           = IORING_POLL_UPDATE_EVENTS | IORING_POLL_ADD_MULTI;
+            sqe->poll32_events = pollEvents(registration.interest);
+
+            __atomic_store_n(sqTail_, *sqTail_ + 1, __ATOMIC_RELEASE);
+        }
+
+        void Uring::disarm(Fd fd, Registration& registration)
+        {
+            if (!registration.armed)
+                return;
+            registration.armed = false;
+
+            io_uring_sqe* sqe = nextSqe();
+            sqe->opcode       = IORING_OP_POLL_REMOVE;
+            sqe->fd           = -1;
+            sqe->addr         = userData(fd, registration.generation);
+
+            __atomic_store_n(sqTail_, *sqTail_ + 1, __ATOMIC_RELEASE);
+        }
+
+        void Uring::submitUnlessPolling()
+        {
+            if (pollingThread_.load(std::memory_order_relaxed) == std::this_thread::get_id())
+                return;
+
+            int ret = -1;
+            do
+            {
+                ret = enter(pending(), 0, 0, nullptr, 0);
+            } while (ret < 0 && errno == EINTR);
+
+            if (ret < 0)
+                PS_LOG_WARNING_ARGS("io_uring_enter failed: %s", strerror(errno));
+        }
+#else
+        class Uring
+        { };
+#endif
+
+        Epoll::Epoll(Backend backend)
             : epoll_fd([&]()
 #ifdef _USE_LIBEVENT
                        { return TRY_NULL_RET(EventMethFns::create(
@@ -181,7 +619,26 @@ namespace Pistache
                        { return TRY_RET(epoll_create(Const::MaxEvents)); }
 #endif
                        ())
-        { }
+        {
+            if (backend != Backend::IoUring)
+                return;
+
+#ifdef PS_IO_URING
+            uring_ = Uring::create();
+            if (uring_)
+            {
+                close(epoll_fd);
+                epoll_fd = PS_FD_EMPTY;
+            }
+#else
+            PS_LOG_INFO("No io_uring in this build, polling with epoll");
+#endif
+        }
+
+        Backend Epoll::backend() const
+        {
+            return uring_ ? Backend::IoUring : Backend::Epoll;
+        }
 
         Epoll::~Epoll()
         {
@@ -199,6 +656,14 @@ namespace Pistache
         {
             PS_TIMEDBG_START_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
 
+#ifdef PS_IO_URING
+            if (uring_)
+            {
+                uring_->add(fd, interest, tag, mode, false);
+                return;
+            }
+#endif
+
 #ifdef _USE_LIBEVENT
             short events = static_cast<short>(epoll_fd->toEvEvents(interest));
             events |= EVM_PERSIST; // since EPOLLONESHOT not to be set
@@ -226,6 +691,14 @@ namespace Pistache
         {
             PS_TIMEDBG_START_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
 
+#ifdef PS_IO_URING
+            if (uring_)
+            {
+                uring_->add(fd, interest, tag, mode, true);
+                return;
+            }
+#endif
+
 #ifdef _USE_LIBEVENT
             short events = static_cast<short>(epoll_fd->toEvEvents(interest));
 
@@ -259,6 +732,14 @@ namespace Pistache
         {
             PS_TIMEDBG_START_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
 
+#ifdef PS_IO_URING
+            if (uring_)
+            {
+                uring_->remove(fd);
+                return;
+            }
+#endif
+
 #ifdef _USE_LIBEVENT
             TRY(epoll_fd->ctl(EvCtlAction::Del,
                               fd, 0 /* events */, nullptr /* time */));
@@ -273,6 +754,15 @@ namespace Pistache
         {
             PS_TIMEDBG_START_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
 
+            // Not one-shot any more, as with EPOLL_CTL_MOD (see below)
+#ifdef PS_IO_URING
+            if (uring_)
+            {
+                uring_->add(fd, interest, tag, mode, false);
+                return;
+            }
+#endif
+
 #ifdef _USE_LIBEVENT
             short events = static_cast<short>(epoll_fd->toEvEvents(interest));
 
@@ -345,6 +835,8 @@ namespace Pistache
                 str += " hangup";
             if ((static_cast<unsigned int>(interest)) & (static_cast<unsigned int>(Polling::NotifyOn::Shutdown)))
                 str += " shutdown";
+            if ((static_cast<unsigned int>(interest)) & (static_cast<unsigned int>(Polling::NotifyOn::Error)))
+                str += " error";
 
             PS_LOG_DEBUG_ARGS("%s", str.c_str());
         }
@@ -446,6 +938,11 @@ namespace Pistache
 
 #else // not ifdef _USE_LIBEVENT
 
+#ifdef PS_IO_URING
+            if (uring_)
+                return uring_->poll(events, timeout);
+#endif
+
             struct epoll_event evs[Const::MaxEvents];
 
             int ready_fds = -1;
@@ -540,6 +1037,8 @@ namespace Pistache
                 events |= EPOLLHUP;
             if (interest.hasFlag(NotifyOn::Shutdown))
                 events |= EPOLLRDHUP;
+            if (interest.hasFlag(NotifyOn::Error))
+                events |= EPOLLERR;
 
             return events;
         }
@@ -558,6 +1057,8 @@ namespace Pistache
             {
                 flags.setFlag(NotifyOn::Shutdown);
             }
+            if (events & EPOLLERR)
+                flags.setFlag(NotifyOn::Error);
 
             return flags;
         }
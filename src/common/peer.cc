@@ -23,6 +23,7 @@
 #include <pistache/async.h>
 #include <pistache/peer.h>
 #include <pistache/pist_quote.h>
+#include <pistache/trace.h>
 #include <pistache/transport.h>
 
 namespace Pistache::Tcp
@@ -45,6 +46,9 @@ namespace Pistache::Tcp
     {
         PS_LOG_DEBUG_ARGS("peer %p, fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", Address ptr %p, ssl %p",
                           this, fd, &addr, ssl);
+
+        if (Trace::enabled())
+            acceptedAt_ = Trace::now();
     }
 
     Peer::~Peer()
@@ -18,6 +18,7 @@
 #include <pistache/ps_strl.h>
 
 #include <pistache/ps_basename.h> // for PS_BASENAME_R
+#include <pistache/async_log.h>
 
 #include <stdio.h> // snprintf
 #include <stdlib.h> // malloc
@@ -543,6 +544,10 @@ public:
              const char * _format, va_list _ap);
     void log(int _priority, bool _andPrintf,
              const char * _str);
+
+    // As if logged by thread _thread
+    void logFrom(int _priority, bool _andPrintf, PST_THREAD_ID _thread,
+                 const char * _str);
 };
 
 // For use of class PSLogging only; treat as private to PSLogging
@@ -712,15 +717,14 @@ PSLogging::~PSLogging()
 // ---------------------------------------------------------------------------
 
 // rets -1 for fail, 0 for OK
-static int snprintProcessAndThread(char * _buff, size_t _buffSize)
+static int snprintProcessAndThread(char * _buff, size_t _buffSize,
+                                   PST_THREAD_ID pt)
 {
     if (!_buff)
         return(-1);
     if (!_buffSize)
         return(-1);
 
-    PST_THREAD_ID pt = PST_THREAD_ID_SELF(); // This function always succeeds
-
     unsigned char *ptc =
         reinterpret_cast<unsigned char*>((reinterpret_cast<void*>(&pt)));
     int buff_would_have_been_len = 0;
@@ -970,8 +974,10 @@ void PSLogging::log(int _priority, bool _andPrintf,
 {
     char buff[2048];
     buff[0] = '(';
+    // PST_THREAD_ID_SELF always succeeds
     if (snprintProcessAndThread(&(buff[1]),
-                                sizeof(buff)-3-strlen(gLogEntryPrefix)) >= 0)
+                                sizeof(buff)-3-strlen(gLogEntryPrefix),
+                                PST_THREAD_ID_SELF()) >= 0)
         PS_STRLCAT(&(buff[0]), " ", sizeof(buff)-8);
     PS_STRLCAT(&(buff[0]), gLogEntryPrefix, sizeof(buff)-8);
     PS_STRLCAT(&(buff[0]), ") ", sizeof(buff)-8);
@@ -1040,6 +1046,12 @@ void PSLogging::log(int _priority, bool _andPrintf,
 }
 
 void PSLogging::log(int _priority, bool _andPrintf, const char * _str)
+{
+    logFrom(_priority, _andPrintf, PST_THREAD_ID_SELF(), _str);
+}
+
+void PSLogging::logFrom(int _priority, bool _andPrintf, PST_THREAD_ID _thread,
+                        const char * _str)
 {
     if (!_str)
         return;
@@ -1047,7 +1059,8 @@ void PSLogging::log(int _priority, bool _andPrintf, const char * _str)
     char buff[2048];
     buff[0] = '(';
     if (snprintProcessAndThread(&(buff[1]),
-                                sizeof(buff)-3-strlen(gLogEntryPrefix)) >= 0)
+                                sizeof(buff)-3-strlen(gLogEntryPrefix),
+                                _thread) >= 0)
     PS_STRLCAT(&(buff[0]), " ", sizeof(buff)-8);
     PS_STRLCAT(&(buff[0]), gLogEntryPrefix, sizeof(buff)-8);
     PS_STRLCAT(&(buff[0]), ") ", sizeof(buff)-8);
@@ -1059,7 +1072,7 @@ void PSLogging::log(int _priority, bool _andPrintf, const char * _str)
     if ((res < 0) && (_priority >= LOG_WARNING))
     {
         logToStdOutMaybeErr(LOG_ALERT, _andPrintf,
-                            "snprintf failed for log in PSLogging::log");
+                            "snprintf failed for log in PSLogging::logFrom");
 
         #ifdef PIST_USE_OS_LOG
           OS_LOG_BY_PRIORITY_FORMAT_ARG("%s", _str);
@@ -1112,6 +1125,68 @@ static void PSLogStrPrv(int _priority, bool _andPrintf, const char * _str)
     PSLogging::getPSLogging()->log(_priority, _andPrintf, _str);
 }
 
+// Returns false if asynchronous logging is off, the message to be logged
+// synchronously
+static bool PSLogAsyncPrv(int _priority, bool _andPrintf,
+                          const char * f, int l, const char * m,
+                          const char * _format, va_list _ap)
+{
+    if (!Pistache::Log::AsyncLog::isRunning())
+        return(false);
+
+    #ifndef DEBUG
+    if (_priority == LOG_DEBUG)
+        return(true);
+    #endif
+
+    // Dropped if the thread's log ring is full
+    Pistache::Log::AsyncLog::log(_priority, _andPrintf, f, l, m, _format, _ap);
+    return(true);
+}
+
+// ---------------------------------------------------------------------------
+
+// Called from the thread draining the asynchronous log rings
+void Pistache::Log::Private::emitLog(FILE * out, int priority, bool andPrintf,
+                                     PST_THREAD_ID thread,
+                                     std::chrono::system_clock::time_point time,
+                                     const char * str)
+{
+    if (!str)
+        return;
+
+    if (!out)
+    {
+        PSLogging::getPSLogging()->logFrom(priority, andPrintf, thread, str);
+        return;
+    }
+
+    char dAndT[64];
+    PS_STRLCPY(&(dAndT[0]), "<No Timestamp>", sizeof(dAndT));
+
+    const time_t t = std::chrono::system_clock::to_time_t(time);
+    struct tm this_tm;
+    memset(&this_tm, 0, sizeof(this_tm));
+    if (PST_LOCALTIME_R(&t, &this_tm))
+    {
+        const long long ms =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                time.time_since_epoch()).count() % 1000;
+        snprintf(&(dAndT[0]), sizeof(dAndT),
+                 "%04d-%02d-%02d %02d:%02d:%02d.%03lld",
+                 this_tm.tm_year + 1900, this_tm.tm_mon + 1, this_tm.tm_mday,
+                 this_tm.tm_hour, this_tm.tm_min, this_tm.tm_sec, ms);
+    }
+
+    char thread_buff[64];
+    if (snprintProcessAndThread(&(thread_buff[0]), sizeof(thread_buff),
+                                thread) < 0)
+        thread_buff[0] = 0;
+
+    fprintf(out, "%s %s (%s %s) %s\n", &(dAndT[0]), levelCStr(priority),
+            &(thread_buff[0]), gLogEntryPrefix, str);
+}
+
 // ---------------------------------------------------------------------------
 
 extern "C" void PSLogNoLocFn(int _pri, bool _andPrintf,
@@ -1135,7 +1210,12 @@ extern "C" void PSLogNoLocFn(int _pri, bool _andPrintf,
 
     va_list ap;
     va_start(ap, _format);
-    PSLogPrv(_pri, _andPrintf, _format, ap);
+    if (!PSLogAsyncPrv(_pri, _andPrintf, nullptr, 0, nullptr, _format, ap))
+    {
+        va_end(ap);
+        va_start(ap, _format);
+        PSLogPrv(_pri, _andPrintf, _format, ap);
+    }
     va_end(ap);
 
     errno = tmp_errno;
@@ -1166,6 +1246,19 @@ extern "C" void PSLogFn(int _pri, bool _andPrintf,
     // not preserve errno").
     int tmp_errno = errno;
 
+    { // The location is formatted by the thread writing the log
+        va_list ap;
+        va_start(ap, _format);
+        const bool logged = PSLogAsyncPrv(_pri, _andPrintf, f, l, m,
+                                          _format, ap);
+        va_end(ap);
+        if (logged)
+        {
+            errno = tmp_errno;
+            return;
+        }
+    }
+
     char bname_buff[PST_MAXPATHLEN+6];
     if ((f) && (f[0]))
     {
@@ -146,12 +146,12 @@ namespace Pistache::Aio
     class SyncImpl : public Reactor::Impl
     {
     public:
-        explicit SyncImpl(Reactor* reactor)
+        SyncImpl(Reactor* reactor, Polling::Backend backend)
             : Reactor::Impl(reactor)
             , handlers_()
             , shutdown_()
             , shutdownFd()
-            , poller()
+            , poller(backend)
         {
             shutdownFd.bind(poller);
         }
@@ -290,7 +290,8 @@ namespace Pistache::Aio
                         poller_reg_unreg_mutex(poller.reg_unreg_mutex_);
                     GUARD_AND_DBG_LOG(poller_reg_unreg_mutex);
 
-                    std::vector<Polling::Event> events;
+                    auto& events = events_;
+                    events.clear();
                     int ready_fds = poller.poll(events);
 
                     switch (ready_fds)
@@ -308,7 +309,7 @@ namespace Pistache::Aio
                             if (shutdown_)
                                 return;
 
-                            handleFds(std::move(events));
+                            handleFds(events);
                         }
                     }
                 }
@@ -359,12 +360,16 @@ namespace Pistache::Aio
             return HandlerList::decodeTag(tag);
         }
 
-        void handleFds(std::vector<Polling::Event> events) const
+        void handleFds(std::vector<Polling::Event>& events)
         {
             // Fast-path: if we only have one handler, do not bother scanning the fds to
             // find the right handlers
             if (handlers_.size() == 1)
-                handlers_.at(0)->onReady(FdSet(std::move(events)));
+            {
+                FdSet fds(std::move(events), std::move(entries_));
+                handlers_.at(0)->onReady(fds);
+                entries_ = std::move(fds).release();
+            }
             else
             {
                 std::unordered_map<std::shared_ptr<Handler>, std::vector<Polling::Event>>
@@ -494,6 +499,10 @@ namespace Pistache::Aio
         NotifyFd shutdownFd;
 
         Polling::Epoll poller;
+
+        // Kept from one poll to the next, not to allocate for each
+        std::vector<Polling::Event> events_;
+        std::vector<FdSet::Entry> entries_;
     };
 
     /* Asynchronous implementation of the reactor that spawns a number N of threads
@@ -528,7 +537,8 @@ namespace Pistache::Aio
         static constexpr uint32_t KeyMarker = 0xBADB0B;
 
         AsyncImpl(Reactor* reactor,
-                  size_t threads, const std::string& threadsName)
+                  size_t threads, const std::string& threadsName,
+                  Polling::Backend backend)
             : Reactor::Impl(reactor)
         {
             PS_TIMEDBG_START_THIS;
@@ -537,7 +547,7 @@ namespace Pistache::Aio
                 throw std::runtime_error("Too many worker threads requested (max "s + std::to_string(SyncImpl::MaxHandlers()) + ")."s);
 
             for (size_t i = 0; i < threads; ++i)
-                workers_.emplace_back(std::make_unique<Worker>(reactor, threadsName));
+                workers_.emplace_back(std::make_unique<Worker>(reactor, threadsName, backend));
             PS_LOG_DEBUG_ARGS("threads %d, workers_.size() %d",
                               threads, workers_.size());
         }
@@ -695,9 +705,10 @@ namespace Pistache::Aio
         struct Worker
         {
 
-            explicit Worker(Reactor* reactor, const std::string& threadsName)
+            Worker(Reactor* reactor, const std::string& threadsName,
+                   Polling::Backend backend)
                 : thread()
-                , sync(new SyncImpl(reactor))
+                , sync(new SyncImpl(reactor, backend))
                 , threadsName_(threadsName)
             { }
 
@@ -928,13 +939,13 @@ namespace Pistache::Aio
     Reactor::Impl* SyncContext::makeImpl(Reactor* reactor) const
     {
         PS_TIMEDBG_START_THIS;
-        return new SyncImpl(reactor);
+        return new SyncImpl(reactor, backend_);
     }
 
     Reactor::Impl* AsyncContext::makeImpl(Reactor* reactor) const
     {
         PS_TIMEDBG_START_THIS;
-        return new AsyncImpl(reactor, threads_, threadsName_);
+        return new AsyncImpl(reactor, threads_, threadsName_, backend_);
     }
 
     AsyncContext AsyncContext::singleThreaded() { return AsyncContext(1); }
@@ -0,0 +1,209 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* simd_scan.cc
+
+   Implementation of the delimiter search
+*/
+
+#include <pistache/simd_scan.h>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define PST_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace Pistache::Scan
+{
+
+    namespace
+    {
+        using FindFirstOf = const char* (*)(const char*, const char*, std::string_view);
+
+        const char* findFirstOfScalar(const char* begin, const char* end, std::string_view set)
+        {
+            if (begin == end)
+                return end;
+
+            if (set.size() == 1)
+            {
+                const void* found = std::memchr(begin, set[0], static_cast<size_t>(end - begin));
+                return found ? static_cast<const char*>(found) : end;
+            }
+
+            for (; begin != end; ++begin)
+            {
+                if (set.find(*begin) != std::string_view::npos)
+                    return begin;
+            }
+            return end;
+        }
+
+#ifdef PST_SCAN_X86
+        // Bytes past the last full block are left to the scalar loop, the
+        // vector loads never read past end. A single byte is left to memchr,
+        // which libc already vectorizes better than a set comparison does
+
+        __attribute__((target("sse4.2"))) const char*
+        findFirstOfSse42(const char* begin, const char* end, std::string_view set)
+        {
+            if (set.size() == 1)
+                return findFirstOfScalar(begin, end, set);
+
+            alignas(16) char setBytes[16] = {};
+            std::memcpy(setBytes, set.data(), set.size());
+
+            const __m128i needles = _mm_load_si128(reinterpret_cast<const __m128i*>(setBytes));
+            const int needleCount = static_cast<int>(set.size());
+
+            for (; end - begin >= 16; begin += 16)
+            {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+                const int index     = _mm_cmpestri(needles, needleCount, block, 16,
+                                                   _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY
+                                                       | _SIDD_LEAST_SIGNIFICANT);
+                if (index != 16)
+                    return begin + index;
+            }
+
+            return findFirstOfScalar(begin, end, set);
+        }
+
+        __attribute__((target("avx2"))) const char*
+        findFirstOfAvx2(const char* begin, const char* end, std::string_view set)
+        {
+            if (set.size() == 1)
+                return findFirstOfScalar(begin, end, set);
+
+            __m256i needles[16];
+            for (size_t i = 0; i < set.size(); ++i)
+                needles[i] = _mm256_set1_epi8(set[i]);
+
+            for (; end - begin >= 32; begin += 32)
+            {
+                const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+
+                __m256i found = _mm256_cmpeq_epi8(block, needles[0]);
+                for (size_t i = 1; i < set.size(); ++i)
+                    found = _mm256_or_si256(found, _mm256_cmpeq_epi8(block, needles[i]));
+
+                const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(found));
+                if (mask != 0)
+                    return begin + __builtin_ctz(mask);
+            }
+
+            return findFirstOfScalar(begin, end, set);
+        }
+#endif
+
+        FindFirstOf implementation(Isa isa)
+        {
+            switch (isa)
+            {
+#ifdef PST_SCAN_X86
+            case Isa::Avx2:
+                return &findFirstOfAvx2;
+            case Isa::Sse42:
+                return &findFirstOfSse42;
+#endif
+            default:
+                return &findFirstOfScalar;
+            }
+        }
+
+        Isa best()
+        {
+            if (supported(Isa::Avx2))
+                return Isa::Avx2;
+            if (supported(Isa::Sse42))
+                return Isa::Sse42;
+            return Isa::Scalar;
+        }
+
+        struct Current
+        {
+            Isa isa;
+            FindFirstOf findFirstOf;
+        };
+
+        Current& current()
+        {
+            static Current current { best(), implementation(best()) };
+            return current;
+        }
+    }
+
+    const char* isaString(Isa isa)
+    {
+        switch (isa)
+        {
+        case Isa::Scalar:
+            return "scalar";
+        case Isa::Sse42:
+            return "sse4.2";
+        case Isa::Avx2:
+            return "avx2";
+        }
+        return "unknown";
+    }
+
+    bool supported(Isa isa)
+    {
+        switch (isa)
+        {
+        case Isa::Scalar:
+            return true;
+#ifdef PST_SCAN_X86
+        case Isa::Sse42:
+            __builtin_cpu_init(); // in case this runs before static constructors
+            return __builtin_cpu_supports("sse4.2");
+        case Isa::Avx2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+        }
+    }
+
+    Isa isa() { return current().isa; }
+
+    void setIsa(Isa isa)
+    {
+        if (!supported(isa))
+            throw std::invalid_argument(std::string("Unsupported instruction set: ") + isaString(isa));
+
+        current() = Current { isa, implementation(isa) };
+    }
+
+    const char* findFirstOf(const char* begin, const char* end, std::string_view set)
+    {
+        if (set.empty() || set.size() > 16)
+            throw std::invalid_argument("Between 1 and 16 bytes can be searched for");
+
+        return current().findFirstOf(begin, end, set);
+    }
+
+    const char* findCrLf(const char* begin, const char* end)
+    {
+        auto findFirstOf = current().findFirstOf;
+        for (;;)
+        {
+            const char* cr = findFirstOf(begin, end, "\r");
+            if (end - cr < 2)
+                return end;
+            if (cr[1] == '\n')
+                return cr;
+            begin = cr + 1;
+        }
+    }
+
+} // namespace Pistache::Scan
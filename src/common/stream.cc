@@ -62,9 +62,15 @@ namespace Pistache
 
     size_t RawBuffer::size() const { return length_; }
 
+    OpenFile::~OpenFile()
+    {
+        if (fd_ != -1)
+            PST_FILE_CLOSE(fd_);
+    }
+
     FileBuffer::FileBuffer(const std::string& fileName)
         : fileName_(fileName)
-        , fd_(-1)
+        , file_()
         , size_(0)
     {
         if (fileName.empty())
@@ -77,25 +83,175 @@ namespace Pistache
         {
             throw std::runtime_error("Could not open file");
         }
+        file_ = std::make_shared<const OpenFile>(fd);
 
         struct stat sb;
         int res = ::fstat(fd, &sb);
         if (res == -1)
         {
-            PST_FILE_CLOSE(fd);
             throw std::runtime_error("Could not get file stats");
         }
 
-        fd_   = fd;
         size_ = sb.st_size;
     }
 
-    int FileBuffer::fd() const { return fd_; }
+    FileBuffer::FileBuffer(const std::string& fileName, size_t offset, size_t length)
+        : FileBuffer(fileName)
+    {
+        if (offset > size_ || length > size_ - offset)
+        {
+            throw std::runtime_error("File range out of bounds");
+        }
+
+        offset_ = offset;
+        size_   = length;
+    }
+
+    FileBuffer::FileBuffer(std::shared_ptr<const OpenFile> file, size_t offset,
+                           size_t length)
+        : fileName_()
+        , file_(std::move(file))
+        , offset_(offset)
+        , size_(length)
+    {
+        if (!file_)
+        {
+            throw std::runtime_error("No file");
+        }
+    }
+
+    int FileBuffer::fd() const { return file_->fd(); }
+
+    size_t FileBuffer::offset() const { return offset_; }
 
     size_t FileBuffer::size() const { return size_; }
 
+    void GatherBuffer::add(RawBuffer buffer)
+    {
+        if (buffer.size() == 0)
+            return;
+
+        size_ += buffer.size();
+
+        Piece piece;
+        piece.length = buffer.size();
+        piece.owned  = std::move(buffer);
+        pieces_.push_back(std::move(piece));
+    }
+
+    void GatherBuffer::add(std::string data)
+    {
+        const size_t length = data.size();
+        add(RawBuffer(std::move(data), length));
+    }
+
+    void GatherBuffer::add(std::shared_ptr<const std::string> data)
+    {
+        if (!data)
+            return;
+
+        const size_t length = data->size();
+        add(std::move(data), 0, length);
+    }
+
+    void GatherBuffer::add(std::shared_ptr<const std::string> data, size_t offset,
+                           size_t length)
+    {
+        if (!data || length == 0)
+            return;
+
+        if (offset > data->size() || length > data->size() - offset)
+            throw std::range_error("Trying to gather past the end of a buffer");
+
+        size_ += length;
+
+        Piece piece;
+        piece.shared = std::move(data);
+        piece.offset = offset;
+        piece.length = length;
+        pieces_.push_back(std::move(piece));
+    }
+
+    void GatherBuffer::add(GatherBuffer&& other)
+    {
+        for (auto& piece : other.pieces_)
+            pieces_.push_back(std::move(piece));
+        size_ += other.size_;
+
+        other.pieces_.clear();
+        other.size_ = 0;
+    }
+
+    std::string_view GatherBuffer::piece(size_t index) const
+    {
+        const auto& piece      = pieces_.at(index);
+        const std::string& str = piece.shared ? *piece.shared : piece.owned.data();
+        return std::string_view(str.data() + piece.offset, piece.length);
+    }
+
+    namespace
+    {
+        // Storage of the buffers destroyed last on this thread. A response
+        // is written to a buffer of its own, which would otherwise be one
+        // allocation per response. Only a few, small enough, are kept
+        class StoragePool
+        {
+        public:
+            static constexpr size_t MaxCount    = 16;
+            static constexpr size_t MaxCapacity = 64 * 1024;
+
+            ~StoragePool() { destroyed = true; }
+
+            std::vector<char> acquire()
+            {
+                if (free_.empty())
+                    return {};
+
+                auto storage = std::move(free_.back());
+                free_.pop_back();
+                return storage;
+            }
+
+            void release(std::vector<char>&& storage)
+            {
+                if (storage.capacity() == 0 || storage.capacity() > MaxCapacity || free_.size() >= MaxCount)
+                    return;
+
+                storage.clear();
+                free_.push_back(std::move(storage));
+            }
+
+            // Buffers outliving the thread's pool, static ones destroyed at
+            // exit, simply free their storage
+            static thread_local bool destroyed;
+
+        private:
+            std::vector<std::vector<char>> free_;
+        };
+
+        thread_local bool StoragePool::destroyed = false;
+
+        StoragePool* storagePool()
+        {
+            thread_local StoragePool pool;
+            return StoragePool::destroyed ? nullptr : &pool;
+        }
+
+        std::vector<char> acquireStorage()
+        {
+            auto* pool = storagePool();
+            return pool ? pool->acquire() : std::vector<char>();
+        }
+
+        void releaseStorage(std::vector<char>&& storage)
+        {
+            if (auto* pool = storagePool())
+                pool->release(std::move(storage));
+        }
+    }
+
     DynamicStreamBuf::DynamicStreamBuf(size_t size, size_t maxSize)
-        : data_()
+        : data_(acquireStorage())
         , maxSize_(maxSize)
     {
         assert(size <= maxSize);
@@ -115,6 +271,7 @@ namespace Pistache
     {
         if (&other != this)
         {
+            releaseStorage(std::move(data_));
             data_    = std::move(other.data_);
             maxSize_ = other.maxSize_;
             setp(other.pptr(), other.epptr());
@@ -124,6 +281,8 @@ namespace Pistache
         return *this;
     }
 
+    DynamicStreamBuf::~DynamicStreamBuf() { releaseStorage(std::move(data_)); }
+
     RawBuffer DynamicStreamBuf::buffer() const
     {
         return RawBuffer(data_.data(), pptr() - data_.data());
@@ -172,11 +331,7 @@ namespace Pistache
         if (static_cast<PST_SSIZE_T>(count) > buf->in_avail())
             return false;
 
-        for (size_t i = 0; i < count; ++i)
-        {
-            buf->sbumpc();
-        }
-
+        buf->setArea(buf->begptr(), buf->curptr() + count, buf->endptr());
         return true;
     }
 
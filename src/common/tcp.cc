@@ -33,4 +33,7 @@ namespace Pistache::Tcp
     void Handler::onDisconnection(const std::shared_ptr<Tcp::Peer>& /*peer*/)
     { }
 
+    void Handler::onReadResumed(const std::shared_ptr<Tcp::Peer>& /*peer*/)
+    { }
+
 } // namespace Pistache::Tcp
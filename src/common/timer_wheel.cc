@@ -0,0 +1,246 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* timer_wheel.cc
+
+   Implementation of the hashed timer wheel
+*/
+
+#include <pistache/timer_wheel.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Pistache
+{
+
+    namespace
+    {
+        size_t countTrailingZeros(uint64_t bits)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<size_t>(__builtin_ctzll(bits));
+#else
+            size_t n = 0;
+            while ((bits & 1) == 0)
+            {
+                bits >>= 1;
+                ++n;
+            }
+            return n;
+#endif
+        }
+    }
+
+    TimerWheel::TimerWheel(std::chrono::milliseconds tick, size_t slots,
+                           Clock::time_point origin)
+        : tick_(tick)
+        , origin_(origin)
+    {
+        if (tick_.count() <= 0)
+            throw std::invalid_argument("Timer wheel tick must be positive");
+
+        size_t count = 64;
+        while (count < slots)
+            count <<= 1;
+
+        mask_ = count - 1;
+        slots_.assign(count, Nil);
+        occupied_.assign(count / 64, 0);
+    }
+
+    TimerWheel::Id TimerWheel::armAt(Clock::time_point deadline, Callback callback)
+    {
+        // An idle wheel is not advanced, catch up so that the timer does
+        // not land in a slot the wheel is about to sweep for nothing
+        if (size_ == 0)
+            currentTick_ = std::max(currentTick_, tickOf(Clock::now()));
+
+        // Rounded up, a timer must not fire before its deadline
+        uint64_t expiry = currentTick_ + 1;
+        if (deadline > origin_)
+        {
+            const auto elapsed = std::chrono::ceil<std::chrono::milliseconds>(deadline - origin_);
+            expiry             = std::max(expiry,
+                                          static_cast<uint64_t>((elapsed.count() + tick_.count() - 1) / tick_.count()));
+        }
+
+        const uint32_t index = allocNode();
+        auto& node           = nodes_[index];
+        node.expiry          = expiry;
+        node.armed           = true;
+        node.callback        = std::move(callback);
+        link(index);
+        ++size_;
+
+        return (static_cast<Id>(node.generation) << 32) | index;
+    }
+
+    bool TimerWheel::disarm(Id id)
+    {
+        const auto index      = static_cast<uint32_t>(id & UINT32_MAX);
+        const auto generation = static_cast<uint32_t>(id >> 32);
+
+        if (index >= nodes_.size())
+            return false;
+
+        auto& node = nodes_[index];
+        if (!node.armed || node.generation != generation)
+            return false;
+
+        unlink(index);
+        freeNode(index);
+        --size_;
+        return true;
+    }
+
+    size_t TimerWheel::advance(Clock::time_point now)
+    {
+        const uint64_t target = tickOf(now);
+        if (target <= currentTick_)
+            return 0;
+
+        // Beyond one turn every slot gets visited anyway
+        const uint64_t steps = std::min<uint64_t>(target - currentTick_, mask_ + 1);
+        for (uint64_t step = 1; step <= steps && size_ > due_.size(); ++step)
+        {
+            const size_t slot = (currentTick_ + step) & mask_;
+
+            uint32_t index = slots_[slot];
+            while (index != Nil)
+            {
+                auto& node          = nodes_[index];
+                const uint32_t next = node.next;
+                if (node.expiry <= target)
+                {
+                    due_.push_back(std::move(node.callback));
+                    unlink(index);
+                    freeNode(index);
+                }
+                index = next;
+            }
+        }
+
+        currentTick_ = target;
+        size_ -= due_.size();
+
+        // Callbacks only run once the wheel is consistent again, so that
+        // they can arm or disarm timers
+        const size_t fired = due_.size();
+        for (auto& callback : due_)
+        {
+            if (callback)
+                callback();
+        }
+        due_.clear();
+
+        return fired;
+    }
+
+    std::optional<TimerWheel::Clock::time_point> TimerWheel::nextExpiry() const
+    {
+        if (size_ == 0)
+            return std::nullopt;
+
+        // The first non-empty slot after the current one holds the soonest
+        // candidate, which may be due on a later turn
+        const size_t start = (currentTick_ + 1) & mask_;
+        const size_t words = occupied_.size();
+
+        for (size_t n = 0; n <= words; ++n)
+        {
+            const size_t word = ((start / 64) + n) % words;
+            uint64_t bits     = occupied_[word];
+
+            const uint64_t startBit = uint64_t(1) << (start % 64);
+            if (n == 0)
+                bits &= ~(startBit - 1);
+            else if (n == words)
+                bits &= (startBit - 1);
+
+            if (bits != 0)
+            {
+                const size_t slot     = word * 64 + countTrailingZeros(bits);
+                const uint64_t ticks = currentTick_ + 1 + ((slot - start) & mask_);
+                return origin_ + tick_ * ticks;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    uint64_t TimerWheel::tickOf(Clock::time_point time) const
+    {
+        if (time <= origin_)
+            return 0;
+
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(time - origin_) / tick_);
+    }
+
+    uint32_t TimerWheel::allocNode()
+    {
+        if (freeList_ != Nil)
+        {
+            const uint32_t index = freeList_;
+            freeList_            = nodes_[index].next;
+            return index;
+        }
+
+        if (nodes_.size() >= Nil)
+            throw std::length_error("Too many timers armed");
+
+        nodes_.emplace_back();
+        return static_cast<uint32_t>(nodes_.size() - 1);
+    }
+
+    void TimerWheel::freeNode(uint32_t index)
+    {
+        auto& node = nodes_[index];
+        node.armed = false;
+        node.callback = nullptr;
+
+        // Skip 0 on wrap-around, so that no id is ever InvalidId
+        if (++node.generation == 0)
+            node.generation = 1;
+
+        node.prev = Nil;
+        node.next = freeList_;
+        freeList_ = index;
+    }
+
+    void TimerWheel::link(uint32_t index)
+    {
+        auto& node        = nodes_[index];
+        const size_t slot = node.expiry & mask_;
+
+        node.prev = Nil;
+        node.next = slots_[slot];
+        if (node.next != Nil)
+            nodes_[node.next].prev = index;
+
+        slots_[slot] = index;
+        occupied_[slot / 64] |= uint64_t(1) << (slot % 64);
+    }
+
+    void TimerWheel::unlink(uint32_t index)
+    {
+        auto& node        = nodes_[index];
+        const size_t slot = node.expiry & mask_;
+
+        if (node.prev != Nil)
+            nodes_[node.prev].next = node.next;
+        else
+            slots_[slot] = node.next;
+
+        if (node.next != Nil)
+            nodes_[node.next].prev = node.prev;
+
+        if (slots_[slot] == Nil)
+            occupied_[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+    }
+
+} // namespace Pistache
@@ -0,0 +1,165 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* trace.cc
+
+   Request sampling, and the sinks spans are handed to
+*/
+
+#include <pistache/trace.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace Pistache::Trace
+{
+
+    namespace Private
+    {
+        std::atomic<uint32_t> sampling { 0 };
+    } // namespace Private
+
+    namespace
+    {
+        std::atomic<uint64_t> lastId { 0 };
+
+        // Swapped with std::atomic_store, as Rest::Router's frozen routes
+        std::shared_ptr<Sink> currentSink;
+    }
+
+    const char* phaseString(Phase phase)
+    {
+        switch (phase)
+        {
+        case Phase::Accepted:
+            return "accepted";
+        case Phase::FirstByte:
+            return "first_byte";
+        case Phase::Parsed:
+            return "parsed";
+        case Phase::RouteMatched:
+            return "route_matched";
+        case Phase::HandlerReturned:
+            return "handler_returned";
+        case Phase::FirstWrite:
+            return "first_write";
+        case Phase::LastByteFlushed:
+            return "last_byte_flushed";
+        }
+        return "unknown";
+    }
+
+    uint64_t now()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+
+    uint64_t Span::between(Phase from, Phase to) const
+    {
+        if (!reached(from) || !reached(to))
+            return 0;
+
+        const uint64_t start = at[static_cast<size_t>(from)];
+        const uint64_t end   = at[static_cast<size_t>(to)];
+        return end > start ? end - start : 0;
+    }
+
+    RingSink::RingSink(size_t capacity)
+        : capacity_(std::max<size_t>(capacity, 1))
+    {
+        spans_.reserve(capacity_);
+    }
+
+    void RingSink::onSpan(const Span& span)
+    {
+        std::lock_guard<std::mutex> guard(mtx_);
+        if (spans_.size() < capacity_)
+            spans_.push_back(span);
+        else
+            spans_[next_] = span;
+        next_ = (next_ + 1) % capacity_;
+    }
+
+    std::vector<Span> RingSink::spans() const
+    {
+        std::lock_guard<std::mutex> guard(mtx_);
+        if (spans_.size() < capacity_)
+            return spans_;
+
+        std::vector<Span> spans;
+        spans.reserve(capacity_);
+        spans.insert(spans.end(), spans_.begin() + static_cast<std::ptrdiff_t>(next_), spans_.end());
+        spans.insert(spans.end(), spans_.begin(), spans_.begin() + static_cast<std::ptrdiff_t>(next_));
+        return spans;
+    }
+
+    FileSink::FileSink(const std::string& path)
+        : file_(fopen(path.c_str(), "a"))
+    {
+        if (!file_)
+            throw std::runtime_error("Cannot open trace file " + path);
+    }
+
+    FileSink::~FileSink() { fclose(file_); }
+
+    void FileSink::onSpan(const Span& span)
+    {
+        uint64_t start = 0;
+        for (uint64_t when : span.at)
+        {
+            if (when && (!start || when < start))
+                start = when;
+        }
+
+        std::string line = "span " + std::to_string(span.id) + ' ' + Http::methodString(span.method)
+            + ' ' + span.resource + ' ' + std::to_string(static_cast<int>(span.code));
+        for (size_t i = 0; i < PhaseCount; ++i)
+        {
+            if (span.at[i])
+                line += std::string(" ") + phaseString(static_cast<Phase>(i)) + "=+"
+                    + std::to_string((span.at[i] - start) / 1000) + "us";
+        }
+        line += '\n';
+
+        std::lock_guard<std::mutex> guard(mtx_);
+        fwrite(line.data(), 1, line.size(), file_);
+        fflush(file_);
+    }
+
+    void sampleEvery(uint32_t n) { Private::sampling.store(n, std::memory_order_relaxed); }
+
+    void setSink(std::shared_ptr<Sink> sink) { std::atomic_store(&currentSink, std::move(sink)); }
+
+    std::shared_ptr<Sink> sink() { return std::atomic_load(&currentSink); }
+
+    std::shared_ptr<Span> sample()
+    {
+        const uint32_t every = Private::sampling.load(std::memory_order_relaxed);
+        if (!every)
+            return nullptr;
+
+        // Counted by each thread, not to share a cache line between them
+        thread_local uint32_t seen = 0;
+        if (++seen < every)
+            return nullptr;
+        seen = 0;
+
+        auto span = std::make_shared<Span>();
+        span->id  = lastId.fetch_add(1, std::memory_order_relaxed) + 1;
+        span->mark(Phase::FirstByte);
+        return span;
+    }
+
+    void finish(const Span& span)
+    {
+        if (auto current = sink())
+            current->onSpan(span);
+    }
+
+} // namespace Pistache::Trace
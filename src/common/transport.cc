@@ -12,6 +12,7 @@
 */
 
 #include <pistache/eventmeth.h>
+#include <pistache/metrics.h>
 #include <pistache/pist_quote.h>
 
 #ifdef _USE_LIBEVENT_LIKE_APPLE
@@ -48,8 +49,29 @@
 #include <pistache/transport.h>
 #include <pistache/utils.h>
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
 using std::to_string;
 
+#if !defined(_IS_WINDOWS) && !defined(_USE_LIBEVENT_LIKE_APPLE)
+// Several buffers queued for a peer go out with one sendmsg
+#define PS_GATHER_WRITES 1
+#endif
+
+#if defined(__linux__) && !defined(_USE_LIBEVENT)
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+// Large writes may go out with MSG_ZEROCOPY, see setZeroCopyThreshold
+#define PS_ZEROCOPY 1
+#endif
+#endif
+
 #ifdef _USE_LIBEVENT_LIKE_APPLE
 #if defined(__NetBSD__) || defined(_IS_WINDOWS)
 #define PS_USE_TCP_NODELAY 1
@@ -60,6 +82,72 @@ namespace Pistache::Tcp
 {
     using namespace Polling;
 
+    namespace
+    {
+        thread_local Transport* currentTransport = nullptr;
+
+        // Makes transport the current one while it handles its events
+        class CurrentTransport
+        {
+        public:
+            explicit CurrentTransport(Transport* transport)
+                : previous_(currentTransport)
+            {
+                currentTransport = transport;
+            }
+
+            CurrentTransport(const CurrentTransport&)            = delete;
+            CurrentTransport& operator=(const CurrentTransport&) = delete;
+
+            ~CurrentTransport() { currentTransport = previous_; }
+
+        private:
+            Transport* previous_;
+        };
+    }
+
+#ifdef PS_GATHER_WRITES
+    namespace
+    {
+        // Points iov at what is left of buffer (a BufferHolder, raw or
+        // gathered) past offset, in up to max iovecs. Returns how many
+        template <typename Buffer>
+        size_t gatherInto(const Buffer& buffer, size_t offset, struct iovec* iov, size_t max)
+        {
+            if (buffer.isRaw())
+            {
+                if (max == 0 || offset >= buffer.size())
+                    return 0;
+
+                iov[0].iov_base = const_cast<char*>(buffer.raw().data().data()) + offset;
+                iov[0].iov_len  = buffer.size() - offset;
+                return 1;
+            }
+
+            const auto& gather = buffer.gather();
+
+            size_t count = 0;
+            for (size_t i = 0; i < gather.count() && count < max; ++i)
+            {
+                auto piece = gather.piece(i);
+                if (offset >= piece.size())
+                {
+                    offset -= piece.size();
+                    continue;
+                }
+
+                piece.remove_prefix(offset);
+                offset = 0;
+
+                iov[count].iov_base = const_cast<char*>(piece.data());
+                iov[count].iov_len  = piece.size();
+                ++count;
+            }
+            return count;
+        }
+    }
+#endif /* PS_GATHER_WRITES */
+
     Transport::Transport(const std::shared_ptr<Tcp::Handler>& handler)
 #ifdef _USE_LIBEVENT_LIKE_APPLE
         : tcp_prot_num_(-1)
@@ -88,11 +176,26 @@ namespace Pistache::Tcp
     Transport::~Transport()
     {
         removeAllPeers();
+
+        // Whatever the kernel still reads from goes with the process now
+        for (auto& lingering : lingering_)
+            CLOSE_FD(lingering.fd);
     }
 
     std::shared_ptr<Aio::Handler> Transport::clone() const
     {
-        return std::make_shared<Transport>(handler_->clone());
+        auto transport = std::make_shared<Transport>(handler_->clone());
+        transport->setReadBufferSize(readBufferSize_);
+        transport->setZeroCopyThreshold(zeroCopyThreshold_);
+        return transport;
+    }
+
+    void Transport::setReadBufferSize(size_t size)
+    {
+        if (size == 0)
+            throw std::invalid_argument("Read buffer size must not be zero");
+
+        readBufferSize_ = size;
     }
 
     void Transport::flush()
@@ -107,27 +210,71 @@ namespace Pistache::Tcp
         writesQueue.bind(poller);
         timersQueue.bind(poller);
         peersQueue.bind(poller);
+        resumesQueue.bind(poller);
+        postsQueue.bind(poller);
         notifier.bind(poller);
 
 #ifdef _USE_LIBEVENT
         epoll_fd = poller.getEventMethEpollEquiv();
 #endif
+
+        // One-shot timer, armed for the timer wheel's next expiry (see
+        // rearmTimerWheel)
+        timerWheelFd_ =
+#ifdef _USE_LIBEVENT
+            TRY_NULL_RET(poller.em_timer_new(PST_CLOCK_MONOTONIC,
+                                             F_SETFDL_NOTHING,
+                                             PST_O_NONBLOCK));
+#else
+            TRY_RET(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK));
+#endif
+        poller.addFd(timerWheelFd_,
+                     Flags<Polling::NotifyOn>(Polling::NotifyOn::Read),
+                     Polling::Tag(timerWheelFd_));
+        timerWheelArmedFor_.reset();
     }
 
     void Transport::unregisterPoller(Polling::Epoll& poller)
     {
         PS_TIMEDBG_START_THIS;
 
+        // The listening socket itself is the listener's to close
+        if (acceptFd_ != PS_FD_EMPTY)
+        {
+            poller.removeFd(acceptFd_);
+            acceptFd_ = PS_FD_EMPTY;
+        }
+
+        if (timerWheelFd_ != PS_FD_EMPTY)
+        {
+            poller.removeFd(timerWheelFd_);
+            CLOSE_FD(timerWheelFd_);
+            timerWheelFd_ = PS_FD_EMPTY;
+        }
+
 #ifdef _USE_LIBEVENT
         epoll_fd = nullptr;
 #endif
 
         notifier.unbind(poller);
+        postsQueue.unbind(poller);
+        resumesQueue.unbind(poller);
         peersQueue.unbind(poller);
         timersQueue.unbind(poller);
         writesQueue.unbind(poller);
     }
 
+    void Transport::acceptOn(Fd listenFd, Acceptor accept)
+    {
+        PS_TIMEDBG_START_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD), listenFd);
+
+        acceptFd_ = listenFd;
+        acceptor_ = std::move(accept);
+
+        // Level triggered, as handleAccept may leave connections pending
+        reactor()->registerFd(key(), listenFd, NotifyOn::Read, Polling::Mode::Level);
+    }
+
     void Transport::handleNewPeer(const std::shared_ptr<Tcp::Peer>& peer)
     {
         auto ctx                   = context();
@@ -146,7 +293,6 @@ namespace Pistache::Tcp
             handlePeer(peer);
         }
 
-        Guard guard(toWriteLock);
         Fd fd = peer->fd();
         if (fd == PS_FD_EMPTY)
         {
@@ -154,7 +300,35 @@ namespace Pistache::Tcp
             return;
         }
 
-        toWrite.emplace(fd, std::deque<WriteEntry> {});
+        auto writes = peerWrites(fd, true);
+        Guard guard(writes->lock);
+        writes->queued = true;
+    }
+
+    Transport::WriteShard& Transport::writeShard(Fd fd)
+    {
+        // Fds are small consecutive integers (or, with libevent, aligned
+        // pointers), fold the higher bits in before picking a shard
+        auto h = std::hash<Fd> {}(fd);
+        h ^= (h >> 4) ^ (h >> 8);
+        return toWrite[h % WriteShardCount];
+    }
+
+    std::shared_ptr<Transport::PeerWrites> Transport::peerWrites(Fd fd, bool create)
+    {
+        auto& shard = writeShard(fd);
+        Guard guard(shard.lock);
+
+        if (!create)
+        {
+            auto it = shard.peers.find(fd);
+            return it != std::end(shard.peers) ? it->second : nullptr;
+        }
+
+        auto& writes = shard.peers[fd];
+        if (!writes)
+            writes = std::make_shared<PeerWrites>();
+        return writes;
     }
 
 #ifdef DEBUG
@@ -194,10 +368,19 @@ namespace Pistache::Tcp
     {
         PS_LOG_DEBUG_ARGS("%d fds", fds.size());
 
+        CurrentTransport current(this);
+
         for (const auto& entry : fds)
         {
             PS_LOG_DBG_FD_AND_NOTIFY;
 
+#ifdef PS_ZEROCOPY
+            // Whatever else the peer's fd is ready for
+            if (zeroCopyThreshold_ != 0 && entry.isError() && isPeerFd(entry.getTag()))
+                handleZeroCopyCompletions(PS_CAST_AWAY_CONST_FD(
+                    static_cast<FdConst>(entry.getTag().value())));
+#endif
+
             if (entry.getTag() == writesQueue.tag())
             {
                 PS_LOG_DEBUG("Write queue");
@@ -213,11 +396,47 @@ namespace Pistache::Tcp
                 PS_LOG_DEBUG("Peers queue");
                 handlePeerQueue();
             }
+            else if (acceptFd_ != PS_FD_EMPTY && entry.getTag() == Polling::Tag(acceptFd_))
+            {
+                PS_LOG_DEBUG("Listening socket");
+                handleAccept();
+            }
+            else if (entry.getTag() == resumesQueue.tag())
+            {
+                PS_LOG_DEBUG("Resumes queue");
+                handleResumeQueue();
+            }
+            else if (entry.getTag() == postsQueue.tag())
+            {
+                PS_LOG_DEBUG("Posts queue");
+                handlePostQueue();
+            }
             else if (entry.getTag() == notifier.tag())
             {
                 PS_LOG_DEBUG("notifier");
                 handleNotify();
             }
+            else if (entry.getTag() == Polling::Tag(timerWheelFd_))
+            {
+                PS_LOG_DEBUG("Timer wheel");
+                handleTimerWheel();
+            }
+#ifdef PISTACHE_USE_SSL
+            else if (isSslHandshakeFd(entry.getTag()))
+            {
+                // Readable, writable or hung up: in every case it is
+                // SSL_accept that tells us what happens next
+                auto tag = entry.getTag();
+                auto it  = handshakes_.find(PS_CAST_AWAY_CONST_FD(
+                    static_cast<FdConst>(tag.value())));
+
+                // Copied, since the handshake may complete or fail and
+                // erase the entry from handshakes_
+                auto peer = it->second.peer;
+                PS_LOG_DEBUG("continueSslHandshake");
+                continueSslHandshake(peer);
+            }
+#endif /* PISTACHE_USE_SSL */
 
             else if (entry.isReadable())
             {
@@ -231,22 +450,9 @@ namespace Pistache::Tcp
                     PS_LOG_DEBUG("handleIncoming");
                     handleIncoming(peer);
                 }
-                else if (isTimerFd(tag))
-                {
-                    auto it      = timers.find(static_cast<decltype(timers)::key_type>(tag.value()));
-                    auto& entry_ = it->second;
-                    PS_LOG_DEBUG("handleTimer");
-                    handleTimer(std::move(entry_));
-                    PS_LOG_DEBUG_ARGS("Timer %" PIST_QUOTE(PS_FD_PRNTFCD) " erased from timers",
-                                      it->first);
-
-                    PS_LOG_DEBUG_ARGS("Timer %" PIST_QUOTE(PS_FD_PRNTFCD) " erasing from timers",
-                                      it->first);
-                    timers.erase(it->first);
-                }
                 else
                 {
-                    PS_LOG_DEBUG("neither peer nor timer");
+                    PS_LOG_DEBUG("not a peer");
                 }
             }
             else if (entry.isWritable())
@@ -259,16 +465,14 @@ namespace Pistache::Tcp
                 // and we cast away the const
                 Fd fd = PS_CAST_AWAY_CONST_FD(fdconst);
 
+#ifdef DEBUG
+                if (!hasPendingWrites(fd))
                 {
-                    Guard guard(toWriteLock);
-                    auto it = toWrite.find(fd);
-                    if (it == std::end(toWrite))
-                    {
-                        // This can happen if another thread triggered an explicit
-                        // flush right when this thread woke up to write as well
-                        PS_LOG_DEBUG("fd not in toWrite, nothing to write");
-                    }
+                    // This can happen if another thread triggered an explicit
+                    // flush right when this thread woke up to write as well
+                    PS_LOG_DEBUG("fd not in toWrite, nothing to write");
                 }
+#endif
 
                 reactor()->modifyFd(key(), fd, NotifyOn::Read, Polling::Mode::Edge);
 
@@ -279,16 +483,39 @@ namespace Pistache::Tcp
         }
     }
 
+    void Transport::disarmTimer(TimerId id)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        disarmTimer(id, PS_FD_EMPTY);
+    }
+
     void Transport::disarmTimer(Fd fd)
     {
         PS_TIMEDBG_START_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
 
-        auto it = timers.find(fd);
-        if (it == std::end(timers))
-            throw std::runtime_error("Timer has not been armed");
+        disarmTimer(TimerWheel::InvalidId, fd);
+    }
+
+    void Transport::disarmTimer(TimerId id, Fd fd)
+    {
+        auto ctx                   = context();
+        const bool isInRightThread = std::this_thread::get_id() == ctx.thread();
+
+        if (!isInRightThread)
+        {
+            timersQueue.push(TimerEntry::disarming(id, fd));
+            return;
+        }
 
-        auto& entry = it->second;
-        entry.disable();
+        if (disarmTimerImpl(id, fd))
+            return;
+
+        // The timer may have been armed from another thread and still be
+        // sitting in timersQueue
+        handleTimerQueue();
+        if (!disarmTimerImpl(id, fd) && id == TimerWheel::InvalidId)
+            throw std::runtime_error("Timer has not been armed");
     }
 
     void Transport::handleIncoming(const std::shared_ptr<Peer>& peer)
@@ -299,10 +526,22 @@ namespace Pistache::Tcp
             return;
         }
 
-        char buffer[Const::MaxBuffer] = { 0 };
+        // Left in the socket until reading resumes
+        if (peer->readPaused_)
+        {
+            PS_LOG_DEBUG("Reading paused");
+            return;
+        }
 
-        PST_SSIZE_T totalBytes = 0;
-        em_socket_t fdactual   = peer->actualFd();
+        // Allocated on first use, in the reactor thread
+        if (readBuffer_.size() != readBufferSize_)
+            readBuffer_.resize(readBufferSize_);
+
+        char* buffer            = readBuffer_.data();
+        const size_t bufferSize = readBuffer_.size();
+
+        size_t totalBytes    = 0;
+        em_socket_t fdactual = peer->actualFd();
         if (fdactual < 0)
         {
             PS_LOG_DEBUG_ARGS("Peer %p has no actual Fd", peer.get());
@@ -322,7 +561,9 @@ namespace Pistache::Tcp
 
                 bytes = SSL_read(reinterpret_cast<SSL*>(peer->ssl()),
                                  buffer + totalBytes,
-                                 static_cast<int>(Const::MaxBuffer - totalBytes));
+                                 static_cast<int>(std::min<size_t>(
+                                     bufferSize - totalBytes,
+                                     static_cast<size_t>(std::numeric_limits<int>::max()))));
                 if (bytes <= 0)
                 {
                     int ssl_get_error_res = SSL_get_error(
@@ -353,7 +594,7 @@ namespace Pistache::Tcp
 #endif /* PISTACHE_USE_SSL */
                 PS_LOG_DEBUG("recv (read)");
                 bytes = PST_SOCK_READ(fdactual, buffer + totalBytes,
-                                      Const::MaxBuffer - totalBytes);
+                                      bufferSize - totalBytes);
                 if (bytes < 0)
                     retry = (errno == EAGAIN || errno == EWOULDBLOCK);
 #ifdef PISTACHE_USE_SSL
@@ -369,31 +610,32 @@ namespace Pistache::Tcp
                               (bytes < 0) ? errno : 0,
                               (bytes < 0) ? (PST_STRERROR_R_ERRNO) : "");
 
-            if (bytes == -1)
+            if (bytes > 0)
             {
-                if (retry)
-                {
-                    if (totalBytes > 0)
-                    {
-                        handler_->onInput(buffer, totalBytes, peer);
-                    }
-                }
-                else
+                totalBytes += static_cast<size_t>(bytes);
+                Metrics::local().bytesIn.add(static_cast<uint64_t>(bytes));
+
+                // Only hand the input over once the buffer is full, or the
+                // socket has been drained
+                if (totalBytes == bufferSize)
                 {
-                    handlePeerDisconnection(peer);
+                    handler_->onInput(buffer, totalBytes, peer);
+                    totalBytes = 0;
+
+                    if (peer->readPaused_)
+                        return;
                 }
-                break;
-            }
-            else if (bytes == 0)
-            {
-                handlePeerDisconnection(peer);
-                break;
+                continue;
             }
 
-            else
-            {
-                handler_->onInput(buffer, bytes, peer);
-            }
+            // Whatever came in before EAGAIN or the disconnection still has
+            // to be processed
+            if (totalBytes > 0)
+                handler_->onInput(buffer, totalBytes, peer);
+
+            if (bytes == 0 || !retry)
+                handlePeerDisconnection(peer);
+            break;
         }
     }
 
@@ -424,6 +666,7 @@ namespace Pistache::Tcp
             else
             {
                 peers_.erase(it);
+                Metrics::local().connectionsClosed.add();
             }
         }
 
@@ -448,12 +691,96 @@ namespace Pistache::Tcp
             return;
         }
 
-        Guard guard(toWriteLock);
-        toWrite.erase(fd); // Clean up write buffers
+        std::shared_ptr<PeerWrites> writes;
+        {
+            auto& shard = writeShard(fd);
+            Guard guard(shard.lock);
+
+            auto it = shard.peers.find(fd);
+            if (it != std::end(shard.peers))
+            {
+                writes = std::move(it->second);
+                shard.peers.erase(it);
+            }
+        }
+
+        // Once a write in progress is done. Whoever still holds them finds
+        // them with no queue
+        ZeroCopy zeroCopy;
+        if (writes)
+        {
+            Guard guard(writes->lock);
+            writes->queue.clear(); // Clean up write buffers
+            writes->queued = false;
+            zeroCopy       = std::move(writes->zeroCopy);
+        }
+
+#ifdef PS_ZEROCOPY
+        // What the kernel is done with already goes now
+        if (!zeroCopy.sent.empty())
+            readZeroCopyCompletions(fd, zeroCopy);
+
+        // Closing it would lose the completions of the sends still in
+        // flight, their buffers being freed while the kernel reads from them
+        if (!zeroCopy.sent.empty())
+        {
+            PS_LOG_DEBUG_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD) " lingers, %zu zero-copy sends in flight",
+                              fd, zeroCopy.sent.size());
+
+            ::shutdown(GET_ACTUAL_FD(fd), SHUT_RDWR);
+            {
+                Guard guard(lingeringLock_);
+                lingering_.push_back({ fd, std::move(zeroCopy) });
+            }
+            post([this]() { reapLingering(); });
+            return;
+        }
+#endif
 
         CLOSE_FD(fd);
     }
 
+    void Transport::pauseReading(const std::shared_ptr<Peer>& peer)
+    {
+        Fd fd = peer->fd();
+        if (peer->readPaused_ || fd == PS_FD_EMPTY)
+            return;
+
+        PS_LOG_DEBUG_ARGS("Pausing reads, fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
+
+        peer->readPaused_ = true;
+
+        // Not to miss when a pending write can go on
+        Flags<NotifyOn> interest(NotifyOn::Shutdown);
+        if (hasPendingWrites(fd))
+            interest |= NotifyOn::Write;
+        reactor()->modifyFd(key(), fd, interest, Polling::Mode::Edge);
+    }
+
+    bool Transport::hasPendingWrites(Fd fd)
+    {
+        auto writes = peerWrites(fd, false);
+        if (!writes)
+            return false;
+
+        Guard guard(writes->lock);
+        return writes->queued;
+    }
+
+    void Transport::resumeReading(const std::shared_ptr<Peer>& peer)
+    {
+        // Always through the queue, even from the transport's thread: this
+        // may well be called from within the handler's onInput
+        resumesQueue.push(PeerEntry(peer));
+    }
+
+    void Transport::post(std::function<void()> task)
+    {
+        postsQueue.push(std::move(task));
+    }
+
+    Transport* Transport::current() { return currentTransport; }
+
     void Transport::removeAllPeers()
     {
         PS_TIMEDBG_START_THIS;
@@ -479,32 +806,52 @@ namespace Pistache::Tcp
 
             removePeer(peer); // removePeer locks mutex, erases peer from peers_
         }
+
+#ifdef PISTACHE_USE_SSL
+        for (auto& handshake : handshakes_)
+        {
+            timerWheel_.disarm(handshake.second.timer);
+            handshake.second.peer->closeFd();
+        }
+        handshakes_.clear();
+#endif /* PISTACHE_USE_SSL */
     }
 
     void Transport::asyncWriteImpl(Fd fd)
     {
         PS_TIMEDBG_START_THIS;
 
+        // cleanup will have been handled by handlePeerDisconnection
+        auto writes = peerWrites(fd, false);
+        if (!writes)
+        {
+            PS_LOG_DEBUG_ARGS("Failed to find fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
+            return;
+        }
+
         bool stop = false;
         while (!stop)
         {
-            std::unique_lock<std::mutex> lock(toWriteLock);
-
-            auto it = toWrite.find(fd);
-
-            // cleanup will have been handled by handlePeerDisconnection
-            if (it == std::end(toWrite))
+            std::unique_lock<Lock> lock(writes->lock);
+            if (!writes->queued)
             {
-                PS_LOG_DEBUG_ARGS("Failed to find fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
+                PS_LOG_DEBUG_ARGS("No write queue for fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
                 return;
             }
-            auto& wq = it->second;
+
+            auto& wq = writes->queue;
             if (wq.empty())
             {
                 PS_LOG_DEBUG("wq empty");
                 break;
             }
 
+            if (writeZeroCopy(fd, *writes, lock, stop))
+                continue;
+
+            if (writeGathered(fd, *writes, lock, stop))
+                continue;
+
             auto& entry = wq.front();
             int flags   = entry.flags;
 #ifdef _USE_LIBEVENT_LIKE_APPLE
@@ -518,7 +865,7 @@ namespace Pistache::Tcp
                 if (wq.empty())
                 {
                     PS_LOG_DEBUG_ARGS("Erasing fd %" PIST_QUOTE(PS_FD_PRNTFCD) " from toWrite", fd);
-                    toWrite.erase(fd);
+                    writes->queued = false;
                     reactor()->modifyFd(key(), fd, NotifyOn::Read, Polling::Mode::Edge);
                     stop = true;
                 }
@@ -536,12 +883,37 @@ namespace Pistache::Tcp
                     PS_LOG_DEBUG_ARGS("sendRawBuffer fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", len %d",
                                       fd, len);
 
-                    auto raw        = buffer.raw();
+                    const auto& raw = buffer.raw();
                     const auto* ptr = raw.data().c_str() + totalWritten;
                     bytesWritten    = sendRawBuffer(fd, ptr, len, flags
 #ifdef _USE_LIBEVENT_LIKE_APPLE
                                                  ,
                                                  msg_more_style
+#endif
+                    );
+                }
+                else if (buffer.isGather() && len == 0)
+                {
+                    bytesWritten = 0; // nothing to gather
+                }
+                else if (buffer.isGather())
+                {
+                    // Piece by piece, where there is no writev (or TLS)
+                    const auto& gather = buffer.gather();
+
+                    size_t index = 0, skipped = 0;
+                    while (skipped + gather.piece(index).size() <= totalWritten)
+                        skipped += gather.piece(index++).size();
+
+                    const auto piece = gather.piece(index).substr(totalWritten - skipped);
+
+                    PS_LOG_DEBUG_ARGS("sendRawBuffer fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", len %d",
+                                      fd, piece.size());
+
+                    bytesWritten = sendRawBuffer(fd, piece.data(), piece.size(), flags
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+                                                 ,
+                                                 msg_more_style
 #endif
                     );
                 }
@@ -550,79 +922,423 @@ namespace Pistache::Tcp
                     PS_LOG_DEBUG_ARGS("sendFile fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", len %d",
                                       fd, len);
 
-                    auto file    = buffer.fd();
-                    off_t offset = static_cast<off_t>(totalWritten);
-                    bytesWritten = sendFile(fd, file, offset, len);
-                }
-                if (bytesWritten < 0)
-                {
-                    PST_DBG_DECL_SE_ERR_P_EXTRA;
-                    PS_LOG_DEBUG_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD) " errno %d %s",
-                                      fd, errno, PST_STRERROR_R_ERRNO);
+                    auto file    = buffer.fd();
+                    off_t offset = static_cast<off_t>(totalWritten);
+                    bytesWritten = sendFile(fd, file, offset, len);
+                }
+                if (bytesWritten < 0)
+                {
+                    PST_DBG_DECL_SE_ERR_P_EXTRA;
+                    PS_LOG_DEBUG_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD) " errno %d %s",
+                                      fd, errno, PST_STRERROR_R_ERRNO);
+
+                    if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    {
+                        Metrics::local().writesWouldBlock.add();
+
+                        auto bufferHolder = buffer.detach(static_cast<off_t>(totalWritten));
+
+                        // pop_front kills buffer - so we cannot continue loop or use buffer
+                        // after this point
+                        wq.pop_front();
+                        wq.push_front(WriteEntry(std::move(deferred),
+                                                 bufferHolder, fd, flags
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+                                                 ,
+                                                 msg_more_style
+#endif
+                                                 ));
+                        reactor()->modifyFd(key(), fd, NotifyOn::Read | NotifyOn::Write,
+                                            Polling::Mode::Edge);
+                        stop = true;
+                    }
+                    // EBADF can happen when the HTTP parser, in the case of
+                    // an error, closes fd before the entire request is processed.
+                    // https://github.com/pistacheio/pistache/issues/501
+                    else if (errno == EBADF || errno == EPIPE || errno == ECONNRESET)
+                    {
+                        PS_LOG_DEBUG_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD) " EBADF/EPIPE/ECONNRESET so erasing",
+                                          fd);
+                        wq.clear();
+                        writes->queued = false;
+                        stop           = true;
+                    }
+                    else
+                    {
+                        PS_LOG_DEBUG_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD) " rejecting write attempt", fd);
+                        cleanUp();
+                        deferred.reject(Pistache::Error::system("Could not write data"));
+                    }
+                    break;
+                }
+                else
+                {
+                    Metrics::local().bytesOut.add(static_cast<uint64_t>(bytesWritten));
+                    totalWritten += bytesWritten;
+                    if (totalWritten >= buffer.size())
+                    {
+                        // A file buffer's file is closed along with the
+                        // last holder of it, once popped from the queue
+                        cleanUp();
+
+                        // Cast to match the type of defered template
+                        // to avoid a BadType exception
+                        deferred.resolve(static_cast<PST_SSIZE_T>(totalWritten));
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    bool Transport::writeGathered(Fd fd, PeerWrites& writes,
+                                  std::unique_lock<Lock>& lock, bool& stop)
+    {
+#ifdef PS_GATHER_WRITES
+        auto& wq = writes.queue;
+
+        auto gatherable = [](const WriteEntry& entry) {
+            return entry.buffer.isRaw() || entry.buffer.isGather();
+        };
+
+        if (wq[0].pinned || !gatherable(wq[0])
+            || (wq[0].buffer.isRaw() && (wq.size() < 2 || !gatherable(wq[1]))))
+            return false;
+
+        // Whole entries, and possibly the first pieces of the last one
+        constexpr size_t MaxGathered = 64;
+
+        std::array<struct iovec, MaxGathered> iov;
+        size_t count   = 0;
+        size_t entries = 0;
+        for (const auto& entry : wq)
+        {
+            if (count == MaxGathered || !gatherable(entry) || entry.pinned)
+                break;
+
+            count += gatherInto(entry.buffer, entry.buffer.offset(), iov.data() + count,
+                                MaxGathered - count);
+            ++entries;
+        }
+
+        if (count < 2)
+            return false;
+
+#ifdef PISTACHE_USE_SSL
+        {
+            // See comment in transport.h on why peers_ must be mutex-protected
+            std::lock_guard<std::mutex> l_guard(peers_mutex_);
+            auto it = peers_.find(fd);
+            if (it == std::end(peers_) || it->second->ssl() != nullptr)
+                return false;
+        }
+#endif /* PISTACHE_USE_SSL */
+
+        struct msghdr msg = {};
+        msg.msg_iov       = iov.data();
+        msg.msg_iovlen    = count;
+
+        // MSG_MORE if the last of them expects more to follow
+        const int flags = wq[entries - 1].flags;
+
+        PS_LOG_DEBUG_ARGS("sendmsg fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", %d buffers",
+                          fd, static_cast<int>(count));
+        const PST_SSIZE_T bytesWritten = ::sendmsg(GET_ACTUAL_FD(fd), &msg, flags | MSG_NOSIGNAL);
+        if (bytesWritten < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                return false; // for the one buffer at a time path to handle
+
+            Metrics::local().writesWouldBlock.add();
+            reactor()->modifyFd(key(), fd, NotifyOn::Read | NotifyOn::Write,
+                                Polling::Mode::Edge);
+            stop = true;
+            lock.unlock();
+            return true;
+        }
+
+        Metrics::local().bytesOut.add(static_cast<uint64_t>(bytesWritten));
+
+        // Resolved once the lock is released
+        std::vector<std::pair<Async::Deferred<PST_SSIZE_T>, PST_SSIZE_T>> written;
+        written.reserve(entries);
+
+        auto remaining = static_cast<size_t>(bytesWritten);
+        for (size_t i = 0; i < entries; ++i)
+        {
+            auto& entry       = wq.front();
+            const size_t left = entry.buffer.size() - entry.buffer.offset();
+            if (remaining < left)
+            {
+                // The rest of it goes first next time
+                auto rest = entry.buffer.detach(static_cast<off_t>(entry.buffer.offset() + remaining));
+                WriteEntry partial(std::move(entry.deferred), std::move(rest), fd, entry.flags);
+                wq.pop_front();
+                wq.push_front(std::move(partial));
+                break;
+            }
+
+            remaining -= left;
+            written.emplace_back(std::move(entry.deferred), static_cast<PST_SSIZE_T>(entry.buffer.size()));
+            wq.pop_front();
+        }
+
+        if (wq.empty())
+        {
+            PS_LOG_DEBUG_ARGS("Erasing fd %" PIST_QUOTE(PS_FD_PRNTFCD) " from toWrite", fd);
+            writes.queued = false;
+            reactor()->modifyFd(key(), fd, NotifyOn::Read, Polling::Mode::Edge);
+            stop = true;
+        }
+        lock.unlock();
+
+        for (auto& [deferred, size] : written)
+            deferred.resolve(size);
+
+        return true;
+#else
+        (void)fd;
+        (void)writes;
+        (void)lock;
+        (void)stop;
+        return false;
+#endif /* PS_GATHER_WRITES */
+    }
+
+    bool Transport::writeZeroCopy(Fd fd, PeerWrites& writes,
+                                  std::unique_lock<Lock>& lock, bool& stop)
+    {
+#ifdef PS_ZEROCOPY
+        auto& wq       = writes.queue;
+        auto& zeroCopy = writes.zeroCopy;
+        auto& entry    = wq.front();
+        if (!entry.pinned)
+        {
+            const auto& buffer = entry.buffer;
+            if (zeroCopyThreshold_ == 0 || !(buffer.isRaw() || buffer.isGather())
+                || buffer.size() - buffer.offset() < zeroCopyThreshold_)
+                return false;
+
+#ifdef PISTACHE_USE_SSL
+            {
+                // See comment in transport.h on why peers_ must be mutex-protected
+                std::lock_guard<std::mutex> l_guard(peers_mutex_);
+                auto it = peers_.find(fd);
+                if (it == std::end(peers_) || it->second->ssl() != nullptr)
+                    return false;
+            }
+#endif /* PISTACHE_USE_SSL */
+
+            if (zeroCopy.unsupported)
+                return false;
+
+            if (!zeroCopy.enabled)
+            {
+                const int one = 1;
+                if (::setsockopt(GET_ACTUAL_FD(fd), SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) < 0)
+                {
+                    PS_LOG_DEBUG_ARGS("No SO_ZEROCOPY for fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", errno %d",
+                                      fd, errno);
+                    zeroCopy.unsupported = true;
+                    return false;
+                }
+                zeroCopy.enabled = true;
+            }
+
+            // From now on the buffer is not to move, nor to be freed
+            // before the kernel is done with it
+            entry.pinned     = std::make_shared<const BufferHolder>(std::move(entry.buffer));
+            entry.pinnedSent = 0;
+        }
+
+        const auto& pinned  = *entry.pinned;
+        const size_t size   = pinned.size();
+        const size_t toSend = size - pinned.offset();
+
+        while (entry.pinnedSent < toSend)
+        {
+            constexpr size_t MaxGathered = 64;
+
+            std::array<struct iovec, MaxGathered> iov;
+            struct msghdr msg = {};
+            msg.msg_iov       = iov.data();
+            msg.msg_iovlen    = gatherInto(pinned, pinned.offset() + entry.pinnedSent,
+                                           iov.data(), iov.size());
+
+            const int flags = entry.flags | MSG_NOSIGNAL;
+
+            PS_LOG_DEBUG_ARGS("sendmsg MSG_ZEROCOPY fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", send %u",
+                              fd, zeroCopy.nextSend);
+            PST_SSIZE_T bytesWritten = ::sendmsg(GET_ACTUAL_FD(fd), &msg, flags | MSG_ZEROCOPY);
+            if (bytesWritten >= 0)
+            {
+                zeroCopy.sent.emplace_back(zeroCopy.nextSend++, entry.pinned);
+            }
+            else if (errno == ENOBUFS)
+            {
+                // Over what the kernel lets be pinned for the socket: copied
+                // this time
+                bytesWritten = ::sendmsg(GET_ACTUAL_FD(fd), &msg, flags);
+            }
+
+            if (bytesWritten < 0)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    Metrics::local().writesWouldBlock.add();
+                    reactor()->modifyFd(key(), fd, NotifyOn::Read | NotifyOn::Write,
+                                        Polling::Mode::Edge);
+                    stop = true;
+                    lock.unlock();
+                    return true;
+                }
+
+                PST_DBG_DECL_SE_ERR_P_EXTRA;
+                PS_LOG_DEBUG_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD) " errno %d %s",
+                                  fd, errno, PST_STRERROR_R_ERRNO);
+
+                // As when sending without MSG_ZEROCOPY
+                if (errno == EBADF || errno == EPIPE || errno == ECONNRESET)
+                {
+                    wq.clear();
+                    writes.queued = false;
+                    stop          = true;
+                    lock.unlock();
+                    return true;
+                }
+
+                auto deferred = std::move(entry.deferred);
+                wq.pop_front();
+                if (wq.empty())
+                {
+                    writes.queued = false;
+                    reactor()->modifyFd(key(), fd, NotifyOn::Read, Polling::Mode::Edge);
+                    stop = true;
+                }
+                lock.unlock();
+
+                deferred.reject(Pistache::Error::system("Could not write data"));
+                return true;
+            }
+
+            Metrics::local().bytesOut.add(static_cast<uint64_t>(bytesWritten));
+            entry.pinnedSent += static_cast<size_t>(bytesWritten);
+        }
+
+        // The buffer itself stays in zeroCopy.sent until the kernel reports
+        // these sends complete
+        auto deferred = std::move(entry.deferred);
+        wq.pop_front();
+        if (wq.empty())
+        {
+            PS_LOG_DEBUG_ARGS("Erasing fd %" PIST_QUOTE(PS_FD_PRNTFCD) " from toWrite", fd);
+            writes.queued = false;
+            reactor()->modifyFd(key(), fd, NotifyOn::Read, Polling::Mode::Edge);
+            stop = true;
+        }
+        lock.unlock();
+
+        deferred.resolve(static_cast<PST_SSIZE_T>(size));
+        return true;
+#else
+        (void)fd;
+        (void)writes;
+        (void)lock;
+        (void)stop;
+        return false;
+#endif /* PS_ZEROCOPY */
+    }
+
+    void Transport::handleZeroCopyCompletions(Fd fd)
+    {
+        auto writes = peerWrites(fd, false);
+        if (!writes)
+            return;
+
+        Guard guard(writes->lock);
+        readZeroCopyCompletions(fd, writes->zeroCopy);
+    }
+
+    void Transport::readZeroCopyCompletions(Fd fd, ZeroCopy& zeroCopy)
+    {
+#ifdef PS_ZEROCOPY
+        auto& sent = zeroCopy.sent;
+
+        // All of them, as polling is edge triggered
+        for (;;)
+        {
+            alignas(struct cmsghdr) char control[128];
+            struct msghdr msg  = {};
+            msg.msg_control    = control;
+            msg.msg_controllen = sizeof(control);
+
+            if (::recvmsg(GET_ACTUAL_FD(fd), &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+                break;
 
-                    if (errno == EAGAIN || errno == EWOULDBLOCK)
-                    {
-                        auto bufferHolder = buffer.detach(static_cast<off_t>(totalWritten));
+            for (auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+            {
+                const bool recvErr = (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+                    || (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR);
+                if (!recvErr)
+                    continue;
 
-                        // pop_front kills buffer - so we cannot continue loop or use buffer
-                        // after this point
-                        wq.pop_front();
-                        wq.push_front(WriteEntry(std::move(deferred),
-                                                 bufferHolder, fd, flags
-#ifdef _USE_LIBEVENT_LIKE_APPLE
-                                                 ,
-                                                 msg_more_style
-#endif
-                                                 ));
-                        reactor()->modifyFd(key(), fd, NotifyOn::Read | NotifyOn::Write,
-                                            Polling::Mode::Edge);
-                        stop = true;
-                    }
-                    // EBADF can happen when the HTTP parser, in the case of
-                    // an error, closes fd before the entire request is processed.
-                    // https://github.com/pistacheio/pistache/issues/501
-                    else if (errno == EBADF || errno == EPIPE || errno == ECONNRESET)
-                    {
-                        PS_LOG_DEBUG_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD) " EBADF/EPIPE/ECONNRESET so erasing",
-                                          fd);
-                        wq.pop_front();
-                        toWrite.erase(fd);
-                        stop = true;
-                    }
-                    else
-                    {
-                        PS_LOG_DEBUG_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD) " rejecting write attempt", fd);
-                        cleanUp();
-                        deferred.reject(Pistache::Error::system("Could not write data"));
-                    }
-                    break;
-                }
-                else
-                {
-                    totalWritten += bytesWritten;
-                    if (totalWritten >= buffer.size())
-                    {
-                        if (buffer.isFile())
-                        {
-                            PS_LOG_DEBUG_ARGS("file ::close actual_fd %d",
-                                              buffer.fd());
+                struct sock_extended_err err;
+                std::memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+                if (err.ee_errno != 0 || err.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                    continue;
 
-                            // done with the file buffer, nothing else knows
-                            // whether to close it with the way the code is
-                            // written.
-                            PST_FILE_CLOSE(buffer.fd());
-                        }
+                // Sends ee_info to ee_data, both included, are complete.
+                // The kernel copied them after all when sending to a local
+                // peer, or with a device not up to it
+                const uint32_t first = err.ee_info;
+                const uint32_t last  = err.ee_data;
+                PS_LOG_DEBUG_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD) " zero-copy sends %u to %u done%s",
+                                  fd, first, last,
+                                  (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) ? ", copied" : "");
+
+                sent.erase(std::remove_if(sent.begin(), sent.end(),
+                                          [&](const auto& send) {
+                                              return send.first - first <= last - first;
+                                          }),
+                           sent.end());
+            }
+        }
+#else
+        (void)fd;
+        (void)zeroCopy;
+#endif /* PS_ZEROCOPY */
+    }
 
-                        cleanUp();
+    void Transport::reapLingering()
+    {
+        // Completions of sends over loopback come at once, those of sends
+        // over a network as the peer acknowledges them
+        constexpr auto PollInterval = std::chrono::milliseconds(10);
 
-                        // Cast to match the type of defered template
-                        // to avoid a BadType exception
-                        deferred.resolve(static_cast<PST_SSIZE_T>(totalWritten));
-                        break;
-                    }
-                }
+        Guard guard(lingeringLock_);
+
+        for (auto it = lingering_.begin(); it != lingering_.end();)
+        {
+            readZeroCopyCompletions(it->fd, it->zeroCopy);
+            if (!it->zeroCopy.sent.empty())
+            {
+                ++it;
+                continue;
             }
+
+            PS_LOG_DEBUG_ARGS("Closing lingering fd %" PIST_QUOTE(PS_FD_PRNTFCD), it->fd);
+            CLOSE_FD(it->fd);
+            it = lingering_.erase(it);
         }
+
+        if (lingering_.empty() || lingeringTimer_ != TimerWheel::InvalidId)
+            return;
+
+        lingeringTimer_ = timerWheel_.arm(PollInterval, [this]() {
+            lingeringTimer_ = TimerWheel::InvalidId;
+            reapLingering();
+        });
+        rearmTimerWheel();
     }
 
 #ifdef _USE_LIBEVENT_LIKE_APPLE
@@ -947,14 +1663,16 @@ namespace Pistache::Tcp
         return bytesWritten;
     }
 
-    void Transport::armTimerMs(Fd fd, std::chrono::milliseconds value,
-                               Async::Deferred<uint64_t> deferred)
+    Transport::TimerId Transport::armTimerMs(Fd fd, std::chrono::milliseconds value,
+                                             Async::Deferred<uint64_t> deferred)
     {
         PS_TIMEDBG_START_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
 
         auto ctx                   = context();
         const bool isInRightThread = std::this_thread::get_id() == ctx.thread();
-        TimerEntry entry(fd, value, std::move(deferred));
+
+        const TimerId id = nextTimerId_.fetch_add(1, std::memory_order_relaxed);
+        TimerEntry entry(id, fd, value, std::move(deferred));
 
         if (!isInRightThread)
         {
@@ -968,74 +1686,94 @@ namespace Pistache::Tcp
                               fd);
             armTimerMsImpl(std::move(entry));
         }
+
+        return id;
     }
 
     void Transport::armTimerMsImpl(TimerEntry entry)
     {
-#ifdef DEBUG
-        Fd entry_fd = entry.fd;
+        if (entry.disarm)
+        {
+            disarmTimerImpl(entry.id, entry.fd);
+            return;
+        }
 
-#ifdef _USE_LIBEVENT
-        PS_LOG_DEBUG_ARGS("entry.fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", "
-                                                                 "fd->type %d",
-                          entry_fd,
-                          EventMethFns::getEmEventType(entry_fd));
-#else
-        PS_LOG_DEBUG_ARGS("entry.fd %" PIST_QUOTE(PS_FD_PRNTFCD),
-                          entry_fd);
-#endif
+        if (entry.fd != PS_FD_EMPTY)
+        {
+            if (fdTimers_.find(entry.fd) != std::end(fdTimers_))
+            {
+                PS_LOG_DEBUG_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", "
+                                                                   "timer already armed",
+                                  entry.fd);
 
-#endif
+                entry.deferred.reject(std::runtime_error("Timer is already armed"));
+                return;
+            }
+
+            fdTimers_.emplace(entry.fd, entry.id);
+        }
+
+        const TimerId id = entry.id;
+        entry.wheelId    = timerWheel_.arm(entry.value, [this, id]() { handleTimer(id); });
+        timers.emplace(id, std::move(entry));
+
+        rearmTimerWheel();
+    }
 
-        auto it = timers.find(entry.fd);
-        if (it != std::end(timers))
+    bool Transport::disarmTimerImpl(TimerId id, Fd fd)
+    {
+        if (id == TimerWheel::InvalidId)
         {
-            PS_LOG_DEBUG_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD),
-                              "timer already armed",
-                              entry.fd);
+            auto it = fdTimers_.find(fd);
+            if (it == std::end(fdTimers_))
+                return false;
 
-            entry.deferred.reject(std::runtime_error("Timer is already armed"));
-            return;
+            id = it->second;
         }
 
-        int res = -1;
+        auto it = timers.find(id);
+        if (it == std::end(timers))
+            return false;
+
+        // The timerfd is left alone, at worst it wakes us up for nothing
+        timerWheel_.disarm(it->second.wheelId);
+        if (it->second.fd != PS_FD_EMPTY)
+            fdTimers_.erase(it->second.fd);
+        timers.erase(it);
+        return true;
+    }
+
+    void Transport::rearmTimerWheel()
+    {
+        const auto next = timerWheel_.nextExpiry();
+        if (next == timerWheelArmedFor_ || timerWheelFd_ == PS_FD_EMPTY)
+            return;
+
+        // A zero value would disarm the timerfd, so an expiry that has
+        // already passed is rounded up to the shortest possible timeout
+        auto delay = std::chrono::nanoseconds(0);
+        if (next)
+            delay = std::max(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 *next - TimerWheel::Clock::now()),
+                             std::chrono::nanoseconds(1));
+
 #ifdef _USE_LIBEVENT
-        assert(entry.fd != PS_FD_EMPTY);
-        res = EventMethFns::setEmEventTime(entry.fd, &(entry.value));
+        auto value    = std::chrono::ceil<std::chrono::milliseconds>(delay);
+        const int res = EventMethFns::setEmEventTime(timerWheelFd_,
+                                                     next ? &value : nullptr);
 #else
         itimerspec spec;
         spec.it_interval.tv_sec  = 0;
         spec.it_interval.tv_nsec = 0;
+        spec.it_value.tv_sec     = std::chrono::duration_cast<std::chrono::seconds>(delay).count();
+        spec.it_value.tv_nsec    = (delay % std::chrono::seconds(1)).count();
 
-        if (entry.value.count() < 1000)
-        {
-            spec.it_value.tv_sec  = 0;
-            spec.it_value.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(entry.value)
-                                        .count();
-        }
-        else
-        {
-            spec.it_value.tv_sec  = std::chrono::duration_cast<std::chrono::seconds>(entry.value).count();
-            spec.it_value.tv_nsec = 0;
-        }
-
-        res = timerfd_settime(entry.fd, 0, &spec, nullptr);
+        const int res = timerfd_settime(timerWheelFd_, 0, &spec, nullptr);
 #endif
         if (res == -1)
-        {
-            PST_DBG_DECL_SE_ERR_P_EXTRA;
-            PS_LOG_DEBUG_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", ernno %d %s",
-                              entry.fd, errno, PST_STRERROR_R_ERRNO);
-
-            entry.deferred.reject(Pistache::Error::system("Could not set timer time"));
-            return;
-        }
+            throw Pistache::Error::system("Could not set timer wheel time");
 
-        reactor()->registerFdOneShot(key(), entry.fd, NotifyOn::Read,
-                                     Polling::Mode::Edge);
-
-        PS_LOG_DEBUG_ARGS("Timer %" PIST_QUOTE(PS_FD_PRNTFCD) " inserting into timers", entry.fd);
-        timers.insert(std::make_pair(entry.fd, std::move(entry)));
+        timerWheelArmedFor_ = next;
     }
 
     void Transport::handleWriteQueue(bool flush)
@@ -1054,8 +1792,11 @@ namespace Pistache::Tcp
                 continue;
 
             {
-                Guard guard(toWriteLock);
-                toWrite[fd].push_back(std::move(*write));
+                auto writes = peerWrites(fd, true);
+                Guard guard(writes->lock);
+                writes->queue.push_back(std::move(*write));
+                writes->queued = true;
+                Metrics::local().writeQueueDepth.record(writes->queue.size());
             }
 
             if (flush)
@@ -1095,6 +1836,69 @@ namespace Pistache::Tcp
         }
     }
 
+    void Transport::handleAccept()
+    {
+        PS_TIMEDBG_START_THIS;
+
+        // A bounded batch, so that a burst of connections does not hold up
+        // the peers already connected: the socket is level triggered, and
+        // reported again for the rest
+        static constexpr int MaxAcceptsPerReady = 64;
+
+        for (int i = 0; i < MaxAcceptsPerReady; ++i)
+        {
+            auto peer = acceptor_(acceptFd_);
+            if (!peer)
+                break;
+
+            handleNewPeer(peer);
+        }
+    }
+
+    void Transport::handlePostQueue()
+    {
+        PS_TIMEDBG_START_THIS;
+
+        for (;;)
+        {
+            auto task = postsQueue.popSafe();
+            if (!task)
+                break;
+
+            (*task)();
+        }
+    }
+
+    void Transport::handleResumeQueue()
+    {
+        PS_TIMEDBG_START_THIS;
+
+        for (;;)
+        {
+            auto data = resumesQueue.popSafe();
+            if (!data)
+                break;
+
+            auto& peer = data->peer;
+            Fd fd      = peer->fd();
+            if (!peer->readPaused_ || fd == PS_FD_EMPTY || !isPeerFd(fd))
+                continue;
+
+            peer->readPaused_ = false;
+
+            Flags<NotifyOn> interest(NotifyOn::Read | NotifyOn::Shutdown);
+            if (hasPendingWrites(fd))
+                interest |= NotifyOn::Write;
+            reactor()->modifyFd(key(), fd, interest, Polling::Mode::Edge);
+
+            handler_->onReadResumed(peer);
+
+            // Edge triggered: whatever arrived meanwhile would not be
+            // signalled again
+            handleIncoming(peer);
+        }
+    }
+
     void Transport::handlePeer(const std::shared_ptr<Peer>& peer)
     {
         PS_TIMEDBG_START_THIS;
@@ -1106,6 +1910,27 @@ namespace Pistache::Tcp
             return;
         }
 
+#ifdef PISTACHE_USE_SSL
+        if (peer->sslHandshakePending_)
+        {
+            startSslHandshake(peer);
+            return;
+        }
+#endif /* PISTACHE_USE_SSL */
+
+        activatePeer(peer);
+        reactor()->registerFd(key(), fd, NotifyOn::Read | NotifyOn::Shutdown,
+                              Polling::Mode::Edge);
+    }
+
+    // Makes the peer visible to the rest of the transport and announces it
+    // to the handler. The caller is in charge of the peer's poller interest
+    void Transport::activatePeer(const std::shared_ptr<Peer>& peer)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        Fd fd = peer->fd();
+
         {
             // See comment in transport.h on why peers_ must be mutex-protected
             std::lock_guard<std::mutex> l_guard(peers_mutex_);
@@ -1113,14 +1938,143 @@ namespace Pistache::Tcp
             auto auto_insert_res_pr = peers_.insert(std::make_pair(fd, peer));
             if (!auto_insert_res_pr.second)
                 PS_LOG_WARNING_ARGS("Failed to insert peer %p", peer.get());
+            else
+                Metrics::local().connectionsAccepted.add();
         }
 
         peer->associateTransport(this);
 
         handler_->onConnection(peer);
+    }
+
+#ifdef PISTACHE_USE_SSL
+    bool Transport::isSslHandshakeFd(Polling::Tag tag) const
+    {
+        if (handshakes_.empty())
+            return false;
+
+        Fd fd = PS_CAST_AWAY_CONST_FD(static_cast<FdConst>(tag.value()));
+        return handshakes_.find(fd) != std::end(handshakes_);
+    }
+
+    void Transport::startSslHandshake(const std::shared_ptr<Peer>& peer)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        Fd fd = peer->fd();
+
+        SslHandshake handshake { peer };
+
+        const auto deadline = peer->sslHandshakeDeadline_;
+        if (deadline != std::chrono::steady_clock::time_point::max())
+        {
+            handshake.timer = timerWheel_.armAt(deadline, [this, fd]() {
+                auto it = handshakes_.find(fd);
+                if (it == std::end(handshakes_))
+                    return;
+
+                auto expired = it->second.peer;
+                PS_LOG_DEBUG_ARGS("SSL handshake timed out, fd %" PIST_QUOTE(PS_FD_PRNTFCD),
+                                  fd);
+                abortSslHandshake(expired);
+            });
+            rearmTimerWheel();
+        }
+
+        handshakes_.emplace(fd, std::move(handshake));
+        peer->associateTransport(this);
+
         reactor()->registerFd(key(), fd, NotifyOn::Read | NotifyOn::Shutdown,
                               Polling::Mode::Edge);
+
+        // The ClientHello is quite possibly here already
+        continueSslHandshake(peer);
+    }
+
+    void Transport::continueSslHandshake(const std::shared_ptr<Peer>& peer)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        auto* ssl = static_cast<SSL*>(peer->ssl());
+        Fd fd     = peer->fd();
+
+        ERR_clear_error();
+        const int res = SSL_accept(ssl);
+        if (res == 1)
+        {
+            PS_LOG_DEBUG_ARGS("SSL handshake done, fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
+
+            eraseSslHandshake(fd);
+            peer->sslHandshakePending_ = false;
+
+            activatePeer(peer);
+            reactor()->modifyFd(key(), fd, NotifyOn::Read | NotifyOn::Shutdown,
+                                Polling::Mode::Edge);
+
+            // The client may have sent its request right behind its last
+            // handshake message, in which case it is already sitting in
+            // the SSL buffer and no further edge will be signalled for it
+            handleIncoming(peer);
+            return;
+        }
+
+        const int err = SSL_get_error(ssl, res);
+        switch (err)
+        {
+        case SSL_ERROR_WANT_READ:
+            reactor()->modifyFd(key(), fd, NotifyOn::Read | NotifyOn::Shutdown,
+                                Polling::Mode::Edge);
+            break;
+
+        case SSL_ERROR_WANT_WRITE:
+            reactor()->modifyFd(key(), fd,
+                                NotifyOn::Read | NotifyOn::Write | NotifyOn::Shutdown,
+                                Polling::Mode::Edge);
+            break;
+
+        default:
+        {
+            char err_str[256] = { 0 };
+            ERR_error_string_n(ERR_peek_last_error(), err_str, sizeof(err_str));
+            PS_LOG_INFO_ARGS("SSL handshake failed, fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", "
+                                                                                    "ssl error %d, %s",
+                             fd, err, err_str);
+            ERR_clear_error();
+
+            abortSslHandshake(peer);
+            break;
+        }
+        }
+    }
+
+    void Transport::abortSslHandshake(const std::shared_ptr<Peer>& peer)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        Fd fd = peer->fd();
+        if (fd == PS_FD_EMPTY)
+            return;
+
+        eraseSslHandshake(fd);
+
+        Aio::Reactor* r = reactor();
+        if (r)
+            r->removeFd(key(), fd);
+
+        // The handler never saw this peer, so no onDisconnection
+        peer->closeFd();
+    }
+
+    void Transport::eraseSslHandshake(Fd fd)
+    {
+        auto it = handshakes_.find(fd);
+        if (it == std::end(handshakes_))
+            return;
+
+        timerWheel_.disarm(it->second.timer);
+        handshakes_.erase(it);
     }
+#endif /* PISTACHE_USE_SSL */
 
     void Transport::handleNotify()
     {
@@ -1147,36 +2101,32 @@ namespace Pistache::Tcp
         loadRequest_.clear();
     }
 
-    void Transport::handleTimer(TimerEntry entry)
+    void Transport::handleTimer(TimerId id)
     {
         PS_TIMEDBG_START_THIS;
 
-        if (entry.isActive())
-        {
-            uint64_t numWakeups;
+        auto it = timers.find(id);
+        if (it == std::end(timers))
+            return;
 
-            auto res = READ_FD(entry.fd, &numWakeups, sizeof numWakeups);
-            if (res == -1)
-            {
-                if (errno == EAGAIN || errno == EWOULDBLOCK)
-                    return;
-                else
-                    entry.deferred.reject(
-                        Pistache::Error::system("Could not read timerfd"));
-            }
-            else
-            {
-                if (res != sizeof(numWakeups))
-                {
-                    entry.deferred.reject(
-                        Pistache::Error("Read invalid number of bytes for timer fd: " + std::to_string(GET_ACTUAL_FD(entry.fd))));
-                }
-                else
-                {
-                    entry.deferred.resolve(numWakeups);
-                }
-            }
-        }
+        auto deferred = std::move(it->second.deferred);
+        if (it->second.fd != PS_FD_EMPTY)
+            fdTimers_.erase(it->second.fd);
+        timers.erase(it);
+
+        deferred.resolve(static_cast<uint64_t>(1));
+    }
+
+    void Transport::handleTimerWheel()
+    {
+        PS_TIMEDBG_START_THIS;
+
+        uint64_t wakeups;
+        [[maybe_unused]] auto rv = READ_FD(timerWheelFd_, &wakeups, sizeof wakeups);
+
+        timerWheelArmedFor_.reset();
+        timerWheel_.advance();
+        rearmTimerWheel();
     }
 
     bool Transport::isPeerFd(FdConst fdconst) const
@@ -1198,29 +2148,12 @@ namespace Pistache::Tcp
         return peers_.find(fd) != std::end(peers_);
     }
 
-    bool Transport::isTimerFd(FdConst fdconst) const
-    {
-        PS_TIMEDBG_START_THIS;
-
-        // Can cast away const since we're not actually going to change fd
-        Fd fd    = PS_CAST_AWAY_CONST_FD(fdconst);
-        bool res = (timers.find(fd) != std::end(timers));
-
-        PS_LOG_DEBUG_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD) " %s in timers",
-                          fdconst, (res ? "is" : "is not"));
-        return res;
-    }
-
     bool Transport::isPeerFd(Polling::Tag tag) const
     {
         PS_TIMEDBG_START_THIS;
 
         return isPeerFd(static_cast<FdConst>(tag.value()));
     }
-    bool Transport::isTimerFd(Polling::Tag tag) const
-    {
-        return isTimerFd(static_cast<FdConst>(tag.value()));
-    }
 
     std::shared_ptr<Peer> Transport::getPeer(FdConst fdconst)
     {
@@ -247,6 +247,8 @@ namespace Pistache::Http
         transport->setHeaderTimeout(headerTimeout_);
         transport->setBodyTimeout(bodyTimeout_);
         transport->setKeepaliveTimeout(keepaliveTimeout_);
+        transport->setReadBufferSize(readBufferSize());
+        transport->setZeroCopyThreshold(zeroCopyThreshold());
         return transport;
     }
 
@@ -262,6 +264,12 @@ namespace Pistache::Http
         , logger_(PISTACHE_NULL_STRING_LOGGER)
         // This should be moved after "keepaliveTimeout_" in the next ABI change
         , sslHandshakeTimeout_(Const::DefaultSSLHandshakeTimeout)
+        // This should be moved after "maxResponseSize_" in the next ABI change
+        , readBufferSize_(Const::DefaultReadBufferSize)
+        , zeroCopyThreshold_(0)
+        , pollBackend_(Polling::Backend::Epoll)
+        , perWorkerListeners_(false)
+        , reusePortProgram_(-1)
     { }
 
     Endpoint::Options& Endpoint::Options::threads(int val)
@@ -305,6 +313,36 @@ namespace Pistache::Http
         return *this;
     }
 
+    Endpoint::Options& Endpoint::Options::readBufferSize(size_t val)
+    {
+        readBufferSize_ = val;
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::zeroCopyThreshold(size_t val)
+    {
+        zeroCopyThreshold_ = val;
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::pollBackend(Polling::Backend backend)
+    {
+        pollBackend_ = backend;
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::perWorkerListeners(bool enable)
+    {
+        perWorkerListeners_ = enable;
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::reusePortProgram(int bpfProgramFd)
+    {
+        reusePortProgram_ = bpfProgramFd;
+        return *this;
+    }
+
     Endpoint::Options& Endpoint::Options::logger(PISTACHE_STRING_LOGGER_T logger)
     {
         logger_ = logger;
@@ -320,6 +358,9 @@ namespace Pistache::Http
     void Endpoint::init(const Endpoint::Options& options)
     {
         listener.init(options.threads_, options.flags_, options.threadsName_, options.backlog_);
+        listener.setPollBackend(options.pollBackend_);
+        listener.setPerWorkerListeners(options.perWorkerListeners_);
+        listener.setReusePortProgram(options.reusePortProgram_);
         listener.setTransportFactory([this, options] {
             if (!handler_)
                 throw std::runtime_error("Must call setHandler()");
@@ -328,6 +369,8 @@ namespace Pistache::Http
             transport->setHeaderTimeout(options.headerTimeout_);
             transport->setBodyTimeout(options.bodyTimeout_);
             transport->setKeepaliveTimeout(options.keepaliveTimeout_);
+            transport->setReadBufferSize(options.readBufferSize_);
+            transport->setZeroCopyThreshold(options.zeroCopyThreshold_);
 
             return transport;
         });
@@ -61,6 +61,11 @@
 
 using namespace std::chrono_literals;
 
+// Per-worker listening sockets. Fds are the sockets themselves here
+#if !defined(_USE_LIBEVENT) && defined(SO_REUSEPORT)
+#define PS_REUSEPORT_WORKERS
+#endif
+
 namespace Pistache::Tcp
 {
 
@@ -297,6 +302,13 @@ namespace Pistache::Tcp
         if (acceptThread.joinable())
             acceptThread.join();
 
+        // The workers must be done accepting before their sockets close
+        if (workersAccept_)
+            reactor_.reset();
+        for (Fd fd : workerListenFds_)
+            CLOSE_FD(fd);
+        workerListenFds_.clear();
+
         if (listen_fd != PS_FD_EMPTY)
         {
             CLOSE_FD(listen_fd);
@@ -331,6 +343,21 @@ namespace Pistache::Tcp
         handler_ = handler;
     }
 
+    void Listener::setPollBackend(Polling::Backend backend)
+    {
+        pollBackend_ = backend;
+    }
+
+    void Listener::setPerWorkerListeners(bool enable)
+    {
+        perWorkerListeners_ = enable;
+    }
+
+    void Listener::setReusePortProgram(int bpfProgramFd)
+    {
+        reusePortProgram_ = bpfProgramFd;
+    }
+
     void Listener::pinWorker([[maybe_unused]] size_t worker, [[maybe_unused]] const CpuSet& set)
     {
 #if 0
@@ -360,6 +387,8 @@ namespace Pistache::Tcp
     {
         PS_TIMEDBG_START_THIS;
 
+        const bool perWorker = acceptsPerWorker(addr->ai_family);
+
         auto socktype = addr->ai_socktype;
 // SOCK_CLOEXEC not defined in macOS Nov 2023
 // In the _USE_LIBEVENT_LIKE_APPLE case, we set FD_CLOEXEC using fcntl
@@ -382,7 +411,8 @@ namespace Pistache::Tcp
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
 
-        setSocketOptions(actual_fd, options_);
+        setSocketOptions(actual_fd,
+                         perWorker ? options_ | Options::ReusePort : options_);
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
 
@@ -428,10 +458,14 @@ namespace Pistache::Tcp
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
 
-        PS_LOG_DEBUG_ARGS("Add read fd %" PIST_QUOTE(PS_FD_PRNTFCD), event_fd);
-        poller.addFd(event_fd,
-                     Flags<Polling::NotifyOn>(Polling::NotifyOn::Read),
-                     Polling::Tag(event_fd));
+        // In per-worker mode, the first worker accepts on it instead
+        if (!perWorker)
+        {
+            PS_LOG_DEBUG_ARGS("Add read fd %" PIST_QUOTE(PS_FD_PRNTFCD), event_fd);
+            poller.addFd(event_fd,
+                         Flags<Polling::NotifyOn>(Polling::NotifyOn::Read),
+                         Polling::Tag(event_fd));
+        }
         listen_fd = event_fd;
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
@@ -439,15 +473,95 @@ namespace Pistache::Tcp
         auto transport = transportFactory_();
 
         reactor_ = std::make_shared<Aio::Reactor>();
-        reactor_->init(Aio::AsyncContext(workers_, workersName_));
+        reactor_->init(Aio::AsyncContext(workers_, workersName_, pollBackend_));
 
         transportKey = reactor_->addHandler(transport);
 
+        if (perWorker)
+            acceptInWorkers(addr, socktype, actual_fd);
+
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
 
         return true;
     }
 
+    bool Listener::acceptsPerWorker([[maybe_unused]] int family) const
+    {
+        if (!perWorkerListeners_)
+            return false;
+
+#ifdef PS_REUSEPORT_WORKERS
+        if (family != AF_UNIX)
+            return true;
+        PS_LOG_INFO("No SO_REUSEPORT for unix domain sockets, "
+                    "accepting from the listener's thread");
+#else
+        PS_LOG_INFO("No per-worker listeners in this build, "
+                    "accepting from the listener's thread");
+#endif
+        return false;
+    }
+
+    void Listener::acceptInWorkers([[maybe_unused]] const struct addrinfo* addr,
+                                   [[maybe_unused]] int socktype,
+                                   [[maybe_unused]] em_socket_t first)
+    {
+        PS_TIMEDBG_START_THIS;
+
+#ifdef PS_REUSEPORT_WORKERS
+        // The other sockets join the SO_REUSEPORT group of the first one,
+        // on the very port it is bound to: one the kernel picked, possibly
+        struct sockaddr_storage bound = {};
+        socklen_t bound_len           = sizeof(bound);
+        auto* bound_alias             = reinterpret_cast<struct sockaddr*>(&bound);
+        TRY(::getsockname(first, bound_alias, &bound_len));
+
+        auto handlers = reactor_->handlers(transportKey);
+        for (size_t i = 0; i < handlers.size(); ++i)
+        {
+            em_socket_t fd = first;
+            if (i > 0)
+            {
+                fd = TRY_RET(::socket(addr->ai_family, socktype, addr->ai_protocol));
+                workerListenFds_.push_back(fd);
+
+                setSocketOptions(fd, options_ | Options::ReusePort);
+                TRY(::bind(fd, bound_alias, bound_len));
+                TRY(::listen(fd, backlog_));
+                make_non_blocking(fd);
+            }
+
+            auto transport = std::static_pointer_cast<Transport>(handlers[i]);
+            transport->acceptOn(fd, [this](Fd listenFd) -> std::shared_ptr<Peer> {
+                try
+                {
+                    return acceptPeer(listenFd);
+                }
+                catch (SocketError& ex)
+                {
+                    PISTACHE_LOG_STRING_WARN(logger_, "Socket error: " << ex.what());
+                }
+                catch (ServerError& ex)
+                {
+                    PISTACHE_LOG_STRING_FATAL(logger_, "Server error: " << ex.what());
+                }
+                return nullptr;
+            });
+        }
+        workersAccept_ = true;
+
+        if (reusePortProgram_ >= 0)
+        {
+#ifdef SO_ATTACH_REUSEPORT_EBPF
+            TRY(::setsockopt(first, SOL_SOCKET, SO_ATTACH_REUSEPORT_EBPF,
+                             &reusePortProgram_, sizeof(reusePortProgram_)));
+#else
+            throw std::runtime_error("No SO_REUSEPORT eBPF programs on this platform");
+#endif
+        }
+#endif
+    }
+
     void Listener::bind(const Address& address)
     {
         PS_TIMEDBG_START_THIS;
@@ -699,8 +813,22 @@ namespace Pistache::Tcp
     {
         PS_TIMEDBG_START_THIS;
 
+        auto peer = acceptPeer(listen_fd);
+        if (!peer)
+            return;
+
+        PS_LOG_DEBUG_ARGS("Calling dispatchPeer %p", peer.get());
+        dispatchPeer(peer);
+    }
+
+    std::shared_ptr<Peer> Listener::acceptPeer(Fd listenFd)
+    {
+        PS_TIMEDBG_START_THIS;
+
         struct sockaddr_storage peer_addr;
-        em_socket_t actual_cli_fd = acceptConnection(peer_addr);
+        em_socket_t actual_cli_fd = acceptConnection(listenFd, peer_addr);
+        if (actual_cli_fd < 0)
+            return nullptr;
 
         void* ssl = nullptr;
 
@@ -720,49 +848,6 @@ namespace Pistache::Tcp
                 throw ServerError(err.c_str());
             }
 
-            // If user requested SSL handshake timeout, enable it on the
-            //  socket.  This is sometimes necessary if a client connects,
-            //  sends nothing, or possibly refuses to accept any bytes, and
-            //  never completes a handshake. This would have left SSL_accept
-            //  hanging indefinitely and is effectively a DoS...
-            if (sslHandshakeTimeout_ > 0ms)
-            {
-                PS_LOG_DEBUG("SSL timeout to be set");
-
-#ifdef _IS_WINDOWS
-
-                unsigned long int timeout_in_ms =
-                    static_cast<unsigned long int>(
-                        std::chrono::duration_cast<
-                        std::chrono::milliseconds>(sslHandshakeTimeout_)
-                        .count());
-
-                PS_LOG_DEBUG_ARGS("Socket timeout %dms", timeout_in_ms);
-
-                TRY(pist_sock_set_timeout(actual_cli_fd, SO_RCVTIMEO,
-                                          timeout_in_ms));
-
-                TRY(pist_sock_set_timeout(actual_cli_fd, SO_SNDTIMEO,
-                                          timeout_in_ms));
-
-#else
-
-                struct timeval timeout;
-
-                timeout.tv_sec = static_cast<PST_TIMEVAL_S_T>(std::chrono::duration_cast<std::chrono::seconds>(sslHandshakeTimeout_).count());
-
-                const auto residual_microseconds = std::chrono::duration_cast<std::chrono::microseconds>(sslHandshakeTimeout_) - std::chrono::duration_cast<std::chrono::seconds>(sslHandshakeTimeout_);
-                timeout.tv_usec                  = static_cast<PST_SUSECONDS_T>(residual_microseconds.count());
-
-                TRY(::setsockopt(actual_cli_fd, SOL_SOCKET, SO_RCVTIMEO,
-                                 reinterpret_cast<PST_SOCK_OPT_VAL_PTR_T>(&timeout),
-                                 sizeof(timeout)));
-                TRY(::setsockopt(actual_cli_fd, SOL_SOCKET, SO_SNDTIMEO,
-                                 reinterpret_cast<PST_SOCK_OPT_VAL_PTR_T>(&timeout),
-                                 sizeof(timeout)));
-#endif // Of ifdef _IS_WINDOWS... else...
-            }
-
             SSL_set_fd(ssl_data,
 #ifdef _IS_WINDOWS
                        // SSL_set_fd takes type int for the FD parm, resulting
@@ -780,61 +865,16 @@ namespace Pistache::Tcp
             );
             SSL_set_accept_state(ssl_data);
 
-            PS_LOG_DEBUG_ARGS("Calling SSL_accept with ssl_data %p", ssl_data);
-            int ssl_accept_res = SSL_accept(ssl_data);
-
-            if (ssl_accept_res <= 0)
-            {
-                PS_LOG_DEBUG_ARGS("SSL_accept failed, ssl_accept_res %d, "
-                                  "actual_cli_fd %d",
-                                  ssl_accept_res, actual_cli_fd);
-
-#ifdef DEBUG
-                const char* ssl_ver = OPENSSL_VERSION_TEXT;
-                PS_LOG_DEBUG_ARGS("openssl: %s", ssl_ver);
-
-                int ssl_err_code = SSL_get_error(ssl_data, ssl_accept_res);
-#endif
-                std::string err = "SSL connection error: "
-                    + ssl_print_errors_to_string();
-                PS_LOG_DEBUG_ARGS("ssl_err_code %d, %s",
-                                  ssl_err_code, err.c_str());
-                PISTACHE_LOG_STRING_INFO(logger_, err);
-
-                PS_LOG_DEBUG("ssl_accept failed");
-                SSL_free(ssl_data);
-                PST_SOCK_CLOSE(actual_cli_fd);
-                return;
-            }
-
-            PS_LOG_DEBUG("SSL_accept succcess");
-
-            // Remove socket timeouts if they were enabled now that we have
-            //  handshaked...
-            if (sslHandshakeTimeout_ > 0ms)
-            {
-                PS_LOG_DEBUG("SSL timeout to be removed");
-
-#ifdef _IS_WINDOWS
-
-                TRY(pist_sock_set_timeout(actual_cli_fd, SO_RCVTIMEO, 0));
-                TRY(pist_sock_set_timeout(actual_cli_fd, SO_SNDTIMEO, 0));
-
-#else
-
-                struct timeval timeout;
-                timeout.tv_sec  = 0;
-                timeout.tv_usec = 0;
-
-                TRY(::setsockopt(actual_cli_fd, SOL_SOCKET, SO_RCVTIMEO,
-                                 reinterpret_cast<PST_SOCK_OPT_VAL_PTR_T>(&timeout),
-                                 sizeof(timeout)));
-                TRY(::setsockopt(actual_cli_fd, SOL_SOCKET, SO_SNDTIMEO,
-                                 reinterpret_cast<PST_SOCK_OPT_VAL_PTR_T>(&timeout),
-                                 sizeof(timeout)));
-
-#endif // Of ifdef _IS_WINDOWS... else...
-            }
+            // The handshake itself is not done here: a blocking SSL_accept
+            // would let a single slow (or malicious) client stall the accept
+            // loop for every other connection. Instead, the peer is flagged
+            // as handshake-pending and the worker's transport drives
+            // SSL_accept on socket readiness, dropping the peer if
+            // sslHandshakeTimeout_ expires first (see
+            // Transport::continueSslHandshake)
+            PS_LOG_DEBUG_ARGS("SSL handshake deferred to transport, "
+                              "ssl_data %p",
+                              ssl_data);
 
             ssl = static_cast<void*>(ssl_data);
         }
@@ -845,8 +885,12 @@ namespace Pistache::Tcp
             PS_LOG_WARNING_ARGS("actual_cli_fd %d failed make_non_blocking",
                                 actual_cli_fd);
 
+#ifdef PISTACHE_USE_SSL
+            if (ssl)
+                SSL_free(static_cast<SSL*>(ssl));
+#endif /* PISTACHE_USE_SSL */
             PST_SOCK_CLOSE(actual_cli_fd);
-            return;
+            return nullptr;
         }
 
 #ifdef _USE_LIBEVENT
@@ -869,6 +913,10 @@ namespace Pistache::Tcp
             PS_LOG_DEBUG("Calling Peer::CreateSSL");
 
             peer = Peer::CreateSSL(client_fd, Address::fromUnix(peer_alias), ssl);
+
+            peer->sslHandshakePending_ = true;
+            if (sslHandshakeTimeout_ > 0ms)
+                peer->sslHandshakeDeadline_ = std::chrono::steady_clock::now() + sslHandshakeTimeout_;
         }
         else
         {
@@ -877,21 +925,21 @@ namespace Pistache::Tcp
             peer = Peer::Create(client_fd, Address::fromUnix(peer_alias));
         }
 
-        PS_LOG_DEBUG_ARGS("Calling dispatchPeer %p", peer.get());
-        dispatchPeer(peer);
+        return peer;
     }
 
-    em_socket_t Listener::acceptConnection(struct sockaddr_storage& peer_addr) const
+    em_socket_t Listener::acceptConnection(Fd listenFd,
+                                           struct sockaddr_storage& peer_addr) const
     {
         PS_TIMEDBG_START_THIS;
 
         socklen_t peer_addr_len = sizeof(peer_addr);
 
-        em_socket_t listen_fd_actual = GET_ACTUAL_FD(listen_fd);
+        em_socket_t listen_fd_actual = GET_ACTUAL_FD(listenFd);
 
-        PS_LOG_DEBUG_ARGS("listen_fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", "
-                                                                  "listen_fd_actual %d",
-                          listen_fd, listen_fd_actual);
+        PS_LOG_DEBUG_ARGS("listenFd %" PIST_QUOTE(PS_FD_PRNTFCD) ", "
+                                                                 "listen_fd_actual %d",
+                          listenFd, listen_fd_actual);
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(listen_fd_actual);
 
@@ -932,6 +980,10 @@ namespace Pistache::Tcp
 
         if (client_actual_fd < 0)
         {
+            // Accepted by someone else, or none left of a batch
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return -1;
+
             PS_LOG_DEBUG("socket accept failed");
 
             PST_DECL_SE_ERR_P_EXTRA;
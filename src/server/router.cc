@@ -11,20 +11,45 @@
 */
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <optional>
 
 #include <pistache/description.h>
+#include <pistache/metrics.h>
 #include <pistache/router.h>
 
 namespace Pistache::Rest
 {
 
-    Request::Request(Http::Request request, std::vector<TypedParam>&& params,
-                     std::vector<TypedParam>&& splats)
+    Request::Request(Http::Request request)
+        : Http::Request(std::move(request))
+    { }
+
+    Request::Request(Http::Request request, Params params, Params splats)
         : Http::Request(std::move(request))
         , params_(std::move(params))
         , splats_(std::move(splats))
     { }
 
+    Request::Params Request::paramsOf(const SegmentTreeNode::Matches& params)
+    {
+        Params typed;
+        typed.reserve(params.size());
+        for (const auto& param : params)
+            typed.emplace_back(param.name, param.value);
+        return typed;
+    }
+
+    Request::Params Request::splatsOf(const SegmentTreeNode::Matches& splats)
+    {
+        Params typed;
+        typed.reserve(splats.size());
+        for (const auto& splat : splats)
+            typed.emplace_back(splat.value, splat.value);
+        return typed;
+    }
+
     bool Request::hasParam(const std::string& name) const
     {
         auto it = std::find_if(
@@ -57,9 +82,10 @@ namespace Pistache::Rest
         return splats_[index];
     }
 
-    std::vector<TypedParam> Request::splat() const { return splats_; }
-
-    std::regex SegmentTreeNode::multiple_slash = std::regex("//+", std::regex_constants::optimize);
+    std::vector<TypedParam> Request::splat() const
+    {
+        return std::vector<TypedParam>(splats_.begin(), splats_.end());
+    }
 
     SegmentTreeNode::SegmentTreeNode()
         : resource_ref_()
@@ -121,13 +147,34 @@ namespace Pistache::Rest
 
     std::string SegmentTreeNode::sanitizeResource(const std::string& path)
     {
-        const auto& dup = std::regex_replace(path, SegmentTreeNode::multiple_slash,
-                                             std::string("/"));
-        if (dup[dup.length() - 1] == '/')
+        std::string scratch;
+        return std::string(sanitizeResource(std::string_view(path), scratch));
+    }
+
+    std::string_view SegmentTreeNode::sanitizeResource(std::string_view path,
+                                                       std::string& scratch)
+    {
+        if (path.empty())
+            return path;
+
+        std::string_view collapsed = path;
+        if (path.find("//") != std::string_view::npos)
         {
-            return dup.substr(1, dup.length() - 2);
+            scratch.clear();
+            scratch.reserve(path.size());
+            for (size_t i = 0; i < path.size(); ++i)
+            {
+                if (path[i] != '/' || scratch.empty() || scratch.back() != '/')
+                    scratch.push_back(path[i]);
+            }
+            collapsed = scratch;
         }
-        return dup.substr(1);
+
+        // The leading slash, then the trailing one if any
+        collapsed.remove_prefix(1);
+        if (!collapsed.empty() && collapsed.back() == '/')
+            collapsed.remove_suffix(1);
+        return collapsed;
     }
 
     void SegmentTreeNode::addRoute(
@@ -245,18 +292,16 @@ namespace Pistache::Rest
         return fixed_.empty() && param_.empty() && optional_.empty() && splat_ == nullptr && route_ == nullptr;
     }
 
-    std::tuple<std::shared_ptr<Route>, std::vector<TypedParam>,
-               std::vector<TypedParam>>
-    Pistache::Rest::SegmentTreeNode::findRoute(
-        const std::string_view& path, std::vector<TypedParam>& params,
-        std::vector<TypedParam>& splats) const
+    const std::shared_ptr<Route>*
+    Pistache::Rest::SegmentTreeNode::findRoute(std::string_view path, Matches& params,
+                                               Matches& splats) const
     {
         // recursion to correct path segment
         if (!path.empty())
         {
             const auto segment_delimiter = path.find('/');
             // current segment value
-            auto current_segment = path.substr(0, segment_delimiter);
+            const auto current_segment = path.substr(0, segment_delimiter);
             // complete child path (path without this segment)
             // if no '/' was found, it means that it is a leaf resource
             const auto lower_path = (segment_delimiter == std::string_view::npos)
@@ -264,63 +309,45 @@ namespace Pistache::Rest
                 : path.substr(segment_delimiter + 1);
 
             // Check if it is a fixed route
-            if (fixed_.count(current_segment) != 0)
+            const auto fixed = fixed_.find(current_segment);
+            if (fixed != fixed_.end())
             {
-                auto result = fixed_.at(current_segment)->findRoute(lower_path, params, splats);
-                auto route  = std::get<0>(result);
-                if (route != nullptr)
-                    return result;
+                if (auto route = fixed->second->findRoute(lower_path, params, splats))
+                    return route;
             }
 
             // Check if it is a path param
             for (const auto& param : param_)
             {
-                std::string para_name { param.first.data(), param.first.length() };
-                std::string para_val { current_segment.data(), current_segment.length() };
-                params.emplace_back(para_name, para_val);
-                auto result = param.second->findRoute(lower_path, params, splats);
-                auto route  = std::get<0>(result);
-                if (route != nullptr)
-                    return result;
+                params.push_back({ param.first, current_segment });
+                if (auto route = param.second->findRoute(lower_path, params, splats))
+                    return route;
                 params.pop_back();
             }
 
             // Check if it is an optional path param
             for (const auto& optional : optional_)
             {
-                std::string opt_name { optional.first.data(), optional.first.length() };
-                std::string opt_val { current_segment.data(), current_segment.length() };
-                params.emplace_back(opt_name, opt_val);
-                auto result = optional.second->findRoute(lower_path, params, splats);
-
-                auto route = std::get<0>(result);
-                if (route != nullptr)
-                    return result;
+                params.push_back({ optional.first, current_segment });
+                if (auto route = optional.second->findRoute(lower_path, params, splats))
+                    return route;
                 params.pop_back();
                 // try to find a route for lower path assuming that
                 // this optional path param is not present
-                result = optional.second->findRoute(lower_path, params, splats);
-
-                route = std::get<0>(result);
-                if (route != nullptr)
-                    return result;
+                if (auto route = optional.second->findRoute(lower_path, params, splats))
+                    return route;
             }
 
             // Check if it is a splat
             if (splat_ != nullptr)
             {
-                std::string splat { current_segment.data(), current_segment.length() };
-                splats.emplace_back(splat, splat);
-                auto result = splat_->findRoute(lower_path, params, splats);
-
-                auto route = std::get<0>(result);
-                if (route != nullptr)
-                    return result;
+                splats.push_back({ current_segment, current_segment });
+                if (auto route = splat_->findRoute(lower_path, params, splats))
+                    return route;
                 splats.pop_back();
             }
             // Requested route does not exists
-            return std::make_tuple(nullptr, std::vector<TypedParam>(),
-                                   std::vector<TypedParam>());
+            return nullptr;
         }
         else
         { // current leaf requested, or empty final optional
@@ -329,19 +356,17 @@ namespace Pistache::Rest
                 // in case of more than one optional at this point, as it is an
                 // ambiguity, it is resolved by using the first optional
                 auto optional = optional_.begin();
-                // std::string opt {optional->first.data(), optional->first.length()};
                 return optional->second->findRoute(path, params, splats);
             }
             else if (route_ == nullptr)
             {
                 // if we are here but route is null, we reached this point
                 // trying to parse an optional, that was missing
-                return std::make_tuple(nullptr, std::vector<TypedParam>(),
-                                       std::vector<TypedParam>());
+                return nullptr;
             }
             else
             {
-                return std::make_tuple(route_, std::move(params), std::move(splats));
+                return &route_;
             }
         }
     }
@@ -350,9 +375,194 @@ namespace Pistache::Rest
                std::vector<TypedParam>>
     Pistache::Rest::SegmentTreeNode::findRoute(const std::string_view& path) const
     {
-        std::vector<TypedParam> params;
-        std::vector<TypedParam> splats;
-        return findRoute(path, params, splats);
+        Matches params;
+        Matches splats;
+
+        const auto route = findRoute(path, params, splats);
+        if (!route)
+            return std::make_tuple(nullptr, std::vector<TypedParam>(),
+                                   std::vector<TypedParam>());
+
+        std::vector<TypedParam> typedParams;
+        for (const auto& param : params)
+            typedParams.emplace_back(param.name, param.value);
+
+        std::vector<TypedParam> typedSplats;
+        for (const auto& splat : splats)
+            typedSplats.emplace_back(splat.value, splat.value);
+
+        return std::make_tuple(*route, std::move(typedParams), std::move(typedSplats));
+    }
+
+    RouteTable::RouteTable(const SegmentTreeNode& root)
+    {
+        // Breadth first: the tree nodes still to compile, with their index
+        std::vector<std::pair<const SegmentTreeNode*, uint32_t>> pending;
+
+        auto addNode = [&](const SegmentTreeNode* tree) {
+            const auto index = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+            pending.emplace_back(tree, index);
+            return index;
+        };
+
+        auto addEdge = [&](std::string_view name, size_t hash, const SegmentTreeNode* child) {
+            edges_.push_back({ hash, static_cast<uint32_t>(names_.size()),
+                               static_cast<uint32_t>(name.size()), addNode(child) });
+            names_.append(name);
+        };
+
+        addNode(&root);
+        for (size_t i = 0; i < pending.size(); ++i)
+        {
+            const auto [tree, index] = pending[i];
+
+            Node node;
+            node.edges = static_cast<uint32_t>(edges_.size());
+
+            std::vector<std::tuple<size_t, std::string_view, const SegmentTreeNode*>> fixed;
+            fixed.reserve(tree->fixed_.size());
+            for (const auto& child : tree->fixed_)
+                fixed.emplace_back(std::hash<std::string_view> {}(child.first), child.first,
+                                   child.second.get());
+            std::sort(fixed.begin(), fixed.end());
+
+            for (const auto& [hash, name, child] : fixed)
+                addEdge(name, hash, child);
+            node.fixedEnd = static_cast<uint32_t>(edges_.size());
+
+            if (fixed.size() > MaxScanned)
+            {
+                // At most half full, so that probes are short
+                size_t size = 2;
+                while (size < fixed.size() * 2)
+                    size *= 2;
+
+                node.slots    = static_cast<uint32_t>(slots_.size());
+                node.slotMask = static_cast<uint32_t>(size - 1);
+                slots_.resize(slots_.size() + size, None);
+
+                for (uint32_t edge = node.edges; edge < node.fixedEnd; ++edge)
+                {
+                    size_t slot = edges_[edge].hash & node.slotMask;
+                    while (slots_[node.slots + slot] != None)
+                        slot = (slot + 1) & node.slotMask;
+                    slots_[node.slots + slot] = edge;
+                }
+            }
+
+            // In the order the tree tries them in
+            for (const auto& child : tree->param_)
+                addEdge(child.first, 0, child.second.get());
+            node.paramEnd = static_cast<uint32_t>(edges_.size());
+
+            for (const auto& child : tree->optional_)
+                addEdge(child.first, 0, child.second.get());
+            node.edgesEnd = static_cast<uint32_t>(edges_.size());
+
+            if (tree->splat_ != nullptr)
+                node.splat = addNode(tree->splat_.get());
+
+            if (tree->route_ != nullptr)
+            {
+                node.route = static_cast<uint32_t>(routes_.size());
+                routes_.push_back(tree->route_);
+            }
+
+            nodes_[index] = node;
+        }
+    }
+
+    const std::shared_ptr<Route>*
+    RouteTable::findRoute(std::string_view path, SegmentTreeNode::Matches& params,
+                          SegmentTreeNode::Matches& splats) const
+    {
+        return findRoute(0, path, params, splats);
+    }
+
+    // Mirrors SegmentTreeNode::findRoute, step by step
+    const std::shared_ptr<Route>*
+    RouteTable::findRoute(uint32_t index, std::string_view path,
+                          SegmentTreeNode::Matches& params,
+                          SegmentTreeNode::Matches& splats) const
+    {
+        const auto& node = nodes_[index];
+
+        if (!path.empty())
+        {
+            const auto segment_delimiter = path.find('/');
+            const auto current_segment   = path.substr(0, segment_delimiter);
+            const auto lower_path        = (segment_delimiter == std::string_view::npos)
+                       ? std::string_view { nullptr, 0 }
+                       : path.substr(segment_delimiter + 1);
+
+            if (node.fixedEnd - node.edges <= MaxScanned)
+            {
+                for (uint32_t i = node.edges; i < node.fixedEnd; ++i)
+                {
+                    if (name(edges_[i]) != current_segment)
+                        continue;
+
+                    if (auto route = findRoute(edges_[i].child, lower_path, params, splats))
+                        return route;
+                    break;
+                }
+            }
+            else
+            {
+                const size_t hash = std::hash<std::string_view> {}(current_segment);
+
+                for (size_t slot = hash & node.slotMask;; slot = (slot + 1) & node.slotMask)
+                {
+                    const uint32_t edge = slots_[node.slots + slot];
+                    if (edge == None)
+                        break;
+
+                    const auto& fixed = edges_[edge];
+                    if (fixed.hash != hash || name(fixed) != current_segment)
+                        continue;
+
+                    if (auto route = findRoute(fixed.child, lower_path, params, splats))
+                        return route;
+                    break;
+                }
+            }
+
+            for (uint32_t i = node.fixedEnd; i < node.paramEnd; ++i)
+            {
+                params.push_back({ name(edges_[i]), current_segment });
+                if (auto route = findRoute(edges_[i].child, lower_path, params, splats))
+                    return route;
+                params.pop_back();
+            }
+
+            for (uint32_t i = node.paramEnd; i < node.edgesEnd; ++i)
+            {
+                params.push_back({ name(edges_[i]), current_segment });
+                if (auto route = findRoute(edges_[i].child, lower_path, params, splats))
+                    return route;
+                params.pop_back();
+                if (auto route = findRoute(edges_[i].child, lower_path, params, splats))
+                    return route;
+            }
+
+            if (node.splat != None)
+            {
+                splats.push_back({ current_segment, current_segment });
+                if (auto route = findRoute(node.splat, lower_path, params, splats))
+                    return route;
+                splats.pop_back();
+            }
+            return nullptr;
+        }
+
+        // An empty final optional, the first one
+        if (node.paramEnd != node.edgesEnd)
+            return findRoute(edges_[node.paramEnd].child, path, params, splats);
+
+        if (node.route == None)
+            return nullptr;
+        return &routes_[node.route];
     }
 
     namespace Private
@@ -373,6 +583,13 @@ namespace Pistache::Rest
             router->route(req, std::move(response));
         }
 
+        void RouterHandler::takeRequest(Http::Request&& req,
+                                        Http::ResponseWriter response)
+        {
+            PS_TIMEDBG_START_THIS;
+            router->route(std::move(req), std::move(response));
+        }
+
         void RouterHandler::onDisconnection(const std::shared_ptr<Tcp::Peer>& peer)
         {
             PS_TIMEDBG_START_THIS;
@@ -459,10 +676,10 @@ namespace Pistache::Rest
     {
         if (resource.empty())
             throw std::runtime_error("Invalid zero-length URL.");
-        auto& r              = routes[method];
-        const auto sanitized = SegmentTreeNode::sanitizeResource(resource);
-        const std::string_view path { sanitized.data(), sanitized.size() };
-        r.removeRoute(path);
+        auto& r = routes[method];
+        std::string scratch;
+        r.removeRoute(SegmentTreeNode::sanitizeResource(resource, scratch));
+        refreeze();
     }
 
     void Router::head(const std::string& resource, Route::Handler handler)
@@ -485,6 +702,23 @@ namespace Pistache::Rest
         disconnectHandlers.push_back(std::move(handler));
     }
 
+    void Router::freeze()
+    {
+        auto frozen = std::make_shared<FrozenRoutes>();
+        for (const auto& tree : routes)
+            frozen->emplace(tree.first, RouteTable(tree.second));
+
+        std::atomic_store(&frozenRoutes, std::shared_ptr<const FrozenRoutes>(std::move(frozen)));
+    }
+
+    bool Router::frozen() const { return std::atomic_load(&frozenRoutes) != nullptr; }
+
+    void Router::refreeze()
+    {
+        if (frozen())
+            freeze();
+    }
+
     void Router::addNotFoundHandler(Route::Handler handler)
     {
         notFoundHandler = std::move(handler);
@@ -493,59 +727,83 @@ namespace Pistache::Rest
     void Router::invokeNotFoundHandler(const Http::Request& req,
                                        Http::ResponseWriter resp) const
     {
-        notFoundHandler(Rest::Request(req, std::vector<TypedParam>(),
-                                      std::vector<TypedParam>()),
-                        std::move(resp));
+        notFoundHandler(Rest::Request(req), std::move(resp));
     }
 
     Route::Status Router::route(const Http::Request& request,
                                 Http::ResponseWriter response) const
+    {
+        return route(Http::Request(request), std::move(response));
+    }
+
+    Route::Status Router::route(Http::Request&& req,
+                                Http::ResponseWriter response) const
     {
         PS_TIMEDBG_START_THIS;
 
-        const auto& resource = request.resource();
+        const auto& resource = req.resource();
         if (resource.empty())
             throw std::runtime_error("Invalid zero-length URL.");
 
-        auto req  = request;
-        auto resp = response.clone();
-
-        for (const auto& middleware : middlewares)
+        // Middlewares work on a copy of the response, which is dropped if
+        // no route matches. Without any, there is nothing to copy
+        std::optional<Http::ResponseWriter> resp;
+        if (!middlewares.empty())
         {
-            auto result = middleware(req, resp);
+            resp.emplace(response.clone());
+            for (const auto& middleware : middlewares)
+            {
+                auto result = middleware(req, *resp);
 
-            // Handler returns true, go to the next piped handler, otherwise break and return
-            if (!result)
-                return Route::Status::Match;
+                // Handler returns true, go to the next piped handler, otherwise break and return
+                if (!result)
+                    return Route::Status::Match;
+            }
         }
 
-        std::tuple<std::shared_ptr<Route>, std::vector<TypedParam>,
-                   std::vector<TypedParam>>
-            result;
+        std::string scratch;
+        const auto path = SegmentTreeNode::sanitizeResource(resource, scratch);
 
-        const auto sanitized = SegmentTreeNode::sanitizeResource(resource);
-        const std::string_view path { sanitized.data(), sanitized.size() };
+        SegmentTreeNode::Matches params;
+        SegmentTreeNode::Matches splats;
+
+        // The tables in use for the whole request, even if others are
+        // swapped in meanwhile
+        const auto frozen = std::atomic_load(&frozenRoutes);
+
+        auto findRoute = [&](Http::Method method) -> const std::shared_ptr<Route>* {
+            params.clear();
+            splats.clear();
+            if (frozen)
+            {
+                const auto table = frozen->find(method);
+                return table != frozen->end() ? table->second.findRoute(path, params, splats)
+                                              : nullptr;
+            }
 
-        const auto routesIt = routes.find(req.method());
-        if (routesIt != routes.end())
-            result = routesIt->second.findRoute(path);
+            const auto tree = routes.find(method);
+            return tree != routes.end() ? tree->second.findRoute(path, params, splats)
+                                        : nullptr;
+        };
 
-        auto route = std::get<0>(result);
+        const auto route = findRoute(req.method());
         if (route != nullptr)
         {
-            auto params = std::get<1>(result);
-            auto splats = std::get<2>(result);
-            route->invokeHandler(Request(std::move(req), std::move(params), std::move(splats)),
-                                 std::move(resp));
+            // Keeps the route alive while it runs, in case it is removed
+            const auto matched = *route;
+            if (req.span())
+                req.span()->mark(Trace::Phase::RouteMatched);
+            auto typedParams = Request::paramsOf(params);
+            auto typedSplats = Request::splatsOf(splats);
+            matched->invokeHandler(Request(std::move(req), std::move(typedParams), std::move(typedSplats)),
+                                   resp ? std::move(*resp) : std::move(response));
             return Route::Status::Match;
         }
 
         for (const auto& handler : customHandlers)
         {
-            auto cloned_resp     = response.clone();
-            auto handler1 = handler(
-                Request(req, std::vector<TypedParam>(), std::vector<TypedParam>()),
-                std::move(cloned_resp));
+            auto cloned_resp = response.clone();
+            auto handler1    = handler(Request(req), std::move(cloned_resp));
             if (handler1 == Route::Result::Ok)
                 return Route::Status::Match;
         }
@@ -558,25 +816,30 @@ namespace Pistache::Rest
         // RFC 7231 requires HTTP 405 responses to include a list of
         // supported methods for the requested resource.
         std::vector<Http::Method> supportedMethods;
-        for (auto& methods : routes)
-        {
-            if (methods.first == req.method())
-                continue;
+        auto checkMethod = [&](Http::Method method) {
+            if (method != req.method() && findRoute(method) != nullptr)
+                supportedMethods.push_back(method);
+        };
 
-            auto res = methods.second.findRoute(path);
-            auto rte = std::get<0>(res);
-            if (rte != nullptr)
-            {
-                supportedMethods.push_back(methods.first);
-            }
+        if (frozen)
+        {
+            for (const auto& table : *frozen)
+                checkMethod(table.first);
+        }
+        else
+        {
+            for (const auto& tree : routes)
+                checkMethod(tree.first);
         }
 
         if (!supportedMethods.empty())
         {
+            Metrics::local().routesNotAllowed.add();
             response.sendMethodNotAllowed(supportedMethods);
             return Route::Status::NotAllowed;
         }
 
+        Metrics::local().routesNotFound.add();
         if (hasNotFoundHandler())
         {
             invokeNotFoundHandler(req, std::move(response));
@@ -602,6 +865,7 @@ namespace Pistache::Rest
         std::memcpy(ptr.get(), sanitized.data(), sanitized.length());
         const std::string_view path { ptr.get(), sanitized.length() };
         r.addRoute(path, handler, ptr);
+        refreeze();
     }
 
     void Router::disconnectPeer(const std::shared_ptr<Tcp::Peer>& peer)
@@ -665,5 +929,14 @@ namespace Pistache::Rest
             router.head(resource, std::move(handler));
         }
 
+        void Prometheus(Router& router, const std::string& resource)
+        {
+            router.get(resource, [](const Request&, Http::ResponseWriter response) {
+                response.send(Http::Code::Ok, Metrics::prometheus(),
+                              MIME(Text, Plain));
+                return Route::Result::Ok;
+            });
+        }
+
     } // namespace Routes
 } // namespace Pistache::Rest
@@ -0,0 +1,120 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/endpoint.h>
+#include <pistache/http.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+
+#include "tcp_client.h"
+
+using namespace Pistache;
+
+namespace
+{
+    // Only the allocations made while a test counts them, on any thread
+    std::atomic<bool> counting { false };
+    std::atomic<size_t> allocations { 0 };
+}
+
+void* operator new(size_t size)
+{
+    if (counting.load(std::memory_order_relaxed))
+        allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace
+{
+    // Allocations the server may make serving one keep-alive request, the
+    // test itself making none. Lower it along with the count it guards
+    constexpr size_t MaxAllocationsPerRequest = 18;
+
+    struct HelloHandler : public Http::Handler
+    {
+        HTTP_PROTOTYPE(HelloHandler)
+
+        void onRequest(const Http::Request& /*request*/, Http::ResponseWriter response) override
+        {
+            response.send(Http::Code::Ok, "Hello, World!");
+        }
+    };
+
+    // Sends a request and reads the whole response, without allocating
+    bool exchange(TcpClient& client, const std::string& request)
+    {
+        static constexpr std::string_view End = "Hello, World!";
+
+        if (!client.send(request))
+            return false;
+
+        char buffer[4096];
+        size_t total = 0;
+        while (std::string_view(buffer, total).find(End) == std::string_view::npos)
+        {
+            size_t bytes = 0;
+            if (total == sizeof(buffer)
+                || !client.receive(buffer + total, sizeof(buffer) - total, &bytes,
+                                   std::chrono::seconds(5)))
+                return false;
+            total += bytes;
+        }
+        return true;
+    }
+}
+
+// Serving requests on a connection kept alive reuses what was allocated
+// for the previous ones: the request, the buffers and the polling state
+TEST(allocation_test, keep_alive_requests_allocate_little)
+{
+    Http::Endpoint server(Address("localhost", Port(0)));
+    server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr).threads(1));
+    server.setHandler(Http::make_handler<HelloHandler>());
+    server.serveThreaded();
+
+    TcpClient client;
+    ASSERT_TRUE(client.connect(Address("localhost", server.getPort())));
+
+    const std::string request = "GET / HTTP/1.1\r\n"
+                                "Host: localhost\r\n"
+                                "Connection: keep-alive\r\n"
+                                "\r\n";
+
+    // The first requests fill the pools and caches
+    for (int i = 0; i < 10; ++i)
+        ASSERT_TRUE(exchange(client, request));
+
+    constexpr size_t Requests = 100;
+
+    bool exchanged = true;
+    counting       = true;
+    for (size_t i = 0; i < Requests && exchanged; ++i)
+        exchanged = exchange(client, request);
+    counting = false;
+
+    server.shutdown();
+
+    ASSERT_TRUE(exchanged);
+
+    const size_t perRequest = allocations.load() / Requests;
+    std::cout << "Allocations per request: " << perRequest << std::endl;
+    EXPECT_LE(perRequest, MaxAllocationsPerRequest);
+}
@@ -0,0 +1,166 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/async_log.h>
+#include <pistache/pist_syslog.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Pistache;
+
+namespace
+{
+    std::string logPath(const char* name)
+    {
+        const std::string path = testing::TempDir() + name;
+        std::remove(path.c_str());
+        return path;
+    }
+
+    std::vector<std::string> readLines(const std::string& path)
+    {
+        std::ifstream in(path);
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(in, line);)
+            lines.push_back(line);
+        return lines;
+    }
+
+    size_t countContaining(const std::vector<std::string>& lines, const std::string& text)
+    {
+        size_t count = 0;
+        for (const auto& line : lines)
+            count += line.find(text) != std::string::npos;
+        return count;
+    }
+}
+
+TEST(async_log_test, writes_what_threads_log_to_a_file)
+{
+    const std::string path = logPath("async_log_file.log");
+
+    Log::AsyncLog::Options options;
+    options.sink = Log::AsyncLog::Sink::File;
+    options.path = path;
+    Log::AsyncLog::start(options);
+    EXPECT_TRUE(Log::AsyncLog::isRunning());
+    EXPECT_THROW(Log::AsyncLog::start(options), std::runtime_error);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t)
+    {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 10; ++i)
+                PS_LOG_WARNING_ARGS("async message %d from %d", i, t);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    Log::AsyncStringLogger logger(Log::Level::LL_INFO);
+    logger.log(Log::Level::LL_ERROR, "string logger message");
+    logger.log(Log::Level::LL_DEBUG, "below the logger's level");
+
+    Log::AsyncLog::flush();
+    Log::AsyncLog::stop();
+    EXPECT_FALSE(Log::AsyncLog::isRunning());
+
+    const auto lines = readLines(path);
+    EXPECT_EQ(countContaining(lines, "async message "), 30u);
+    EXPECT_EQ(countContaining(lines, " WRN "), 30u);
+    EXPECT_EQ(countContaining(lines, "async_log_test.cc:"), 30u);
+    EXPECT_EQ(countContaining(lines, "async message 9 from 2"), 1u);
+    EXPECT_EQ(countContaining(lines, "ERR"), 1u);
+    EXPECT_EQ(countContaining(lines, "string logger message"), 1u);
+    EXPECT_EQ(countContaining(lines, "below the logger's level"), 0u);
+
+    std::remove(path.c_str());
+}
+
+TEST(async_log_test, drops_and_counts_what_does_not_fit)
+{
+    const std::string path = logPath("async_log_drops.log");
+
+    Log::AsyncLog::Options options;
+    options.sink     = Log::AsyncLog::Sink::File;
+    options.path     = path;
+    options.records  = 4;
+    options.interval = std::chrono::milliseconds(200);
+    Log::AsyncLog::start(options);
+
+    const auto before = Log::AsyncLog::stats();
+
+    // A thread of its own, for its ring to be made with the size above
+    size_t accepted = 0;
+    std::thread([&accepted] {
+        for (int i = 0; i < 100; ++i)
+            accepted += Log::AsyncLog::log(LOG_WARNING, false, "overflowing");
+    }).join();
+
+    Log::AsyncLog::flush();
+    const auto after = Log::AsyncLog::stats();
+    Log::AsyncLog::stop();
+
+    EXPECT_LT(accepted, 100u);
+    EXPECT_EQ(after.written - before.written, accepted);
+    EXPECT_EQ(after.dropped - before.dropped, 100u - accepted);
+
+    const auto lines = readLines(path);
+    EXPECT_EQ(countContaining(lines, "overflowing"), accepted);
+    EXPECT_EQ(countContaining(lines, "log messages dropped"), 1u);
+
+    std::remove(path.c_str());
+}
+
+TEST(async_log_test, logs_synchronously_once_stopped)
+{
+    EXPECT_FALSE(Log::AsyncLog::isRunning());
+    EXPECT_FALSE(Log::AsyncLog::log(LOG_INFO, false, "not queued"));
+
+    // Returns at once
+    Log::AsyncLog::flush();
+}
+
+TEST(async_log_test, async_logging_benchmark)
+{
+    const std::string path = logPath("async_log_benchmark.log");
+
+    Log::AsyncLog::Options options;
+    options.sink    = Log::AsyncLog::Sink::File;
+    options.path    = path;
+    options.records = 16384;
+    Log::AsyncLog::start(options);
+
+    constexpr int Messages = 10000;
+
+    std::chrono::nanoseconds elapsed {};
+    std::thread([&elapsed] {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < Messages; ++i)
+            PS_LOG_INFO_ARGS("benchmark message %d of %d", i, Messages);
+        elapsed = std::chrono::steady_clock::now() - start;
+    }).join();
+
+    Log::AsyncLog::flush();
+    Log::AsyncLog::stop();
+
+    std::cout << "async logging: " << elapsed.count() / Messages
+              << " ns per PS_LOG_INFO_ARGS call" << std::endl;
+
+    EXPECT_EQ(countContaining(readLines(path), "benchmark message"),
+              static_cast<size_t>(Messages));
+
+    std::remove(path.c_str());
+}
@@ -10,8 +10,11 @@
 #include <pistache/common.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <deque>
+#include <iostream>
 #include <mutex>
 #include <random>
 #include <thread>
@@ -519,3 +522,66 @@ TEST(async_test, chain_rejects)
     (*rejecter)(std::runtime_error("foo"));
     ASSERT_TRUE(ok);
 }
+
+// Continuations attached while another thread resolves the promise run
+// exactly once, whether they are attached before or after it settles
+TEST(async_test, then_races_resolve)
+{
+    constexpr int Promises = 20000;
+
+    std::atomic<int> runs { 0 };
+    for (int i = 0; i < Promises; ++i)
+    {
+        Async::Deferred<int> deferred;
+        Async::Promise<int> promise(
+            [&](Async::Deferred<int> d) { deferred = std::move(d); });
+
+        std::thread resolver([&] { deferred.resolve(i); });
+        promise.then([&](int v) { runs += v == i; }, Async::NoExcept);
+        promise.then([&](int v) { runs += v == i; }, Async::NoExcept);
+        resolver.join();
+    }
+
+    ASSERT_EQ(runs.load(), 2 * Promises);
+}
+
+// Chains continuations onto pending promises and onto already resolved
+// ones, the two ways responses use them, and reports the time per chain
+TEST(async_test, chained_promise_benchmark)
+{
+    constexpr int Chains = 200000;
+    using Clock          = std::chrono::steady_clock;
+
+    long long sum    = 0;
+    const auto start = Clock::now();
+    for (int i = 0; i < Chains; ++i)
+    {
+        Async::Deferred<int> deferred;
+        Async::Promise<int> promise(
+            [&](Async::Deferred<int> d) { deferred = std::move(d); });
+        promise
+            .then([](int v) { return v + 1; }, Async::Throw)
+            .then([](int v) { return Async::Promise<int>::resolved(v * 2); }, Async::Throw)
+            .then([&](int v) { sum += v; }, Async::NoExcept);
+        deferred.resolve(i);
+    }
+    const auto pending = Clock::now() - start;
+    ASSERT_EQ(sum, static_cast<long long>(Chains) * (Chains + 1));
+
+    sum                      = 0;
+    const auto startResolved = Clock::now();
+    for (int i = 0; i < Chains; ++i)
+    {
+        Async::Promise<int>::resolved(i)
+            .then([](int v) { return v + 1; }, Async::Throw)
+            .then([&](int v) { sum += v; }, Async::NoExcept);
+    }
+    const auto resolved = Clock::now() - startResolved;
+    ASSERT_EQ(sum, static_cast<long long>(Chains) * (Chains + 1) / 2);
+
+    auto nsPerChain = [&](Clock::duration elapsed) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / Chains;
+    };
+    std::cout << "chained promises: " << nsPerChain(pending) << " ns per pending chain of 3, "
+              << nsPerChain(resolved) << " ns per resolved chain of 2" << std::endl;
+}
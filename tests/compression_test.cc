@@ -0,0 +1,276 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/compression.h>
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+#include <brotli/decode.h>
+#include <brotli/encode.h>
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+#include <zlib.h>
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+#include <zstd.h>
+#endif
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace Pistache;
+using Http::CompressedCache;
+using Http::Compressor;
+using Http::CompressorPool;
+
+namespace
+{
+    [[maybe_unused]] std::vector<std::string> sampleChunks()
+    {
+        std::vector<std::string> chunks;
+        for (int i = 0; i < 16; ++i)
+            chunks.push_back("line " + std::to_string(i) + " of a streamed body, "
+                             + std::string(100, static_cast<char>('a' + i % 26)) + "\n");
+        return chunks;
+    }
+
+    // Compresses chunks the way a ResponseStream does, with a sync flush
+    // after every chunk, and returns the output of each
+    [[maybe_unused]] std::vector<std::string> compressChunks(Compressor& compressor,
+                                                             const std::vector<std::string>& chunks)
+    {
+        std::vector<std::string> out;
+        for (const auto& chunk : chunks)
+        {
+            std::string compressed;
+            compressor.compress(chunk.data(), chunk.size(), Compressor::Flush::Sync, compressed);
+            out.push_back(std::move(compressed));
+        }
+
+        std::string last;
+        compressor.compress(nullptr, 0, Compressor::Flush::Finish, last);
+        out.push_back(std::move(last));
+        return out;
+    }
+}
+
+TEST(compression_test, unsupported_encoding_throws)
+{
+    EXPECT_THROW(CompressorPool::acquire(Http::Header::Encoding::Gzip, 0), std::runtime_error);
+    EXPECT_THROW(CompressorPool::acquire(Http::Header::Encoding::Identity, 0), std::runtime_error);
+}
+
+TEST(compression_test, body_ids_tell_contents_apart)
+{
+    const std::string body(1000, 'x');
+    std::string other = body;
+    other[500]        = 'y';
+
+    EXPECT_EQ(CompressedCache::bodyId(body.data(), body.size()),
+              CompressedCache::bodyId(body.data(), body.size()));
+    EXPECT_NE(CompressedCache::bodyId(body.data(), body.size()),
+              CompressedCache::bodyId(other.data(), other.size()));
+    EXPECT_NE(CompressedCache::bodyId(body.data(), body.size()),
+              CompressedCache::bodyId(body.data(), body.size() - 1));
+
+    // Bytes past the last full 8-byte word count as well
+    const std::string shortBody  = "0123456789abc";
+    const std::string shortOther = "0123456789abd";
+    EXPECT_NE(CompressedCache::bodyId(shortBody.data(), shortBody.size()),
+              CompressedCache::bodyId(shortOther.data(), shortOther.size()));
+}
+
+TEST(compressed_cache_test, hits_and_misses_per_encoding_and_level)
+{
+    CompressedCache cache;
+    const CompressedCache::Key key { "body", Http::Header::Encoding::Br, 4 };
+
+    EXPECT_EQ(cache.get(key), nullptr);
+    cache.put(key, std::make_shared<const std::string>("compressed"));
+
+    auto cached = cache.get(key);
+    ASSERT_NE(cached, nullptr);
+    EXPECT_EQ(*cached, "compressed");
+
+    EXPECT_EQ(cache.get({ "body", Http::Header::Encoding::Br, 5 }), nullptr);
+    EXPECT_EQ(cache.get({ "body", Http::Header::Encoding::Zstd, 4 }), nullptr);
+
+    EXPECT_EQ(cache.stats().hits, 1u);
+    EXPECT_EQ(cache.stats().misses, 3u);
+}
+
+TEST(compressed_cache_test, least_recently_used_is_evicted_past_max_bytes)
+{
+    CompressedCache cache(30);
+    auto key = [](const char* id) {
+        return CompressedCache::Key { id, Http::Header::Encoding::Deflate, 1 };
+    };
+
+    cache.put(key("a"), std::make_shared<const std::string>(10, 'a'));
+    cache.put(key("b"), std::make_shared<const std::string>(10, 'b'));
+    cache.put(key("c"), std::make_shared<const std::string>(10, 'c'));
+    EXPECT_EQ(cache.bytes(), 30u);
+
+    // Makes "b" the least recently used
+    cache.get(key("a"));
+    cache.put(key("d"), std::make_shared<const std::string>(10, 'd'));
+
+    EXPECT_EQ(cache.size(), 3u);
+    EXPECT_EQ(cache.get(key("b")), nullptr);
+    EXPECT_NE(cache.get(key("a")), nullptr);
+    EXPECT_EQ(cache.stats().evictions, 1u);
+
+    // Too large to ever be cached
+    cache.put(key("e"), std::make_shared<const std::string>(40, 'e'));
+    EXPECT_EQ(cache.get(key("e")), nullptr);
+
+    cache.setMaxBytes(10);
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_LE(cache.bytes(), 10u);
+}
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+TEST(compressed_cache_test, compresses_once)
+{
+    CompressedCache cache;
+    const std::string body(10000, 'x');
+    const CompressedCache::Key key { CompressedCache::bodyId(body.data(), body.size()),
+                                     Http::Header::Encoding::Deflate, Z_BEST_SPEED };
+
+    auto first  = cache.getOrCompress(key, body.data(), body.size());
+    auto second = cache.getOrCompress(key, body.data(), body.size());
+    EXPECT_EQ(first, second);
+    EXPECT_LT(first->size(), body.size());
+    EXPECT_EQ(cache.stats().misses, 1u);
+    EXPECT_EQ(cache.stats().hits, 1u);
+
+    std::string decoded(body.size(), '\0');
+    uLongf decodedSize = static_cast<uLongf>(decoded.size());
+    ASSERT_EQ(uncompress(reinterpret_cast<Bytef*>(decoded.data()), &decodedSize,
+                         reinterpret_cast<const Bytef*>(first->data()),
+                         static_cast<uLong>(first->size())),
+              Z_OK);
+    EXPECT_EQ(decoded, body);
+}
+
+TEST(compression_test, deflate_sync_flush_makes_every_chunk_decodable)
+{
+    const auto chunks = sampleChunks();
+
+    auto compressor = CompressorPool::acquire(Http::Header::Encoding::Deflate, Z_DEFAULT_COMPRESSION);
+    const auto out  = compressChunks(*compressor, chunks);
+
+    z_stream zs {};
+    ASSERT_EQ(inflateInit(&zs), Z_OK);
+
+    // Everything up to a sync flush decodes, without what follows
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        std::string decoded(chunks[i].size() + 64, '\0');
+        zs.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(out[i].data()));
+        zs.avail_in  = static_cast<uInt>(out[i].size());
+        zs.next_out  = reinterpret_cast<Bytef*>(decoded.data());
+        zs.avail_out = static_cast<uInt>(decoded.size());
+
+        ASSERT_EQ(inflate(&zs, Z_SYNC_FLUSH), Z_OK);
+        decoded.resize(decoded.size() - zs.avail_out);
+        EXPECT_EQ(decoded, chunks[i]);
+    }
+
+    char end[16];
+    zs.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(out.back().data()));
+    zs.avail_in  = static_cast<uInt>(out.back().size());
+    zs.next_out  = reinterpret_cast<Bytef*>(end);
+    zs.avail_out = sizeof(end);
+    EXPECT_EQ(inflate(&zs, Z_FINISH), Z_STREAM_END);
+    inflateEnd(&zs);
+}
+
+TEST(compression_test, compressors_are_pooled_per_thread)
+{
+    const auto encoding = Http::Header::Encoding::Deflate;
+
+    Compressor* first = nullptr;
+    {
+        auto compressor = CompressorPool::acquire(encoding, Z_BEST_SPEED);
+        first           = compressor.get();
+
+        std::string out;
+        compressor->compress("abc", 3, Compressor::Flush::None, out);
+    }
+    const size_t idle = CompressorPool::idle(encoding);
+    EXPECT_GE(idle, 1u);
+
+    // The same one comes back, reset: a whole new stream
+    auto again = CompressorPool::acquire(encoding, Z_BEST_COMPRESSION);
+    EXPECT_EQ(again.get(), first);
+    EXPECT_EQ(CompressorPool::idle(encoding), idle - 1);
+
+    const std::string data(1000, 'x');
+    std::string out;
+    again->compress(data.data(), data.size(), Compressor::Flush::Finish, out);
+
+    std::string decoded(data.size(), '\0');
+    uLongf decodedSize = static_cast<uLongf>(decoded.size());
+    ASSERT_EQ(uncompress(reinterpret_cast<Bytef*>(decoded.data()), &decodedSize,
+                         reinterpret_cast<const Bytef*>(out.data()),
+                         static_cast<uLong>(out.size())),
+              Z_OK);
+    EXPECT_EQ(decoded, data);
+}
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+TEST(compression_test, brotli_streamed_round_trip)
+{
+    const auto chunks = sampleChunks();
+
+    auto compressor = CompressorPool::acquire(Http::Header::Encoding::Br, BROTLI_DEFAULT_QUALITY);
+    const auto out  = compressChunks(*compressor, chunks);
+
+    std::string compressed, expected;
+    for (const auto& part : out)
+        compressed += part;
+    for (const auto& chunk : chunks)
+        expected += chunk;
+
+    std::string decoded(expected.size(), '\0');
+    size_t decodedSize = decoded.size();
+    ASSERT_EQ(BrotliDecoderDecompress(compressed.size(),
+                                      reinterpret_cast<const uint8_t*>(compressed.data()),
+                                      &decodedSize, reinterpret_cast<uint8_t*>(decoded.data())),
+              BROTLI_DECODER_RESULT_SUCCESS);
+    decoded.resize(decodedSize);
+    EXPECT_EQ(decoded, expected);
+}
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+TEST(compression_test, zstd_streamed_round_trip)
+{
+    const auto chunks = sampleChunks();
+
+    auto compressor = CompressorPool::acquire(Http::Header::Encoding::Zstd, 0);
+    const auto out  = compressChunks(*compressor, chunks);
+
+    std::string compressed, expected;
+    for (const auto& part : out)
+        compressed += part;
+    for (const auto& chunk : chunks)
+        expected += chunk;
+
+    std::string decoded(expected.size(), '\0');
+    const size_t decodedSize = ZSTD_decompress(decoded.data(), decoded.size(),
+                                               compressed.data(), compressed.size());
+    ASSERT_FALSE(ZSTD_isError(decodedSize));
+    decoded.resize(decodedSize);
+    EXPECT_EQ(decoded, expected);
+}
+#endif
@@ -0,0 +1,185 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/coroutine.h>
+#include <pistache/endpoint.h>
+#include <pistache/http.h>
+#include <pistache/router.h>
+
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <httplib.h>
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Pistache;
+
+#ifdef __cpp_impl_coroutine
+
+namespace
+{
+    // Resolves the promise it returns from a thread of its own, later on
+    class Later
+    {
+    public:
+        Later()             = default;
+        Later(const Later&) = delete;
+        ~Later() { join(); }
+
+        Async::Promise<int> value(int v)
+        {
+            return Async::Promise<int>([&](Async::Deferred<int> deferred) {
+                std::lock_guard<std::mutex> guard(mtx_);
+                threads_.emplace_back([deferred = std::move(deferred), v]() mutable {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    deferred.resolve(v);
+                });
+            });
+        }
+
+        void join()
+        {
+            std::lock_guard<std::mutex> guard(mtx_);
+            for (auto& thread : threads_)
+                thread.join();
+            threads_.clear();
+        }
+
+    private:
+        std::mutex mtx_;
+        std::vector<std::thread> threads_;
+    };
+
+    Async::Task<int> sum(Later& later)
+    {
+        const int settled = co_await Async::Promise<int>::resolved(1);
+        const int pending = co_await later.value(2);
+        co_return settled + pending;
+    }
+
+    Async::Task<> store(Later& later, int& result)
+    {
+        result = co_await sum(later);
+    }
+
+    Async::Task<std::string> failing()
+    {
+        try
+        {
+            co_await Async::Promise<int>::rejected(std::runtime_error("refused"));
+        }
+        catch (const std::runtime_error& e)
+        {
+            co_return e.what();
+        }
+        co_return "not thrown";
+    }
+
+    Async::Task<> storeFailure(std::string& result) { result = co_await failing(); }
+}
+
+TEST(coroutine_test, awaits_settled_and_pending_promises)
+{
+    Later later;
+    int result = 0;
+
+    auto task = store(later, result);
+    EXPECT_FALSE(task.isDone());
+
+    later.join();
+    EXPECT_TRUE(task.isDone());
+    EXPECT_EQ(result, 3);
+}
+
+TEST(coroutine_test, rethrows_rejections)
+{
+    std::string result;
+    auto task = storeFailure(result);
+
+    EXPECT_TRUE(task.isDone());
+    EXPECT_EQ(result, "refused");
+}
+
+TEST(coroutine_test, carries_on_once_dropped)
+{
+    Later later;
+    int result = 0;
+
+    store(later, result);
+    EXPECT_EQ(result, 0);
+
+    later.join();
+    EXPECT_EQ(result, 3);
+}
+
+namespace
+{
+    class CoroutineEndpoint
+    {
+    public:
+        Async::Task<> handle(Rest::Request request, Http::ResponseWriter response)
+        {
+            const auto thread = std::this_thread::get_id();
+            const int value   = co_await later.value(42);
+
+            // The request was taken by value, still there once resumed
+            co_await response.send(Http::Code::Ok,
+                                   request.resource() + " " + std::to_string(value)
+                                       + (std::this_thread::get_id() == thread ? " resumed in place"
+                                                                                : " resumed elsewhere"));
+        }
+
+        Later later;
+    };
+}
+
+// The handler resumes in its worker's thread, whichever thread settled
+// what it awaited
+TEST(coroutine_test, route_handlers_resume_in_their_worker)
+{
+    CoroutineEndpoint endpoint;
+
+    Rest::Router router;
+    Rest::Routes::Get(router, "/value", Rest::Routes::bind(&CoroutineEndpoint::handle, &endpoint));
+
+    Http::Endpoint server(Address("localhost", Port(0)));
+    server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr).threads(2));
+    server.setHandler(router.handler());
+    server.serveThreaded();
+
+    httplib::Client client("localhost", server.getPort());
+    for (int i = 0; i < 4; ++i)
+    {
+        auto res = client.Get("/value");
+        ASSERT_TRUE(res);
+        EXPECT_EQ(res->status, 200);
+        EXPECT_EQ(res->body, "/value 42 resumed in place");
+    }
+
+    server.shutdown();
+    endpoint.later.join();
+}
+
+#else
+
+TEST(coroutine_test, requires_cpp20)
+{
+    GTEST_SKIP() << "Coroutines need C++20";
+}
+
+#endif // __cpp_impl_coroutine
@@ -0,0 +1,445 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/compression.h>
+#include <pistache/endpoint.h>
+#include <pistache/file_cache.h>
+#include <pistache/http.h>
+
+#include <curl/curl.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Pistache;
+using namespace std::chrono_literals;
+
+namespace
+{
+    struct TempFile
+    {
+        explicit TempFile(const std::string& data, const std::string& extension = ".txt")
+            : path((std::filesystem::temp_directory_path()
+                    / ("pistache_file_cache_" + std::to_string(std::random_device {}()) + extension))
+                       .string())
+        {
+            write(data);
+        }
+
+        ~TempFile() { std::filesystem::remove(path); }
+
+        void write(const std::string& data) const
+        {
+            std::ofstream file(path, std::ios::trunc);
+            file << data;
+        }
+
+        std::string path;
+    };
+
+    struct StaticFileHandler : public Http::Handler
+    {
+        HTTP_PROTOTYPE(StaticFileHandler)
+
+        explicit StaticFileHandler(const std::string& fileName)
+            : fileName_(fileName)
+        { }
+
+        void onRequest(const Http::Request& request,
+                       Http::ResponseWriter writer) override
+        {
+            Http::serveFile(writer, request, fileName_)
+                .then([](PST_SSIZE_T) {}, Async::IgnoreException);
+        }
+
+    private:
+        std::string fileName_;
+    };
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+    // Has serveFile compress the file itself
+    struct CompressingFileHandler : public Http::Handler
+    {
+        HTTP_PROTOTYPE(CompressingFileHandler)
+
+        explicit CompressingFileHandler(const std::string& fileName)
+            : fileName_(fileName)
+        { }
+
+        void onRequest(const Http::Request& request,
+                       Http::ResponseWriter writer) override
+        {
+            writer.setCompression(Http::Header::Encoding::Deflate);
+            Http::serveFile(writer, request, fileName_)
+                .then([](PST_SSIZE_T) {}, Async::IgnoreException);
+        }
+
+    private:
+        std::string fileName_;
+    };
+#endif
+
+    size_t discard(void*, size_t size, size_t nmemb, void*) { return size * nmemb; }
+
+    size_t append(void* data, size_t size, size_t nmemb, void* out)
+    {
+        static_cast<std::string*>(out)->append(static_cast<const char*>(data), size * nmemb);
+        return size * nmemb;
+    }
+}
+
+TEST(file_cache_test, hits_and_misses)
+{
+    TempFile file("hello");
+    Http::FileCache cache(4);
+
+    auto first = cache.get(file.path);
+    EXPECT_EQ(first->size, 5u);
+    EXPECT_FALSE(first->etag.empty());
+    EXPECT_EQ(first->mime, MIME(Text, Plain));
+
+    auto second = cache.get(file.path);
+    EXPECT_EQ(first, second);
+
+    const auto stats = cache.stats();
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(cache.size(), 1u);
+
+    EXPECT_THROW(cache.get(file.path + ".missing"), Http::HttpError);
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST(file_cache_test, least_recently_used_is_evicted)
+{
+    TempFile a("a"), b("b"), c("c");
+    Http::FileCache cache(2);
+
+    cache.get(a.path);
+    cache.get(b.path);
+    cache.get(a.path); // b is now the least recently used
+    cache.get(c.path);
+
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_EQ(cache.stats().evictions, 1u);
+
+    cache.get(a.path);
+    EXPECT_EQ(cache.stats().hits, 2u);
+    cache.get(b.path);
+    EXPECT_EQ(cache.stats().misses, 4u);
+}
+
+TEST(file_cache_test, entries_expire_after_ttl)
+{
+    TempFile file("hello");
+    Http::FileCache cache(4, 50ms);
+
+    auto first = cache.get(file.path);
+    std::this_thread::sleep_for(100ms);
+    auto second = cache.get(file.path);
+
+    EXPECT_NE(first, second);
+    EXPECT_EQ(cache.stats().misses, 2u);
+    EXPECT_EQ(cache.stats().evictions, 1u);
+}
+
+TEST(file_cache_test, zero_capacity_caches_nothing)
+{
+    TempFile file("hello");
+    Http::FileCache cache(0);
+
+    cache.get(file.path);
+    cache.get(file.path);
+
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_EQ(cache.stats().misses, 2u);
+}
+
+TEST(file_cache_test, explicit_invalidation)
+{
+    TempFile file("hello");
+    Http::FileCache cache(4);
+
+    auto first = cache.get(file.path);
+    file.write("hello, world");
+    cache.invalidate(file.path);
+
+    auto second = cache.get(file.path);
+    EXPECT_EQ(second->size, 12u);
+    EXPECT_EQ(cache.stats().invalidations, 1u);
+
+    // The evicted file stays open for whoever still holds it
+    char byte = 0;
+    EXPECT_EQ(::pread(first->file->fd(), &byte, 1, 0), 1);
+    EXPECT_EQ(byte, 'h');
+}
+
+#ifdef __linux__
+TEST(file_cache_test, modified_file_is_invalidated)
+{
+    TempFile file("hello");
+    Http::FileCache cache(4, std::chrono::hours(1));
+
+    EXPECT_EQ(cache.get(file.path)->size, 5u);
+    file.write("hello, world");
+
+    // inotify is read at most once a millisecond
+    std::this_thread::sleep_for(2ms);
+    EXPECT_EQ(cache.get(file.path)->size, 12u);
+    EXPECT_GE(cache.stats().invalidations, 1u);
+
+    std::filesystem::remove(file.path);
+    std::this_thread::sleep_for(2ms);
+    EXPECT_THROW(cache.get(file.path), Http::HttpError);
+}
+#endif
+
+TEST(file_cache_test, hits_from_several_threads)
+{
+    TempFile a("a"), b("b"), c("c");
+    Http::FileCache cache(2);
+
+    const auto first = cache.get(a.path);
+    cache.get(b.path);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; ++i)
+                EXPECT_EQ(cache.get(a.path), first);
+        });
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_EQ(cache.stats().hits, 4000u);
+    EXPECT_EQ(cache.stats().misses, 2u);
+
+    // Hits count as uses: b goes first
+    cache.get(c.path);
+    cache.get(a.path);
+    EXPECT_EQ(cache.stats().hits, 4001u);
+    EXPECT_EQ(cache.stats().evictions, 1u);
+}
+
+TEST(file_cache_test, missing_files_are_found_missing_until_ttl)
+{
+    TempFile file("hello");
+    const auto missing = file.path + ".gz";
+    Http::FileCache cache(4, 50ms);
+
+    EXPECT_EQ(cache.find(missing), nullptr);
+    EXPECT_EQ(cache.find(missing), nullptr);
+    EXPECT_EQ(cache.stats().hits, 1u);
+    EXPECT_THROW(cache.get(missing), Http::HttpError);
+
+    TempFile sibling("");
+    std::filesystem::rename(sibling.path, missing);
+    sibling.path = missing;
+    std::this_thread::sleep_for(100ms);
+
+    auto found = cache.find(missing);
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(found->size, 0u);
+}
+
+// A precompressed sibling is served as is to clients accepting its
+// encoding, unless it is older than the file
+TEST(file_cache_test, precompressed_sibling_is_served)
+{
+    TempFile file(std::string(1000, 'x'), ".html");
+    TempFile sibling("not really gzip");
+    std::filesystem::rename(sibling.path, file.path + ".gz");
+    sibling.path = file.path + ".gz";
+
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr).threads(1));
+    server.setHandler(Http::make_handler<StaticFileHandler>(file.path));
+    server.serveThreaded();
+
+    const std::string url = "http://localhost:" + server.getPort().toString() + "/";
+
+    auto get = [&](const char* acceptEncoding, std::string& headers) {
+        CURL* curl                = curl_easy_init();
+        struct curl_slist* fields = curl_slist_append(nullptr, acceptEncoding);
+
+        std::string body;
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, fields);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &append);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, &append);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &headers);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+        EXPECT_EQ(curl_easy_perform(curl), CURLE_OK);
+
+        curl_slist_free_all(fields);
+        curl_easy_cleanup(curl);
+        return body;
+    };
+
+    std::string headers;
+    EXPECT_EQ(get("Accept-Encoding: br, gzip;q=0.5", headers), "not really gzip");
+    EXPECT_NE(headers.find("Content-Encoding: gzip"), std::string::npos);
+    EXPECT_NE(headers.find("Vary: Accept-Encoding"), std::string::npos);
+
+    headers.clear();
+    EXPECT_EQ(get("Accept-Encoding: identity", headers), std::string(1000, 'x'));
+    EXPECT_EQ(headers.find("Content-Encoding"), std::string::npos);
+
+    std::filesystem::last_write_time(sibling.path,
+                                     std::filesystem::last_write_time(file.path) - std::chrono::hours(1));
+    Http::FileCache::instance().clear();
+
+    headers.clear();
+    EXPECT_EQ(get("Accept-Encoding: gzip", headers), std::string(1000, 'x'));
+    EXPECT_EQ(headers.find("Content-Encoding"), std::string::npos);
+
+    server.shutdown();
+}
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+// A file serveFile compresses is only compressed once a body is to be
+// sent: not to answer a HEAD, nor a request its validators turn into a 304
+TEST(file_cache_test, files_are_compressed_only_to_be_sent)
+{
+    TempFile file(std::string(10000, 'x'), ".html");
+
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr).threads(1));
+    server.setHandler(Http::make_handler<CompressingFileHandler>(file.path));
+    server.serveThreaded();
+
+    const std::string url = "http://localhost:" + server.getPort().toString() + "/";
+
+    auto perform = [&](bool head, const std::string& field, std::string& headers) {
+        CURL* curl                = curl_easy_init();
+        struct curl_slist* fields = field.empty() ? nullptr : curl_slist_append(nullptr, field.c_str());
+
+        std::string body;
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_NOBODY, head ? 1L : 0L);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, fields);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &append);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, &append);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &headers);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+        EXPECT_EQ(curl_easy_perform(curl), CURLE_OK);
+
+        long code = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+        EXPECT_TRUE(head || code != 200 || !body.empty());
+
+        curl_slist_free_all(fields);
+        curl_easy_cleanup(curl);
+        return code;
+    };
+
+    auto etagOf = [](const std::string& headers) {
+        const auto start = headers.find("ETag: ");
+        if (start == std::string::npos)
+            return std::string();
+        return headers.substr(start + 6, headers.find("\r\n", start) - start - 6);
+    };
+
+    auto& cache       = Http::CompressedCache::instance();
+    const auto cached = cache.size();
+
+    std::string headers;
+    EXPECT_EQ(perform(true, "", headers), 200);
+    EXPECT_NE(headers.find("Content-Encoding: deflate"), std::string::npos);
+    EXPECT_EQ(headers.find("Content-Length"), std::string::npos);
+    const auto etag = etagOf(headers);
+    ASSERT_FALSE(etag.empty());
+    EXPECT_EQ(cache.size(), cached);
+
+    headers.clear();
+    EXPECT_EQ(perform(false, "If-None-Match: " + etag, headers), 304);
+    EXPECT_EQ(cache.size(), cached);
+
+    headers.clear();
+    EXPECT_EQ(perform(false, "", headers), 200);
+    EXPECT_EQ(etagOf(headers), etag);
+    EXPECT_EQ(cache.size(), cached + 1);
+
+    // Now that it is known, a HEAD gets its length
+    headers.clear();
+    EXPECT_EQ(perform(true, "", headers), 200);
+    EXPECT_NE(headers.find("Content-Length"), std::string::npos);
+
+    server.shutdown();
+}
+#endif
+
+// Serves one small file over keep-alive connections, with and without the
+// cache, and reports the throughput of both
+TEST(file_cache_test, static_file_throughput)
+{
+    TempFile file(std::string(4096, 'x'), ".html");
+
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr).threads(2));
+    server.setHandler(Http::make_handler<StaticFileHandler>(file.path));
+    server.serveThreaded();
+
+    const std::string url = "http://localhost:" + server.getPort().toString() + "/";
+
+    auto run = [&](size_t requests) {
+        CURL* curl = curl_easy_init();
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &discard);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+
+        size_t ok        = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < requests; ++i)
+        {
+            long code = 0;
+            if (curl_easy_perform(curl) == CURLE_OK)
+                curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+            ok += code == 200;
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        curl_easy_cleanup(curl);
+
+        EXPECT_EQ(ok, requests);
+        return static_cast<double>(requests) / elapsed.count();
+    };
+
+    auto& cache           = Http::FileCache::instance();
+    const auto capacity   = cache.capacity();
+    const size_t REQUESTS = 2000;
+
+    cache.setCapacity(0);
+    const double uncached = run(REQUESTS);
+
+    cache.setCapacity(capacity);
+    const auto before = cache.stats();
+    const double cached = run(REQUESTS);
+    const auto after    = cache.stats();
+
+    server.shutdown();
+
+    std::cout << "static file throughput: " << uncached << " req/s uncached, "
+              << cached << " req/s cached" << std::endl;
+
+    EXPECT_GE(after.hits - before.hits, REQUESTS - 1);
+}
@@ -13,7 +13,9 @@
 #include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <optional>
 #include <sstream>
+#include <thread>
 
 using testing::ElementsAre;
 using testing::SizeIs;
@@ -1141,4 +1143,98 @@ TEST(headers_test, etag_test)
             },
             ThrowsMessage<std::runtime_error>("Invalid ETag format: etagc must contain chars in a range of 0x21 / 0x23-0x7E / 0x80-0xFF"));
     }
-}
\ No newline at end of file
+}
+TEST(headers_test, received_headers_are_parsed_on_demand)
+{
+    Pistache::Http::Header::Collection headers;
+    headers.addReceived("content-length", "42");
+    headers.addReceived("X-Custom", "some value");
+
+    ASSERT_TRUE(headers.has<Pistache::Http::Header::ContentLength>());
+    ASSERT_FALSE(headers.has<Pistache::Http::Header::Host>());
+
+    // Parsed once, then memoized
+    const auto contentLength = headers.tryGet<Pistache::Http::Header::ContentLength>();
+    ASSERT_TRUE(contentLength);
+    ASSERT_EQ(contentLength->value(), 42u);
+    ASSERT_EQ(headers.tryGet<Pistache::Http::Header::ContentLength>(), contentLength);
+
+    ASSERT_EQ(headers.getRaw("x-custom").value(), "some value");
+    ASSERT_EQ(headers.rawList().size(), 2u);
+    ASSERT_EQ(headers.list().size(), 1u);
+}
+
+TEST(headers_test, received_headers_survive_copies)
+{
+    std::optional<Pistache::Http::Header::Collection> copy;
+    {
+        Pistache::Http::Header::Collection headers;
+        headers.addReceived("Host", "localhost:8080");
+        headers.addReceived("X-Custom", "some value");
+        copy = headers;
+    }
+
+    const auto host = copy->get<Pistache::Http::Header::Host>();
+    ASSERT_EQ(host->host(), "localhost");
+    ASSERT_EQ(copy->getRaw("X-Custom").value(), "some value");
+}
+
+// Each header is parsed once, whichever thread asks for it first
+TEST(headers_test, received_headers_can_be_read_from_several_threads)
+{
+    Pistache::Http::Header::Collection collection;
+    collection.addReceived("Host", "localhost:8080");
+    collection.addReceived("Content-Length", "42");
+    collection.addReceived("User-Agent", "test");
+    collection.addReceived("X-Custom", "some value");
+    const auto& headers = collection;
+
+    std::vector<std::thread> readers;
+    std::vector<std::shared_ptr<const Pistache::Http::Header::ContentLength>> seen(8);
+    for (size_t i = 0; i < seen.size(); ++i)
+    {
+        readers.emplace_back([&headers, &seen, i] {
+            EXPECT_TRUE(headers.has<Pistache::Http::Header::UserAgent>());
+            EXPECT_EQ(headers.get<Pistache::Http::Header::Host>()->host(), "localhost");
+            EXPECT_EQ(headers.getRaw("x-custom").value(), "some value");
+            EXPECT_EQ(headers.rawList().size(), 4u);
+            seen[i] = headers.tryGet<Pistache::Http::Header::ContentLength>();
+            const Pistache::Http::Header::Collection copy(headers);
+            EXPECT_EQ(copy.list().size(), 3u);
+        });
+    }
+    for (auto& reader : readers)
+        reader.join();
+
+    for (const auto& contentLength : seen)
+        EXPECT_EQ(contentLength, seen.front());
+}
+
+TEST(headers_test, first_received_header_wins)
+{
+    Pistache::Http::Header::Collection headers;
+    headers.addReceived("Host", "first");
+    headers.addReceived("host", "second");
+    ASSERT_EQ(headers.getRaw("HOST").value(), "first");
+
+    // As when headers were added as they were parsed
+    headers.add<Pistache::Http::Header::Host>("third");
+    headers.addRaw(Pistache::Http::Header::Raw("Host", "fourth"));
+    ASSERT_EQ(headers.get<Pistache::Http::Header::Host>()->host(), "first");
+    ASSERT_EQ(headers.getRaw("Host").value(), "first");
+
+    // Later headers still go after the others
+    headers.addReceived("X-Late", "late");
+    ASSERT_EQ(headers.getRaw("x-late").value(), "late");
+    ASSERT_EQ(headers.rawList().size(), 2u);
+}
+
+TEST(headers_test, malformed_received_header_throws_when_asked_for)
+{
+    Pistache::Http::Header::Collection headers;
+    ASSERT_NO_THROW(headers.addReceived("Content-Type", "not a media type"));
+
+    ASSERT_TRUE(headers.has<Pistache::Http::Header::ContentType>());
+    ASSERT_ANY_THROW(headers.tryGet<Pistache::Http::Header::ContentType>());
+    ASSERT_EQ(headers.getRaw("Content-Type").value(), "not a media type");
+}
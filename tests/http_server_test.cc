@@ -30,17 +30,26 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <ctime>
+#include <deque>
+#include <filesystem>
 #include <fstream>
 #include <future>
+#include <memory>
 #include <mutex>
 #include <numeric>
 #include <random>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <vector>
+
+#include <curl/curl.h>
+#include <strings.h>
 
 #include "helpers/fd_utils.h"
 #include "tcp_client.h"
@@ -173,6 +182,27 @@ private:
     std::string fileName_;
 };
 
+// Like FileHandler, but passing the request on so that its Range and
+// conditional headers are honoured
+struct RangeFileHandler : public Http::Handler
+{
+    HTTP_PROTOTYPE(RangeFileHandler)
+
+    explicit RangeFileHandler(const std::string& fileName)
+        : fileName_(fileName)
+    { }
+
+    void onRequest(const Http::Request& request,
+                   Http::ResponseWriter writer) override
+    {
+        Http::serveFile(writer, request, fileName_, MIME(Text, Plain))
+            .then([](PST_SSIZE_T) {}, Async::IgnoreException);
+    }
+
+private:
+    std::string fileName_;
+};
+
 struct AddressEchoHandler : public Http::Handler
 {
     HTTP_PROTOTYPE(AddressEchoHandler)
@@ -277,6 +307,97 @@ int clientLogicFunc(size_t response_size, const std::string& server_page,
     return resolver_counter;
 }
 
+// Arms a response timeout on every request. /slow never answers, so that
+// the timeout fires; every other page answers right away, which disarms it
+struct ResponseTimeoutHandler : public Http::Handler
+{
+    HTTP_PROTOTYPE(ResponseTimeoutHandler)
+
+    void onRequest(const Http::Request& request,
+                   Http::ResponseWriter writer) override
+    {
+        // Armed where it is kept, Timeout must not be moved once armed
+        auto kept = std::make_unique<Http::ResponseWriter>(std::move(writer));
+        if (request.resource() == "/slow")
+        {
+            kept->timeoutAfter(std::chrono::milliseconds(300));
+
+            std::lock_guard<std::mutex> guard(pending_->lock);
+            pending_->writers.push_back(std::move(kept));
+        }
+        else
+        {
+            // Would fire before /slow's, were it not disarmed
+            kept->timeoutAfter(std::chrono::milliseconds(100));
+            kept->send(Http::Code::Ok, "fast");
+        }
+    }
+
+    // The request is not available any more by then, the peer's parser has
+    // moved on, so only the number of timeouts is checked
+    void onTimeout(const Http::Request& /*request*/,
+                   Http::ResponseWriter writer) override
+    {
+        ++timeouts;
+        writer.send(Http::Code::Request_Timeout, "Timeout");
+    }
+
+    static inline std::atomic<int> timeouts { 0 };
+
+    // Shared by the handler's clones
+    struct Pending
+    {
+        std::mutex lock;
+        std::vector<std::unique_ptr<Http::ResponseWriter>> writers;
+    };
+    std::shared_ptr<Pending> pending_ = std::make_shared<Pending>();
+};
+
+TEST(http_server_test, response_timeouts_fire_unless_disarmed)
+{
+    PS_TIMEDBG_START;
+
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    auto flags       = Tcp::Options::ReuseAddr;
+    auto server_opts = Http::Endpoint::options().flags(flags);
+    server.init(server_opts);
+    server.setHandler(Http::make_handler<ResponseTimeoutHandler>());
+    server.serveThreaded();
+
+    const std::string server_address = "localhost:" + server.getPort().toString();
+
+    // Plenty of timeouts armed and disarmed before the slow one
+    const int FAST_REQUESTS = 200;
+    ASSERT_EQ(clientLogicFunc(FAST_REQUESTS, server_address + "/fast", 5, 10),
+              FAST_REQUESTS);
+
+    Http::Experimental::Client client;
+    client.init();
+
+    const auto start = std::chrono::steady_clock::now();
+    auto response    = client.get(server_address + "/slow")
+                        .timeout(std::chrono::seconds(5))
+                        .send();
+
+    Http::Code code = Http::Code::Ok;
+    response.then([&code](Http::Response resp) { code = resp.code(); },
+                  Async::IgnoreException);
+
+    Async::Barrier<Http::Response> barrier(response);
+    barrier.wait_for(std::chrono::seconds(5));
+
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    client.shutdown();
+    server.shutdown();
+
+    ASSERT_EQ(code, Http::Code::Request_Timeout);
+    ASSERT_GE(elapsed, std::chrono::milliseconds(300));
+    ASSERT_EQ(ResponseTimeoutHandler::timeouts.load(), 1);
+}
+
 TEST(http_server_test,
      client_disconnection_on_timeout_from_single_threaded_server)
 {
@@ -494,6 +615,558 @@ TEST(http_server_test, many_client_with_requests_to_multithreaded_server)
 #endif
 }
 
+// Hands every response over to a pool of application threads, so that the
+// sends for different peers are issued concurrently and off the reactor
+class ResponderPool
+{
+public:
+    explicit ResponderPool(size_t threads)
+    {
+        for (size_t i = 0; i < threads; ++i)
+            threads_.emplace_back([this] { run(); });
+    }
+
+    ~ResponderPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& thread : threads_)
+            thread.join();
+    }
+
+    void push(Http::ResponseWriter writer)
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            writers_.push_back(std::move(writer));
+        }
+        cv_.notify_one();
+    }
+
+private:
+    void run()
+    {
+        for (;;)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stop_ || !writers_.empty(); });
+            if (writers_.empty())
+                return;
+
+            auto writer = std::move(writers_.front());
+            writers_.pop_front();
+            lock.unlock();
+
+            writer.send(Http::Code::Ok, "Hello, World!");
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Http::ResponseWriter> writers_;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+};
+
+struct OffloadingHandler : public Http::Handler
+{
+    HTTP_PROTOTYPE(OffloadingHandler)
+
+    explicit OffloadingHandler(std::shared_ptr<ResponderPool> pool)
+        : pool_(std::move(pool))
+    { }
+
+    void onRequest(const Http::Request& /*request*/,
+                   Http::ResponseWriter writer) override
+    {
+        pool_->push(std::move(writer));
+    }
+
+    std::shared_ptr<ResponderPool> pool_;
+};
+
+// Many peers being written to from several application threads at once;
+// also reports the throughput, to compare write-path changes against
+TEST(http_server_test, many_clients_with_responses_sent_from_app_threads)
+{
+    PS_TIMEDBG_START;
+
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    auto flags       = Tcp::Options::ReuseAddr;
+    auto server_opts = Http::Endpoint::options().flags(flags).threads(4);
+    server.init(server_opts);
+
+    const size_t PRODUCER_THREADS = 8;
+    server.setHandler(Http::make_handler<OffloadingHandler>(
+        std::make_shared<ResponderPool>(PRODUCER_THREADS)));
+    ASSERT_NO_THROW(server.serveThreaded());
+
+    const std::string server_address = "localhost:" + server.getPort().toString();
+
+    const int NO_TIMEOUT          = 0;
+    const int SECONDS_TIMOUT      = 30;
+    const int CLIENTS             = 8;
+    const int CLIENT_REQUEST_SIZE = 250;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < CLIENTS; ++i)
+        results.push_back(std::async(std::launch::async, clientLogicFunc,
+                                     CLIENT_REQUEST_SIZE, server_address,
+                                     NO_TIMEOUT, SECONDS_TIMOUT));
+
+    int total = 0;
+    for (auto& result : results)
+        total += result.get();
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    server.shutdown();
+
+    LOGGER("test", total << " responses from " << PRODUCER_THREADS
+                         << " producer threads in " << elapsed.count() << "ms");
+
+    ASSERT_EQ(total, CLIENTS * CLIENT_REQUEST_SIZE);
+}
+
+// Answers /slow from another thread after a delay, everything else at once
+// with the resource as body
+struct SlowFirstHandler : public Http::Handler
+{
+    HTTP_PROTOTYPE(SlowFirstHandler)
+
+    void onRequest(const Http::Request& request,
+                   Http::ResponseWriter writer) override
+    {
+        if (request.resource() != "/slow")
+        {
+            writer.send(Http::Code::Ok, request.resource());
+            return;
+        }
+
+        std::thread([writer = std::move(writer)]() mutable {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            writer.send(Http::Code::Ok, "/slow");
+        }).detach();
+    }
+};
+
+// Requests sent in one write are all answered, in the order they were sent,
+// even when the first one is answered last
+TEST(http_server_test, pipelined_requests_are_answered_in_order)
+{
+    PS_TIMEDBG_START;
+
+    Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr));
+    server.setHandler(Http::make_handler<SlowFirstHandler>());
+    server.serveThreaded();
+
+    TcpClient client;
+    ASSERT_TRUE(client.connect(Pistache::Address("localhost", server.getPort())))
+        << client.lastError();
+
+    const std::vector<std::string> resources = { "/slow", "/a", "/b", "/c" };
+    std::string requests;
+    for (const auto& resource : resources)
+        requests += "GET " + resource + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ASSERT_TRUE(client.send(requests)) << client.lastError();
+
+    std::string received;
+    char buffer[1024];
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (received.find(resources.back()) == std::string::npos
+           && std::chrono::steady_clock::now() < deadline)
+    {
+        size_t bytes = 0;
+        if (client.receive(buffer, sizeof buffer, &bytes, std::chrono::seconds(1)))
+            received.append(buffer, bytes);
+    }
+
+    server.shutdown();
+
+    size_t offset = 0;
+    for (const auto& resource : resources)
+    {
+        const auto status = received.find("HTTP/1.1 200 OK", offset);
+        ASSERT_NE(status, std::string::npos) << "no response for " << resource;
+        const auto body = received.find("\r\n\r\n", status);
+        ASSERT_NE(body, std::string::npos);
+        EXPECT_EQ(received.compare(body + 4, resource.size(), resource), 0)
+            << "expected " << resource << " in " << received.substr(status);
+        offset = body + 4 + resource.size();
+    }
+    EXPECT_EQ(offset, received.size());
+}
+
+// Keeps each writer around once it has sent its response
+struct KeepingHandler : public Http::Handler
+{
+    HTTP_PROTOTYPE(KeepingHandler)
+
+    static std::mutex& lock()
+    {
+        static std::mutex lock;
+        return lock;
+    }
+
+    static std::vector<Http::ResponseWriter>& kept()
+    {
+        static std::vector<Http::ResponseWriter> kept;
+        return kept;
+    }
+
+    void onRequest(const Http::Request& request,
+                   Http::ResponseWriter writer) override
+    {
+        writer.send(Http::Code::Ok, request.resource());
+
+        std::lock_guard<std::mutex> guard(lock());
+        kept().push_back(std::move(writer));
+    }
+};
+
+// A response does not wait for the writer of the one before to be gone,
+// only for it to have been sent
+TEST(http_server_test, response_does_not_wait_for_previous_writer)
+{
+    Http::Endpoint server(Pistache::Address("localhost", Pistache::Port(0)));
+    server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr));
+    server.setHandler(Http::make_handler<KeepingHandler>());
+    server.serveThreaded();
+
+    TcpClient client;
+    ASSERT_TRUE(client.connect(Pistache::Address("localhost", server.getPort())))
+        << client.lastError();
+
+    for (const std::string resource : { "/first", "/second" })
+    {
+        ASSERT_TRUE(client.send("GET " + resource + " HTTP/1.1\r\nHost: localhost\r\n\r\n"))
+            << client.lastError();
+
+        std::string received;
+        char buffer[1024];
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (received.find(resource) == std::string::npos
+               && std::chrono::steady_clock::now() < deadline)
+        {
+            size_t bytes = 0;
+            if (client.receive(buffer, sizeof buffer, &bytes, std::chrono::milliseconds(200)))
+                received.append(buffer, bytes);
+        }
+        EXPECT_NE(received.find("HTTP/1.1 200 OK"), std::string::npos) << "no response for " << resource;
+        EXPECT_NE(received.find(resource), std::string::npos) << received;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(KeepingHandler::lock());
+        EXPECT_EQ(KeepingHandler::kept().size(), 2u);
+        KeepingHandler::kept().clear();
+    }
+    server.shutdown();
+}
+
+struct GatheringHandler : public Http::Handler
+{
+    HTTP_PROTOTYPE(GatheringHandler)
+
+    // Bodies of 4 MiB, larger than the socket buffers, and a small one
+    static std::string body(const std::string& resource)
+    {
+        if (resource == "/small")
+            return "small";
+
+        std::string body(4 * 1024 * 1024, '\0');
+        for (size_t i = 0; i < body.size(); ++i)
+            body[i] = static_cast<char>('a' + (i + resource.size()) % 26);
+        return body;
+    }
+
+    // Held here and by the writes sending it, until they are done with it
+    static const std::shared_ptr<const std::string>& shared()
+    {
+        static const auto shared = std::make_shared<const std::string>(body("/shared"));
+        return shared;
+    }
+
+    void onRequest(const Http::Request& request,
+                   Http::ResponseWriter writer) override
+    {
+        const auto& resource = request.resource();
+        if (resource == "/shared")
+        {
+            writer.send(Http::Code::Ok, shared());
+        }
+        else if (resource == "/copied")
+        {
+            const auto copied = body(resource);
+            writer.send(Http::Code::Ok, copied.data(), copied.size());
+        }
+        else
+        {
+            writer.send(Http::Code::Ok, body(resource));
+        }
+    }
+};
+
+// Requests all of GatheringHandler's bodies at once from a server with
+// options, and checks they are all received whole and in order. Then
+// calls whileServing, before the server shuts down
+void expectGatheredBodies(const Http::Endpoint::Options& options,
+                          const std::function<void()>& whileServing = {})
+{
+    Http::Endpoint server(Pistache::Address("localhost", Pistache::Port(0)));
+    server.init(options);
+    server.setHandler(Http::make_handler<GatheringHandler>());
+    server.serveThreaded();
+
+    TcpClient client;
+    ASSERT_TRUE(client.connect(Pistache::Address("localhost", server.getPort())))
+        << client.lastError();
+
+    const std::vector<std::string> resources = { "/moved", "/small", "/shared", "/copied" };
+    std::string requests;
+    for (const auto& resource : resources)
+        requests += "GET " + resource + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ASSERT_TRUE(client.send(requests)) << client.lastError();
+
+    // Not reading for a while fills the socket buffers up
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    size_t expected = 0;
+    for (const auto& resource : resources)
+        expected += GatheringHandler::body(resource).size();
+
+    std::string received;
+    std::vector<char> buffer(64 * 1024);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (received.size() < expected && std::chrono::steady_clock::now() < deadline)
+    {
+        size_t bytes = 0;
+        if (client.receive(buffer.data(), buffer.size(), &bytes, std::chrono::seconds(1)))
+            received.append(buffer.data(), bytes);
+    }
+
+    if (whileServing)
+        whileServing();
+
+    server.shutdown();
+
+    size_t offset = 0;
+    for (const auto& resource : resources)
+    {
+        const auto body = GatheringHandler::body(resource);
+
+        const auto status = received.find("HTTP/1.1 200 OK", offset);
+        ASSERT_EQ(status, offset) << "no response for " << resource;
+        const auto headersEnd = received.find("\r\n\r\n", status);
+        ASSERT_NE(headersEnd, std::string::npos);
+
+        const auto headers = received.substr(status, headersEnd - status);
+        EXPECT_NE(headers.find("Content-Length: " + std::to_string(body.size())),
+                  std::string::npos)
+            << headers;
+
+        ASSERT_GE(received.size(), headersEnd + 4 + body.size()) << resource;
+        EXPECT_EQ(received.compare(headersEnd + 4, body.size(), body), 0) << resource;
+        offset = headersEnd + 4 + body.size();
+    }
+    EXPECT_EQ(offset, received.size());
+}
+
+// Bodies moved in, shared or too large to be copied behind the headers are
+// sent as buffers of their own, resumed where they stopped when the peer
+// does not keep up
+TEST(http_server_test, gathered_bodies_are_sent_whole_and_in_order)
+{
+    PS_TIMEDBG_START;
+
+    expectGatheredBodies(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr));
+}
+
+// The same with the workers polling with io_uring, where there is one
+TEST(http_server_test, io_uring_backend_sends_bodies_whole_and_in_order)
+{
+    PS_TIMEDBG_START;
+
+    expectGatheredBodies(Http::Endpoint::options()
+                             .flags(Tcp::Options::ReuseAddr)
+                             .pollBackend(Polling::Backend::IoUring));
+}
+
+// The same with MSG_ZEROCOPY, where there is one. The shared body is held
+// on to until the kernel reports it is done with it, and no longer: not
+// only once the connection is closed
+TEST(http_server_test, zero_copy_bodies_are_sent_whole_and_released)
+{
+    PS_TIMEDBG_START;
+
+    expectGatheredBodies(Http::Endpoint::options()
+                             .flags(Tcp::Options::ReuseAddr)
+                             .zeroCopyThreshold(64 * 1024),
+                         [] {
+                             const auto deadline = std::chrono::steady_clock::now()
+                                 + std::chrono::seconds(5);
+                             while (GatheringHandler::shared().use_count() > 1
+                                    && std::chrono::steady_clock::now() < deadline)
+                                 std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+                             EXPECT_EQ(GatheringHandler::shared().use_count(), 1);
+                         });
+}
+
+// The server closes a connection, here on its keep-alive timeout, while
+// MSG_ZEROCOPY sends are still in flight as the client reads nothing: their
+// buffers are kept until the kernel reports them complete, then released
+// with the server still running, and the server goes on serving
+TEST(http_server_test, zero_copy_buffers_outlive_a_closed_connection)
+{
+    PS_TIMEDBG_START;
+
+    Http::Endpoint server(Pistache::Address("localhost", Pistache::Port(0)));
+    server.init(Http::Endpoint::options()
+                    .flags(Tcp::Options::ReuseAddr)
+                    .zeroCopyThreshold(64 * 1024)
+                    .keepaliveTimeout(std::chrono::milliseconds(100)));
+    server.setHandler(Http::make_handler<GatheringHandler>());
+    server.serveThreaded();
+
+    TcpClient client;
+    ASSERT_TRUE(client.connect(Pistache::Address("localhost", server.getPort())))
+        << client.lastError();
+    ASSERT_TRUE(client.send("GET /shared HTTP/1.1\r\nHost: localhost\r\n\r\n"))
+        << client.lastError();
+
+    // Idle peers are looked for every 500 ms
+    std::this_thread::sleep_for(std::chrono::milliseconds(1200));
+    EXPECT_GT(GatheringHandler::shared().use_count(), 1);
+
+    // What was sent before the close comes whole, up to the end of stream
+    std::string received;
+    std::vector<char> buffer(64 * 1024);
+    for (;;)
+    {
+        size_t bytes = 0;
+        ASSERT_TRUE(client.receive(buffer.data(), buffer.size(), &bytes, std::chrono::seconds(5)))
+            << client.lastError();
+        if (bytes == 0)
+            break;
+        received.append(buffer.data(), bytes);
+    }
+    client.close();
+
+    const auto headersEnd = received.find("\r\n\r\n");
+    ASSERT_NE(headersEnd, std::string::npos);
+    const auto body = received.substr(headersEnd + 4);
+    EXPECT_FALSE(body.empty());
+    EXPECT_EQ(body, GatheringHandler::shared()->substr(0, body.size()));
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (GatheringHandler::shared().use_count() > 1
+           && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(GatheringHandler::shared().use_count(), 1);
+
+    TcpClient other;
+    ASSERT_TRUE(other.connect(Pistache::Address("localhost", server.getPort())))
+        << other.lastError();
+    ASSERT_TRUE(other.send("GET /small HTTP/1.1\r\nHost: localhost\r\n\r\n"))
+        << other.lastError();
+
+    size_t bytes = 0;
+    ASSERT_TRUE(other.receive(buffer.data(), buffer.size(), &bytes, std::chrono::seconds(5)))
+        << other.lastError();
+    const std::string small(buffer.data(), bytes);
+    EXPECT_EQ(small.rfind("HTTP/1.1 200 OK", 0), 0u) << small;
+    other.close();
+
+    server.shutdown();
+}
+
+struct BulkHandler : public Http::Handler
+{
+    HTTP_PROTOTYPE(BulkHandler)
+
+    static size_t bodySize() { return 16 * 1024 * 1024; }
+
+    void onRequest(const Http::Request& /*request*/,
+                   Http::ResponseWriter writer) override
+    {
+        static const auto bulk = std::make_shared<const std::string>(bodySize(), 'x');
+        writer.send(Http::Code::Ok, bulk);
+    }
+};
+
+// Logs the CPU time (of the whole process, i.e. the client reading too)
+// spent per GB of responses sent, with and without MSG_ZEROCOPY. Over the
+// loopback interface the kernel copies anyway: the gain is only to be seen
+// with a NIC sending from user pages
+TEST(http_server_test, zero_copy_cpu_per_gb_benchmark)
+{
+    PS_TIMEDBG_START;
+
+    constexpr size_t Responses = 16;
+
+    for (size_t threshold : { size_t(0), size_t(1024 * 1024) })
+    {
+        Http::Endpoint server(Pistache::Address("localhost", Pistache::Port(0)));
+        server.init(Http::Endpoint::options()
+                        .flags(Tcp::Options::ReuseAddr)
+                        .zeroCopyThreshold(threshold));
+        server.setHandler(Http::make_handler<BulkHandler>());
+        server.serveThreaded();
+
+        TcpClient client;
+        ASSERT_TRUE(client.connect(Pistache::Address("localhost", server.getPort())))
+            << client.lastError();
+
+        const std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        std::vector<char> buffer(256 * 1024);
+
+        const auto cpuBefore  = std::clock();
+        const auto wallBefore = std::chrono::steady_clock::now();
+
+        size_t received = 0;
+        for (size_t i = 0; i < Responses; ++i)
+        {
+            ASSERT_TRUE(client.send(request)) << client.lastError();
+
+            // The body, and headers of well under a KB
+            const size_t expected = (i + 1) * BulkHandler::bodySize();
+            while (received < expected)
+            {
+                size_t bytes = 0;
+                ASSERT_TRUE(client.receive(buffer.data(), buffer.size(), &bytes,
+                                           std::chrono::seconds(5)))
+                    << client.lastError();
+                received += bytes;
+            }
+        }
+
+        const auto cpuMs = static_cast<double>(std::clock() - cpuBefore) * 1e3 / CLOCKS_PER_SEC;
+        const auto wallUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - wallBefore)
+                                .count();
+
+        server.shutdown();
+
+        const double gb = static_cast<double>(received) / 1e9;
+        LOGGER("bench", (threshold ? "MSG_ZEROCOPY" : "copied")
+                            << ": " << cpuMs / gb << " ms CPU per GB, "
+                            << static_cast<double>(received) / static_cast<double>(wallUs)
+                            << " MB/s");
+    }
+}
+
 TEST(http_server_test,
      multiple_client_with_different_requests_to_multithreaded_server)
 {
@@ -673,6 +1346,161 @@ TEST(http_server_test, server_with_static_file)
 #endif
 }
 
+namespace
+{
+    size_t appendToString(void* contents, size_t size, size_t nmemb, void* userp)
+    {
+        static_cast<std::string*>(userp)->append(static_cast<char*>(contents), size * nmemb);
+        return size * nmemb;
+    }
+
+    struct CurlResult
+    {
+        long code = 0;
+        std::string headers;
+        std::string body;
+
+        std::string header(const std::string& name) const
+        {
+            std::istringstream iss(headers);
+            std::string line;
+            while (std::getline(iss, line))
+            {
+                if (line.size() > name.size() + 1
+                    && strncasecmp(line.c_str(), name.c_str(), name.size()) == 0
+                    && line[name.size()] == ':')
+                {
+                    auto value = line.substr(name.size() + 1);
+                    value.erase(0, value.find_first_not_of(' '));
+                    value.erase(value.find_last_not_of("\r\n ") + 1);
+                    return value;
+                }
+            }
+            return {};
+        }
+    };
+
+    CurlResult curlGet(const std::string& url, const std::vector<std::string>& headers)
+    {
+        CurlResult result;
+
+        CURL* curl                  = curl_easy_init();
+        struct curl_slist* reqHeaders = nullptr;
+        for (const auto& header : headers)
+            reqHeaders = curl_slist_append(reqHeaders, header.c_str());
+
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, reqHeaders);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &appendToString);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &result.body);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, &appendToString);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &result.headers);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+
+        if (curl_easy_perform(curl) == CURLE_OK)
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &result.code);
+
+        curl_slist_free_all(reqHeaders);
+        curl_easy_cleanup(curl);
+
+        return result;
+    }
+}
+
+TEST(http_server_test, server_with_static_file_ranges_and_conditionals)
+{
+    PS_TIMEDBG_START;
+
+    const auto fileName = (std::filesystem::temp_directory_path()
+                           / ("pistache_range_" + std::to_string(std::random_device {}())))
+                              .string();
+
+    const std::string data("abcdefghijklmnopqrstuvwxyz0123456789");
+    {
+        std::ofstream tmpFile(fileName);
+        tmpFile << data;
+    }
+
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    auto flags       = Tcp::Options::ReuseAddr;
+    auto server_opts = Http::Endpoint::options().flags(flags);
+    server.init(server_opts);
+    server.setHandler(Http::make_handler<RangeFileHandler>(fileName));
+    server.serveThreaded();
+
+    const std::string url = "http://localhost:" + server.getPort().toString() + "/";
+
+    auto full = curlGet(url, {});
+    EXPECT_EQ(full.code, 200);
+    EXPECT_EQ(full.body, data);
+    EXPECT_EQ(full.header("Accept-Ranges"), "bytes");
+    EXPECT_FALSE(full.header("Last-Modified").empty());
+    const auto etag = full.header("ETag");
+    ASSERT_FALSE(etag.empty());
+
+    auto single = curlGet(url, { "Range: bytes=2-5" });
+    EXPECT_EQ(single.code, 206);
+    EXPECT_EQ(single.body, "cdef");
+    EXPECT_EQ(single.header("Content-Range"), "bytes 2-5/36");
+
+    auto suffix = curlGet(url, { "Range: bytes=-4" });
+    EXPECT_EQ(suffix.code, 206);
+    EXPECT_EQ(suffix.body, "6789");
+
+    // Overlapping ranges are merged into one
+    auto merged = curlGet(url, { "Range: bytes=0-3,2-5" });
+    EXPECT_EQ(merged.code, 206);
+    EXPECT_EQ(merged.body, "abcdef");
+
+    auto multi = curlGet(url, { "Range: bytes=0-1,10-11" });
+    EXPECT_EQ(multi.code, 206);
+    const auto contentType = multi.header("Content-Type");
+    ASSERT_EQ(contentType.rfind("multipart/byteranges; boundary=", 0), 0u);
+    const auto boundary = contentType.substr(contentType.find('=') + 1);
+    EXPECT_NE(multi.body.find("Content-Range: bytes 0-1/36\r\n\r\nab\r\n--" + boundary),
+              std::string::npos);
+    EXPECT_NE(multi.body.find("Content-Range: bytes 10-11/36\r\n\r\nkl\r\n--" + boundary + "--"),
+              std::string::npos);
+    EXPECT_EQ(std::to_string(multi.body.size()), multi.header("Content-Length"));
+
+    auto unsatisfiable = curlGet(url, { "Range: bytes=100-" });
+    EXPECT_EQ(unsatisfiable.code, 416);
+    EXPECT_EQ(unsatisfiable.header("Content-Range"), "bytes */36");
+
+    // Not a bytes range, ignored
+    auto ignored = curlGet(url, { "Range: lines=1-2" });
+    EXPECT_EQ(ignored.code, 200);
+    EXPECT_EQ(ignored.body, data);
+
+    auto notModified = curlGet(url, { "If-None-Match: \"other\", " + etag });
+    EXPECT_EQ(notModified.code, 304);
+    EXPECT_TRUE(notModified.body.empty());
+    EXPECT_EQ(notModified.header("ETag"), etag);
+
+    auto modified = curlGet(url, { "If-None-Match: \"other\"" });
+    EXPECT_EQ(modified.code, 200);
+
+    auto notModifiedSince = curlGet(url, { "If-Modified-Since: Sat, 06 Nov 2094 08:49:37 GMT" });
+    EXPECT_EQ(notModifiedSince.code, 304);
+
+    auto modifiedSince = curlGet(url, { "If-Modified-Since: Sun, 06 Nov 1994 08:49:37 GMT" });
+    EXPECT_EQ(modifiedSince.code, 200);
+
+    auto ifRangeMatch = curlGet(url, { "Range: bytes=0-0", "If-Range: " + etag });
+    EXPECT_EQ(ifRangeMatch.code, 206);
+    EXPECT_EQ(ifRangeMatch.body, "a");
+
+    // The file changed since, as far as the client knows: all of it
+    auto ifRangeStale = curlGet(url, { "Range: bytes=0-0", "If-Range: \"stale\"" });
+    EXPECT_EQ(ifRangeStale.code, 200);
+    EXPECT_EQ(ifRangeStale.body, data);
+
+    server.shutdown();
+    std::remove(fileName.c_str());
+}
+
 TEST(http_server_test, server_request_copies_address)
 {
     PS_TIMEDBG_START;
@@ -1912,6 +2740,92 @@ TEST(http_server_test, server_with_content_encoding_deflate)
 }
 #endif
 
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+// Streams its response deflate compressed, one chunk per flush, unless the
+// request asks for nothing but identity. A plain send() of a body shorter
+// than the minimum size is sent as is
+struct StreamingCompressionHandler : public Http::Handler
+{
+    HTTP_PROTOTYPE(StreamingCompressionHandler)
+
+    static constexpr int Pieces = 8;
+
+    static std::string piece(int i)
+    {
+        return "piece " + std::to_string(i) + ": " + std::string(200, static_cast<char>('a' + i));
+    }
+
+    void onRequest(const Http::Request& request,
+                   Http::ResponseWriter writer) override
+    {
+        writer.setCompression(request.getBestAcceptEncoding());
+        writer.setCompressionMinSize(64);
+
+        if (request.resource() == "/small")
+        {
+            writer.send(Http::Code::Ok, "too small to compress");
+            return;
+        }
+
+        auto stream = writer.stream(Http::Code::Ok);
+        for (int i = 0; i < Pieces; ++i)
+        {
+            const auto data = piece(i);
+            stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+            stream.flush();
+        }
+        stream.ends();
+    }
+};
+
+TEST(http_server_test, server_with_streamed_content_encoding_deflate)
+{
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr));
+    server.setHandler(Http::make_handler<StreamingCompressionHandler>());
+    server.serveThreaded();
+
+    const std::string url = "http://localhost:" + server.getPort().toString();
+
+    std::string expected;
+    for (int i = 0; i < StreamingCompressionHandler::Pieces; ++i)
+        expected += StreamingCompressionHandler::piece(i);
+
+    auto streamed = curlGet(url + "/", { "Accept-Encoding: deflate" });
+    EXPECT_EQ(streamed.code, 200);
+    EXPECT_EQ(streamed.header("Content-Encoding"), "deflate");
+    EXPECT_EQ(streamed.header("Transfer-Encoding"), "chunked");
+
+    // curl leaves the body compressed, as no CURLOPT_ACCEPT_ENCODING is set
+    std::string inflated(expected.size() * 2, '\0');
+    z_stream zs {};
+    ASSERT_EQ(inflateInit(&zs), Z_OK);
+    zs.next_in   = reinterpret_cast<Bytef*>(streamed.body.data());
+    zs.avail_in  = static_cast<uInt>(streamed.body.size());
+    zs.next_out  = reinterpret_cast<Bytef*>(inflated.data());
+    zs.avail_out = static_cast<uInt>(inflated.size());
+    EXPECT_EQ(inflate(&zs, Z_FINISH), Z_STREAM_END);
+    inflated.resize(zs.total_out);
+    inflateEnd(&zs);
+
+    EXPECT_EQ(inflated, expected);
+    EXPECT_LT(streamed.body.size(), expected.size());
+
+    auto small = curlGet(url + "/small", { "Accept-Encoding: deflate" });
+    EXPECT_EQ(small.code, 200);
+    EXPECT_EQ(small.header("Content-Encoding"), "");
+    EXPECT_EQ(small.body, "too small to compress");
+
+    auto identity = curlGet(url + "/", { "Accept-Encoding: identity" });
+    EXPECT_EQ(identity.header("Content-Encoding"), "");
+    EXPECT_EQ(identity.body, expected);
+
+    server.shutdown();
+}
+#endif
+
 
 TEST(http_server_test, http_server_is_not_leaked)
 {
@@ -20,6 +20,8 @@
 #include PST_MISC_IO_HDR // unistd.h
 
 #include <array>
+#include <cstring>
+#include <set>
 #include <sstream>
 
 #include <chrono>
@@ -36,6 +38,14 @@ using namespace std::chrono_literals;
 #include <sys/wait.h> // for wait
 #endif
 
+#if defined(__linux__) && __has_include(<linux/bpf.h>)
+#include <linux/bpf.h>
+#include <sys/syscall.h>
+#define PS_TEST_REUSEPORT_BPF
+#endif
+
+#include "tcp_client.h"
+
 #ifdef _IS_WINDOWS
 #include <Windows.h> // for fileapi.h
 #include <fileapi.h> // for GetTempPathA
@@ -353,6 +363,147 @@ TEST(listener_test, listener_bind_ephemeral_v6_port)
     ASSERT_TRUE(true);
 }
 
+// Answers with the id of the worker thread serving the request
+class WorkerIdHandler : public Pistache::Http::Handler
+{
+public:
+    HTTP_PROTOTYPE(WorkerIdHandler)
+
+    void onRequest(const Pistache::Http::Request& /*request*/,
+                   Pistache::Http::ResponseWriter response) override
+    {
+        std::ostringstream id;
+        id << std::this_thread::get_id();
+        response.send(Pistache::Http::Code::Ok, id.str());
+    }
+};
+
+// The body of a GET / over a connection of its own, empty on failure
+std::string fetchOnNewConnection(Pistache::Port port)
+{
+    Pistache::TcpClient client;
+    if (!client.connect(Pistache::Address("127.0.0.1", port)))
+        return "";
+    if (!client.send("GET / HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n"))
+        return "";
+
+    static const std::string Length = "Content-Length: ";
+
+    std::string received;
+    char buffer[1024];
+    size_t bytes = 0;
+    while (client.receive(buffer, sizeof(buffer), &bytes, std::chrono::seconds(2)) && bytes > 0)
+    {
+        received.append(buffer, bytes);
+
+        const auto body   = received.find("\r\n\r\n");
+        const auto length = received.find(Length);
+        if (body == std::string::npos || length == std::string::npos)
+            continue;
+
+        const auto size = std::stoul(received.substr(length + Length.size()));
+        if (received.size() >= body + 4 + size)
+            return received.substr(body + 4, size);
+    }
+    return "";
+}
+
+// With a listening socket per worker, the kernel spreads the connections
+// over the workers, each accepting its own
+TEST(listener_test, per_worker_listeners_serve_connections)
+{
+    PS_TIMEDBG_START;
+
+    Pistache::Http::Endpoint server(Pistache::Address("127.0.0.1", Pistache::Port(0)));
+    server.init(Pistache::Http::Endpoint::options()
+                    .threads(2)
+                    .flags(Pistache::Tcp::Options::ReuseAddr)
+                    .perWorkerListeners(true));
+    server.setHandler(Pistache::Http::make_handler<WorkerIdHandler>());
+    server.serveThreaded();
+
+    const auto port = server.getPort();
+    ASSERT_TRUE(port > static_cast<uint16_t>(0));
+
+    std::set<std::string> workers;
+    for (int i = 0; i < 32; ++i)
+    {
+        const auto worker = fetchOnNewConnection(port);
+        ASSERT_FALSE(worker.empty()) << "connection " << i;
+        workers.insert(worker);
+    }
+
+    server.shutdown();
+
+    // Connections are hashed over the sockets: all 32 going to the same
+    // one would be a 1 in 2^31 chance
+    EXPECT_EQ(workers.size(), 2u);
+}
+
+#ifdef PS_TEST_REUSEPORT_BPF
+
+// A BPF_PROG_TYPE_SK_REUSEPORT program returning verdict, -1 if it can't
+// be loaded (e.g. unprivileged)
+int loadReusePortProgram(int verdict)
+{
+    struct bpf_insn insns[2] = {};
+    insns[0].code            = BPF_ALU64 | BPF_MOV | BPF_K;
+    insns[0].dst_reg         = BPF_REG_0;
+    insns[0].imm             = verdict;
+    insns[1].code            = BPF_JMP | BPF_EXIT;
+
+    static const char license[] = "GPL";
+
+    union bpf_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_SK_REUSEPORT;
+    attr.insns     = reinterpret_cast<uint64_t>(insns);
+    attr.insn_cnt  = 2;
+    attr.license   = reinterpret_cast<uint64_t>(license);
+
+    return static_cast<int>(syscall(__NR_bpf, BPF_PROG_LOAD, &attr, sizeof(attr)));
+}
+
+// The program given decides where connections go, here whether they go
+// anywhere at all
+TEST(listener_test, per_worker_listeners_run_reuseport_program)
+{
+    PS_TIMEDBG_START;
+
+    const int pass = loadReusePortProgram(SK_PASS);
+    const int drop = loadReusePortProgram(SK_DROP);
+    if (pass < 0 || drop < 0)
+    {
+        if (pass >= 0)
+            close(pass);
+        if (drop >= 0)
+            close(drop);
+        GTEST_SKIP() << "Cannot load eBPF programs here";
+    }
+
+    for (const int program : { pass, drop })
+    {
+        Pistache::Http::Endpoint server(Pistache::Address("127.0.0.1", Pistache::Port(0)));
+        server.init(Pistache::Http::Endpoint::options()
+                        .threads(2)
+                        .flags(Pistache::Tcp::Options::ReuseAddr)
+                        .perWorkerListeners(true)
+                        .reusePortProgram(program));
+        server.setHandler(Pistache::Http::make_handler<WorkerIdHandler>());
+        server.serveThreaded();
+
+        const auto worker = fetchOnNewConnection(server.getPort());
+        EXPECT_EQ(worker.empty(), program == drop);
+
+        server.shutdown();
+    }
+
+    close(pass);
+    close(drop);
+}
+
+#endif
+
 TEST(listener_test, listener_bind_unix_domain)
 {
     PS_TIMEDBG_START;
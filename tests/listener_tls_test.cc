@@ -9,7 +9,11 @@
 #include <pistache/listener.h>
 
 #include <chrono>
+#include <string>
+#include <vector>
+
 #include <openssl/bio.h>
+#include <openssl/ssl.h>
 #include <pistache/http.h>
 
 using testing::Eq;
@@ -100,3 +104,68 @@ TEST(listener_tls_test, tls_handshake_timeout_custom)
 
     BIO_free_all(bio);
 }
+
+// Clients that connect but never (or only very slowly) handshake must
+// neither hold up the accept loop nor delay well-behaved clients
+TEST(listener_tls_test, tls_handshake_slow_clients_do_not_block)
+{
+    Pistache::Tcp::Listener listener;
+    listener.init(1);
+    listener.setupSSL("./certs/server.crt", "./certs/server.key", false, nullptr, std::chrono::seconds(3));
+    listener.setHandler(Pistache::Http::make_handler<HelloHandler>());
+    listener.bind(Pistache::Address(Pistache::IP::loopback(), 0));
+    listener.runThreaded();
+
+    const std::string port = listener.getPort().toString();
+
+    constexpr size_t SlowClients = 1000;
+    std::vector<BIO*> slow_bios;
+    slow_bios.reserve(SlowClients);
+    for (size_t i = 0; i < SlowClients; ++i)
+    {
+        BIO* bio = BIO_new_connect("localhost");
+        BIO_set_conn_port(bio, port.c_str());
+        ASSERT_THAT(BIO_do_connect(bio), Eq(1));
+        slow_bios.push_back(bio);
+    }
+
+    // A regular TLS client has to be served right away, well before any of
+    // the slow clients has timed out
+    SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+    BIO* bio     = BIO_new_ssl_connect(ctx);
+    BIO_set_conn_hostname(bio, ("localhost:" + port).c_str());
+
+    const auto pre_handshake = std::chrono::steady_clock::now();
+    ASSERT_THAT(BIO_do_connect(bio), Eq(1));
+    ASSERT_THAT(BIO_do_handshake(bio), Eq(1));
+
+    const std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+    ASSERT_THAT(BIO_write(bio, request.data(), static_cast<int>(request.size())),
+                Eq(static_cast<int>(request.size())));
+
+    // Read up to the body rather than waiting for the connection to close
+    std::string response;
+    char buf[256];
+    int read_res;
+    while (response.find("Hello world") == std::string::npos
+           && (read_res = BIO_read(bio, buf, sizeof buf)) > 0)
+        response.append(buf, static_cast<size_t>(read_res));
+
+    const auto duration = std::chrono::steady_clock::now() - pre_handshake;
+    EXPECT_THAT(duration, Le(std::chrono::seconds(2)));
+    EXPECT_NE(response.find("Hello world"), std::string::npos);
+
+    BIO_free_all(bio);
+    SSL_CTX_free(ctx);
+
+    // Every slow client gets dropped once its handshake timeout expires
+    for (BIO* slow_bio : slow_bios)
+    {
+        unsigned char slow_buf[10];
+        EXPECT_THAT(BIO_read(slow_bio, slow_buf, sizeof slow_buf), Le(0));
+        BIO_free_all(slow_bio);
+    }
+
+    const auto total_duration = std::chrono::steady_clock::now() - pre_handshake;
+    EXPECT_THAT(total_duration, Le(std::chrono::seconds(8)));
+}
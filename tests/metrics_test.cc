@@ -0,0 +1,200 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/endpoint.h>
+#include <pistache/http.h>
+#include <pistache/metrics.h>
+#include <pistache/router.h>
+
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <httplib.h>
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "tcp_client.h"
+
+using namespace Pistache;
+
+TEST(metrics_test, histogram_buckets_are_log_linear)
+{
+    using Metrics::Histogram;
+
+    for (uint64_t value : { 0ull, 1ull, 7ull, 8ull, 15ull, 16ull, 1000ull, 123456789ull })
+    {
+        const size_t bucket = Histogram::bucketOf(value);
+        EXPECT_LE(Histogram::lowerBound(bucket), value);
+        EXPECT_GT(Histogram::lowerBound(bucket + 1), value);
+    }
+    EXPECT_EQ(Histogram::bucketOf(~uint64_t(0)), Histogram::BucketCount - 1);
+
+    Histogram histogram;
+    for (uint64_t value = 1; value <= 1000; ++value)
+        histogram.record(value);
+
+    EXPECT_EQ(histogram.count(), 1000u);
+    EXPECT_EQ(histogram.sum(), 500500u);
+    EXPECT_EQ(histogram.max(), 1000u);
+    EXPECT_EQ(histogram.countBelow(512), 511u);
+
+    // Within a bucket's width, an eighth of its power of two
+    EXPECT_NEAR(static_cast<double>(histogram.quantile(0.5)), 500.0, 500.0 / 8);
+    EXPECT_NEAR(static_cast<double>(histogram.quantile(0.99)), 990.0, 990.0 / 8);
+    EXPECT_EQ(histogram.quantile(1.0), 1000u);
+}
+
+namespace
+{
+    uint64_t status4xx(const Metrics::Values& values) { return values.responses[3].value(); }
+    uint64_t gets(const Metrics::Values& values)
+    {
+        return values.requests[static_cast<size_t>(Http::Method::Get)].value();
+    }
+}
+
+TEST(metrics_test, counts_what_the_server_does)
+{
+    Rest::Router router;
+    Rest::Routes::Get(router, "/hello",
+                      [](const Rest::Request&, Http::ResponseWriter response) {
+                          response.send(Http::Code::Ok, "Hello");
+                          return Rest::Route::Result::Ok;
+                      });
+    Rest::Routes::Prometheus(router);
+
+    Http::Endpoint server(Address("localhost", Port(0)));
+    server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr).threads(2));
+    server.setHandler(router.handler());
+    server.serveThreaded();
+
+    const auto before = Metrics::total();
+
+    httplib::Client client("localhost", server.getPort());
+    for (int i = 0; i < 3; ++i)
+    {
+        auto res = client.Get("/hello");
+        ASSERT_TRUE(res);
+        EXPECT_EQ(res->status, 200);
+    }
+
+    auto missing = client.Get("/missing");
+    ASSERT_TRUE(missing);
+    EXPECT_EQ(missing->status, 404);
+
+    auto notAllowed = client.Post("/hello", "", "text/plain");
+    ASSERT_TRUE(notAllowed);
+    EXPECT_EQ(notAllowed->status, 405);
+
+    {
+        TcpClient raw;
+        ASSERT_TRUE(raw.connect(Address("localhost", server.getPort())));
+        ASSERT_TRUE(raw.send("NOT HTTP\r\n\r\n"));
+
+        char buffer[1024];
+        size_t bytes = 0;
+        ASSERT_TRUE(raw.receive(buffer, sizeof(buffer), &bytes, std::chrono::seconds(5)));
+    }
+
+    auto scraped = client.Get("/metrics");
+    ASSERT_TRUE(scraped);
+    EXPECT_EQ(scraped->status, 200);
+
+    const auto after = Metrics::total();
+    const auto workers = Metrics::workers();
+    server.shutdown();
+
+    EXPECT_GE(gets(after) - gets(before), 5u);
+    EXPECT_GE(after.responses[1].value() - before.responses[1].value(), 3u);
+    EXPECT_GE(status4xx(after) - status4xx(before), 3u);
+    EXPECT_EQ(after.routesNotFound.value() - before.routesNotFound.value(), 1u);
+    EXPECT_EQ(after.routesNotAllowed.value() - before.routesNotAllowed.value(), 1u);
+    EXPECT_EQ(after.parseErrors.value() - before.parseErrors.value(), 1u);
+    EXPECT_GE(after.connectionsAccepted.value() - before.connectionsAccepted.value(), 2u);
+    EXPECT_GT(after.bytesIn.value(), before.bytesIn.value());
+    EXPECT_GT(after.bytesOut.value(), before.bytesOut.value());
+    EXPECT_GE(after.requestLatency.count() - before.requestLatency.count(), 6u);
+    EXPECT_FALSE(workers.empty());
+
+    const std::string& text = scraped->body;
+    EXPECT_NE(text.find("# TYPE pistache_requests_total counter"), std::string::npos);
+    EXPECT_NE(text.find("pistache_requests_total{method=\"GET\"}"), std::string::npos);
+    EXPECT_NE(text.find("pistache_responses_total{code=\"4xx\"}"), std::string::npos);
+    EXPECT_NE(text.find("pistache_request_duration_seconds_bucket{le=\"+Inf\"}"),
+              std::string::npos);
+    EXPECT_NE(text.find("pistache_route_misses_total{reason=\"not_found\"}"), std::string::npos);
+
+    std::cout << "request latency: p50 " << after.requestLatency.quantile(0.5) << " us, p99 "
+              << after.requestLatency.quantile(0.99) << " us" << std::endl;
+}
+
+TEST(metrics_test, counts_files_served)
+{
+    const std::string fileName = "/tmp/pistache_metrics_test.txt";
+    {
+        std::ofstream file(fileName);
+        file << "0123456789";
+    }
+
+    Rest::Router router;
+    Rest::Routes::Get(router, "/file",
+                      [&](const Rest::Request& request, Http::ResponseWriter response) {
+                          Http::serveFile(response, request, fileName, MIME(Text, Plain));
+                          return Rest::Route::Result::Ok;
+                      });
+
+    Http::Endpoint server(Address("localhost", Port(0)));
+    server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr).threads(1));
+    server.setHandler(router.handler());
+    server.serveThreaded();
+
+    const auto before = Metrics::total();
+
+    httplib::Client client("localhost", server.getPort());
+    auto whole = client.Get("/file");
+    ASSERT_TRUE(whole);
+    EXPECT_EQ(whole->status, 200);
+
+    auto partial = client.Get("/file", { { "Range", "bytes=2-4" } });
+    ASSERT_TRUE(partial);
+    EXPECT_EQ(partial->status, 206);
+
+    {
+        // httplib waits for the body of a 304, until the connection closes
+        TcpClient raw;
+        ASSERT_TRUE(raw.connect(Address("localhost", server.getPort())));
+        ASSERT_TRUE(raw.send("GET /file HTTP/1.1\r\nHost: localhost\r\nIf-None-Match: "
+                             + whole->get_header_value("ETag") + "\r\n\r\n"));
+
+        char buffer[1024];
+        size_t bytes = 0;
+        ASSERT_TRUE(raw.receive(buffer, sizeof(buffer), &bytes, std::chrono::seconds(5)));
+        EXPECT_EQ(std::string(buffer, bytes).rfind("HTTP/1.1 304", 0), 0u);
+    }
+
+    auto unsatisfiable = client.Get("/file", { { "Range", "bytes=100-200" } });
+    ASSERT_TRUE(unsatisfiable);
+    EXPECT_EQ(unsatisfiable->status, 416);
+
+    const auto after = Metrics::total();
+    server.shutdown();
+    std::remove(fileName.c_str());
+
+    EXPECT_EQ(after.responses[1].value() - before.responses[1].value(), 2u);
+    EXPECT_EQ(after.responses[2].value() - before.responses[2].value(), 1u);
+    EXPECT_EQ(status4xx(after) - status4xx(before), 1u);
+    EXPECT_EQ(after.requestLatency.count() - before.requestLatency.count(), 4u);
+}
@@ -12,9 +12,14 @@
 #include <chrono>
 #include <iostream>
 #include <memory>
+#include <set>
 #include <thread>
 #include <unordered_set>
 
+#ifndef _USE_LIBEVENT
+#include <unistd.h>
+#endif
+
 using namespace Pistache;
 
 class TransportMock : public Aio::Handler
@@ -113,3 +118,91 @@ TEST(reactor_test, reactor_exceed_max_threads)
         reactor->init(Aio::AsyncContext(5 * MAX_SUPPORTED_THREADS + 1)),
         std::runtime_error);
 }
+
+#ifndef _USE_LIBEVENT
+
+// Level triggered fds are reported for as long as they are ready, edge
+// triggered ones when they become ready, whatever the poller polls with
+void expectPollingSemantics(Polling::Backend backend)
+{
+    Polling::Epoll poller(backend);
+
+    int level[2];
+    int edge[2];
+    ASSERT_EQ(pipe(level), 0);
+    ASSERT_EQ(pipe(edge), 0);
+
+    const auto levelTag = Polling::Tag(static_cast<uint64_t>(level[0]));
+    const auto edgeTag  = Polling::Tag(static_cast<uint64_t>(edge[0]));
+    const auto read     = Flags<Polling::NotifyOn>(Polling::NotifyOn::Read);
+
+    poller.addFd(level[0], read, levelTag, Polling::Mode::Level);
+    poller.addFd(edge[0], read, edgeTag, Polling::Mode::Edge);
+
+    auto ready = [&poller] {
+        std::vector<Polling::Event> events;
+        poller.poll(events, std::chrono::milliseconds(100));
+
+        std::set<uint64_t> tags;
+        for (const auto& event : events)
+        {
+            if (event.flags.hasFlag(Polling::NotifyOn::Read))
+                tags.insert(event.tag.value());
+        }
+        return tags;
+    };
+    using Tags = std::set<uint64_t>;
+
+    EXPECT_EQ(ready(), Tags());
+
+    ASSERT_EQ(write(level[1], "x", 1), 1);
+    ASSERT_EQ(write(edge[1], "x", 1), 1);
+    EXPECT_EQ(ready(), Tags({ levelTag.value(), edgeTag.value() }));
+
+    // Neither was read from
+    EXPECT_EQ(ready(), Tags({ levelTag.value() }));
+
+    ASSERT_EQ(write(edge[1], "x", 1), 1);
+    EXPECT_EQ(ready(), Tags({ levelTag.value(), edgeTag.value() }));
+
+    // Rearming reports what is ready at once, as edge triggered from now
+    poller.rearmFd(level[0], read, levelTag, Polling::Mode::Edge);
+    EXPECT_EQ(ready(), Tags({ levelTag.value() }));
+    EXPECT_EQ(ready(), Tags());
+
+    poller.removeFd(edge[0]);
+    ASSERT_EQ(write(edge[1], "x", 1), 1);
+    EXPECT_EQ(ready(), Tags());
+
+    poller.addFdOneShot(edge[0], read, edgeTag, Polling::Mode::Level);
+    EXPECT_EQ(ready(), Tags({ edgeTag.value() }));
+    EXPECT_EQ(ready(), Tags());
+
+    poller.rearmFd(edge[0], read, edgeTag, Polling::Mode::Level);
+    EXPECT_EQ(ready(), Tags({ edgeTag.value() }));
+    EXPECT_EQ(ready(), Tags({ edgeTag.value() }));
+
+    poller.removeFd(level[0]);
+    poller.removeFd(edge[0]);
+    for (int fd : { level[0], level[1], edge[0], edge[1] })
+        close(fd);
+}
+
+TEST(reactor_test, epoll_polling)
+{
+    Polling::Epoll poller;
+    ASSERT_EQ(poller.backend(), Polling::Backend::Epoll);
+
+    expectPollingSemantics(Polling::Backend::Epoll);
+}
+
+TEST(reactor_test, io_uring_polling)
+{
+    Polling::Epoll poller(Polling::Backend::IoUring);
+    if (poller.backend() != Polling::Backend::IoUring)
+        GTEST_SKIP() << "No io_uring here, epoll being used instead";
+
+    expectPollingSemantics(Polling::Backend::IoUring);
+}
+
+#endif
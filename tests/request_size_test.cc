@@ -12,11 +12,16 @@
 
 #include <gtest/gtest.h>
 
+#include <curl/curl.h>
+
 #include <chrono>
+#include <iostream>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "tcp_client.h"
+
 using namespace Pistache;
 
 const int wait_time = 3;
@@ -87,6 +92,12 @@ void testRequestSizes(const std::string& url,
     client.shutdown();
 }
 
+static size_t appendToString(void* contents, size_t size, size_t nmemb, void* userp)
+{
+    static_cast<std::string*>(userp)->append(static_cast<char*>(contents), size * nmemb);
+    return size * nmemb;
+}
+
 void handleEcho(const Rest::Request& /*request*/,
                 Http::ResponseWriter response)
 {
@@ -185,3 +196,114 @@ TEST(request_size, manual_construction)
 
     endpoint->shutdown();
 }
+
+class SizeHandler : public Http::Handler
+{
+public:
+    HTTP_PROTOTYPE(SizeHandler)
+
+    void onRequest(const Http::Request& request,
+                   Http::ResponseWriter response) override
+    {
+        response.send(Http::Code::Ok, std::to_string(request.body().size()));
+    }
+};
+
+// Uploads a 100 MB body to a server reading readBufferSize bytes at a
+// time, and returns how long it took
+static std::chrono::milliseconds uploadWithReadBufferSize(size_t readBufferSize)
+{
+    const Address addr(Ipv4::loopback(), Port(0));
+    const size_t uploadSize     = 100 * 1024 * 1024;
+    const size_t maxRequestSize = uploadSize + 4096; // room for the headers
+
+    auto endpoint = std::make_shared<Http::Endpoint>(addr);
+    auto opts     = Http::Endpoint::options()
+                    .flags(Tcp::Options::ReuseAddr)
+                    .maxRequestSize(maxRequestSize)
+                    .readBufferSize(readBufferSize);
+
+    endpoint->init(opts);
+    endpoint->setHandler(Http::make_handler<SizeHandler>());
+    endpoint->serveThreaded();
+
+    const auto port = endpoint->getPort();
+
+    const std::string payload(uploadSize, 'A');
+    std::string body;
+
+    CURL* curl = curl_easy_init();
+    EXPECT_NE(curl, nullptr);
+    if (!curl)
+    {
+        endpoint->shutdown();
+        return std::chrono::milliseconds(0);
+    }
+
+    // No "Expect: 100-continue" round trip, send the body straight away
+    struct curl_slist* headers = curl_slist_append(nullptr, "Expect:");
+
+    const std::string url = "http://127.0.0.1:" + std::to_string(port);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, payload.data());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE,
+                     static_cast<curl_off_t>(payload.size()));
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &appendToString);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L);
+
+    const auto start   = std::chrono::steady_clock::now();
+    const auto res     = curl_easy_perform(curl);
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    std::cout << "Uploaded " << uploadSize << " bytes with a "
+              << readBufferSize << " byte read buffer in " << elapsed.count()
+              << "ms" << std::endl;
+
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
+    endpoint->shutdown();
+
+    EXPECT_EQ(res, CURLE_OK);
+    EXPECT_EQ(body, std::to_string(uploadSize));
+    return elapsed;
+}
+
+TEST(request_size, large_upload_with_read_buffer_size)
+{
+    const auto defaultSize = uploadWithReadBufferSize(Const::DefaultReadBufferSize);
+    const auto largeSize   = uploadWithReadBufferSize(256 * 1024);
+
+    // Informational only, timings on a shared machine are too noisy to
+    // assert on
+    std::cout << "256 KB read buffer vs default: " << largeSize.count() << "ms vs "
+              << defaultSize.count() << "ms" << std::endl;
+}
+
+TEST(request_size, content_length_beyond_max_request_size)
+{
+    const Address addr(Ipv4::loopback(), Port(0));
+
+    auto endpoint = std::make_shared<Http::Endpoint>(addr);
+    endpoint->init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr).maxRequestSize(4096));
+    endpoint->setHandler(Http::make_handler<SizeHandler>());
+    endpoint->serveThreaded();
+
+    // Refused from the header alone, nothing is allocated for it
+    TcpClient client;
+    ASSERT_TRUE(client.connect(Address("127.0.0.1", endpoint->getPort())));
+    ASSERT_TRUE(client.send("POST / HTTP/1.1\r\n"
+                            "Host: localhost\r\n"
+                            "Content-Length: 100000000000\r\n"
+                            "\r\n"
+                            "AAAA"));
+
+    char buffer[1024];
+    size_t bytes = 0;
+    ASSERT_TRUE(client.receive(buffer, sizeof(buffer), &bytes, std::chrono::seconds(wait_time)));
+    const std::string response(buffer, bytes);
+    EXPECT_EQ(response.rfind("HTTP/1.1 413", 0), 0u) << response;
+
+    endpoint->shutdown();
+}
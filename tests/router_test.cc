@@ -11,6 +11,8 @@
 */
 
 #include <algorithm>
+#include <chrono>
+#include <iostream>
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
@@ -256,6 +258,42 @@ TEST(router_test, test_route_head_request)
     endpoint->shutdown();
 }
 
+// Requests are handed over to the route rather than copied: their params,
+// found in the resource, and their body still come through, and the next
+// request on the connection starts afresh
+TEST(router_test, test_request_handed_over)
+{
+    Address addr(Ipv4::any(), 0);
+    auto endpoint = std::make_shared<Http::Endpoint>(addr);
+    endpoint->init(Http::Endpoint::options().threads(1));
+
+    Rest::Router router;
+    Routes::Post(router, "/a/:id/*",
+                 [](const Rest::Request& request, Http::ResponseWriter response) {
+                     response.send(Http::Code::Ok,
+                                   request.param(":id").as<std::string>() + ' '
+                                       + request.splatAt(0).as<std::string>() + ' '
+                                       + request.body());
+                     return Rest::Route::Result::Ok;
+                 });
+
+    endpoint->setHandler(router.handler());
+    endpoint->serveThreaded();
+
+    httplib::Client client("localhost", endpoint->getPort());
+    client.set_keep_alive(true);
+
+    auto res = client.Post("/a/7/b", "body", "text/plain");
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->body, "7 b body");
+
+    res = client.Post("/a/8/c", "", "text/plain");
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->body, "8 c ");
+
+    endpoint->shutdown();
+}
+
 TEST(router_test, test_remove_not_existing)
 {
     SegmentTreeNode routes;
@@ -449,6 +487,246 @@ TEST(segment_tree_node_test, test_resource_sanitize)
     ASSERT_EQ(SegmentTreeNode::sanitizeResource("/path/to///////:place"), "path/to/:place");
 }
 
+TEST(segment_tree_node_test, test_resource_sanitize_in_place)
+{
+    std::string scratch;
+
+    // Nothing to collapse: a view into the resource itself
+    const std::string resource = "/path/to/bar/";
+    auto sanitized             = SegmentTreeNode::sanitizeResource(std::string_view(resource), scratch);
+    ASSERT_EQ(sanitized, "path/to/bar");
+    ASSERT_EQ(sanitized.data(), resource.data() + 1);
+    ASSERT_TRUE(scratch.empty());
+
+    sanitized = SegmentTreeNode::sanitizeResource(std::string_view("//path///to//"), scratch);
+    ASSERT_EQ(sanitized, "path/to");
+
+    ASSERT_EQ(SegmentTreeNode::sanitizeResource(std::string_view("/"), scratch), "");
+    ASSERT_EQ(SegmentTreeNode::sanitizeResource(std::string_view("//"), scratch), "");
+}
+
+TEST(segment_tree_node_test, test_matches_are_views)
+{
+    SegmentTreeNode routes;
+    const auto s = SegmentTreeNode::sanitizeResource("/users/:id/files/*");
+    routes.addRoute(std::string_view { s.data(), s.length() }, nullptr, nullptr);
+
+    const std::string path = "users/42/files/readme";
+    SegmentTreeNode::Matches params;
+    SegmentTreeNode::Matches splats;
+    ASSERT_NE(routes.findRoute(std::string_view(path), params, splats), nullptr);
+
+    ASSERT_EQ(params.size(), 1u);
+    ASSERT_EQ(params[0].name, ":id");
+    ASSERT_EQ(params[0].value, "42");
+    ASSERT_EQ(params[0].value.data(), path.data() + 6);
+    ASSERT_EQ(splats.size(), 1u);
+    ASSERT_EQ(splats[0].value, "readme");
+    ASSERT_TRUE(params.isInline());
+
+    // A failed lookup leaves what was matched so far alone
+    params.clear();
+    splats.clear();
+    ASSERT_EQ(routes.findRoute(std::string_view("users/42/other/readme"), params, splats), nullptr);
+    ASSERT_TRUE(params.empty());
+    ASSERT_TRUE(splats.empty());
+}
+
+TEST(segment_tree_node_test, test_route_table_matches_like_tree)
+{
+    SegmentTreeNode routes;
+    std::vector<std::string> resources = {
+        "/v1/hello", "/v1/hello/:name", "/v1/:version/items", "/get/:key?/bar",
+        "/say/*/to/*", "/opt/:a?/:b?", "/opt/fixed", "/mixed/:id/*/end", "/"
+    };
+    std::vector<std::string> sanitized;
+    sanitized.reserve(resources.size());
+    for (const auto& resource : resources)
+    {
+        sanitized.push_back(SegmentTreeNode::sanitizeResource(resource));
+        auto handler = [](const Rest::Request&, Http::ResponseWriter) {
+            return Route::Result::Ok;
+        };
+        routes.addRoute(sanitized.back(), handler, nullptr);
+    }
+
+    const RouteTable table(routes);
+    EXPECT_GT(table.nodeCount(), resources.size());
+
+    const std::vector<std::string> paths = {
+        "v1/hello", "v1/hello/joe", "v1/v2/items", "v1/v2/other", "get/bar", "get/k/bar",
+        "say/hi/to/you", "say/hi/to", "opt", "opt/x", "opt/x/y", "opt/fixed", "opt/x/y/z",
+        "mixed/1/anything/end", "mixed/1/end", "", "nothing"
+    };
+    for (const auto& path : paths)
+    {
+        SegmentTreeNode::Matches treeParams, treeSplats, tableParams, tableSplats;
+        const auto* fromTree  = routes.findRoute(path, treeParams, treeSplats);
+        const auto* fromTable = table.findRoute(path, tableParams, tableSplats);
+
+        ASSERT_EQ(fromTree == nullptr, fromTable == nullptr) << path;
+        if (fromTree == nullptr)
+            continue;
+
+        EXPECT_EQ(fromTree->get(), fromTable->get()) << path;
+        ASSERT_EQ(treeParams.size(), tableParams.size()) << path;
+        for (size_t i = 0; i < treeParams.size(); ++i)
+        {
+            EXPECT_EQ(treeParams[i].name, tableParams[i].name) << path;
+            EXPECT_EQ(treeParams[i].value, tableParams[i].value) << path;
+        }
+        ASSERT_EQ(treeSplats.size(), tableSplats.size()) << path;
+        for (size_t i = 0; i < treeSplats.size(); ++i)
+            EXPECT_EQ(treeSplats[i].value, tableSplats[i].value) << path;
+    }
+}
+
+TEST(router_test, test_frozen_routes_hot_swap)
+{
+    Address addr(Ipv4::any(), 0);
+    auto endpoint = std::make_shared<Http::Endpoint>(addr);
+
+    auto opts = Http::Endpoint::options().threads(1).maxRequestSize(4096);
+    endpoint->init(opts);
+
+    auto router = std::make_shared<Rest::Router>();
+    auto echo   = [](const Rest::Request& request, Http::ResponseWriter response) {
+        response.send(Http::Code::Ok, request.hasParam(":id") ? request.param(":id").as<std::string>() : "");
+        return Route::Result::Ok;
+    };
+
+    Routes::Get(*router, "/items/:id", echo);
+    Routes::Get(*router, "/files/*", echo);
+    ASSERT_FALSE(router->frozen());
+    router->freeze();
+    ASSERT_TRUE(router->frozen());
+
+    endpoint->setHandler(Rest::Router::handler(router));
+    endpoint->serveThreaded();
+    httplib::Client client("localhost", endpoint->getPort());
+
+    auto res = client.Get("/items/42");
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->status, int(Http::Code::Ok));
+    EXPECT_EQ(res->body, "42");
+
+    res = client.Post("/items/42", "", "text/plain");
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->status, int(Http::Code::Method_Not_Allowed));
+
+    // Changes are compiled into new tables right away
+    Routes::Get(*router, "/added", echo);
+    res = client.Get("/added");
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->status, int(Http::Code::Ok));
+
+    Routes::Remove(*router, Http::Method::Get, "/items/:id");
+    res = client.Get("/items/42");
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->status, int(Http::Code::Not_Found));
+
+    res = client.Get("/files/readme");
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->status, int(Http::Code::Ok));
+
+    endpoint->shutdown();
+}
+
+// Looks up paths in a tree of 1000 routes, a quarter each fixed, with a
+// parameter, with an optional parameter and with a splat, through the
+// allocation-free lookup, the one returning TypedParams and a RouteTable
+TEST(segment_tree_node_test, lookup_benchmark)
+{
+    constexpr int RoutesPerKind = 250;
+
+    std::vector<std::string> resources;
+    std::vector<std::string> requests;
+    for (int i = 0; i < RoutesPerKind; ++i)
+    {
+        const auto n = std::to_string(i);
+        resources.push_back("/api/v1/fixed" + n + "/items/all");
+        resources.push_back("/api/v1/param" + n + "/:id/details");
+        resources.push_back("/api/v1/optional" + n + "/:id?");
+        resources.push_back("/api/v1/splat" + n + "/*/tail");
+
+        requests.push_back("/api/v1/fixed" + n + "/items/all");
+        requests.push_back("/api/v1/param" + n + "/1234/details");
+        requests.push_back("/api/v1/optional" + n + "/5678");
+        requests.push_back("/api/v1/optional" + n);
+        requests.push_back("/api/v1/splat" + n + "/anything/tail");
+    }
+
+    SegmentTreeNode routes;
+    std::vector<std::string> sanitized;
+    sanitized.reserve(resources.size());
+    for (const auto& resource : resources)
+    {
+        sanitized.push_back(SegmentTreeNode::sanitizeResource(resource));
+        routes.addRoute(sanitized.back(), nullptr, nullptr);
+    }
+
+    constexpr int Rounds = 200;
+    using Clock          = std::chrono::steady_clock;
+
+    size_t found     = 0;
+    const auto start = Clock::now();
+    for (int round = 0; round < Rounds; ++round)
+    {
+        std::string scratch;
+        for (const auto& request : requests)
+        {
+            SegmentTreeNode::Matches params;
+            SegmentTreeNode::Matches splats;
+            const auto path = SegmentTreeNode::sanitizeResource(std::string_view(request), scratch);
+            found += routes.findRoute(path, params, splats) != nullptr;
+        }
+    }
+    const auto views = Clock::now() - start;
+
+    const RouteTable table(routes);
+
+    size_t foundFrozen     = 0;
+    const auto startFrozen = Clock::now();
+    for (int round = 0; round < Rounds; ++round)
+    {
+        std::string scratch;
+        for (const auto& request : requests)
+        {
+            SegmentTreeNode::Matches params;
+            SegmentTreeNode::Matches splats;
+            const auto path = SegmentTreeNode::sanitizeResource(std::string_view(request), scratch);
+            foundFrozen += table.findRoute(path, params, splats) != nullptr;
+        }
+    }
+    const auto frozen = Clock::now() - startFrozen;
+
+    size_t foundTyped     = 0;
+    const auto startTyped = Clock::now();
+    for (int round = 0; round < Rounds; ++round)
+    {
+        for (const auto& request : requests)
+        {
+            const auto path = SegmentTreeNode::sanitizeResource(request);
+            foundTyped += std::get<0>(routes.findRoute(path)) != nullptr;
+        }
+    }
+    const auto typed = Clock::now() - startTyped;
+
+    const size_t lookups = requests.size() * Rounds;
+    ASSERT_EQ(found, lookups);
+    ASSERT_EQ(foundTyped, lookups);
+    ASSERT_EQ(foundFrozen, lookups);
+
+    auto nsPerLookup = [&](Clock::duration elapsed) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()
+            / static_cast<long long>(lookups);
+    };
+    std::cout << "router lookup over " << resources.size() << " routes: "
+              << nsPerLookup(views) << " ns with views, "
+              << nsPerLookup(typed) << " ns with TypedParams, "
+              << nsPerLookup(frozen) << " ns frozen" << std::endl;
+}
+
 namespace
 {
     class WaitHelper
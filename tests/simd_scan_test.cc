@@ -0,0 +1,185 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/http.h>
+#include <pistache/simd_scan.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Pistache;
+
+namespace
+{
+    std::vector<Scan::Isa> supportedIsas()
+    {
+        std::vector<Scan::Isa> isas;
+        for (auto isa : { Scan::Isa::Scalar, Scan::Isa::Sse42, Scan::Isa::Avx2 })
+        {
+            if (Scan::supported(isa))
+                isas.push_back(isa);
+        }
+        return isas;
+    }
+
+    // Restores the default implementation when a test is done with others
+    struct IsaGuard
+    {
+        IsaGuard()
+            : saved(Scan::isa())
+        { }
+
+        ~IsaGuard() { Scan::setIsa(saved); }
+
+        Scan::Isa saved;
+    };
+
+    // Everything a parse resulted in, in a string, to tell parses apart.
+    // The input is fed in pieces of at most step bytes, parsing after each
+    std::string parseOutcome(const std::string& input, size_t step)
+    {
+        Http::RequestParser parser(1 << 20);
+        std::ostringstream out;
+
+        auto state = Http::Private::State::Again;
+        try
+        {
+            for (size_t offset = 0; offset < input.size() && state == Http::Private::State::Again;
+                 offset += step)
+            {
+                const size_t size = std::min(step, input.size() - offset);
+                if (!parser.feed(input.data() + offset, size))
+                {
+                    out << "too large";
+                    break;
+                }
+                state = parser.parse();
+            }
+            out << static_cast<int>(state);
+        }
+        catch (const std::exception& e)
+        {
+            out << "error: " << e.what();
+        }
+
+        const auto& request = parser.request;
+        out << '|' << static_cast<int>(request.method()) << '|' << request.resource() << '|'
+            << request.query().as_str() << '|' << static_cast<int>(request.version());
+        for (const auto& header : request.headers().rawList())
+            out << '|' << header.first << ": " << header.second.value();
+        out << '|' << request.body();
+        return out.str();
+    }
+
+    std::vector<std::string> corpus()
+    {
+        std::vector<std::string> inputs;
+
+        const auto dir = std::filesystem::path(__FILE__).parent_path() / "fuzzers" / "corpus";
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(dir, ec))
+        {
+            std::ifstream file(entry.path(), std::ios::binary);
+            inputs.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        return inputs;
+    }
+}
+
+TEST(simd_scan_test, find_first_of_agrees_with_scalar)
+{
+    IsaGuard guard;
+
+    std::mt19937 rng(42);
+    const std::string alphabet = "abc: \r\n?&=";
+    const std::vector<std::string> sets = { ":", " ?", "= &", "\r", "0123456789abcdef" };
+
+    for (size_t size = 0; size < 100; ++size)
+    {
+        std::string data(size + 1, '\0');
+        for (auto& c : data)
+            c = alphabet[rng() % alphabet.size()];
+
+        // Every alignment of the start
+        for (size_t offset = 0; offset <= 1; ++offset)
+        {
+            const char* begin = data.data() + offset;
+            const char* end   = data.data() + offset + size;
+            for (const auto& set : sets)
+            {
+                const char* expected = begin;
+                while (expected != end && set.find(*expected) == std::string::npos)
+                    ++expected;
+
+                for (auto isa : supportedIsas())
+                {
+                    Scan::setIsa(isa);
+                    EXPECT_EQ(Scan::findFirstOf(begin, end, set), expected)
+                        << Scan::isaString(isa) << ", size " << size << ", set '" << set << "'";
+                }
+            }
+        }
+    }
+
+    EXPECT_THROW(Scan::findFirstOf(nullptr, nullptr, ""), std::invalid_argument);
+}
+
+TEST(simd_scan_test, find_crlf)
+{
+    IsaGuard guard;
+
+    for (auto isa : supportedIsas())
+    {
+        Scan::setIsa(isa);
+
+        auto find = [](const std::string& data) {
+            return static_cast<size_t>(Scan::findCrLf(data.data(), data.data() + data.size()) - data.data());
+        };
+
+        EXPECT_EQ(find(""), 0u);
+        EXPECT_EQ(find("abc"), 3u);
+        EXPECT_EQ(find("abc\r"), 4u);
+        EXPECT_EQ(find("abc\r\n"), 3u);
+        EXPECT_EQ(find("a\rb\r\r\n"), 4u);
+        EXPECT_EQ(find(std::string(40, 'x') + "\r" + std::string(40, 'y') + "\r\n"), 81u);
+    }
+}
+
+// Every input of the parser fuzzer's corpus is parsed the same whatever
+// the implementation, and whether it comes in at once or byte by byte
+TEST(simd_scan_test, fuzz_corpus_parses_the_same)
+{
+    IsaGuard guard;
+
+    auto inputs = corpus();
+    if (inputs.empty())
+        GTEST_SKIP() << "fuzzer corpus not found";
+
+    inputs.push_back("GET /search?q=pistache&page=2&flag HTTP/1.1\r\n"
+                     "Host: localhost\r\nCookie: a=b\r\nContent-Length: 4\r\n\r\nbody");
+    inputs.push_back("POST /x HTTP/1.0\r\nX-Odd:   spaced\rvalue\r\n\r\n");
+
+    for (const auto& input : inputs)
+    {
+        Scan::setIsa(Scan::Isa::Scalar);
+        const auto expected = parseOutcome(input, input.size() + 1);
+
+        for (auto isa : supportedIsas())
+        {
+            Scan::setIsa(isa);
+            EXPECT_EQ(parseOutcome(input, input.size() + 1), expected) << Scan::isaString(isa);
+            EXPECT_EQ(parseOutcome(input, 1), expected) << Scan::isaString(isa);
+        }
+    }
+}
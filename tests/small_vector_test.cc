@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/small_vector.h>
+
+#include <memory>
+#include <string>
+
+using Pistache::SmallVector;
+
+TEST(small_vector_test, stays_inline_up_to_capacity)
+{
+    SmallVector<std::string, 2> values;
+    values.emplace_back("a");
+    values.push_back("b");
+
+    EXPECT_TRUE(values.isInline());
+    EXPECT_EQ(values.size(), 2u);
+    EXPECT_EQ(values[0], "a");
+    EXPECT_EQ(values.back(), "b");
+
+    values.emplace_back("c");
+    EXPECT_FALSE(values.isInline());
+    EXPECT_EQ(values.size(), 3u);
+    EXPECT_EQ(values[0], "a");
+    EXPECT_EQ(values[2], "c");
+
+    values.pop_back();
+    EXPECT_EQ(values.size(), 2u);
+    EXPECT_THROW(values.at(2), std::out_of_range);
+}
+
+TEST(small_vector_test, copies_and_moves)
+{
+    SmallVector<std::string, 2> small { "a", "b" };
+    SmallVector<std::string, 2> large { "a", "b", "c", "d" };
+
+    auto smallCopy = small;
+    auto largeCopy = large;
+    EXPECT_EQ(smallCopy.size(), 2u);
+    EXPECT_EQ(largeCopy[3], "d");
+
+    // Inline elements are moved one by one, heap storage is taken over
+    const auto* largeData = large.data();
+    auto smallMoved       = std::move(small);
+    auto largeMoved       = std::move(large);
+    EXPECT_TRUE(smallMoved.isInline());
+    EXPECT_EQ(smallMoved[1], "b");
+    EXPECT_EQ(largeMoved.data(), largeData);
+    EXPECT_TRUE(small.empty());
+    EXPECT_TRUE(large.isInline());
+
+    smallMoved = largeCopy;
+    EXPECT_EQ(smallMoved.size(), 4u);
+    largeMoved = std::move(smallCopy);
+    EXPECT_EQ(largeMoved.size(), 2u);
+    EXPECT_TRUE(largeMoved.isInline());
+}
+
+TEST(small_vector_test, destroys_its_elements)
+{
+    auto counted = std::make_shared<int>(0);
+    {
+        SmallVector<std::shared_ptr<int>, 2> values;
+        for (int i = 0; i < 5; ++i)
+            values.push_back(counted);
+        EXPECT_EQ(counted.use_count(), 6);
+
+        values.pop_back();
+        EXPECT_EQ(counted.use_count(), 5);
+    }
+    EXPECT_EQ(counted.use_count(), 1);
+}
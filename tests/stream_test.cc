@@ -14,6 +14,7 @@
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 
 #ifdef _IS_WINDOWS
@@ -237,3 +238,33 @@ TEST(stream, test_cursor_diff_for_array)
     second_cursor.advance(4);
     ASSERT_EQ(second_cursor.diff(first_cursor), 0u);
 }
+
+TEST(stream, test_gather_buffer_pieces)
+{
+    auto shared = std::make_shared<const std::string>("0123456789");
+
+    GatherBuffer gather;
+    gather.add(std::string("head"));
+    gather.add(std::string()); // nothing to send, not a piece
+    gather.add(shared, 2, 5);
+
+    GatherBuffer tail;
+    tail.add(shared);
+    tail.add(RawBuffer("tail!", 4));
+    gather.add(std::move(tail));
+
+    ASSERT_EQ(gather.count(), 4u);
+    ASSERT_EQ(gather.size(), 4u + 5u + 10u + 4u);
+    ASSERT_EQ(gather.piece(0), "head");
+    ASSERT_EQ(gather.piece(1), "23456");
+    ASSERT_EQ(gather.piece(2), "0123456789");
+    ASSERT_EQ(gather.piece(3), "tail");
+
+    ASSERT_TRUE(tail.empty());
+    ASSERT_EQ(tail.count(), 0u);
+
+    // Pieces are shared, not copied
+    ASSERT_EQ(gather.piece(2).data(), shared->data());
+
+    ASSERT_THROW(gather.add(shared, 8, 3), std::range_error);
+}
@@ -21,6 +21,8 @@
 #include <thread>
 #include <vector>
 
+#include "tcp_client.h"
+
 using namespace Pistache;
 
 static constexpr size_t N_LETTERS      = 26;
@@ -314,6 +316,162 @@ public:
     }
 };
 
+// Takes request bodies part by part, each part being done with in another
+// thread, and answers with how many bytes it got
+class UploadHandler : public Http::Handler
+{
+public:
+    HTTP_PROTOTYPE(UploadHandler)
+
+    struct State
+    {
+        State()
+            : worker([this] { run(); })
+        { }
+
+        ~State()
+        {
+            {
+                std::lock_guard<std::mutex> guard(m);
+                stop = true;
+            }
+            cv.notify_one();
+            worker.join();
+        }
+
+        void run()
+        {
+            for (;;)
+            {
+                std::unique_lock<std::mutex> lock(m);
+                cv.wait(lock, [this] { return stop || !pending.empty(); });
+                if (pending.empty())
+                    return;
+
+                auto deferred = std::move(pending.front());
+                pending.pop();
+                busy = false;
+                lock.unlock();
+
+                deferred.resolve();
+            }
+        }
+
+        std::mutex m;
+        std::condition_variable cv;
+        std::queue<Async::Deferred<void>> pending;
+        bool stop = false;
+
+        bool busy        = false; // with a part
+        size_t received  = 0;
+        size_t parts     = 0;
+        bool overlapping = false; // a part came in while busy with another
+
+        std::thread worker;
+    };
+
+    explicit UploadHandler(std::shared_ptr<State> state)
+        : state_(std::move(state))
+    { }
+
+    bool streamBody(const Http::Request& request) override
+    {
+        return request.resource() == "/upload";
+    }
+
+    Async::Promise<void> onBody(const Http::Request&, const char*, size_t size) override
+    {
+        std::lock_guard<std::mutex> guard(state_->m);
+        state_->overlapping = state_->overlapping || state_->busy;
+        state_->busy        = true;
+        state_->received += size;
+        ++state_->parts;
+
+        return Async::Promise<void>([&](Async::Deferred<void> deferred) {
+            state_->pending.push(std::move(deferred));
+            state_->cv.notify_one();
+        });
+    }
+
+    void onRequest(const Http::Request& request, Http::ResponseWriter response) override
+    {
+        std::lock_guard<std::mutex> guard(state_->m);
+        response.send(Http::Code::Ok,
+                      std::to_string(state_->received) + " " + std::to_string(request.body().size()));
+        state_->received = 0;
+    }
+
+private:
+    std::shared_ptr<State> state_;
+};
+
+namespace
+{
+    // The response to the request sent, until its body is as long as expected
+    std::string exchange(TcpClient& client, const std::string& request, const std::string& expected)
+    {
+        if (!client.send(request))
+            return "send failed: " + client.lastError();
+
+        std::string received;
+        char buffer[1024];
+        while (received.size() < expected.size()
+               || received.compare(received.size() - expected.size(), expected.size(), expected) != 0)
+        {
+            size_t bytes = 0;
+            if (!client.receive(buffer, sizeof buffer, &bytes, std::chrono::seconds(10)) || bytes == 0)
+                return received + " (" + client.lastError() + ")";
+            received.append(buffer, bytes);
+        }
+        return received;
+    }
+}
+
+// Bodies much larger than the maximum request size go through when streamed,
+// a part at a time, Content-Length or chunked, pipelined or not
+TEST(StreamingTest, RequestBodyStreamedWithBackpressure)
+{
+    PS_TIMEDBG_START;
+
+    auto state = std::make_shared<UploadHandler::State>();
+
+    Http::Endpoint endpoint(Address(IP::loopback(), Port(0)));
+    endpoint.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr).maxRequestSize(4096));
+    endpoint.setHandler(Http::make_handler<UploadHandler>(state));
+    endpoint.serveThreaded();
+
+    TcpClient client;
+    ASSERT_TRUE(client.connect(Address("localhost", endpoint.getPort()))) << client.lastError();
+
+    const size_t size = 8 * 1024 * 1024;
+    const std::string body(size, 'x');
+
+    auto response = exchange(client,
+                             "POST /upload HTTP/1.1\r\nConnection: keep-alive\r\nContent-Length: "
+                                 + std::to_string(size) + "\r\n\r\n" + body,
+                             std::to_string(size) + " 0");
+    EXPECT_NE(response.find("200 OK"), std::string::npos) << response;
+
+    std::string chunked = "POST /upload HTTP/1.1\r\nConnection: keep-alive\r\n"
+                          "Transfer-Encoding: chunked\r\n\r\n";
+    const std::string chunk(10000, 'y');
+    for (int i = 0; i < 100; ++i)
+        chunked += "2710\r\n" + chunk + "\r\n";
+    chunked += "0\r\n\r\n";
+
+    // Followed by a request whose body is not streamed
+    response = exchange(client,
+                        chunked + "POST /small HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello",
+                        "0 5");
+    EXPECT_NE(response.find("1000000 0"), std::string::npos) << response.substr(0, 200);
+
+    endpoint.shutdown();
+
+    std::lock_guard<std::mutex> guard(state->m);
+    EXPECT_FALSE(state->overlapping);
+    EXPECT_GT(state->parts, size / 4096);
+}
+
 // MUST be LAST test, since it calls curl_global_cleanup
 TEST(StreamingTest, ClientDisconnect)
 {
@@ -178,6 +178,13 @@ namespace Pistache
             return true;
         }
 
+        void close()
+        {
+            if (fd_ >= 0)
+                PST_SOCK_CLOSE(fd_);
+            fd_ = -1;
+        }
+
         std::string lastError() const
         {
             return lastError_;
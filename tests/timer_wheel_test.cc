@@ -0,0 +1,193 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/timer_wheel.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace Pistache;
+using namespace std::chrono_literals;
+
+namespace
+{
+    // A wheel whose origin lies ahead of the real clock, so that arming never
+    // catches it up to the current time and tests can drive it with time
+    // points of their own
+    struct ManualWheel
+    {
+        ManualWheel(std::chrono::milliseconds tick = 1ms, size_t slots = 64)
+            : origin(TimerWheel::Clock::now() + std::chrono::hours(1))
+            , wheel(tick, slots, origin)
+        { }
+
+        size_t advanceTo(std::chrono::milliseconds elapsed)
+        {
+            return wheel.advance(origin + elapsed);
+        }
+
+        TimerWheel::Clock::time_point origin;
+        TimerWheel wheel;
+    };
+}
+
+TEST(timer_wheel_test, fires_at_deadline)
+{
+    ManualWheel m;
+    int fired = 0;
+
+    m.wheel.armAt(m.origin + 10ms, [&]() { ++fired; });
+    EXPECT_EQ(m.wheel.size(), 1u);
+    ASSERT_TRUE(m.wheel.nextExpiry().has_value());
+    EXPECT_LE(*m.wheel.nextExpiry(), m.origin + 10ms);
+
+    EXPECT_EQ(m.advanceTo(9ms), 0u);
+    EXPECT_EQ(fired, 0);
+
+    EXPECT_EQ(m.advanceTo(10ms), 1u);
+    EXPECT_EQ(fired, 1);
+    EXPECT_TRUE(m.wheel.empty());
+    EXPECT_FALSE(m.wheel.nextExpiry().has_value());
+}
+
+TEST(timer_wheel_test, disarmed_timer_does_not_fire)
+{
+    ManualWheel m;
+    int fired = 0;
+
+    auto id = m.wheel.armAt(m.origin + 5ms, [&]() { ++fired; });
+    m.wheel.armAt(m.origin + 5ms, [&]() { fired += 10; });
+
+    EXPECT_TRUE(m.wheel.disarm(id));
+    EXPECT_FALSE(m.wheel.disarm(id));
+    EXPECT_FALSE(m.wheel.disarm(TimerWheel::InvalidId));
+
+    m.advanceTo(5ms);
+    EXPECT_EQ(fired, 10);
+
+    // The node has been reused since, the stale id must not match it
+    auto other = m.wheel.armAt(m.origin + 20ms, [&]() { ++fired; });
+    EXPECT_NE(other, id);
+    EXPECT_FALSE(m.wheel.disarm(id));
+    EXPECT_EQ(m.wheel.size(), 1u);
+}
+
+TEST(timer_wheel_test, timers_beyond_one_turn_wait_for_their_round)
+{
+    // 64 slots of 1ms, so these are several turns away
+    ManualWheel m;
+    std::vector<int> order;
+
+    m.wheel.armAt(m.origin + 200ms, [&]() { order.push_back(200); });
+    m.wheel.armAt(m.origin + 72ms, [&]() { order.push_back(72); });
+    m.wheel.armAt(m.origin + 8ms, [&]() { order.push_back(8); });
+
+    for (int ms = 1; ms <= 250; ++ms)
+        m.advanceTo(std::chrono::milliseconds(ms));
+
+    EXPECT_EQ(order, (std::vector<int> { 8, 72, 200 }));
+}
+
+TEST(timer_wheel_test, large_jump_fires_everything_due)
+{
+    ManualWheel m;
+    int fired = 0;
+
+    for (int ms = 1; ms <= 1000; ms += 7)
+        m.wheel.armAt(m.origin + std::chrono::milliseconds(ms), [&]() { ++fired; });
+    m.wheel.armAt(m.origin + 5000ms, [&]() { fired += 1000; });
+
+    EXPECT_EQ(m.advanceTo(1000ms), 143u);
+    EXPECT_EQ(fired, 143);
+    EXPECT_EQ(m.wheel.size(), 1u);
+}
+
+TEST(timer_wheel_test, next_expiry_is_never_late)
+{
+    ManualWheel m(2ms, 128);
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> delay(1, 2000);
+
+    auto soonest = TimerWheel::Clock::time_point::max();
+    for (int i = 0; i < 100; ++i)
+    {
+        auto deadline = m.origin + std::chrono::milliseconds(delay(rng));
+        soonest       = std::min(soonest, deadline);
+        m.wheel.armAt(deadline, []() { });
+    }
+
+    ASSERT_TRUE(m.wheel.nextExpiry().has_value());
+    EXPECT_LE(*m.wheel.nextExpiry(), soonest + m.wheel.tick());
+}
+
+TEST(timer_wheel_test, callbacks_can_rearm)
+{
+    ManualWheel m;
+    int fired = 0;
+
+    std::function<void()> periodic = [&]() {
+        if (++fired < 3)
+            m.wheel.armAt(m.origin + std::chrono::milliseconds(10 * (fired + 1)), periodic);
+    };
+    m.wheel.armAt(m.origin + 10ms, periodic);
+
+    for (int ms = 10; ms <= 50; ms += 10)
+        m.advanceTo(std::chrono::milliseconds(ms));
+
+    EXPECT_EQ(fired, 3);
+    EXPECT_TRUE(m.wheel.empty());
+}
+
+// Arm/disarm churn, as with request timeouts which are nearly all disarmed
+// before they expire. Reports the cost per operation, and checks it does
+// not grow with the number of timers armed
+TEST(timer_wheel_test, arm_disarm_churn)
+{
+    TimerWheel wheel;
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> delay(1, 30000);
+
+    auto churn = [&](size_t armed, size_t ops) {
+        std::vector<TimerWheel::Id> ids;
+        ids.reserve(armed);
+        for (size_t i = 0; i < armed; ++i)
+            ids.push_back(wheel.arm(std::chrono::milliseconds(delay(rng)), []() { }));
+
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < ops; ++i)
+        {
+            auto& id = ids[i % armed];
+            wheel.disarm(id);
+            id = wheel.arm(std::chrono::milliseconds(delay(rng)), []() { });
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        for (auto id : ids)
+            wheel.disarm(id);
+
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())
+            / static_cast<double>(ops);
+    };
+
+    const size_t OPS = 1000000;
+    const double few  = churn(100, OPS);
+    const double many = churn(100000, OPS);
+
+    std::cout << "timer wheel arm+disarm: " << few << "ns with 100 timers armed, "
+              << many << "ns with 100000 timers armed" << std::endl;
+
+    EXPECT_TRUE(wheel.empty());
+    // Generous, this only guards against an O(n) regression
+    EXPECT_LT(many, few * 20 + 1000);
+}
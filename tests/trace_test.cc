@@ -0,0 +1,260 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Pistache contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/endpoint.h>
+#include <pistache/http.h>
+#include <pistache/router.h>
+#include <pistache/trace.h>
+
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <httplib.h>
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace Pistache;
+
+namespace
+{
+    class TraceServer
+    {
+    public:
+        TraceServer()
+            : server(Address("localhost", Port(0)))
+        {
+            Rest::Routes::Get(router, "/hello",
+                              [](const Rest::Request&, Http::ResponseWriter response) {
+                                  response.send(Http::Code::Ok, "Hello");
+                                  return Rest::Route::Result::Ok;
+                              });
+            Rest::Routes::Get(router, "/stream",
+                              [](const Rest::Request&, Http::ResponseWriter response) {
+                                  auto stream = response.stream(Http::Code::Accepted);
+                                  stream << "chunk";
+                                  stream.ends();
+                                  return Rest::Route::Result::Ok;
+                              });
+            Rest::Routes::Get(router, "/file",
+                              [](const Rest::Request& request, Http::ResponseWriter response) {
+                                  Http::serveFile(response, request, fileName(), MIME(Text, Plain));
+                                  return Rest::Route::Result::Ok;
+                              });
+
+            server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr).threads(1));
+            server.setHandler(router.handler());
+            server.serveThreaded();
+        }
+
+        ~TraceServer()
+        {
+            server.shutdown();
+            Trace::sampleEvery(0);
+            Trace::setSink(nullptr);
+        }
+
+        Port port() const { return server.getPort(); }
+
+        static const std::string& fileName()
+        {
+            static const std::string name = "/tmp/pistache_trace_test.txt";
+            return name;
+        }
+
+    private:
+        Rest::Router router;
+        Http::Endpoint server;
+    };
+
+    // Spans are handed over once the response is out, the client may be
+    // done first
+    template <typename Predicate>
+    bool waitFor(Predicate predicate)
+    {
+        for (int i = 0; i < 200 && !predicate(); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return predicate();
+    }
+
+    uint64_t at(const Trace::Span& span, Trace::Phase phase)
+    {
+        return span.at[static_cast<size_t>(phase)];
+    }
+}
+
+TEST(trace_test, nothing_is_traced_unless_sampling)
+{
+    EXPECT_FALSE(Trace::enabled());
+    EXPECT_EQ(Trace::sample(), nullptr);
+
+    auto ring = std::make_shared<Trace::RingSink>(16);
+    Trace::setSink(ring);
+
+    TraceServer server;
+    httplib::Client client("localhost", server.port());
+    auto res = client.Get("/hello");
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->status, 200);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_TRUE(ring->spans().empty());
+}
+
+TEST(trace_test, spans_carry_every_phase_in_order)
+{
+    using Trace::Phase;
+
+    auto ring = std::make_shared<Trace::RingSink>(16);
+    Trace::setSink(ring);
+    Trace::sampleEvery(1);
+
+    TraceServer server;
+    {
+        httplib::Client client("localhost", server.port());
+        auto res = client.Get("/hello");
+        ASSERT_TRUE(res);
+        EXPECT_EQ(res->status, 200);
+    }
+    ASSERT_TRUE(waitFor([&] { return ring->spans().size() == 1; }));
+
+    const auto span = ring->spans().front();
+    EXPECT_NE(span.id, 0u);
+    EXPECT_EQ(span.method, Http::Method::Get);
+    EXPECT_EQ(span.resource, "/hello");
+    EXPECT_EQ(span.code, Http::Code::Ok);
+
+    for (size_t i = 0; i < Trace::PhaseCount; ++i)
+        EXPECT_TRUE(span.reached(static_cast<Phase>(i))) << Trace::phaseString(static_cast<Phase>(i));
+
+    EXPECT_LE(at(span, Phase::Accepted), at(span, Phase::FirstByte));
+    EXPECT_LE(at(span, Phase::FirstByte), at(span, Phase::Parsed));
+    EXPECT_LE(at(span, Phase::Parsed), at(span, Phase::RouteMatched));
+    EXPECT_LE(at(span, Phase::RouteMatched), at(span, Phase::FirstWrite));
+    EXPECT_LE(at(span, Phase::FirstWrite), at(span, Phase::LastByteFlushed));
+    EXPECT_LE(at(span, Phase::RouteMatched), at(span, Phase::HandlerReturned));
+    EXPECT_GT(span.between(Phase::Accepted, Phase::LastByteFlushed), 0u);
+
+    std::cout << "accept to last byte: "
+              << span.between(Phase::Accepted, Phase::LastByteFlushed) / 1000 << " us, parse "
+              << span.between(Phase::FirstByte, Phase::Parsed) / 1000 << " us" << std::endl;
+}
+
+TEST(trace_test, streamed_responses_are_traced)
+{
+    auto ring = std::make_shared<Trace::RingSink>(16);
+    Trace::setSink(ring);
+    Trace::sampleEvery(1);
+
+    TraceServer server;
+    httplib::Client client("localhost", server.port());
+    auto res = client.Get("/stream");
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->status, 202);
+    EXPECT_EQ(res->body, "chunk");
+
+    ASSERT_TRUE(waitFor([&] { return ring->spans().size() == 1; }));
+    const auto span = ring->spans().front();
+    EXPECT_EQ(span.resource, "/stream");
+    EXPECT_EQ(span.code, Http::Code::Accepted);
+    EXPECT_TRUE(span.reached(Trace::Phase::LastByteFlushed));
+}
+
+TEST(trace_test, served_files_are_traced)
+{
+    {
+        std::ofstream file(TraceServer::fileName());
+        file << "0123456789";
+    }
+
+    auto ring = std::make_shared<Trace::RingSink>(16);
+    Trace::setSink(ring);
+    Trace::sampleEvery(1);
+
+    TraceServer server;
+    httplib::Client client("localhost", server.port());
+    auto res = client.Get("/file", { { "Range", "bytes=2-4" } });
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->status, 206);
+    EXPECT_EQ(res->body, "234");
+
+    ASSERT_TRUE(waitFor([&] { return ring->spans().size() == 1; }));
+    std::remove(TraceServer::fileName().c_str());
+
+    const auto span = ring->spans().front();
+    EXPECT_EQ(span.resource, "/file");
+    EXPECT_EQ(span.code, Http::Code::Partial_Content);
+    EXPECT_TRUE(span.reached(Trace::Phase::FirstWrite));
+    EXPECT_TRUE(span.reached(Trace::Phase::LastByteFlushed));
+    EXPECT_LE(span.at[static_cast<size_t>(Trace::Phase::FirstWrite)],
+              span.at[static_cast<size_t>(Trace::Phase::LastByteFlushed)]);
+}
+
+TEST(trace_test, one_request_in_n_is_sampled)
+{
+    std::atomic<int> seen { 0 };
+    Trace::setSink(std::make_shared<Trace::CallbackSink>([&](const Trace::Span&) { ++seen; }));
+    Trace::sampleEvery(4);
+
+    TraceServer server;
+    httplib::Client client("localhost", server.port());
+    for (int i = 0; i < 40; ++i)
+    {
+        auto res = client.Get("/hello");
+        ASSERT_TRUE(res);
+    }
+
+    ASSERT_TRUE(waitFor([&] { return seen.load() >= 10; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(seen.load(), 10);
+}
+
+TEST(trace_test, file_sink_writes_a_line_per_span)
+{
+    const std::string path = "/tmp/pistache_trace_test.log";
+    std::remove(path.c_str());
+
+    Trace::setSink(std::make_shared<Trace::FileSink>(path));
+    Trace::sampleEvery(1);
+    {
+        TraceServer server;
+        httplib::Client client("localhost", server.port());
+        for (int i = 0; i < 3; ++i)
+        {
+            auto res = client.Get("/hello");
+            ASSERT_TRUE(res);
+        }
+
+        // Let the last span be written
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    std::ifstream file(path);
+    std::string line;
+    int lines = 0;
+    while (std::getline(file, line))
+    {
+        ++lines;
+        EXPECT_EQ(line.rfind("span ", 0), 0u) << line;
+        EXPECT_NE(line.find(" GET /hello 200 "), std::string::npos) << line;
+        EXPECT_NE(line.find("last_byte_flushed=+"), std::string::npos) << line;
+    }
+    EXPECT_EQ(lines, 3);
+    std::remove(path.c_str());
+
+    EXPECT_THROW(Trace::FileSink("/nonexistent/dir/trace.log"), std::runtime_error);
+}